@@ -16,12 +16,14 @@
 
 #include "ActivityClientRecord.h"
 
+#include "app/ContextImpl.h"
+
 namespace os {
 namespace app {
 
 ActivityClientRecord::ActivityClientRecord(const string& name,
                                            const std::shared_ptr<Activity> activity)
-      : mActivityName(name), mActivity(activity), mStatus(CREATING) {}
+      : mActivityName(name), mActivity(activity), mStatus(CREATING), mLaunchOrder(0) {}
 
 ActivityClientRecord::~ActivityClientRecord() {}
 
@@ -36,6 +38,11 @@ int32_t ActivityClientRecord::getStatus() {
     return mStatus;
 }
 
+void ActivityClientRecord::setToken(const sp<IBinder>& token) {
+    // the context of an Activity is always created by ContextImpl
+    std::static_pointer_cast<ContextImpl>(mActivity->getContext())->mToken = token;
+}
+
 void ActivityClientRecord::onActivityResult(const int requestCode, const int resultCode,
                                             const Intent& resultData) {
     mActivity->onActivityResult(requestCode, resultCode, resultData);
@@ -45,6 +45,17 @@ public:
 
     void reportActivityStatus(const int32_t status);
     int32_t getStatus();
+    const string& getName() const {
+        return mActivityName;
+    }
+    void setToken(const sp<IBinder>& token);
+    /** The activities of the same name are told apart by the order they are launched in */
+    uint32_t getLaunchOrder() const {
+        return mLaunchOrder;
+    }
+    void setLaunchOrder(const uint32_t order) {
+        mLaunchOrder = order;
+    }
     void onActivityResult(const int requestCode, const int resultCode, const Intent& resultData);
 
     int onCreate(const Intent& intent);
@@ -60,6 +71,7 @@ private:
     const string mActivityName;
     std::shared_ptr<Activity> mActivity;
     int32_t mStatus;
+    uint32_t mLaunchOrder;
 };
 
 } // namespace app
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/ActivityLaunch.h"
+
+#include "ParcelUtils.h"
+
+namespace os {
+namespace app {
+
+using namespace android;
+
+status_t ActivityLaunch::readFromParcel(const Parcel* parcel) {
+    SAFE_PARCEL(parcel->readUtf8FromUtf16, &mName);
+    SAFE_PARCEL(parcel->readStrongBinder, &mToken);
+    SAFE_PARCEL(mIntent.readFromParcel, parcel);
+    SAFE_PARCEL(parcel->readInt32, &mTargetStatus);
+    return android::OK;
+}
+
+status_t ActivityLaunch::writeToParcel(Parcel* parcel) const {
+    SAFE_PARCEL(parcel->writeUtf8AsUtf16, mName);
+    SAFE_PARCEL(parcel->writeStrongBinder, mToken);
+    SAFE_PARCEL(mIntent.writeToParcel, parcel);
+    SAFE_PARCEL(parcel->writeInt32, mTargetStatus);
+    return android::OK;
+}
+
+} // namespace app
+} // namespace os
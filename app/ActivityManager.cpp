@@ -41,12 +41,14 @@ sp<IActivityManager> ActivityManager::getService() {
     return mService;
 }
 
-int32_t ActivityManager::attachApplication(const sp<IApplicationThread>& app) {
+int32_t ActivityManager::attachApplication(const sp<IApplicationThread>& app,
+                                           std::vector<ActivityLaunch>& launches) {
     AM_PROFILER_BEGIN();
     sp<IActivityManager> service = getService();
     int32_t ret = android::FAILED_TRANSACTION;
     if (service != nullptr) {
-        Status status = service->attachApplication(app, &ret);
+        launches.clear();
+        Status status = service->attachApplication(app, &launches, &ret);
         if (!status.isOk()) {
             ALOGE("attachApplication error:%s", status.toString8().c_str());
         }
@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "ActivityClientRecord.h"
 #include "ServiceClientRecord.h"
 #include "app/ActivityManager.h"
@@ -34,6 +36,7 @@ using ::os::wm::WindowManager;
 Application::Application() {
     mUid = getuid();
     mPid = getpid();
+    mLaunchCount = 0;
     mWindowManager = NULL;
 }
 
@@ -94,6 +97,7 @@ std::shared_ptr<Service> Application::createService(const string& name) {
 
 void Application::addActivity(const sp<IBinder>& token,
                               const std::shared_ptr<ActivityClientRecord>& activity) {
+    activity->setLaunchOrder(mLaunchCount++);
     mExistActivities.insert({token, activity});
 }
 
@@ -156,6 +160,60 @@ void Application::clearActivityAndService() {
     mExistServices.clear();
 }
 
+void Application::reattach(const vector<string>& activityNames,
+                           const vector<sp<IBinder>>& activityTokens,
+                           const vector<string>& serviceNames,
+                           const vector<sp<IBinder>>& serviceTokens) {
+    ActivityManager am;
+    // the activity manager lists them in the order they are launched in, the k-th instance of a
+    // name is matched to the k-th one here
+    vector<std::shared_ptr<ActivityClientRecord>> activities;
+    for (const auto& it : mExistActivities) {
+        activities.push_back(it.second);
+    }
+    std::sort(activities.begin(), activities.end(), [](const auto& a, const auto& b) {
+        return a->getLaunchOrder() < b->getLaunchOrder();
+    });
+    mExistActivities.clear();
+    for (size_t i = 0; i < activityNames.size() && i < activityTokens.size(); i++) {
+        const auto it = std::find_if(activities.begin(), activities.end(), [&](const auto& a) {
+            return a->getName() == activityNames[i];
+        });
+        if (it == activities.end()) {
+            // it's destroyed before the activity manager knew
+            am.reportActivityStatus(activityTokens[i], ActivityClientRecord::DESTROYED);
+            continue;
+        }
+        (*it)->setToken(activityTokens[i]);
+        mExistActivities.emplace(activityTokens[i], *it);
+        activities.erase(it);
+    }
+    // the activity manager doesn't know them, they can't be managed any more
+    for (const auto& activity : activities) {
+        ALOGW("Activity %s isn't adopted, destroy it", activity->getName().c_str());
+        activity->onDestroy();
+    }
+
+    auto services = std::move(mExistServices);
+    mExistServices.clear();
+    for (size_t i = 0; i < serviceNames.size() && i < serviceTokens.size(); i++) {
+        const auto it = std::find_if(services.begin(), services.end(), [&](const auto& s) {
+            return s->getName() == serviceNames[i];
+        });
+        if (it == services.end()) {
+            am.reportServiceStatus(serviceTokens[i], ServiceClientRecord::DESTROYED);
+            continue;
+        }
+        (*it)->setToken(serviceTokens[i]);
+        mExistServices.push_back(*it);
+        services.erase(it);
+    }
+    for (const auto& service : services) {
+        ALOGW("Service %s isn't adopted, destroy it", service->getName().c_str());
+        service->onDestroy();
+    }
+}
+
 WindowManager* Application::getWindowManager() {
     if (mWindowManager == NULL) {
         mWindowManager = new WindowManager();
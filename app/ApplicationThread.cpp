@@ -40,6 +40,10 @@ namespace app {
 
 using android::binder::Status;
 
+// the attach that comes before the spawn completion gets to the activity manager is retried
+static const int ATTACH_RETRY_NUM = 50;
+static const int ATTACH_RETRY_INTERVAL_MS = 10;
+
 /**
  * IApplicationThread.aidl interface service
  */
@@ -64,6 +68,8 @@ public:
 
     Status scheduleStartService(const string& serviceName, const sp<IBinder>& token,
                                 const Intent& intent);
+    Status scheduleStartServiceBatch(const string& serviceName, const sp<IBinder>& token,
+                                     const std::vector<Intent>& intents);
     Status scheduleStopService(const sp<IBinder>& token);
 
     Status scheduleBindService(const string& serviceName, const sp<IBinder>& token,
@@ -72,7 +78,13 @@ public:
     Status scheduleReceiveIntent(const sp<IBinder>& token, const Intent& intent);
 
     Status setForegroundApplication(bool isForeground);
+    Status setFrozenApplication(bool isFrozen);
+    Status scheduleTrimMemory(int32_t level);
     Status terminateApplication();
+    Status scheduleReattachApplication(const std::vector<string>& activityNames,
+                                       const std::vector<sp<IBinder>>& activityTokens,
+                                       const std::vector<string>& serviceNames,
+                                       const std::vector<sp<IBinder>>& serviceTokens);
 
 private:
     int onLaunchActivity(const string& activityName, const sp<IBinder>& token,
@@ -82,22 +94,39 @@ private:
     int onPauseActivity(const sp<IBinder>& token);
     int onStopActivity(const sp<IBinder>& token);
     int onDestroyActivity(const sp<IBinder>& token);
-    int onStartService(const string& serviceName, const sp<IBinder>& token, const Intent& intent);
+    int onStartService(const string& serviceName, const sp<IBinder>& token,
+                       const std::vector<Intent>& intents);
     int onStopService(const sp<IBinder>& token);
 
-    void onBindService(const string& serviceName, const sp<IBinder>& token, const Intent& intent,
-                       const sp<IServiceConnection>& serviceBinder);
+    void onBindService(const string& serviceName, const sp<IBinder>& token, const Intent& intent);
     void onUnbindService(const sp<IBinder>& token);
 
 private:
     Application* mApp;
 };
 
+class ActivityManagerDeathRecipient : public IBinder::DeathRecipient {
+public:
+    explicit ActivityManagerDeathRecipient(ApplicationThread* thread) : mThread(thread) {}
+
+    void binderDied(const android::wp<IBinder>& who) override {
+        ALOGW("the activity manager died, wait for it to restart");
+        mThread->postDelayTask([this](void*) { mThread->reattachApplication(); },
+                               REATTACH_INTERVAL_MS);
+    }
+
+    static const int REATTACH_INTERVAL_MS = 500;
+
+private:
+    ApplicationThread* mThread;
+};
+
 /**
  * ApplicationThread: Application's main thread
  */
 ApplicationThread::ApplicationThread(Application* app) : mApp(app) {
     mApp->setMainLoop(this);
+    mDeathRecipient = new ActivityManagerDeathRecipient(this);
 }
 
 ApplicationThread::~ApplicationThread() {}
@@ -109,6 +138,69 @@ void ApplicationThread::stop() {
     postDelayTask([this](void*) { UvLoop::stop(); }, 100);
 }
 
+/** The activities go on to the target status, the manager doesn't request the steps */
+static void launchActivities(const sp<ApplicationThreadStub>& appThread,
+                             const std::vector<ActivityLaunch>& launches) {
+    for (const auto& launch : launches) {
+        appThread->scheduleLaunchActivity(launch.mName, launch.mToken, launch.mIntent);
+        if (launch.mTargetStatus >= ActivityClientRecord::STARTED) {
+            appThread->scheduleStartActivity(launch.mToken, std::nullopt);
+        }
+        if (launch.mTargetStatus >= ActivityClientRecord::RESUMED) {
+            appThread->scheduleResumeActivity(launch.mToken, std::nullopt);
+        }
+    }
+}
+
+void ApplicationThread::reattachApplication() {
+    ActivityManager am;
+    std::vector<ActivityLaunch> launches;
+    const int32_t ret = am.attachApplication(mAppThread, launches);
+    if (ret == android::OK) {
+        ALOGW("Application:%s attached again", mApp->getPackageName().c_str());
+        launchActivities(mAppThread, launches);
+        watchActivityManager();
+    } else if (ret == android::BAD_VALUE) {
+        // the restarted activity manager doesn't adopt it, nobody can manage the components
+        ALOGE("Application:%s isn't adopted, stop it", mApp->getPackageName().c_str());
+        stop();
+    } else {
+        postDelayTask([this](void*) { reattachApplication(); },
+                      ActivityManagerDeathRecipient::REATTACH_INTERVAL_MS);
+    }
+}
+
+bool ApplicationThread::attachApplication(const int retry) {
+    ActivityManager am;
+    std::vector<ActivityLaunch> launches;
+    const int32_t ret = am.attachApplication(mAppThread, launches);
+    if (ret == android::WOULD_BLOCK && retry < ATTACH_RETRY_NUM) {
+        // the activity manager doesn't know the pid until the spawn of it completes
+        postDelayTask(
+                [this, retry](void*) {
+                    if (!attachApplication(retry + 1)) {
+                        stop();
+                    }
+                },
+                ATTACH_RETRY_INTERVAL_MS);
+        return true;
+    }
+    if (ret != android::OK) {
+        ALOGE("ApplicationThread attach failure");
+        return false;
+    }
+    launchActivities(mAppThread, launches);
+    watchActivityManager();
+    return true;
+}
+
+void ApplicationThread::watchActivityManager() {
+    ActivityManager am;
+    if (const auto service = am.getService()) {
+        android::IInterface::asBinder(service)->linkToDeath(mDeathRecipient);
+    }
+}
+
 static void signalHandler(uv_signal_t* handle, int signum) {
     ALOGW("warning: receive signal:%d", signum);
     ApplicationThread* appThread = static_cast<ApplicationThread*>(handle->data);
@@ -138,14 +230,12 @@ int ApplicationThread::mainRun(int argc, char** argv) {
         android::IPCThreadState::self()->handlePolledCommands();
     });
 
-    android::sp<ApplicationThreadStub> appThread(new ApplicationThreadStub);
+    mAppThread = new ApplicationThreadStub;
     mApp->setPackageName(argv[1]);
     mApp->onCreate(); /** Application create here */
-    appThread->bind(mApp);
+    mAppThread->bind(mApp);
 
-    ActivityManager am;
-    if (0 != am.attachApplication(appThread)) {
-        ALOGE("ApplicationThread attach failure");
+    if (!attachApplication(0)) {
         return -3;
     }
 
@@ -228,8 +318,8 @@ Status ApplicationThreadStub::scheduleDestroyActivity(const sp<IBinder>& token)
 Status ApplicationThreadStub::scheduleBindService(const string& serviceName,
                                                   const sp<IBinder>& token, const Intent& intent,
                                                   const sp<IServiceConnection>& conn) {
-    ALOGD("scheduleBindService token[%p]", token.get());
-    onBindService(serviceName, token, intent, conn);
+    ALOGD("scheduleBindService token[%p] connection[%p]", token.get(), conn.get());
+    onBindService(serviceName, token, intent);
     return Status::ok();
 }
 
@@ -256,7 +346,16 @@ Status ApplicationThreadStub::scheduleStartService(const string& serviceName,
                                                    const sp<IBinder>& token, const Intent& intent) {
     ALOGD("scheduleStartService package:%s service:%s token[%p]", mApp->getPackageName().c_str(),
           serviceName.c_str(), token.get());
-    onStartService(serviceName, token, intent);
+    onStartService(serviceName, token, {intent});
+    return Status::ok();
+}
+
+Status ApplicationThreadStub::scheduleStartServiceBatch(const string& serviceName,
+                                                        const sp<IBinder>& token,
+                                                        const std::vector<Intent>& intents) {
+    ALOGD("scheduleStartServiceBatch package:%s service:%s token[%p] intents:%zu",
+          mApp->getPackageName().c_str(), serviceName.c_str(), token.get(), intents.size());
+    onStartService(serviceName, token, intents);
     return Status::ok();
 }
 
@@ -293,6 +392,24 @@ Status ApplicationThreadStub::setForegroundApplication(bool isForeground) {
     return Status::ok();
 }
 
+Status ApplicationThreadStub::setFrozenApplication(bool isFrozen) {
+    ALOGD("setFrozenApplication package:%s %s", mApp->getPackageName().c_str(),
+          isFrozen ? "true" : "false");
+    if (isFrozen) {
+        mApp->onFreeze();
+    } else {
+        mApp->onThaw();
+    }
+
+    return Status::ok();
+}
+
+Status ApplicationThreadStub::scheduleTrimMemory(int32_t level) {
+    ALOGI("scheduleTrimMemory package:%s level:%" PRId32, mApp->getPackageName().c_str(), level);
+    mApp->onTrimMemory(level);
+    return Status::ok();
+}
+
 Status ApplicationThreadStub::terminateApplication() {
     ALOGW("terminateApplication package:%s", mApp->getPackageName().c_str());
     // delay clear activity for lifecycle changes
@@ -306,6 +423,15 @@ Status ApplicationThreadStub::terminateApplication() {
     return Status::ok();
 }
 
+Status ApplicationThreadStub::scheduleReattachApplication(
+        const std::vector<string>& activityNames, const std::vector<sp<IBinder>>& activityTokens,
+        const std::vector<string>& serviceNames, const std::vector<sp<IBinder>>& serviceTokens) {
+    ALOGW("scheduleReattachApplication package:%s activities:%zu services:%zu",
+          mApp->getPackageName().c_str(), activityNames.size(), serviceNames.size());
+    mApp->reattach(activityNames, activityTokens, serviceNames, serviceTokens);
+    return Status::ok();
+}
+
 int ApplicationThreadStub::onLaunchActivity(const std::string& activityName,
                                             const sp<IBinder>& token, const Intent& intent) {
     AM_PROFILER_BEGIN();
@@ -395,7 +521,7 @@ int ApplicationThreadStub::onDestroyActivity(const sp<IBinder>& token) {
 }
 
 int ApplicationThreadStub::onStartService(const string& serviceName, const sp<IBinder>& token,
-                                          const Intent& intent) {
+                                          const std::vector<Intent>& intents) {
     AM_PROFILER_BEGIN();
     auto serviceRecord = mApp->findService(token);
     if (!serviceRecord) {
@@ -411,7 +537,7 @@ int ApplicationThreadStub::onStartService(const string& serviceName, const sp<IB
         serviceRecord = std::make_shared<ServiceClientRecord>(serviceName, service);
         mApp->addService(serviceRecord);
     }
-    serviceRecord->onStart(intent);
+    serviceRecord->onStart(intents);
     AM_PROFILER_END();
     return 0;
 }
@@ -428,8 +554,7 @@ int ApplicationThreadStub::onStopService(const sp<IBinder>& token) {
 }
 
 void ApplicationThreadStub::onBindService(const string& serviceName, const sp<IBinder>& token,
-                                          const Intent& intent,
-                                          const sp<IServiceConnection>& conn) {
+                                          const Intent& intent) {
     AM_PROFILER_BEGIN();
     auto serviceRecord = mApp->findService(token);
     if (!serviceRecord) {
@@ -445,7 +570,7 @@ void ApplicationThreadStub::onBindService(const string& serviceName, const sp<IB
         serviceRecord = std::make_shared<ServiceClientRecord>(serviceName, service);
         mApp->addService(serviceRecord);
     }
-    serviceRecord->onBind(intent, conn);
+    serviceRecord->onBind(intent);
     AM_PROFILER_END();
     return;
 }
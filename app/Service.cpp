@@ -38,19 +38,17 @@ void Service::unbind() {
     }
 }
 
-int Service::bind(const Intent& intent, const sp<IServiceConnection>& conn) {
+int Service::bind(const Intent& intent) {
     if (!mIsBinded) {
         /** bind only once */
         mServiceBinder = onBind(intent);
-        getActivityManager().publishService(getToken(), mServiceBinder);
         mIsBinded = true;
     }
-    if (mServiceBinder) {
-        conn->onServiceConnected(mServiceBinder);
-    } else {
+    if (!mServiceBinder) {
         ALOGW("bindService with a null service");
     }
-
+    // the activity manager connects all the connections, it may ask again after a restart
+    getActivityManager().publishService(getToken(), mServiceBinder);
     return 0;
 }
 
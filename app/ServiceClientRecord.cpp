@@ -16,6 +16,8 @@
 
 #include "ServiceClientRecord.h"
 
+#include "app/ContextImpl.h"
+
 namespace os {
 namespace app {
 
@@ -36,24 +38,32 @@ const sp<IBinder>& ServiceClientRecord::getToken() {
     return mService->getToken();
 }
 
+void ServiceClientRecord::setToken(const sp<IBinder>& token) {
+    // the context of a Service is always created by ContextImpl
+    std::static_pointer_cast<ContextImpl>(mService->getContext())->mToken = token;
+}
+
 int32_t ServiceClientRecord::getStatus() {
     return mStatus;
 }
 
-void ServiceClientRecord::onStart(const Intent& intent) {
+void ServiceClientRecord::onStart(const std::vector<Intent>& intents) {
     if (mStatus == CREATING) {
         ALOGD("Service onCreate: %s[%p]", mServiceName.c_str(), mService->getToken().get());
         mService->onCreate();
         reportServiceStatus(CREATED);
     }
-    ALOGD("Service onStart: %s[%p]", mServiceName.c_str(), mService->getToken().get());
-    mService->setIntent(intent);
-    mService->onStartCommand(intent);
+    ALOGD("Service onStart: %s[%p] intents:%zu", mServiceName.c_str(), mService->getToken().get(),
+          intents.size());
+    for (const auto& intent : intents) {
+        mService->setIntent(intent);
+        mService->onStartCommand(intent);
+    }
     mStartFlag |= F_STARTED;
     reportServiceStatus(STARTED);
 }
 
-void ServiceClientRecord::onBind(const Intent& intent, const sp<IServiceConnection>& conn) {
+void ServiceClientRecord::onBind(const Intent& intent) {
     if (mStatus == CREATING) {
         ALOGD("Service onCreate: %s[%p]", mServiceName.c_str(), mService->getToken().get());
         mService->onCreate();
@@ -61,7 +71,7 @@ void ServiceClientRecord::onBind(const Intent& intent, const sp<IServiceConnecti
     }
     ALOGD("Service onBind: %s[%p]", mServiceName.c_str(), mService->getToken().get());
     mService->setIntent(intent);
-    mService->bind(intent, conn);
+    mService->bind(intent);
     mStartFlag |= F_BINDED;
     reportServiceStatus(BINDED);
 }
@@ -45,14 +45,19 @@ public:
         F_BINDED = 0b10,
     };
 
-    void onStart(const Intent& intent);
-    void onBind(const Intent& intent, const sp<IServiceConnection>& conn);
+    /** The coalesced start commands are reported as one start */
+    void onStart(const std::vector<Intent>& intents);
+    void onBind(const Intent& intent);
     void onUnbind();
     void onDestroy();
 
     void handleReceiveIntent(const Intent& intent);
     void reportServiceStatus(const int32_t status);
     const sp<IBinder>& getToken();
+    void setToken(const sp<IBinder>& token);
+    const string& getName() const {
+        return mServiceName;
+    }
     int32_t getStatus();
 
 private:
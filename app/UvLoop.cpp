@@ -16,6 +16,8 @@
 
 #include "app/UvLoop.h"
 
+#include <assert.h>
+
 #include "app/Logger.h"
 
 namespace os {
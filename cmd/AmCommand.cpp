@@ -121,8 +121,14 @@ int AmCommand::postIntent() {
     return mAm.postIntent(intent);
 }
 
-int AmCommand::dump() {
-    const android::Vector<android::String16> args;
+int AmCommand::dump(const char* section) {
+    android::Vector<android::String16> args;
+    if (section) {
+        args.add(String16(section));
+    }
+    for (auto param = nextArg(); param != ""; param = nextArg()) {
+        args.add(String16(param.data()));
+    }
     if (auto service = mAm.getService()) {
         android::IInterface::asBinder(service)->dump(fileno(stdout), args);
         return 0;
@@ -160,6 +166,9 @@ int AmCommand::run(int argc, char *argv[]) {
     if ("dump" == subCommand) {
         return dump();
     }
+    if ("stats" == subCommand) {
+        return dump("stats");
+    }
 
     return showUsage();
 }
@@ -171,7 +180,11 @@ int AmCommand::showUsage() {
     printf(" startservice <INTENT>\n");
     printf(" stopservice  <INTENT>\n");
     printf(" postintent   <INTENT>\n");
-    printf(" dump  :show all Activity task\n");
+    printf(" dump [--json] [--reset] [SECTION]... :show the state of activity manager, --reset "
+           "clears the binder statistics after showing them\n");
+    printf("\t SECTION: tasks|services|apps|lmk|receivers|stats|boot, all sections by default\n");
+    printf(" stats [--json] [--reset] :show the launch and binder statistics, --reset clears the "
+           "binder statistics after showing them\n");
     printf("\n You can make <INTENT> like:\n");
     printf("\t-t \t<TARGET> : '-t' is unnecessary when TARGET as the first param\n");
     printf("\t-a \t<ACTION>\n");
@@ -41,7 +41,7 @@ private:
     int startService();
     int stopService();
     int postIntent();
-    int dump();
+    int dump(const char* section = nullptr);
 
 private:
     ActivityManager mAm;
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2024 Xiaomi Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Generate the C++ interface headers of the AIDL files for the host build.
+
+The host build has no binder driver, so only IFoo.h, BnFoo.h and BpFoo.h are
+generated: the interface is pure virtual, BnFoo is the local binder and the
+proxy is never needed because every call stays in the process.
+
+usage: aidl_stub.py <aidl base dir> <output dir>
+"""
+
+import os
+import re
+import sys
+
+PRIMITIVES = {
+    "boolean": "bool",
+    "byte": "int8_t",
+    "char": "char16_t",
+    "int": "int32_t",
+    "long": "int64_t",
+    "float": "float",
+    "double": "double",
+}
+
+HEADER = """\
+/*
+ * Generated by host/aidl_stub.py from {source}, do not edit.
+ */
+
+#pragma once
+"""
+
+
+def strip_comments(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    return re.sub(r"//[^\n]*", "", text)
+
+
+def parse(base):
+    parcelables = {}  # name -> (package, cpp header)
+    interfaces = {}  # name -> (package, body, source)
+    for root, _, files in os.walk(base):
+        for name in sorted(files):
+            if not name.endswith(".aidl"):
+                continue
+            path = os.path.join(root, name)
+            text = strip_comments(open(path).read())
+            package = re.search(r"package\s+([\w.]+)\s*;", text).group(1)
+            m = re.search(r'parcelable\s+(\w+)\s+cpp_header\s+"([^"]+)"', text)
+            if m:
+                parcelables[m.group(1)] = (package, m.group(2))
+                continue
+            m = re.search(r"interface\s+(\w+)\s*\{(.*)\}", text, re.S)
+            if m:
+                interfaces[m.group(1)] = (package, m.group(2), os.path.relpath(path, base))
+    return parcelables, interfaces
+
+
+def cpp_type(aidl_type, annotations, parcelables, interfaces):
+    nullable = "@nullable" in annotations
+    if aidl_type == "void":
+        return "void"
+    m = re.match(r"List<(\w+)>$", aidl_type) or re.match(r"(\w+)\[\]$", aidl_type)
+    if m:
+        element = cpp_type(m.group(1), annotations.replace("@nullable", ""), parcelables,
+                           interfaces)
+        base = "::std::vector<%s>" % element
+        return "::std::optional<%s>" % base if nullable else base
+    if aidl_type in PRIMITIVES:
+        return PRIMITIVES[aidl_type]
+    if aidl_type == "String":
+        base = "::std::string" if "@utf8InCpp" in annotations else "::android::String16"
+    elif aidl_type == "IBinder":
+        return "::android::sp<::android::IBinder>"
+    elif aidl_type in interfaces:
+        package = interfaces[aidl_type][0]
+        return "::android::sp<::%s::%s>" % (package.replace(".", "::"), aidl_type)
+    elif aidl_type in parcelables:
+        base = "::%s::%s" % (parcelables[aidl_type][0].replace(".", "::"), aidl_type)
+    else:
+        sys.exit("aidl_stub.py: unsupported type " + aidl_type)
+    return "::std::optional<%s>" % base if nullable else base
+
+
+def parse_method(match, parcelables, interfaces):
+    annotations, ret, name, params = match.group(1), match.group(2), match.group(3), match.group(4)
+    args = []
+    for param in [p.strip() for p in params.split(",") if p.strip()]:
+        tokens = param.split()
+        notes = " ".join(t for t in tokens if t.startswith("@"))
+        is_out = "out" in tokens or "inout" in tokens
+        tokens = [t for t in tokens if not t.startswith("@") and t not in ("in", "out", "inout")]
+        ctype = cpp_type(tokens[0], notes, parcelables, interfaces)
+        if is_out:
+            args.append("%s* %s" % (ctype, tokens[1]))
+        elif tokens[0] in PRIMITIVES:
+            args.append("%s %s" % (ctype, tokens[1]))
+        else:
+            args.append("const %s& %s" % (ctype, tokens[1]))
+    if ret != "void":
+        args.append("%s* _aidl_return" % cpp_type(ret, annotations, parcelables, interfaces))
+    return "    virtual ::android::binder::Status %s(%s) = 0;" % (name, ", ".join(args))
+
+
+def generate(base, out):
+    parcelables, interfaces = parse(base)
+    method_re = re.compile(r"((?:@\w+\s+)*)(?:oneway\s+)?([\w.]+)\s+(\w+)\s*\(([^)]*)\)\s*;", re.S)
+    for name, (package, body, source) in interfaces.items():
+        namespaces = package.split(".")
+        directory = os.path.join(out, *namespaces)
+        os.makedirs(directory, exist_ok=True)
+        includes = ["#include <binder/IInterface.h>", "#include <binder/Status.h>"]
+        includes += ['#include "%s"' % header for _, header in sorted(parcelables.values())]
+        includes += ["", "#include <optional>", "#include <string>", "#include <vector>"]
+        for other, (other_package, _, _) in sorted(interfaces.items()):
+            if other != name and re.search(r"\b%s\b" % other, body):
+                includes.insert(2, '#include "%s/%s.h"' % (other_package.replace(".", "/"), other))
+        methods = [parse_method(m, parcelables, interfaces) for m in method_re.finditer(body)]
+        opening = "\n".join("namespace %s {" % n for n in namespaces)
+        closing = "\n".join("} // namespace %s" % n for n in reversed(namespaces))
+
+        with open(os.path.join(directory, name + ".h"), "w") as f:
+            f.write(HEADER.format(source=source))
+            f.write("\n%s\n\n%s\n\n" % ("\n".join(includes), opening))
+            f.write("class %s : public ::android::IInterface {\npublic:\n" % name)
+            f.write("%s\n};\n\n%s\n" % ("\n".join(methods), closing))
+
+        include = '#include "%s/%s.h"' % ("/".join(namespaces), name)
+        with open(os.path.join(directory, "Bn" + name[1:] + ".h"), "w") as f:
+            f.write(HEADER.format(source=source))
+            f.write("\n%s\n\n%s\n\n" % (include, opening))
+            f.write("class Bn%s : public ::android::BnInterface<%s> {};\n" % (name[1:], name))
+            f.write("\n%s\n" % closing)
+        with open(os.path.join(directory, "Bp" + name[1:] + ".h"), "w") as f:
+            f.write(HEADER.format(source=source))
+            f.write("\n%s\n" % include)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    generate(sys.argv[1], sys.argv[2])
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <pm/PackageManager.h>
+
+#include "IntentAction.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+using os::pm::ActivityInfo;
+using os::pm::PackageInfo;
+using os::pm::PackageManager;
+using os::pm::ServiceInfo;
+
+static const std::string BOOT_ACTION = "action.bench.BOOT";
+
+/** Every package has 3 activities and 2 services, all of them listen to BOOT_ACTION */
+static void installPackages(const int num) {
+    PackageManager::clearPackages();
+    for (int i = 0; i < num; i++) {
+        const std::string id = std::to_string(i);
+        PackageInfo info;
+        info.packageName = "bench.app" + id;
+        info.entry = "Main";
+        info.execfile = "/bin/bench.app" + id;
+        for (const char* name : {"Main", "Detail", "Settings"}) {
+            info.activitiesInfo.push_back(
+                    {name, "standard", "", {"action.bench." + id + "." + name, BOOT_ACTION}});
+        }
+        for (const char* name : {"Sync", "Push"}) {
+            info.servicesInfo.push_back(
+                    {name, os::pm::MIDDLE, {"action.bench." + id + "." + name, BOOT_ACTION}});
+        }
+        PackageManager::installPackage(info);
+    }
+}
+
+/** Resolve the action that only the last package has, it's the worst case */
+static void BM_IntentResolveSingle(benchmark::State& state) {
+    const int num = state.range(0);
+    installPackages(num);
+    IntentAction action;
+    const std::string target = "action.bench." + std::to_string(num - 1) + ".Settings";
+    std::string out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+                action.getSingleTargetByAction(target, out, IntentAction::COMP_TYPE_ACTIVITY));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IntentResolveSingle)->RangeMultiplier(4)->Range(4, 256);
+
+/** Resolve the broadcast action that every service listens to */
+static void BM_IntentResolveMulti(benchmark::State& state) {
+    installPackages(state.range(0));
+    IntentAction action;
+    for (auto _ : state) {
+        std::vector<IntentTarget> targets;
+        action.getMultiTargetByAction(BOOT_ACTION, targets, IntentAction::COMP_TYPE_SERVICE);
+        benchmark::DoNotOptimize(targets.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IntentResolveMulti)->RangeMultiplier(4)->Range(4, 256);
+
+static void setQueryCounter(benchmark::State& state, const uint64_t begin) {
+    state.counters["pmQueries"] = benchmark::Counter(PackageManager::getQueryCount() - begin,
+                                                     benchmark::Counter::kAvgIterations);
+}
+
+/** The fan-out of a broadcast before the batched path: a PackageInfo copy for each target */
+static void BM_FanoutPerTarget(benchmark::State& state) {
+    installPackages(state.range(0));
+    IntentAction action;
+    PackageManager pm;
+    const uint64_t begin = PackageManager::getQueryCount();
+    for (auto _ : state) {
+        std::vector<IntentTarget> targets;
+        action.getMultiTargetByAction(BOOT_ACTION, targets, IntentAction::COMP_TYPE_SERVICE);
+        std::vector<PackageInfo> packageInfoList;
+        for (const auto& target : targets) {
+            PackageInfo packageInfo;
+            pm.getPackageInfo(target.packageInfo->packageName, &packageInfo);
+            packageInfoList.push_back(packageInfo);
+        }
+        // the launch loop took another copy of each one
+        for (const auto& packageInfo : packageInfoList) {
+            PackageInfo info = packageInfo;
+            benchmark::DoNotOptimize(info.servicesInfo.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    setQueryCounter(state, begin);
+}
+BENCHMARK(BM_FanoutPerTarget)->RangeMultiplier(4)->Range(4, 256);
+
+/** The fan-out by a single query, the components of a package share its PackageInfo */
+static void BM_FanoutBatched(benchmark::State& state) {
+    installPackages(state.range(0));
+    IntentAction action;
+    const uint64_t begin = PackageManager::getQueryCount();
+    for (auto _ : state) {
+        std::vector<IntentTarget> targets;
+        action.getMultiTargetByAction(BOOT_ACTION, targets, IntentAction::COMP_TYPE_SERVICE);
+        for (const auto& target : targets) {
+            benchmark::DoNotOptimize(target.packageInfo->servicesInfo.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    setQueryCounter(state, begin);
+}
+BENCHMARK(BM_FanoutBatched)->RangeMultiplier(4)->Range(4, 256);
+
+} // namespace host
+} // namespace am
+} // namespace os
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "ActivityRecord.h"
+#include "AppRecord.h"
+#include "NullApplicationThread.h"
+#include "TaskBoard.h"
+#include "TaskManager.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+/** The application side is played by the benchmark, the requests are only counted */
+class FakeApplicationThread : public NullApplicationThread {
+public:
+    uint64_t getCallCount() const {
+        return mCallCount;
+    }
+
+protected:
+    Status onRequest() override {
+        mCallCount++;
+        return Status::ok();
+    }
+
+private:
+    uint64_t mCallCount = 0;
+};
+
+/** The activity lifecycle driven by ActivityRecord, the application reports at once */
+class LifecycleFixture {
+public:
+    LifecycleFixture() {
+        // debug mode, the lifecycle tasks never timeout and the looper isn't used
+        mTaskBoard.setDebugMode(true);
+        mTaskBoard.startWork(nullptr);
+        mAppThread = new FakeApplicationThread();
+        mApp = std::make_shared<AppRecord>(mAppThread, "bench.app", false, 1, 1, nullptr,
+                                           nullptr);
+    }
+
+    ActivityHandler newActivity(const std::string& name) {
+        auto activity = std::make_shared<ActivityRecord>("bench.app/" + name, nullptr, -1,
+                                                         ActivityRecord::STANDARD, nullptr,
+                                                         Intent(), nullptr, &mTaskManager,
+                                                         &mTaskBoard);
+        activity->setAppThread(mApp);
+        return activity;
+    }
+
+    void report(const ActivityHandler& activity, const ActivityRecord::Status status) {
+        mTaskBoard.eventTrigger(ActivityLifeCycleTask::Event(status, activity->getToken()));
+    }
+
+    void moveTo(const ActivityHandler& activity, const ActivityRecord::Status status,
+                std::initializer_list<ActivityRecord::Status> reports) {
+        activity->lifecycleTransition(status);
+        for (const auto report : reports) {
+            this->report(activity, report);
+        }
+    }
+
+    TaskBoard mTaskBoard;
+    ITaskManager mTaskManager;
+    sp<FakeApplicationThread> mAppThread;
+    std::shared_ptr<AppRecord> mApp;
+};
+
+/** create -> resume -> pause -> stop -> destroy */
+static void BM_ActivityLifecycle(benchmark::State& state) {
+    LifecycleFixture fixture;
+    for (auto _ : state) {
+        auto activity = fixture.newActivity("Main");
+        fixture.moveTo(activity, ActivityRecord::RESUMED,
+                       {ActivityRecord::CREATED, ActivityRecord::STARTED,
+                        ActivityRecord::RESUMED});
+        fixture.moveTo(activity, ActivityRecord::PAUSED, {ActivityRecord::PAUSED});
+        fixture.moveTo(activity, ActivityRecord::STOPPED, {ActivityRecord::STOPPED});
+        fixture.moveTo(activity, ActivityRecord::DESTROYED, {ActivityRecord::DESTROYED});
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["appCalls"] = benchmark::Counter(fixture.mAppThread->getCallCount(),
+                                                    benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ActivityLifecycle);
+
+/** Switch between two resumed activities, the next one is resumed after the previous paused */
+static void BM_ActivitySwitch(benchmark::State& state) {
+    LifecycleFixture fixture;
+    ActivityHandler current = fixture.newActivity("A");
+    ActivityHandler next = fixture.newActivity("B");
+    fixture.moveTo(current, ActivityRecord::RESUMED,
+                   {ActivityRecord::CREATED, ActivityRecord::STARTED, ActivityRecord::RESUMED});
+    fixture.moveTo(next, ActivityRecord::STOPPED,
+                   {ActivityRecord::CREATED, ActivityRecord::STARTED, ActivityRecord::STOPPED});
+    for (auto _ : state) {
+        current->lifecycleTransition(ActivityRecord::PAUSED);
+        next->setResumeAfterPause(current);
+        next->lifecycleTransition(ActivityRecord::RESUMED);
+        fixture.report(next, ActivityRecord::STARTED);
+        fixture.report(current, ActivityRecord::PAUSED);
+        fixture.report(next, ActivityRecord::RESUMED);
+        fixture.moveTo(current, ActivityRecord::STOPPED, {ActivityRecord::STOPPED});
+        std::swap(current, next);
+    }
+    if (current->getStatus() != ActivityRecord::RESUMED ||
+        next->getStatus() != ActivityRecord::STOPPED) {
+        state.SkipWithError("the activities aren't switched");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ActivitySwitch);
+
+} // namespace host
+} // namespace am
+} // namespace os
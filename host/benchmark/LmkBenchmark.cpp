@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "LowMemoryManager.h"
+#include "ProcessPriorityPolicy.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+using os::pm::ProcessPriority;
+
+static const ProcessPriority priorities[] = {ProcessPriority::LOW, ProcessPriority::MIDDLE,
+                                             ProcessPriority::MIDDLE, ProcessPriority::HIGH};
+
+/** N processes, every 4th one is bound by its previous one */
+static void addProcesses(ProcessPriorityPolicy& policy, const int num) {
+    for (pid_t pid = 1; pid <= num; pid++) {
+        policy.add(pid, false, priorities[pid % 4]);
+        if (pid % 4 == 0) {
+            policy.bindProcess(pid - 1, pid);
+        }
+    }
+}
+
+/** Bring the next process to foreground and score all of them, like an app switch */
+static void BM_LmkScoring(benchmark::State& state) {
+    const int num = state.range(0);
+    LowMemoryManager lmk;
+    ProcessPriorityPolicy policy(&lmk);
+    addProcesses(policy, num);
+    pid_t pid = 1;
+    for (auto _ : state) {
+        policy.intoBackground(pid);
+        pid = pid % num + 1;
+        policy.pushForeground(pid);
+        policy.analyseProcessPriority();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LmkScoring)->RangeMultiplier(4)->Range(4, 256);
+
+/** The memory is at the lowest level, all the background processes are selected and killed */
+static void BM_LmkExecute(benchmark::State& state) {
+    const int num = state.range(0);
+    auto looper = std::make_shared<os::app::UvLoop>();
+    LowMemoryManager lmk;
+    lmk.init(looper);
+    int64_t killed = 0;
+    lmk.setLMKExecutor([&killed](pid_t pid) { killed++; });
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (pid_t pid = 1; pid <= num; pid++) {
+            lmk.setPidOomScore(pid, OS_MIDDLE_LEVEL_MIN_ADJ + pid);
+        }
+        state.ResumeTiming();
+        lmk.executeLMK(100);
+    }
+    state.SetItemsProcessed(killed);
+    looper->stop();
+    looper->run();
+    looper->close();
+}
+BENCHMARK(BM_LmkExecute)->RangeMultiplier(4)->Range(4, 256);
+
+} // namespace host
+} // namespace am
+} // namespace os
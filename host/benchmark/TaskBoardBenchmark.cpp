@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "TaskBoard.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+class CountTask : public Task {
+public:
+    CountTask(const int id, int64_t& executed) : Task(id), mExecuted(executed) {}
+    void execute(const Label& e) override {
+        mExecuted++;
+    }
+
+private:
+    int64_t& mExecuted;
+};
+
+/**
+ * N tasks are waiting, e.g. the lifecycle reports of N activities, the events arrive in the
+ * reverse order, so the latest task is found at last.
+ */
+static void BM_TaskBoardDispatch(benchmark::State& state) {
+    const int num = state.range(0);
+    auto looper = std::make_shared<os::app::UvLoop>();
+    int64_t executed = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto taskBoard = std::make_unique<TaskBoard>();
+        // the timeout checking timer is out of the measurement
+        taskBoard->setDebugMode(true);
+        taskBoard->startWork(looper);
+        state.ResumeTiming();
+
+        for (int i = 0; i < num; i++) {
+            taskBoard->commitTask(std::make_shared<CountTask>(i, executed), REQUEST_TIMEOUT_MS);
+        }
+        for (int i = num - 1; i >= 0; i--) {
+            taskBoard->eventTrigger(Label(i));
+        }
+
+        state.PauseTiming();
+        taskBoard.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(executed);
+    looper->stop();
+    looper->run();
+    looper->close();
+}
+BENCHMARK(BM_TaskBoardDispatch)->RangeMultiplier(4)->Range(4, 1024);
+
+} // namespace host
+} // namespace am
+} // namespace os
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the window of a component, it only keeps its layout, nothing is drawn.
+
+#include <wm/LayoutParams.h>
+
+namespace os {
+namespace wm {
+
+class BaseWindow {
+public:
+    void setType(int32_t type) {
+        mLayoutParams.mType = type;
+    }
+    LayoutParams getLayoutParams() const {
+        return mLayoutParams;
+    }
+    void setLayoutParams(const LayoutParams& layoutParams) {
+        mLayoutParams = layoutParams;
+    }
+    void* getRoot() {
+        return nullptr;
+    }
+    void setVisible(bool isVisible) {
+        mLayoutParams.mVisibility =
+                isVisible ? LayoutParams::WINDOW_VISIBLE : LayoutParams::WINDOW_INVISIBLE;
+    }
+
+private:
+    LayoutParams mLayoutParams;
+};
+
+} // namespace wm
+} // namespace os
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// The host build replaces the posix_spawn of AppSpawn, the host program plays the processes.
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace os {
+namespace app {
+namespace host {
+
+/** Return the pid of the new process, or a negative errno */
+using SpawnHandler =
+        std::function<int(const std::string& execfile, const std::vector<std::string>& args)>;
+
+/**
+ * Without the handler, the spawned process is only a pid that never attaches.
+ * The fake pids are above PID_MAX_LIMIT, the signals to them never reach a real process.
+ */
+void setSpawnHandler(const SpawnHandler& handler);
+int allocFakePid();
+
+/** The process exits, activity manager is notified like SIGCHLD is received */
+void exitProcess(int pid);
+
+} // namespace host
+} // namespace app
+} // namespace os
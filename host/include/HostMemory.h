@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// The host mallinfo() reports the memory of the machine, the harness can replace it to play
+// a device under memory pressure.
+
+#include <malloc.h>
+
+#include <functional>
+
+namespace os {
+namespace am {
+namespace host {
+
+using MallinfoHook = std::function<struct mallinfo()>;
+
+/**
+ * LowMemoryManager reads the total memory at init, so install the hook before the activity
+ * manager is created. An empty hook restores the machine memory.
+ */
+void setMallinfoHook(const MallinfoHook& hook);
+
+} // namespace host
+} // namespace am
+} // namespace os
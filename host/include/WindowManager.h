@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the window manager of the application, every window is attached at once.
+
+#include <memory>
+
+#include "BaseWindow.h"
+
+namespace os {
+namespace app {
+class Context;
+} // namespace app
+
+namespace wm {
+
+class WindowManager {
+public:
+    std::shared_ptr<BaseWindow> newWindow(::os::app::Context* context) {
+        return std::make_shared<BaseWindow>();
+    }
+    int32_t attachIWindow(const std::shared_ptr<BaseWindow>& window) {
+        return window ? 0 : -1;
+    }
+    void removeWindow(const std::shared_ptr<BaseWindow>& window) {}
+};
+
+} // namespace wm
+} // namespace os
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: every binder is a local object, the calls never leave the process.
+
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include <utils/RefBase.h>
+#include <utils/String16.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class BBinder;
+
+class IBinder : public virtual RefBase {
+public:
+    class DeathRecipient : public virtual RefBase {
+    public:
+        virtual void binderDied(const wp<IBinder>& who) = 0;
+    };
+
+    // the local binder never dies, like BBinder of libbinder
+    virtual status_t linkToDeath(const sp<DeathRecipient>& recipient, void* cookie = nullptr,
+                                 uint32_t flags = 0) {
+        return INVALID_OPERATION;
+    }
+    virtual status_t unlinkToDeath(const wp<DeathRecipient>& recipient, void* cookie = nullptr,
+                                   uint32_t flags = 0, wp<DeathRecipient>* outRecipient = nullptr) {
+        return INVALID_OPERATION;
+    }
+    virtual BBinder* localBinder() {
+        return nullptr;
+    }
+    virtual bool isBinderAlive() const {
+        return true;
+    }
+    virtual status_t dump(int fd, const Vector<String16>& args) {
+        return OK;
+    }
+};
+
+class BBinder : public IBinder {
+public:
+    BBinder* localBinder() override {
+        return this;
+    }
+};
+
+} // namespace android
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Binder.h>
+
+namespace android {
+
+class IInterface : public virtual RefBase {
+public:
+    static sp<IBinder> asBinder(const IInterface* iface) {
+        return iface ? const_cast<IInterface*>(iface)->onAsBinder() : nullptr;
+    }
+    static sp<IBinder> asBinder(const sp<IInterface>& iface) {
+        return asBinder(iface.get());
+    }
+
+protected:
+    virtual IBinder* onAsBinder() = 0;
+};
+
+/** The local implementation of the interface is the binder itself */
+template <typename INTERFACE>
+class BnInterface : public INTERFACE, public BBinder {
+protected:
+    IBinder* onAsBinder() override {
+        return this;
+    }
+};
+
+} // namespace android
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the calling identity is per thread, the fake application sets it before calling
+// the service, like the binder driver does for the incoming transaction.
+
+#include <binder/IBinder.h>
+#include <sys/types.h>
+
+namespace android {
+
+class IPCThreadState {
+public:
+    static IPCThreadState* self();
+
+    pid_t getCallingPid() const {
+        return mCallingPid;
+    }
+    uid_t getCallingUid() const {
+        return mCallingUid;
+    }
+
+    /** Return the token of the current identity, and then the caller is this process */
+    int64_t clearCallingIdentity();
+    /** The token is ((int64_t)uid << 32) | pid */
+    void restoreCallingIdentity(int64_t token);
+
+    void flushCommands() {}
+    /** There is no binder driver, the fd is -1, the calls are made in the process */
+    status_t setupPolling(int* fd);
+    status_t handlePolledCommands();
+
+private:
+    IPCThreadState();
+
+    pid_t mCallingPid;
+    uid_t mCallingUid;
+};
+
+} // namespace android
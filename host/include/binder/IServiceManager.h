@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: there is no service manager, the host program registers the services that run in
+// it, and the clients get the local binder itself.
+
+#include <binder/IInterface.h>
+#include <utils/String16.h>
+
+namespace android {
+
+status_t addService(const String16& name, const sp<IBinder>& service);
+sp<IBinder> checkService(const String16& name);
+
+template <typename INTERFACE>
+status_t getService(const String16& name, sp<INTERFACE>* outService) {
+    const sp<IBinder> binder = checkService(name);
+    INTERFACE* service = binder ? dynamic_cast<INTERFACE*>(binder.get()) : nullptr;
+    *outService = service;
+    return service ? NO_ERROR : NAME_NOT_FOUND;
+}
+
+} // namespace android
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: a flat buffer, it's enough to marshal the parcelables of AMS in a round trip. The
+// binders are kept aside, the buffer holds their index.
+
+#include <binder/IBinder.h>
+
+#include <string>
+#include <vector>
+
+namespace android {
+
+class Parcel {
+public:
+    status_t writeInt32(int32_t value);
+    status_t writeUint32(uint32_t value);
+    status_t writeInt64(int64_t value);
+    status_t writeBool(bool value);
+    status_t writeDouble(double value);
+    status_t writeUtf8AsUtf16(const std::string& str);
+    status_t writeStrongBinder(const sp<IBinder>& binder);
+
+    status_t readInt32(int32_t* value) const;
+    status_t readUint32(uint32_t* value) const;
+    status_t readInt64(int64_t* value) const;
+    status_t readBool(bool* value) const;
+    status_t readDouble(double* value) const;
+    status_t readUtf8FromUtf16(std::string* str) const;
+    status_t readStrongBinder(sp<IBinder>* binder) const;
+
+    size_t dataSize() const {
+        return mData.size();
+    }
+    void setDataPosition(size_t pos) const {
+        mPosition = pos;
+    }
+
+private:
+    status_t write(const void* data, size_t len);
+    status_t read(void* data, size_t len) const;
+
+    std::vector<uint8_t> mData;
+    std::vector<sp<IBinder>> mObjects;
+    mutable size_t mPosition = 0;
+};
+
+class Parcelable {
+public:
+    virtual ~Parcelable() = default;
+    virtual status_t readFromParcel(const Parcel* parcel) = 0;
+    virtual status_t writeToParcel(Parcel* parcel) const = 0;
+};
+
+} // namespace android
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Parcel.h>
+
+#include <map>
+
+namespace android {
+namespace os {
+
+class PersistableBundle : public Parcelable {
+public:
+    void putBoolean(const String16& key, bool value) {
+        mBools[key] = value;
+    }
+    void putInt(const String16& key, int32_t value) {
+        mInts[key] = value;
+    }
+    void putLong(const String16& key, int64_t value) {
+        mLongs[key] = value;
+    }
+    void putDouble(const String16& key, double value) {
+        mDoubles[key] = value;
+    }
+    void putString(const String16& key, const String16& value) {
+        mStrings[key] = value;
+    }
+
+    bool getBoolean(const String16& key, bool* out) const {
+        return get(mBools, key, out);
+    }
+    bool getInt(const String16& key, int32_t* out) const {
+        return get(mInts, key, out);
+    }
+    bool getLong(const String16& key, int64_t* out) const {
+        return get(mLongs, key, out);
+    }
+    bool getDouble(const String16& key, double* out) const {
+        return get(mDoubles, key, out);
+    }
+    bool getString(const String16& key, String16* out) const {
+        return get(mStrings, key, out);
+    }
+
+    size_t size() const {
+        return mBools.size() + mInts.size() + mLongs.size() + mDoubles.size() + mStrings.size();
+    }
+    bool empty() const {
+        return size() == 0;
+    }
+
+    status_t readFromParcel(const Parcel* parcel) override;
+    status_t writeToParcel(Parcel* parcel) const override;
+
+private:
+    template <typename T>
+    static bool get(const std::map<String16, T>& map, const String16& key, T* out) {
+        const auto it = map.find(key);
+        if (it == map.end()) {
+            return false;
+        }
+        *out = it->second;
+        return true;
+    }
+
+    std::map<String16, bool> mBools;
+    std::map<String16, int32_t> mInts;
+    std::map<String16, int64_t> mLongs;
+    std::map<String16, double> mDoubles;
+    std::map<String16, String16> mStrings;
+};
+
+} // namespace os
+} // namespace android
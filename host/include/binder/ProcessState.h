@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: there is no binder driver and no binder thread, the calls are made in the process.
+
+#include <utils/RefBase.h>
+
+namespace android {
+
+class ProcessState : public virtual RefBase {
+public:
+    static sp<ProcessState> self() {
+        static sp<ProcessState> state = new ProcessState();
+        return state;
+    }
+
+    void startThreadPool() {}
+};
+
+} // namespace android
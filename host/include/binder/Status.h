@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utils/Errors.h>
+#include <utils/String8.h>
+
+#include <string>
+
+namespace android {
+namespace binder {
+
+class Status {
+public:
+    enum Exception {
+        EX_NONE = 0,
+        EX_ILLEGAL_ARGUMENT = -3,
+        EX_ILLEGAL_STATE = -5,
+        EX_TRANSACTION_FAILED = -129,
+    };
+
+    static Status ok() {
+        return Status();
+    }
+    static Status fromExceptionCode(int32_t exceptionCode) {
+        return Status(exceptionCode, OK);
+    }
+    static Status fromStatusT(status_t status) {
+        return status == OK ? Status() : Status(EX_TRANSACTION_FAILED, status);
+    }
+
+    bool isOk() const {
+        return mException == EX_NONE;
+    }
+    int32_t exceptionCode() const {
+        return mException;
+    }
+    status_t transactionError() const {
+        return mException == EX_TRANSACTION_FAILED ? mErrorCode : OK;
+    }
+    String8 toString8() const {
+        return String8(isOk() ? "No error"
+                              : ("exception:" + std::to_string(mException) +
+                                 " error:" + std::to_string(mErrorCode))
+                                        .c_str());
+    }
+
+private:
+    Status() = default;
+    Status(int32_t exception, status_t errorCode) : mException(exception), mErrorCode(errorCode) {}
+
+    int32_t mException = EX_NONE;
+    status_t mErrorCode = OK;
+};
+
+} // namespace binder
+} // namespace android
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the properties are kept in memory, the host program sets them before running.
+
+#include <stdint.h>
+
+#define PROP_VALUE_MAX 92
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int property_set(const char* key, const char* value);
+int property_get(const char* key, char* value, const char* defaultValue);
+int8_t property_get_bool(const char* key, int8_t defaultValue);
+int32_t property_get_int32(const char* key, int32_t defaultValue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: mallinfo of NuttX, the heap is the whole memory of the device. On the host the
+// system memory is reported, see stubs/Malloc.cpp.
+
+#define mallinfo glibc_mallinfo
+#include_next <malloc.h>
+#undef mallinfo
+
+struct mallinfo {
+    int arena;    // total space of the heap
+    int ordblks;  // number of free chunks
+    int mxordblk; // largest free chunk
+    int uordblks; // total allocated space
+    int fordblks; // total free space
+};
+
+struct mallinfo mallinfo(void);
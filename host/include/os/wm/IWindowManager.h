@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the part of the window manager interface that activity manager calls.
+
+#include <binder/IInterface.h>
+#include <binder/Status.h>
+
+namespace os {
+namespace wm {
+
+class IWindowManager : public ::android::IInterface {
+public:
+    virtual ::android::binder::Status addWindowToken(const ::android::sp<::android::IBinder>& token,
+                                                     int32_t type, int32_t displayId) = 0;
+    virtual ::android::binder::Status removeWindowToken(
+            const ::android::sp<::android::IBinder>& token, int32_t displayId) = 0;
+    virtual ::android::binder::Status updateWindowTokenVisibility(
+            const ::android::sp<::android::IBinder>& token, int32_t visibility) = 0;
+};
+
+} // namespace wm
+} // namespace os
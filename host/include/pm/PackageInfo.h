@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the package description fields that activity manager reads.
+
+#include <string>
+#include <vector>
+
+namespace os {
+namespace pm {
+
+enum ProcessPriority {
+    LOW = 0,
+    MIDDLE,
+    HIGH,
+    PERSISTENT,
+};
+
+struct ActivityInfo {
+    std::string name;
+    std::string launchMode;
+    std::string taskAffinity;
+    std::vector<std::string> actions;
+};
+
+struct ServiceInfo {
+    std::string name;
+    int priority = MIDDLE;
+    std::vector<std::string> actions;
+    std::string startMode; // "latest" or "append" coalesces the start commands
+};
+
+struct PackageInfo {
+    std::string packageName;
+    std::string entry;
+    std::string execfile;
+    std::string appType;
+    bool isSystemUI = false;
+    int priority = MIDDLE;
+    std::vector<ActivityInfo> activitiesInfo;
+    std::vector<ServiceInfo> servicesInfo;
+};
+
+} // namespace pm
+} // namespace os
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the packages are installed into the process by the host program.
+
+#include <pm/PackageInfo.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace os {
+namespace pm {
+
+class PackageManager {
+public:
+    int getPackageInfo(const std::string& packageName, PackageInfo* info);
+    int getAllPackageInfo(std::vector<PackageInfo>* infoList);
+
+    /** Host only, the package is replaced if it exists */
+    static void installPackage(const PackageInfo& info);
+    static void clearPackages();
+    /** Host only, the queries that are binder calls on the device */
+    static uint64_t getQueryCount();
+};
+
+} // namespace pm
+} // namespace os
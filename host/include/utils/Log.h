@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the AMS sources redefine ALOGx by "app/Logger.h", this is for the rest.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef ALOGD
+#define ALOGD(fmt, ...) ((void)0)
+#endif
+#ifndef ALOGI
+#define ALOGI(fmt, ...) ((void)0)
+#endif
+#ifndef ALOGW
+#define ALOGW(fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#endif
+#ifndef ALOGE
+#define ALOGE(fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#endif
+
+#define ALOG_ASSERT(cond, ...) assert(cond)
+#define LOG_ALWAYS_FATAL_IF(cond, ...) \
+    if (cond) {                        \
+        abort();                       \
+    }
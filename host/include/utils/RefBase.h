@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: strong reference counting only, wp is a plain pointer for the signatures.
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <utility>
+
+#include "utils/Errors.h"
+
+namespace android {
+
+class RefBase {
+public:
+    void incStrong(const void* id) const {
+        mStrong.fetch_add(1, std::memory_order_relaxed);
+    }
+    void decStrong(const void* id) const {
+        if (mStrong.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+    int32_t getStrongCount() const {
+        return mStrong.load(std::memory_order_relaxed);
+    }
+
+protected:
+    RefBase() = default;
+    virtual ~RefBase() = default;
+
+private:
+    RefBase(const RefBase&) = delete;
+    RefBase& operator=(const RefBase&) = delete;
+
+    mutable std::atomic<int32_t> mStrong{0};
+};
+
+template <typename T>
+class sp {
+public:
+    sp() : mPtr(nullptr) {}
+    sp(std::nullptr_t) : mPtr(nullptr) {}
+    sp(T* other) : mPtr(other) {
+        if (mPtr) mPtr->incStrong(this);
+    }
+    sp(const sp<T>& other) : sp(other.mPtr) {}
+    sp(sp<T>&& other) noexcept : mPtr(other.mPtr) {
+        other.mPtr = nullptr;
+    }
+    template <typename U>
+    sp(const sp<U>& other) : sp(other.get()) {}
+    ~sp() {
+        if (mPtr) mPtr->decStrong(this);
+    }
+
+    template <typename... Args>
+    static sp<T> make(Args&&... args) {
+        return sp<T>(new T(std::forward<Args>(args)...));
+    }
+    template <typename U>
+    static sp<T> cast(const sp<U>& other) {
+        return sp<T>(static_cast<T*>(other.get()));
+    }
+
+    sp& operator=(const sp<T>& other) {
+        sp<T>(other).swap(*this);
+        return *this;
+    }
+    sp& operator=(sp<T>&& other) noexcept {
+        sp<T>(std::move(other)).swap(*this);
+        return *this;
+    }
+    sp& operator=(T* other) {
+        sp<T>(other).swap(*this);
+        return *this;
+    }
+    template <typename U>
+    sp& operator=(const sp<U>& other) {
+        sp<T>(other).swap(*this);
+        return *this;
+    }
+
+    void clear() {
+        sp<T>().swap(*this);
+    }
+    void swap(sp<T>& other) {
+        std::swap(mPtr, other.mPtr);
+    }
+
+    T* get() const {
+        return mPtr;
+    }
+    T* operator->() const {
+        return mPtr;
+    }
+    T& operator*() const {
+        return *mPtr;
+    }
+    explicit operator bool() const {
+        return mPtr != nullptr;
+    }
+
+private:
+    T* mPtr;
+};
+
+template <typename T>
+class wp {
+public:
+    wp() : mPtr(nullptr) {}
+    wp(T* other) : mPtr(other) {}
+    wp(const sp<T>& other) : mPtr(other.get()) {}
+
+    T* unsafe_get() const {
+        return mPtr;
+    }
+
+private:
+    T* mPtr;
+};
+
+template <typename T, typename U>
+bool operator==(const sp<T>& a, const sp<U>& b) {
+    return (const void*)a.get() == (const void*)b.get();
+}
+template <typename T, typename U>
+bool operator!=(const sp<T>& a, const sp<U>& b) {
+    return !(a == b);
+}
+template <typename T, typename U>
+bool operator<(const sp<T>& a, const sp<U>& b) {
+    return (const void*)a.get() < (const void*)b.get();
+}
+template <typename T>
+bool operator==(const sp<T>& a, std::nullptr_t) {
+    return a.get() == nullptr;
+}
+template <typename T>
+bool operator!=(const sp<T>& a, std::nullptr_t) {
+    return a.get() != nullptr;
+}
+
+} // namespace android
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Host stub: the text is kept as utf-8, the AMS core only passes the strings through.
+
+#include <string>
+
+namespace android {
+
+class String16 {
+public:
+    String16() = default;
+    String16(const char* str) : mStr(str) {}
+    explicit String16(const std::string& str) : mStr(str) {}
+
+    size_t size() const {
+        return mStr.size();
+    }
+    bool operator==(const String16& other) const {
+        return mStr == other.mStr;
+    }
+    bool operator!=(const String16& other) const {
+        return mStr != other.mStr;
+    }
+    bool operator<(const String16& other) const {
+        return mStr < other.mStr;
+    }
+    const std::string& utf8() const {
+        return mStr;
+    }
+
+private:
+    std::string mStr;
+};
+
+} // namespace android
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "utils/String16.h"
+
+namespace android {
+
+class String8 {
+public:
+    String8() = default;
+    String8(const char* str) : mStr(str) {}
+    explicit String8(const String16& str) : mStr(str.utf8()) {}
+
+    const char* c_str() const {
+        return mStr.c_str();
+    }
+    const char* string() const {
+        return mStr.c_str();
+    }
+    size_t size() const {
+        return mStr.size();
+    }
+    size_t length() const {
+        return mStr.size();
+    }
+
+private:
+    std::string mStr;
+};
+
+} // namespace android
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <vector>
+
+namespace android {
+
+template <typename T>
+class Vector {
+public:
+    size_t size() const {
+        return mItems.size();
+    }
+    bool isEmpty() const {
+        return mItems.empty();
+    }
+    const T& operator[](size_t index) const {
+        return mItems[index];
+    }
+    const T& itemAt(size_t index) const {
+        return mItems[index];
+    }
+    ssize_t add(const T& item) {
+        mItems.push_back(item);
+        return mItems.size() - 1;
+    }
+
+private:
+    std::vector<T> mItems;
+};
+
+} // namespace android
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace os {
+namespace wm {
+
+class LayoutParams {
+public:
+    enum {
+        TYPE_APPLICATION = 1,
+        TYPE_DIALOG = 1000,
+        TYPE_SYSTEM_WINDOW = 2000,
+    };
+
+    enum {
+        WINDOW_VISIBLE = 0,
+        WINDOW_INVISIBLE = 4,
+        WINDOW_GONE = 8,
+    };
+
+    int32_t mType = TYPE_APPLICATION;
+    int32_t mVisibility = WINDOW_VISIBLE;
+    int32_t mX = 0;
+    int32_t mY = 0;
+    int32_t mWidth = 0;
+    int32_t mHeight = 0;
+};
+
+} // namespace wm
+} // namespace os
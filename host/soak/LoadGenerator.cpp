@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadGenerator.h"
+
+#include <binder/IPCThreadState.h>
+#include <kvdb.h>
+#include <limits.h>
+#include <pm/PackageManager.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "HostAppSpawn.h"
+#include "HostMemory.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+using os::pm::PackageInfo;
+using os::pm::PackageManager;
+
+static const uint64_t TICK_MS = 10;
+// the warm-up and the drain take at most a fifth of the duration each
+static const uint64_t WARMUP_MS = 1000;
+static const uint64_t DRAIN_MS = 1000;
+
+const std::string LoadGenerator::FANOUT_ACTION = "action.soak.FANOUT";
+
+uint64_t SoakReport::percentile(double p) const {
+    if (latencyUs.empty()) {
+        return 0;
+    }
+    const size_t index = std::min(latencyUs.size() - 1, (size_t)(latencyUs.size() * p));
+    return latencyUs[index];
+}
+
+LoadGenerator::LoadGenerator(const SoakOptions& options)
+      : mOptions(options), mRandom(options.seed), mScenario(nullptr) {
+    if (mOptions.totalMemoryKb == 0) {
+        // the memory is never under pressure
+        mOptions.totalMemoryKb = (mOptions.appNum + 1) * mOptions.behavior.memoryKb * 4;
+    }
+    installPackages();
+    // the boot guide isn't part of the load
+    property_set("persist.global.system.usersetup_complete", "1");
+    setMallinfoHook([this]() { return getMemoryInfo(); });
+    os::app::host::setSpawnHandler(
+            [this](const std::string& execfile, const std::vector<std::string>& args) {
+                const pid_t pid = os::app::host::allocFakePid();
+                const sp<SoakApplication> app(new SoakApplication(this, pid, args[0]));
+                mProcesses.emplace(pid, app);
+                mReport.spawned++;
+                app->start();
+                return pid;
+            });
+    mDumpFd = memfd_create("amsoak", 0);
+    mLooper = std::make_unique<os::app::UvLoop>();
+    mService = new ActivityManagerService(mLooper->get());
+}
+
+LoadGenerator::~LoadGenerator() {
+    // the processes in flight never reply to the service that is going away
+    for (auto& [pid, app] : mProcesses) {
+        app->exit();
+    }
+    mProcesses.clear();
+    mService.clear();
+    os::app::host::setSpawnHandler(nullptr);
+    setMallinfoHook(nullptr);
+    close(mDumpFd);
+
+    mLooper->stop();
+    mLooper->run(UV_RUN_NOWAIT);
+    mLooper->run(UV_RUN_NOWAIT);
+    mLooper->close();
+}
+
+SoakReport LoadGenerator::run(Scenario& scenario) {
+    mScenario = &scenario;
+    mService->systemReady();
+    scenario.setUp(*this);
+    const uint64_t warmupMs = std::min<uint64_t>(WARMUP_MS, mOptions.durationMs / 5);
+    const uint64_t drainMs = std::min<uint64_t>(DRAIN_MS, mOptions.durationMs / 5);
+    runFor(warmupMs, nullptr);
+
+    mReport = SoakReport();
+    mReport.scenario = scenario.getName();
+    mExpectResumed.clear();
+    const uint64_t begin = nowUs();
+    uint64_t steps = 0;
+    uint64_t samples = 0;
+    uint64_t pendingSum = 0;
+    runFor(mOptions.durationMs - warmupMs - drainMs, [&]() {
+        const uint64_t due = (nowUs() - begin) * mOptions.opsPerSecond / 1000000;
+        for (; steps < due; steps++) {
+            scenario.step(*this);
+        }
+        const size_t pending = getPendingTasks();
+        mReport.maxPendingTasks = std::max(mReport.maxPendingTasks, pending);
+        pendingSum += pending;
+        samples++;
+        mReport.peakHeapBytes = std::max(mReport.peakHeapBytes, mallinfo2().uordblks);
+    });
+    mReport.seconds = (nowUs() - begin) / 1000000.0;
+    mReport.avgPendingTasks = samples ? (double)pendingSum / samples : 0;
+
+    // the operations in flight are still measured, but no more load
+    runFor(drainMs, nullptr);
+    mScenario = nullptr;
+
+    std::sort(mReport.latencyUs.begin(), mReport.latencyUs.end());
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        mReport.peakRssKb = usage.ru_maxrss;
+    }
+    return mReport;
+}
+
+void LoadGenerator::dump(int fd, const std::vector<std::string>& args) {
+    android::Vector<android::String16> dumpArgs;
+    for (const auto& arg : args) {
+        dumpArgs.add(android::String16(arg.c_str()));
+    }
+    mService->dump(fd, dumpArgs);
+}
+
+bool LoadGenerator::chance(double rate) {
+    return rate > 0 && std::uniform_real_distribution<double>(0, 1)(mRandom) < rate;
+}
+
+std::string LoadGenerator::packageName(int index) {
+    return "soak.app" + std::to_string(index);
+}
+
+void LoadGenerator::callAs(pid_t pid, const std::function<void()>& call) {
+    auto ipc = android::IPCThreadState::self();
+    const int64_t token = ipc->clearCallingIdentity();
+    ipc->restoreCallingIdentity(((int64_t)getuid() << 32) | pid);
+    call();
+    ipc->restoreCallingIdentity(token);
+}
+
+sp<SoakApplication> LoadGenerator::findProcess(const std::string& packageName) const {
+    for (const auto& [pid, app] : mProcesses) {
+        if (app->getPackageName() == packageName) {
+            return app;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<sp<SoakApplication>> LoadGenerator::getProcesses() const {
+    std::vector<sp<SoakApplication>> processes;
+    for (const auto& [pid, app] : mProcesses) {
+        processes.push_back(app);
+    }
+    return processes;
+}
+
+uint64_t LoadGenerator::nowUs() const {
+    return uv_hrtime() / 1000;
+}
+
+void LoadGenerator::recordIssued(bool isRejected) {
+    mReport.issued++;
+    if (isRejected) {
+        mReport.rejected++;
+    }
+}
+
+void LoadGenerator::recordLatency(uint64_t beginUs) {
+    mReport.latencyUs.push_back(nowUs() - beginUs);
+}
+
+void LoadGenerator::expectResumed(const std::string& packageName) {
+    // the repeated launches are measured from the first one
+    mExpectResumed.emplace(packageName, nowUs());
+}
+
+void LoadGenerator::onAttached(SoakApplication& app) {
+    if (mScenario) {
+        mScenario->onAttached(*this, app);
+    }
+}
+
+void LoadGenerator::onResumed(const std::string& packageName) {
+    const auto it = mExpectResumed.find(packageName);
+    if (it != mExpectResumed.end()) {
+        recordLatency(it->second);
+        mExpectResumed.erase(it);
+    }
+}
+
+void LoadGenerator::onExit(pid_t pid, bool isCrash) {
+    const auto it = mProcesses.find(pid);
+    if (it == mProcesses.end()) {
+        return;
+    }
+    const sp<SoakApplication> app = it->second;
+    mProcesses.erase(it);
+    app->exit();
+    // the launch never finishes
+    mExpectResumed.erase(app->getPackageName());
+    if (isCrash) {
+        mReport.crashed++;
+    }
+    os::app::host::exitProcess(pid);
+}
+
+void LoadGenerator::onDropped() {
+    mReport.dropped++;
+}
+
+void LoadGenerator::onTrimmed() {
+    mReport.trimmed++;
+}
+
+void LoadGenerator::onTerminated() {
+    mReport.terminated++;
+}
+
+void LoadGenerator::installPackages() {
+    PackageManager::clearPackages();
+
+    PackageInfo home;
+    home.packageName = "soak.home";
+    home.entry = "Home";
+    home.execfile = "/bin/soak.home";
+    home.priority = os::pm::HIGH;
+    home.activitiesInfo.push_back({"Home", "singleTask", "", {os::app::Intent::ACTION_HOME}});
+    PackageManager::installPackage(home);
+
+    for (int i = 0; i < mOptions.appNum; i++) {
+        PackageInfo info;
+        info.packageName = packageName(i);
+        info.entry = "Main";
+        info.execfile = "/bin/" + info.packageName;
+        info.activitiesInfo.push_back({"Main", "singleTask", "", {}});
+        info.activitiesInfo.push_back({"Detail", "singleTask", "", {}});
+        info.servicesInfo.push_back({"Service", os::pm::MIDDLE, {}});
+        PackageManager::installPackage(info);
+    }
+}
+
+void LoadGenerator::runFor(uint64_t ms, const std::function<void()>& tick) {
+    uv_loop_t* loop = mLooper->get();
+    uv_update_time(loop);
+    const uint64_t end = uv_now(loop) + ms;
+    os::app::UvTimer timer(loop, [loop, end, &tick](void*) {
+        if (tick) {
+            tick();
+        }
+        if (uv_now(loop) >= end) {
+            uv_stop(loop);
+        }
+    });
+    timer.start(TICK_MS, TICK_MS);
+    mLooper->run();
+    timer.stop();
+}
+
+size_t LoadGenerator::getPendingTasks() {
+    // read it like the collectors, by "dump --json stats"
+    ftruncate(mDumpFd, 0);
+    lseek(mDumpFd, 0, SEEK_SET);
+    dump(mDumpFd, {"--json", "stats"});
+
+    std::string json(lseek(mDumpFd, 0, SEEK_CUR), '\0');
+    if (pread(mDumpFd, json.data(), json.size(), 0) != (ssize_t)json.size()) {
+        return 0;
+    }
+    static const std::string key = "\"pendingTasks\":";
+    const auto pos = json.find(key);
+    return pos == std::string::npos ? 0 : strtoul(json.c_str() + pos + key.size(), nullptr, 10);
+}
+
+struct mallinfo LoadGenerator::getMemoryInfo() const {
+    const uint64_t totalKb = mOptions.totalMemoryKb;
+    uint64_t usedKb = 0;
+    for (const auto& [pid, app] : mProcesses) {
+        usedKb += app->getMemoryKb();
+    }
+    usedKb = std::min(usedKb, totalKb);
+    const auto toInt = [](uint64_t kb) { return (int)std::min<uint64_t>(kb * 1024, INT_MAX); };
+
+    struct mallinfo info = {};
+    info.arena = toInt(totalKb);
+    info.ordblks = 1;
+    info.mxordblk = toInt(totalKb - usedKb);
+    info.uordblks = toInt(usedKb);
+    info.fordblks = toInt(totalKb - usedKb);
+    return info;
+}
+
+} // namespace host
+} // namespace am
+} // namespace os
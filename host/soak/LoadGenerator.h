@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <malloc.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SoakApplication.h"
+#include "am/ActivityManagerService.h"
+#include "app/UvLoop.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+/** The behavior of every fake application, the rates are in [0, 1] */
+struct AppBehavior {
+    uint32_t latencyMs = 1;       // the delay of every reply to activity manager
+    uint32_t jitterMs = 2;        // plus a random delay in [0, jitterMs]
+    double failureRate = 0;       // the reply is dropped, it looks like a hung application
+    double crashRate = 0;         // the process exits instead of replying
+    uint32_t memoryKb = 8 * 1024; // the memory of every process, trim halves it until resumed
+};
+
+struct SoakOptions {
+    int appNum = 50;
+    int durationMs = 10000; // the warm-up, the load and the drain of a scenario
+    int opsPerSecond = 50;
+    uint32_t totalMemoryKb = 0; // the device memory, 0 is large enough for all the apps
+    uint32_t seed = 1;
+    AppBehavior behavior;
+};
+
+struct SoakReport {
+    std::string scenario;
+    double seconds = 0;
+    uint64_t issued = 0;   // the operations sent to activity manager
+    uint64_t rejected = 0; // the operations that activity manager returned an error
+    std::vector<uint64_t> latencyUs;
+    size_t maxPendingTasks = 0;
+    double avgPendingTasks = 0;
+    uint64_t spawned = 0;
+    uint64_t terminated = 0; // terminateApplication, by LMK or the application is idle
+    uint64_t crashed = 0;
+    uint64_t dropped = 0;
+    uint64_t trimmed = 0;
+    size_t peakHeapBytes = 0; // the heap of the whole harness, activity manager dominates it
+    long peakRssKb = 0;
+
+    uint64_t percentile(double p) const;
+};
+
+class LoadGenerator;
+
+/** A scripted load, step() is called opsPerSecond times per second */
+class Scenario {
+public:
+    virtual ~Scenario() = default;
+    virtual const char* getName() const = 0;
+    virtual const char* getDescription() const = 0;
+
+    virtual void configure(SoakOptions& options) {}
+    // the system is ready, prepare the load before the measurement
+    virtual void setUp(LoadGenerator& generator) {}
+    virtual void onAttached(LoadGenerator& generator, SoakApplication& app) {}
+    virtual void step(LoadGenerator& generator) = 0;
+};
+
+std::vector<std::unique_ptr<Scenario>> createScenarios();
+
+/**
+ * Drive ActivityManagerService in the process: the packages "soak.app<N>" are installed, the
+ * spawned processes are SoakApplication, and every binder call from them carries their pid
+ * as the calling identity.
+ */
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const SoakOptions& options);
+    ~LoadGenerator();
+
+    SoakReport run(Scenario& scenario);
+    void dump(int fd, const std::vector<std::string>& args);
+
+    const SoakOptions& getOptions() const {
+        return mOptions;
+    }
+    ActivityManagerService* getService() const {
+        return mService.get();
+    }
+    os::app::UvLoop* getLooper() const {
+        return mLooper.get();
+    }
+    std::mt19937& getRandom() {
+        return mRandom;
+    }
+    bool chance(double rate);
+
+    static std::string packageName(int index);
+    static const std::string FANOUT_ACTION;
+
+    /** Call activity manager with the identity of the process, like a binder call from it */
+    void callAs(pid_t pid, const std::function<void()>& call);
+    sp<SoakApplication> findProcess(const std::string& packageName) const;
+    std::vector<sp<SoakApplication>> getProcesses() const;
+
+    uint64_t nowUs() const;
+    void recordIssued(bool isRejected);
+    void recordLatency(uint64_t beginUs);
+    // the latency of startActivity ends when the application reports RESUMED
+    void expectResumed(const std::string& packageName);
+
+    // the events from the fake applications
+    void onAttached(SoakApplication& app);
+    void onResumed(const std::string& packageName);
+    void onExit(pid_t pid, bool isCrash);
+    void onDropped();
+    void onTrimmed();
+    void onTerminated();
+
+private:
+    void installPackages();
+    void runFor(uint64_t ms, const std::function<void()>& tick);
+    size_t getPendingTasks();
+    struct mallinfo getMemoryInfo() const;
+
+    SoakOptions mOptions;
+    std::mt19937 mRandom;
+    std::unique_ptr<os::app::UvLoop> mLooper;
+    sp<ActivityManagerService> mService;
+    Scenario* mScenario;
+    std::map<pid_t, sp<SoakApplication>> mProcesses;
+    std::map<std::string, uint64_t> mExpectResumed;
+    SoakReport mReport;
+    int mDumpFd;
+};
+
+} // namespace host
+} // namespace am
+} // namespace os
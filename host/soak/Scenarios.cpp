@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include "LoadGenerator.h"
+#include "app/ActivityManager.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+using os::app::ActivityManager;
+
+/** Bring a random application to front, some of them open the second activity */
+class AppSwitchStorm : public Scenario {
+public:
+    const char* getName() const override {
+        return "app-switch";
+    }
+    const char* getDescription() const override {
+        return "startActivity of random apps, latency until RESUMED";
+    }
+
+    void step(LoadGenerator& generator) override {
+        const int index = generator.getRandom()() % generator.getOptions().appNum;
+        const std::string packageName = LoadGenerator::packageName(index);
+        const Intent intent(generator.chance(0.2) ? packageName + "/Detail" : packageName);
+        int32_t ret;
+        generator.getService()->startActivity(nullptr, intent, ActivityManager::NO_REQUEST, &ret);
+        generator.recordIssued(ret != android::OK);
+        if (ret == android::OK) {
+            generator.expectResumed(packageName);
+        }
+    }
+};
+
+/** The processes bind the services of random apps, and unbind them later */
+class BindChurn : public Scenario {
+public:
+    const char* getName() const override {
+        return "bind-churn";
+    }
+    const char* getDescription() const override {
+        return "bindService/unbindService from random clients, latency until connected";
+    }
+
+    void step(LoadGenerator& generator) override {
+        auto& random = generator.getRandom();
+        const size_t maxConnections = generator.getOptions().appNum;
+        if (mConnections.empty() ||
+            (mConnections.size() < maxConnections && generator.chance(0.5))) {
+            const auto processes = generator.getProcesses();
+            const pid_t client =
+                    processes.empty() ? getpid() : processes[random() % processes.size()]->getPid();
+            const int index = random() % generator.getOptions().appNum;
+            const Intent intent(LoadGenerator::packageName(index) + "/Service");
+            const sp<SoakConnection> conn(new SoakConnection(&generator, client));
+            int32_t ret;
+            generator.callAs(client, [&]() {
+                generator.getService()->bindService(nullptr, intent, conn, &ret);
+            });
+            generator.recordIssued(ret != android::OK);
+            if (ret == android::OK) {
+                mConnections.push_back(conn);
+            }
+        } else {
+            const size_t index = random() % mConnections.size();
+            const sp<SoakConnection> conn = mConnections[index];
+            mConnections[index] = mConnections.back();
+            mConnections.pop_back();
+            generator.callAs(conn->getClientPid(),
+                             [&]() { generator.getService()->unbindService(conn); });
+            generator.recordIssued(false);
+        }
+    }
+
+private:
+    std::vector<sp<SoakConnection>> mConnections;
+};
+
+/** Every app runs a service and listens to the same action, which is broadcast by the load */
+class BroadcastFanout : public Scenario {
+public:
+    const char* getName() const override {
+        return "broadcast-fanout";
+    }
+    const char* getDescription() const override {
+        return "sendBroadcast to a receiver of every app, latency of every delivery";
+    }
+
+    void setUp(LoadGenerator& generator) override {
+        for (int i = 0; i < generator.getOptions().appNum; i++) {
+            int32_t ret;
+            generator.getService()->startService(Intent(LoadGenerator::packageName(i) + "/Service"),
+                                                 &ret);
+        }
+    }
+
+    void onAttached(LoadGenerator& generator, SoakApplication& app) override {
+        const sp<SoakReceiver> receiver(new SoakReceiver(&generator));
+        int32_t ret;
+        generator.callAs(app.getPid(), [&]() {
+            generator.getService()->registerReceiver(LoadGenerator::FANOUT_ACTION, receiver, &ret);
+        });
+    }
+
+    void step(LoadGenerator& generator) override {
+        Intent intent;
+        intent.setAction(LoadGenerator::FANOUT_ACTION);
+        intent.setData(std::to_string(generator.nowUs()));
+        int32_t ret;
+        generator.getService()->sendBroadcast(intent, &ret);
+        generator.recordIssued(ret != android::OK);
+    }
+};
+
+/** The app switch storm on a device that only half of the apps fit in */
+class LmkPressure : public AppSwitchStorm {
+public:
+    const char* getName() const override {
+        return "lmk-pressure";
+    }
+    const char* getDescription() const override {
+        return "app-switch with memory for half of the apps, LMK trims and kills";
+    }
+
+    void configure(SoakOptions& options) override {
+        if (options.totalMemoryKb == 0) {
+            options.totalMemoryKb = options.appNum * options.behavior.memoryKb / 2;
+        }
+    }
+};
+
+std::vector<std::unique_ptr<Scenario>> createScenarios() {
+    std::vector<std::unique_ptr<Scenario>> scenarios;
+    scenarios.push_back(std::make_unique<AppSwitchStorm>());
+    scenarios.push_back(std::make_unique<BindChurn>());
+    scenarios.push_back(std::make_unique<BroadcastFanout>());
+    scenarios.push_back(std::make_unique<LmkPressure>());
+    return scenarios;
+}
+
+} // namespace host
+} // namespace am
+} // namespace os
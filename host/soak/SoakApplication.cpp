@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SoakApplication.h"
+
+#include <binder/Binder.h>
+
+#include <algorithm>
+
+#include "ActivityRecord.h"
+#include "LoadGenerator.h"
+#include "ServiceRecord.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+SoakApplication::SoakApplication(LoadGenerator* generator, pid_t pid,
+                                 const std::string& packageName)
+      : mGenerator(generator),
+        mPid(pid),
+        mPackageName(packageName),
+        mIsAlive(true),
+        mMemoryKb(generator->getOptions().behavior.memoryKb),
+        mLastReplyTime(0) {}
+
+void SoakApplication::start() {
+    reply([this] {
+        int32_t ret;
+        std::vector<os::app::ActivityLaunch> launches;
+        mGenerator->getService()->attachApplication(this, &launches, &ret);
+        if (ret == android::OK) {
+            mGenerator->onAttached(*this);
+        }
+        for (const auto& launch : launches) {
+            scheduleLaunchActivity(launch.mName, launch.mToken, launch.mIntent);
+            if (launch.mTargetStatus >= ActivityRecord::STARTED) {
+                scheduleStartActivity(launch.mToken, std::nullopt);
+            }
+            if (launch.mTargetStatus >= ActivityRecord::RESUMED) {
+                scheduleResumeActivity(launch.mToken, std::nullopt);
+            }
+        }
+    });
+}
+
+void SoakApplication::exit() {
+    mIsAlive = false;
+    mActivities.clear();
+    mServices.clear();
+}
+
+void SoakApplication::reply(std::function<void()>&& func) {
+    if (!mIsAlive) {
+        return;
+    }
+    const auto& behavior = mGenerator->getOptions().behavior;
+    if (mGenerator->chance(behavior.failureRate)) {
+        mGenerator->onDropped();
+        return;
+    }
+    const bool isCrash = mGenerator->chance(behavior.crashRate);
+    const uint64_t now = uv_now(mGenerator->getLooper()->get());
+    uint64_t replyTime = now + behavior.latencyMs;
+    if (behavior.jitterMs > 0) {
+        replyTime += mGenerator->getRandom()() % (behavior.jitterMs + 1);
+    }
+    replyTime = std::max(replyTime, mLastReplyTime);
+    mLastReplyTime = replyTime;
+
+    const sp<SoakApplication> self(this);
+    mGenerator->getLooper()->postDelayTask(
+            [self, isCrash, func](void*) {
+                if (!self->mIsAlive) {
+                    return;
+                }
+                if (isCrash) {
+                    self->mGenerator->onExit(self->mPid, true);
+                } else {
+                    self->mGenerator->callAs(self->mPid, func);
+                }
+            },
+            replyTime - now);
+}
+
+void SoakApplication::reportActivity(const sp<IBinder>& token, int32_t status) {
+    mGenerator->getService()->reportActivityStatus(token, status);
+}
+
+void SoakApplication::reportService(const sp<IBinder>& token, int32_t status) {
+    mGenerator->getService()->reportServiceStatus(token, status);
+}
+
+void SoakApplication::createService(const sp<IBinder>& token) {
+    if (mServices.find(token) == mServices.end()) {
+        mServices.emplace(token, nullptr);
+        reportService(token, ServiceRecord::CREATED);
+    }
+}
+
+Status SoakApplication::scheduleLaunchActivity(const std::string& activityName,
+                                               const sp<IBinder>& token, const Intent& intent) {
+    reply([this, activityName, token] {
+        mActivities[token] = activityName;
+        reportActivity(token, ActivityRecord::CREATED);
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleStartActivity(const sp<IBinder>& token,
+                                              const std::optional<Intent>& intent) {
+    reply([this, token] { reportActivity(token, ActivityRecord::STARTED); });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleResumeActivity(const sp<IBinder>& token,
+                                               const std::optional<Intent>& intent) {
+    reply([this, token] {
+        // the foreground application takes its memory back after trimmed
+        mMemoryKb = mGenerator->getOptions().behavior.memoryKb;
+        reportActivity(token, ActivityRecord::RESUMED);
+        mGenerator->onResumed(mPackageName);
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::schedulePauseActivity(const sp<IBinder>& token) {
+    reply([this, token] { reportActivity(token, ActivityRecord::PAUSED); });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleStopActivity(const sp<IBinder>& token) {
+    reply([this, token] { reportActivity(token, ActivityRecord::STOPPED); });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleDestroyActivity(const sp<IBinder>& token) {
+    reply([this, token] {
+        mActivities.erase(token);
+        reportActivity(token, ActivityRecord::DESTROYED);
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleStartService(const std::string& serviceName,
+                                             const sp<IBinder>& token, const Intent& intent) {
+    reply([this, token] {
+        createService(token);
+        reportService(token, ServiceRecord::STARTED);
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleStartServiceBatch(const std::string& serviceName,
+                                                  const sp<IBinder>& token,
+                                                  const std::vector<Intent>& intents) {
+    return scheduleStartService(serviceName, token, intents.back());
+}
+
+Status SoakApplication::scheduleStopService(const sp<IBinder>& token) {
+    reply([this, token] {
+        mServices.erase(token);
+        reportService(token, ServiceRecord::DESTROYED);
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleBindService(const std::string& serviceName,
+                                            const sp<IBinder>& token, const Intent& intent,
+                                            const sp<IServiceConnection>& connection) {
+    reply([this, token] {
+        createService(token);
+        auto& binder = mServices[token];
+        if (!binder) {
+            // onBind only once, like Service::bind
+            binder = new android::BBinder();
+        }
+        // the connections are connected by the activity manager
+        mGenerator->getService()->publishService(token, binder);
+        reportService(token, ServiceRecord::BINDED);
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleUnbindService(const sp<IBinder>& token) {
+    reply([this, token] { reportService(token, ServiceRecord::UNBINDED); });
+    return Status::ok();
+}
+
+Status SoakApplication::scheduleTrimMemory(int32_t level) {
+    reply([this] {
+        mMemoryKb /= 2;
+        mGenerator->onTrimmed();
+    });
+    return Status::ok();
+}
+
+Status SoakApplication::terminateApplication() {
+    mGenerator->onTerminated();
+    reply([this] { mGenerator->onExit(mPid, false); });
+    return Status::ok();
+}
+
+SoakConnection::SoakConnection(LoadGenerator* generator, pid_t clientPid)
+      : mGenerator(generator),
+        mClientPid(clientPid),
+        mBindTime(generator->nowUs()),
+        mIsConnected(false) {}
+
+Status SoakConnection::onServiceConnected(const sp<IBinder>& server) {
+    if (!mIsConnected) {
+        mIsConnected = true;
+        mGenerator->recordLatency(mBindTime);
+    }
+    return Status::ok();
+}
+
+Status SoakConnection::onServiceDisconnected(const sp<IBinder>& server) {
+    mIsConnected = false;
+    return Status::ok();
+}
+
+Status SoakReceiver::receiveBroadcast(const Intent& intent) {
+    if (intent.mAction == LoadGenerator::FANOUT_ACTION) {
+        mGenerator->recordLatency(std::stoull(intent.mData));
+    }
+    return Status::ok();
+}
+
+} // namespace host
+} // namespace am
+} // namespace os
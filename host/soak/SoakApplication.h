@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "NullApplicationThread.h"
+#include "os/app/BnBroadcastReceiver.h"
+#include "os/app/BnServiceConnection.h"
+
+namespace os {
+namespace am {
+namespace host {
+
+class LoadGenerator;
+
+/**
+ * The application process played by the soak harness. It replies to activity manager like
+ * ApplicationThread does, but every reply goes through the configured latency, and may be
+ * dropped(the application hangs) or replaced by a crash.
+ * The replies of a process keep their order, like the oneway binder calls. The requests that
+ * need no reply are ignored, the soak never restarts activity manager.
+ */
+class SoakApplication : public NullApplicationThread {
+public:
+    SoakApplication(LoadGenerator* generator, pid_t pid, const std::string& packageName);
+
+    pid_t getPid() const {
+        return mPid;
+    }
+    const std::string& getPackageName() const {
+        return mPackageName;
+    }
+    bool isAlive() const {
+        return mIsAlive;
+    }
+    uint32_t getMemoryKb() const {
+        return mMemoryKb;
+    }
+
+    // the process is spawned, attach to activity manager later
+    void start();
+    // the process is gone, it never replies again
+    void exit();
+
+    Status scheduleLaunchActivity(const std::string& activityName, const sp<IBinder>& token,
+                                  const Intent& intent) override;
+    Status scheduleStartActivity(const sp<IBinder>& token,
+                                 const std::optional<Intent>& intent) override;
+    Status scheduleResumeActivity(const sp<IBinder>& token,
+                                  const std::optional<Intent>& intent) override;
+    Status schedulePauseActivity(const sp<IBinder>& token) override;
+    Status scheduleStopActivity(const sp<IBinder>& token) override;
+    Status scheduleDestroyActivity(const sp<IBinder>& token) override;
+    Status scheduleStartService(const std::string& serviceName, const sp<IBinder>& token,
+                                const Intent& intent) override;
+    Status scheduleStartServiceBatch(const std::string& serviceName, const sp<IBinder>& token,
+                                     const std::vector<Intent>& intents) override;
+    Status scheduleStopService(const sp<IBinder>& token) override;
+    Status scheduleBindService(const std::string& serviceName, const sp<IBinder>& token,
+                               const Intent& intent,
+                               const sp<IServiceConnection>& connection) override;
+    Status scheduleUnbindService(const sp<IBinder>& token) override;
+    Status scheduleTrimMemory(int32_t level) override;
+    Status terminateApplication() override;
+
+private:
+    void reply(std::function<void()>&& func);
+    void reportActivity(const sp<IBinder>& token, int32_t status);
+    void reportService(const sp<IBinder>& token, int32_t status);
+    void createService(const sp<IBinder>& token);
+
+    LoadGenerator* mGenerator;
+    const pid_t mPid;
+    const std::string mPackageName;
+    bool mIsAlive;
+    uint32_t mMemoryKb;
+    uint64_t mLastReplyTime; // the replies are in order
+    std::map<sp<IBinder>, std::string> mActivities;
+    std::map<sp<IBinder>, sp<IBinder>> mServices; // token -> the published binder
+};
+
+/** The connection of bindService, the latency is measured until the service is connected */
+class SoakConnection : public os::app::BnServiceConnection {
+public:
+    SoakConnection(LoadGenerator* generator, pid_t clientPid);
+
+    pid_t getClientPid() const {
+        return mClientPid;
+    }
+    bool isConnected() const {
+        return mIsConnected;
+    }
+
+    Status onServiceConnected(const sp<IBinder>& server) override;
+    Status onServiceDisconnected(const sp<IBinder>& server) override;
+
+private:
+    LoadGenerator* mGenerator;
+    const pid_t mClientPid;
+    const uint64_t mBindTime;
+    bool mIsConnected;
+};
+
+/** The broadcast carries its sending time in Intent.mData, the delivery latency is measured */
+class SoakReceiver : public os::app::BnBroadcastReceiver {
+public:
+    explicit SoakReceiver(LoadGenerator* generator) : mGenerator(generator) {}
+
+    Status receiveBroadcast(const Intent& intent) override;
+
+private:
+    LoadGenerator* mGenerator;
+};
+
+} // namespace host
+} // namespace am
+} // namespace os
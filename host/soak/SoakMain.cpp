@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "LoadGenerator.h"
+
+using namespace os::am::host;
+
+static void usage(const char* name) {
+    printf("usage: %s [options]\n"
+           "  --scenario=NAME[,NAME]  the scenarios to run, all by default\n"
+           "  --apps=N                the installed apps, default 50\n"
+           "  --duration=MS           the whole run, shared by the scenarios, default 10000 each\n"
+           "  --rate=N                the operations per second, default 50\n"
+           "  --latency=MS            the reply latency of the apps, default 1\n"
+           "  --jitter=MS             plus a random latency, default 2\n"
+           "  --failure=RATE          the replies dropped by the apps, default 0\n"
+           "  --crash=RATE            the apps crash instead of replying, default 0\n"
+           "  --memory=KB             the device memory, the apps use 8MB each\n"
+           "  --seed=N                the random seed, default 1\n"
+           "  --dump[=SECTION,...]    dump activity manager after every scenario\n"
+           "  --list                  list the scenarios\n",
+           name);
+}
+
+static void printReport(const SoakReport& report) {
+    const auto toMs = [](uint64_t us) { return us / 1000.0; };
+    printf("%-18s %8.1f %8" PRIu64 " %8" PRIu64 " %8zu %8.2f %8.2f %8.2f %6zu/%-6.1f %6" PRIu64
+           " %6" PRIu64 " %6" PRIu64 " %6" PRIu64 " %6" PRIu64 " %9zu %8ld\n",
+           report.scenario.c_str(), report.issued / report.seconds, report.issued,
+           report.rejected, report.latencyUs.size(), toMs(report.percentile(0.5)),
+           toMs(report.percentile(0.99)), toMs(report.percentile(1)), report.maxPendingTasks,
+           report.avgPendingTasks, report.spawned, report.terminated, report.crashed,
+           report.dropped, report.trimmed, report.peakHeapBytes / 1024, report.peakRssKb);
+}
+
+int main(int argc, char** argv) {
+    SoakOptions options;
+    int durationMs = 0;
+    std::string selected;
+    std::vector<std::string> dumpArgs;
+    bool isDump = false;
+    auto scenarios = createScenarios();
+    for (int i = 1; i < argc; i++) {
+        const char* value = strchr(argv[i], '=');
+        value = value ? value + 1 : "";
+        if (strncmp(argv[i], "--scenario=", 11) == 0) {
+            selected = std::string(",") + value + ",";
+        } else if (strncmp(argv[i], "--apps=", 7) == 0) {
+            options.appNum = atoi(value);
+        } else if (strncmp(argv[i], "--duration=", 11) == 0) {
+            durationMs = atoi(value);
+        } else if (strncmp(argv[i], "--rate=", 7) == 0) {
+            options.opsPerSecond = atoi(value);
+        } else if (strncmp(argv[i], "--latency=", 10) == 0) {
+            options.behavior.latencyMs = atoi(value);
+        } else if (strncmp(argv[i], "--jitter=", 9) == 0) {
+            options.behavior.jitterMs = atoi(value);
+        } else if (strncmp(argv[i], "--failure=", 10) == 0) {
+            options.behavior.failureRate = atof(value);
+        } else if (strncmp(argv[i], "--crash=", 8) == 0) {
+            options.behavior.crashRate = atof(value);
+        } else if (strncmp(argv[i], "--memory=", 9) == 0) {
+            options.totalMemoryKb = strtoul(value, nullptr, 10);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            options.seed = strtoul(value, nullptr, 10);
+        } else if (strncmp(argv[i], "--dump", 6) == 0) {
+            isDump = true;
+            for (const char* section = value; *section;) {
+                const char* end = strchrnul(section, ',');
+                dumpArgs.emplace_back(section, end - section);
+                section = *end ? end + 1 : end;
+            }
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (const auto& scenario : scenarios) {
+                printf("%-18s %s\n", scenario->getName(), scenario->getDescription());
+            }
+            return 0;
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    std::vector<Scenario*> runs;
+    for (const auto& scenario : scenarios) {
+        if (selected.empty() ||
+            selected.find(std::string(",") + scenario->getName() + ",") != std::string::npos) {
+            runs.push_back(scenario.get());
+        }
+    }
+    // the selected scenarios share the duration
+    if (durationMs > 0 && !runs.empty()) {
+        options.durationMs = durationMs / runs.size();
+    }
+    if (options.appNum <= 0 || options.durationMs <= 0 || options.opsPerSecond <= 0 ||
+        durationMs < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<SoakReport> reports;
+    for (Scenario* scenario : runs) {
+        SoakOptions scenarioOptions = options;
+        scenario->configure(scenarioOptions);
+        SoakReport report;
+        {
+            LoadGenerator generator(scenarioOptions);
+            report = generator.run(*scenario);
+            if (isDump) {
+                generator.dump(STDOUT_FILENO, dumpArgs);
+            }
+        }
+        reports.push_back(std::move(report));
+    }
+
+    // the table is after the logs of activity manager
+    printf("%-18s %8s %8s %8s %8s %8s %8s %8s %13s %6s %6s %6s %6s %6s %9s %8s\n", "scenario",
+           "ops/s", "issued", "rejected", "done", "p50(ms)", "p99(ms)", "max(ms)",
+           "tasks max/avg", "spawn", "term", "crash", "drop", "trim", "heap(KB)", "rss(KB)");
+    int ret = 0;
+    for (const auto& report : reports) {
+        printReport(report);
+        if (report.issued > 0 && report.latencyUs.empty()) {
+            // nothing is done, activity manager is stuck
+            ret = 2;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/IPCThreadState.h>
+#include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
+#include <binder/PersistableBundle.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+
+namespace android {
+
+static std::mutex sServicesLock;
+static std::map<String16, sp<IBinder>> sServices;
+
+status_t addService(const String16& name, const sp<IBinder>& service) {
+    std::lock_guard<std::mutex> lock(sServicesLock);
+    if (service) {
+        sServices[name] = service;
+    } else {
+        sServices.erase(name);
+    }
+    return OK;
+}
+
+sp<IBinder> checkService(const String16& name) {
+    std::lock_guard<std::mutex> lock(sServicesLock);
+    const auto it = sServices.find(name);
+    return it != sServices.end() ? it->second : nullptr;
+}
+
+IPCThreadState* IPCThreadState::self() {
+    static thread_local IPCThreadState state;
+    return &state;
+}
+
+IPCThreadState::IPCThreadState() : mCallingPid(getpid()), mCallingUid(getuid()) {}
+
+int64_t IPCThreadState::clearCallingIdentity() {
+    const int64_t token = ((int64_t)mCallingUid << 32) | (uint32_t)mCallingPid;
+    mCallingPid = getpid();
+    mCallingUid = getuid();
+    return token;
+}
+
+void IPCThreadState::restoreCallingIdentity(int64_t token) {
+    mCallingUid = (uid_t)(token >> 32);
+    mCallingPid = (pid_t)(token & 0xffffffff);
+}
+
+status_t IPCThreadState::setupPolling(int* fd) {
+    *fd = -1;
+    return INVALID_OPERATION;
+}
+
+status_t IPCThreadState::handlePolledCommands() {
+    return INVALID_OPERATION;
+}
+
+status_t Parcel::write(const void* data, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    mData.insert(mData.end(), bytes, bytes + len);
+    return OK;
+}
+
+status_t Parcel::read(void* data, size_t len) const {
+    if (mPosition + len > mData.size()) {
+        return NOT_ENOUGH_DATA;
+    }
+    memcpy(data, mData.data() + mPosition, len);
+    mPosition += len;
+    return OK;
+}
+
+status_t Parcel::writeInt32(int32_t value) {
+    return write(&value, sizeof(value));
+}
+
+status_t Parcel::writeUint32(uint32_t value) {
+    return write(&value, sizeof(value));
+}
+
+status_t Parcel::writeInt64(int64_t value) {
+    return write(&value, sizeof(value));
+}
+
+status_t Parcel::writeBool(bool value) {
+    return writeInt32(value);
+}
+
+status_t Parcel::writeDouble(double value) {
+    return write(&value, sizeof(value));
+}
+
+status_t Parcel::writeUtf8AsUtf16(const std::string& str) {
+    const status_t ret = writeInt32(str.size());
+    return ret == OK ? write(str.data(), str.size()) : ret;
+}
+
+status_t Parcel::writeStrongBinder(const sp<IBinder>& binder) {
+    mObjects.push_back(binder);
+    return writeUint32(mObjects.size() - 1);
+}
+
+status_t Parcel::readInt32(int32_t* value) const {
+    return read(value, sizeof(*value));
+}
+
+status_t Parcel::readUint32(uint32_t* value) const {
+    return read(value, sizeof(*value));
+}
+
+status_t Parcel::readInt64(int64_t* value) const {
+    return read(value, sizeof(*value));
+}
+
+status_t Parcel::readBool(bool* value) const {
+    int32_t v = 0;
+    const status_t ret = readInt32(&v);
+    *value = v != 0;
+    return ret;
+}
+
+status_t Parcel::readDouble(double* value) const {
+    return read(value, sizeof(*value));
+}
+
+status_t Parcel::readUtf8FromUtf16(std::string* str) const {
+    int32_t size;
+    status_t ret = readInt32(&size);
+    if (ret != OK) {
+        return ret;
+    }
+    if (size < 0 || mPosition + size > mData.size()) {
+        return BAD_VALUE;
+    }
+    str->assign((const char*)mData.data() + mPosition, size);
+    mPosition += size;
+    return OK;
+}
+
+status_t Parcel::readStrongBinder(sp<IBinder>* binder) const {
+    uint32_t index;
+    const status_t ret = readUint32(&index);
+    if (ret != OK) {
+        return ret;
+    }
+    if (index >= mObjects.size() || !mObjects[index]) {
+        return UNEXPECTED_NULL;
+    }
+    *binder = mObjects[index];
+    return OK;
+}
+
+namespace os {
+
+status_t PersistableBundle::writeToParcel(Parcel* parcel) const {
+    parcel->writeInt32(mBools.size());
+    for (const auto& [key, value] : mBools) {
+        parcel->writeUtf8AsUtf16(key.utf8());
+        parcel->writeBool(value);
+    }
+    parcel->writeInt32(mInts.size());
+    for (const auto& [key, value] : mInts) {
+        parcel->writeUtf8AsUtf16(key.utf8());
+        parcel->writeInt32(value);
+    }
+    parcel->writeInt32(mLongs.size());
+    for (const auto& [key, value] : mLongs) {
+        parcel->writeUtf8AsUtf16(key.utf8());
+        parcel->writeInt64(value);
+    }
+    parcel->writeInt32(mDoubles.size());
+    for (const auto& [key, value] : mDoubles) {
+        parcel->writeUtf8AsUtf16(key.utf8());
+        parcel->writeDouble(value);
+    }
+    parcel->writeInt32(mStrings.size());
+    for (const auto& [key, value] : mStrings) {
+        parcel->writeUtf8AsUtf16(key.utf8());
+        parcel->writeUtf8AsUtf16(value.utf8());
+    }
+    return OK;
+}
+
+template <typename T, typename F>
+static status_t readMap(const Parcel* parcel, std::map<String16, T>& map, F readValue) {
+    map.clear();
+    int32_t size;
+    status_t ret = parcel->readInt32(&size);
+    for (int32_t i = 0; ret == OK && i < size; i++) {
+        std::string key;
+        ret = parcel->readUtf8FromUtf16(&key);
+        if (ret == OK) {
+            ret = readValue(map[String16(key)]);
+        }
+    }
+    return ret;
+}
+
+status_t PersistableBundle::readFromParcel(const Parcel* parcel) {
+    status_t ret = readMap(parcel, mBools, [parcel](bool& v) { return parcel->readBool(&v); });
+    if (ret == OK) {
+        ret = readMap(parcel, mInts, [parcel](int32_t& v) { return parcel->readInt32(&v); });
+    }
+    if (ret == OK) {
+        ret = readMap(parcel, mLongs, [parcel](int64_t& v) { return parcel->readInt64(&v); });
+    }
+    if (ret == OK) {
+        ret = readMap(parcel, mDoubles, [parcel](double& v) { return parcel->readDouble(&v); });
+    }
+    if (ret == OK) {
+        ret = readMap(parcel, mStrings, [parcel](String16& v) {
+            std::string str;
+            const status_t r = parcel->readUtf8FromUtf16(&str);
+            v = String16(str);
+            return r;
+        });
+    }
+    return ret;
+}
+
+} // namespace os
+} // namespace android
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AppSpawn"
+
+#include "HostAppSpawn.h"
+
+#include "AppSpawn.h"
+#include "app/Logger.h"
+#include "app/UvLoop.h"
+
+namespace os {
+namespace app {
+
+// the last AppSpawn that is initialized, it's the one of activity manager
+static AppSpawn* sAppSpawn = nullptr;
+static host::SpawnHandler sSpawnHandler;
+static int sNextFakePid = 4 * 1024 * 1024 + 1; // PID_MAX_LIMIT on 64-bit linux
+
+AppSpawn::AppSpawn()
+      : mIsSpawning(false),
+        mSpawnCount(0),
+        mCompletedCount(0),
+        mIsExiting(false),
+        mIsSpawnerStarted(false),
+        mIsAsyncInit(false) {}
+
+AppSpawn::~AppSpawn() {
+    if (mIsAsyncInit) {
+        uvCloseHandle((uv_handle_t*)&mCompletionAsync);
+    }
+}
+
+// there is no spawner thread, the spawns are completed on the next loop iteration, like the
+// spawner thread is done at once
+int AppSpawn::signalInit(uv_loop_t* looper, const ChildPidExitCB& cb) {
+    mChildPidExitCB = cb;
+    sAppSpawn = this;
+    mCompletionAsync.data = this;
+    uv_async_init(looper, &mCompletionAsync,
+                  [](uv_async_t* handle) { ((AppSpawn*)handle->data)->deliver(); });
+    uv_unref((uv_handle_t*)&mCompletionAsync);
+    mIsAsyncInit = true;
+    return 0;
+}
+
+int AppSpawn::appSpawn(const char* execfile, std::initializer_list<std::string> argvlist) {
+    ALOGD("appSpawn :%s", execfile);
+    if (sSpawnHandler) {
+        return sSpawnHandler(execfile, std::vector<std::string>(argvlist));
+    }
+    return host::allocFakePid();
+}
+
+void AppSpawn::appSpawnAsync(const std::string& execfile, std::vector<std::string>&& args,
+                             SpawnCB&& cb) {
+    mCompletions.push_back({execfile, std::move(args), std::move(cb), -1});
+    uv_async_send(&mCompletionAsync);
+}
+
+void AppSpawn::deliverSpawned() {
+    deliver();
+}
+
+// the pid is allocated when the spawn is delivered, no pid is ever in flight
+bool AppSpawn::isSpawning() {
+    return false;
+}
+
+int AppSpawn::deliver() {
+    std::deque<SpawnRequest> completions;
+    completions.swap(mCompletions);
+    for (auto& completion : completions) {
+        // the process is played from the moment that it's spawned
+        ALOGD("appSpawn :%s", completion.execfile.c_str());
+        completion.pid = sSpawnHandler ? sSpawnHandler(completion.execfile, completion.args)
+                                       : host::allocFakePid();
+        completion.callback(completion.pid);
+    }
+    return completions.size();
+}
+
+namespace host {
+
+void setSpawnHandler(const SpawnHandler& handler) {
+    sSpawnHandler = handler;
+}
+
+int allocFakePid() {
+    return sNextFakePid++;
+}
+
+void exitProcess(int pid) {
+    if (sAppSpawn && sAppSpawn->mChildPidExitCB) {
+        sAppSpawn->mChildPidExitCB(pid);
+    }
+}
+
+} // namespace host
+} // namespace app
+} // namespace os
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <kvdb.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+static std::mutex sMutex;
+static std::map<std::string, std::string> sProperties;
+
+int property_set(const char* key, const char* value) {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sProperties[key] = value;
+    return 0;
+}
+
+int property_get(const char* key, char* value, const char* defaultValue) {
+    std::lock_guard<std::mutex> lock(sMutex);
+    const auto it = sProperties.find(key);
+    const char* str = it != sProperties.end() ? it->second.c_str() : defaultValue;
+    if (!str) {
+        value[0] = '\0';
+        return 0;
+    }
+    strncpy(value, str, PROP_VALUE_MAX - 1);
+    value[PROP_VALUE_MAX - 1] = '\0';
+    return strlen(value);
+}
+
+int8_t property_get_bool(const char* key, int8_t defaultValue) {
+    char value[PROP_VALUE_MAX];
+    if (property_get(key, value, nullptr) <= 0) {
+        return defaultValue;
+    }
+    if (!strcmp(value, "1") || !strcmp(value, "true") || !strcmp(value, "y")) {
+        return 1;
+    }
+    if (!strcmp(value, "0") || !strcmp(value, "false") || !strcmp(value, "n")) {
+        return 0;
+    }
+    return defaultValue;
+}
+
+int32_t property_get_int32(const char* key, int32_t defaultValue) {
+    char value[PROP_VALUE_MAX];
+    if (property_get(key, value, nullptr) <= 0) {
+        return defaultValue;
+    }
+    return atoi(value);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <sys/sysinfo.h>
+
+#include <algorithm>
+
+#include "HostMemory.h"
+
+static os::am::host::MallinfoHook sMallinfoHook;
+
+static int toInt(const uint64_t bytes) {
+    return (int)std::min<uint64_t>(bytes, INT_MAX);
+}
+
+struct mallinfo mallinfo(void) {
+    if (sMallinfoHook) {
+        return sMallinfoHook();
+    }
+    struct mallinfo info = {};
+    struct sysinfo sys;
+    if (sysinfo(&sys) == 0) {
+        const uint64_t totalBytes = (uint64_t)sys.totalram * sys.mem_unit;
+        const uint64_t freeBytes = (uint64_t)sys.freeram * sys.mem_unit;
+        info.arena = toInt(totalBytes);
+        info.ordblks = 1;
+        info.mxordblk = toInt(freeBytes);
+        info.uordblks = toInt(totalBytes - freeBytes);
+        info.fordblks = toInt(freeBytes);
+    }
+    return info;
+}
+
+void os::am::host::setMallinfoHook(const MallinfoHook& hook) {
+    sMallinfoHook = hook;
+}
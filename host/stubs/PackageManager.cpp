@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pm/PackageManager.h>
+
+#include <map>
+#include <mutex>
+
+namespace os {
+namespace pm {
+
+static std::mutex sMutex;
+// ordered by the package name, like the package list that is scanned from the disk
+static std::map<std::string, PackageInfo> sPackages;
+static uint64_t sQueryCount = 0;
+
+int PackageManager::getPackageInfo(const std::string& packageName, PackageInfo* info) {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sQueryCount++;
+    const auto it = sPackages.find(packageName);
+    if (it == sPackages.end()) {
+        return -1;
+    }
+    *info = it->second;
+    return 0;
+}
+
+int PackageManager::getAllPackageInfo(std::vector<PackageInfo>* infoList) {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sQueryCount++;
+    infoList->clear();
+    infoList->reserve(sPackages.size());
+    for (const auto& it : sPackages) {
+        infoList->push_back(it.second);
+    }
+    return 0;
+}
+
+void PackageManager::installPackage(const PackageInfo& info) {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sPackages[info.packageName] = info;
+}
+
+void PackageManager::clearPackages() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sPackages.clear();
+}
+
+uint64_t PackageManager::getQueryCount() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    return sQueryCount;
+}
+
+} // namespace pm
+} // namespace os
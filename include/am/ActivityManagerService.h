@@ -44,7 +44,9 @@ public:
     ~ActivityManagerService();
 
     /***binder api***/
-    Status attachApplication(const sp<os::app::IApplicationThread>& app, int32_t* ret) override;
+    Status attachApplication(const sp<os::app::IApplicationThread>& app,
+                             std::vector<os::app::ActivityLaunch>* launches,
+                             int32_t* ret) override;
 
     Status startActivity(const sp<IBinder>& token, const Intent& intent, int32_t code,
                          int32_t* ret) override;
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/IBinder.h>
+#include <binder/Parcel.h>
+
+#include <string>
+
+#include "app/Intent.h"
+
+namespace os {
+namespace app {
+
+/** The activity that comes with the attachApplication reply */
+class ActivityLaunch : public android::Parcelable {
+public:
+    std::string mName;
+    android::sp<android::IBinder> mToken;
+    Intent mIntent;
+    int32_t mTargetStatus; // the inside status of AMS, CREATED, STARTED or RESUMED
+
+    ActivityLaunch() : mTargetStatus(0) {}
+    ActivityLaunch(const std::string& name, const android::sp<android::IBinder>& token,
+                   const Intent& intent, int32_t targetStatus)
+          : mName(name), mToken(token), mIntent(intent), mTargetStatus(targetStatus) {}
+
+    android::status_t readFromParcel(const android::Parcel* parcel) final;
+    android::status_t writeToParcel(android::Parcel* parcel) const final;
+}; // class ActivityLaunch
+
+} // namespace app
+} // namespace os
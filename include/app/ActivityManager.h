@@ -19,7 +19,9 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
+#include "app/ActivityLaunch.h"
 #include "app/Intent.h"
 #include "os/am/IActivityManager.h"
 #include "os/app/IApplicationThread.h"
@@ -59,7 +61,16 @@ public:
         DESTROYED = 11,
     };
 
-    int32_t attachApplication(const sp<os::app::IApplicationThread>& app);
+    /** The memory trim level, the higher level the more memory should be released */
+    enum {
+        TRIM_MEMORY_BACKGROUND = 1,
+        TRIM_MEMORY_MODERATE = 2,
+        TRIM_MEMORY_COMPLETE = 3, // the process will be killed if memory is still low
+    };
+
+    /** The launches must be scheduled by the caller, activity manager doesn't send them again */
+    int32_t attachApplication(const sp<os::app::IApplicationThread>& app,
+                              std::vector<ActivityLaunch>& launches);
     int32_t startActivity(const sp<IBinder>& token, const Intent& intent, int32_t requestCode);
     int32_t stopActivity(const Intent& intent, int32_t resultCode);
     int32_t stopApplication(const sp<IBinder>& token);
@@ -63,6 +63,11 @@ public:
     virtual void onBackground() = 0;
     virtual void onDestroy() = 0;
     virtual void onReceiveIntent(const Intent& intent){};
+    /** The application will stop running soon, until onThaw */
+    virtual void onFreeze(){};
+    virtual void onThaw(){};
+    /** Release the memory that can be rebuilt, otherwise the application may be killed */
+    virtual void onTrimMemory(int level){};
 
     const string& getPackageName() const;
     void setPackageName(const string& name);
@@ -98,6 +103,12 @@ private:
     void deleteService(const sp<IBinder>& token);
 
     void clearActivityAndService();
+    /**
+     * The restarted activity manager gives new tokens, the components are matched by name, and
+     * the activities of the same name by their launch order
+     */
+    void reattach(const vector<string>& activityNames, const vector<sp<IBinder>>& activityTokens,
+                  const vector<string>& serviceNames, const vector<sp<IBinder>>& serviceTokens);
 
 private:
     map<sp<IBinder>, std::shared_ptr<ActivityClientRecord>> mExistActivities;
@@ -105,6 +116,7 @@ private:
     string mPackageName;
     map<string, CreateActivityFunc> mActivityMap;
     map<string, CreateServiceFunc> mServiceMap;
+    uint32_t mLaunchCount;
     int mUid;
     int mPid;
     UvLoop* mMainLoop;
@@ -36,9 +36,17 @@ public:
     ~ApplicationThread();
     int mainRun(int argc, char** argv);
     void stop();
+    /** The activity manager died, attach to the restarted one until it's done or rejected */
+    void reattachApplication();
 
 private:
+    /** The retry of the attach that is too early is on the loop, false if it fails at once */
+    bool attachApplication(const int retry);
+    void watchActivityManager();
+
     Application* mApp;
+    sp<ApplicationThreadStub> mAppThread;
+    sp<IBinder::DeathRecipient> mDeathRecipient;
 };
 
 } // namespace app
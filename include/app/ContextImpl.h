@@ -72,7 +72,7 @@ public:
 public:
     const Application* mApp;
     const string mComponentName;
-    const sp<IBinder> mToken;
+    sp<IBinder> mToken; // replaced when the restarted activity manager adopts the component
     UvLoop* mLoop;
 
     ActivityManager mAm;
@@ -14,7 +14,7 @@
 #endif
 
 #ifndef __NuttX__
-#define am_log_print(level, fmt, ...) printf(fmt, __VA_ARGS__)
+#define am_log_print(level, fmt, ...) printf(fmt "\n", ##__VA_ARGS__)
 #else
 #include <syslog.h>
 #define am_log_print(level, fmt, ...) syslog(level, fmt, ##__VA_ARGS__)
@@ -42,7 +42,7 @@ public:
 
 private:
     friend class ServiceClientRecord;
-    int bind(const Intent& intent, const sp<IServiceConnection>& conn);
+    int bind(const Intent& intent);
     void unbind();
 
     sp<IBinder> mServiceBinder;
@@ -174,10 +174,10 @@ private:
 class UvTimer {
 public:
     UvTimer() {
-        mHandler = new uv_timer_t;
+        mHandler = new uv_timer_t();
     }
     UvTimer(uv_loop_t* loop, const UV_CALLBACK& cb) {
-        mHandler = new uv_timer_t;
+        mHandler = new uv_timer_t();
         init(loop, cb);
     }
     ~UvTimer() {
@@ -210,7 +210,11 @@ public:
     }
 
     void close() {
-        if (mHandler && !uv_is_closing((uv_handle_t*)mHandler)) {
+        if (mHandler && !mHandler->loop) {
+            // it's never initialized, the loop doesn't know it
+            delete mHandler;
+            mHandler = nullptr;
+        } else if (mHandler && !uv_is_closing((uv_handle_t*)mHandler)) {
             uv_close((uv_handle_t*)mHandler,
                      [](uv_handle_t* handler) { delete reinterpret_cast<uv_timer_t*>(handler); });
             mHandler = nullptr;
@@ -19,7 +19,9 @@
 #include <binder/IPCThreadState.h>
 #include <kvdb.h>
 #include <pm/PackageManager.h>
+#include <signal.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <list>
@@ -28,11 +30,20 @@
 #include <vector>
 
 #include "ActivityTrace.h"
+#include "AppFreezer.h"
+#include "AppPreloader.h"
 #include "AppRecord.h"
 #include "AppSpawn.h"
+#include "BinderStats.h"
+#include "BootOrchestrator.h"
+#include "DumpWriter.h"
 #include "IntentAction.h"
+#include "LaunchBooster.h"
+#include "LaunchTrace.h"
 #include "LowMemoryManager.h"
+#include "MemoryCgroup.h"
 #include "ProcessPriorityPolicy.h"
+#include "StateJournal.h"
 #include "TaskBoard.h"
 #include "TaskManager.h"
 #include "app/ActivityManager.h"
@@ -55,6 +66,58 @@ using android::sp;
 #define AMS_RUNMODE_FILE "/data/ams.runmode"
 #endif
 
+#ifdef CONFIG_AM_LAUNCH_TRACE_NUM
+#define AM_LAUNCH_TRACE_NUM CONFIG_AM_LAUNCH_TRACE_NUM
+#else
+#define AM_LAUNCH_TRACE_NUM 32
+#endif
+
+#ifdef CONFIG_AM_STATE_JOURNAL_FILE
+#define AM_STATE_JOURNAL_FILE CONFIG_AM_STATE_JOURNAL_FILE
+#else
+#define AM_STATE_JOURNAL_FILE "/tmp/ams.journal"
+#endif
+
+#ifdef CONFIG_AM_STATE_JOURNAL_SIZE
+#define AM_STATE_JOURNAL_SIZE CONFIG_AM_STATE_JOURNAL_SIZE
+#else
+#define AM_STATE_JOURNAL_SIZE 16384
+#endif
+
+#ifdef CONFIG_AM_PRELOAD_BUDGET
+#define AM_PRELOAD_BUDGET CONFIG_AM_PRELOAD_BUDGET
+#else
+#define AM_PRELOAD_BUDGET 0
+#endif
+
+#ifdef CONFIG_AM_BOOT_MANIFEST
+#define AM_BOOT_MANIFEST CONFIG_AM_BOOT_MANIFEST
+#else
+#define AM_BOOT_MANIFEST "/etc/ams/boot.manifest"
+#endif
+
+// ACTION_BOOT_COMPLETED is broadcast anyway if the boot entries or the home aren't ready in time
+static const int BOOT_TIMEOUT_MS = 10000;
+
+// the recovered processes that don't attach again in time are given up
+static const int REATTACH_TIMEOUT_MS = 5000;
+
+// the version of "dump --json" output
+static const int DUMP_SCHEMA_VERSION = 1;
+
+#ifdef CONFIG_AM_BINDER_STATS
+#define AM_BINDER_STATS(method) \
+    BinderStats::Scope binderStatsScope(mInner->getBinderStats(), BinderStats::method)
+#else
+#define AM_BINDER_STATS(method)
+#endif
+
+#ifdef CONFIG_AM_STATE_JOURNAL
+#define AM_JOURNAL(call) mJournal.call
+#else
+#define AM_JOURNAL(call)
+#endif
+
 /** Different applications have different operating environments **/
 static const string APP_TYPE_QUICK = "QUICKAPP";
 static const string APP_TYPE_NATIVE = "NATIVE";
@@ -66,6 +129,11 @@ static const string VSERVICE_EXEC_NAME = "vservice";
 static void getPackageAndComponentName(const string& target, string& packageName,
                                        string& componentName);
 
+struct ReceiverRecord {
+    sp<IBroadcastReceiver> receiver;
+    int pid;
+};
+
 class ActivityManagerInner {
 public:
     enum RunMode {
@@ -75,7 +143,7 @@ public:
     };
     ActivityManagerInner(uv_loop_t* looper);
 
-    int attachApplication(const sp<IApplicationThread>& app);
+    int attachApplication(const sp<IApplicationThread>& app, std::vector<FusedLaunch>& launches);
     int startActivity(const sp<IBinder>& token, const Intent& intent, int32_t requestCode);
     int stopActivity(const Intent& intent, int32_t resultCode);
     int stopApplication(const sp<IBinder>& token);
@@ -103,35 +171,66 @@ public:
 
     void systemReady();
     void procAppTerminated(const std::shared_ptr<AppRecord>& appRecord);
+    /** The spawned process exit is signaled, the adopted one is known by the binder death */
+    void onProcessExit(pid_t pid);
 
     void setWindowManager(sp<::os::wm::IWindowManager> wm) {
         mWindowManager = wm;
     }
 
+#ifdef CONFIG_AM_BINDER_STATS
+    BinderStats& getBinderStats() {
+        return mBinderStats;
+    }
+#endif
+
 private:
     int startActivityReal(ITaskManager* taskmanager, const string& activityName,
-                          PackageInfo& packageInfo, const Intent& intent, const sp<IBinder>& caller,
-                          const int32_t requestCode);
-    int startServiceReal(const string& serviceName, PackageInfo& packageInfo, const Intent& intent,
-                         const bool isBind, const sp<IBinder>& caller,
-                         const sp<IServiceConnection>& conn);
+                          const PackageInfo& packageInfo, const Intent& intent,
+                          const sp<IBinder>& caller, const int32_t requestCode);
+    int startServiceReal(const string& serviceName, const PackageInfo& packageInfo,
+                         const Intent& intent, const bool isBind, const sp<IBinder>& caller,
+                         const sp<IServiceConnection>& conn, const int callerPid);
     int intentToSingleTarget(const Intent& intent, PackageInfo& packageInfo, string& componentName,
                              const IntentAction::ComponentType type);
-    int intentToMultiTarget(const Intent& intent, vector<PackageInfo>& packageInfoList,
-                            vector<string>& componentNameList,
+    int intentToMultiTarget(const Intent& intent, vector<IntentTarget>& targets,
                             const IntentAction::ComponentType type);
     int broadcastIntent(const Intent& intent, const IntentAction::ComponentType type);
     void stopServiceReal(ServiceHandler& service);
     bool startBootGuide();
     int startHomeActivity();
+    using PrepareFunc = std::function<void(pid_t)>;
+    /**
+     * The launch of an activity replaces the queued launch of the same one. The preparation
+     * doesn't wait for the attachment, it runs on the loop while the process is spawning.
+     */
     int submitAppStartupTask(const string& packageName, const string& prcocessName,
-                             const string& execfile, AppAttachTask::TaskFunc&& task,
-                             bool isSupportMultiTask);
+                             const string& execfile, const string& componentName,
+                             PrepareFunc&& prepare, AppAttachTask::TaskFunc&& task,
+                             const ActivityHandler& activity = nullptr);
+    void onAppSpawned(const string& packageName, const string& processName,
+                      const string& execfile, int pid, uint64_t beginTime);
+    void prepareLaunches(pid_t pid);
+    void boostLaunch(pid_t pid, const uint32_t launchId);
+    void trimApplication(pid_t pid, int level);
+    void replayPendingLaunches(const AppAttachTask::Event* e);
+    void dropPendingLaunches(pid_t pid);
     int findSystemTarget(const string& targetAlias, std::shared_ptr<AppRecord>& app,
                          sp<IBinder>& token);
     ActivityHandler getActivity(const sp<IBinder>& token);
     inline ITaskManager* getTaskManager(bool isSystemUI);
     inline ActivityHandler getTopActivity();
+    bool isFreezable(pid_t pid);
+    bool isInRecentTasks(const std::shared_ptr<AppRecord>& app);
+
+    void journalActivityAdded(const ActivityHandler& activity);
+    void journalTaskOrder();
+#ifdef CONFIG_AM_STATE_JOURNAL
+    void reattachApplication(const sp<IApplicationThread>& app, const RecoveredApp& recovered);
+    void restoreTasks(const std::shared_ptr<AppRecord>& appRecord, const RecoveredApp& recovered,
+                      vector<string>& activityNames, vector<sp<IBinder>>& activityTokens);
+    void onReattachTimeout();
+#endif
 
 private:
     int mRunMode;
@@ -144,13 +243,62 @@ private:
     IntentAction mActionFilter;
     PackageManager mPm;
     sp<::os::wm::IWindowManager> mWindowManager;
-    map<string, list<sp<IBroadcastReceiver>>> mReceivers; /** Broadcast */
+    map<string, list<ReceiverRecord>> mReceivers; /** Broadcast */
     LowMemoryManager mLmk;
     ProcessPriorityPolicy mPriorityPolicy;
+    AppFreezer mFreezer;
+    LaunchBooster mBooster;
+    MemoryCgroup mMemoryCgroup;
+    LaunchTrace mLaunchTrace;
+#ifdef CONFIG_AM_BINDER_STATS
+    BinderStats mBinderStats;
+#endif
     AppSpawn mAppSpawn;
+    BootOrchestrator mBoot;
+    AppPreloader mPreloader;
+#ifdef CONFIG_AM_STATE_JOURNAL
+    StateJournal mJournal;
+    RecoveredState mRecovered; // the processes of the last run that haven't attached again
+    map<uint32_t, std::weak_ptr<ActivityStack>> mRestoredTasks;
+    map<pid_t, sp<IBinder::DeathRecipient>> mDeathRecipients; // of the adopted processes
+#endif
+
+    struct PendingLaunch {
+        ActivityHandler activity; // null for a service
+        string componentName;
+        PrepareFunc prepare;      // null when it's done
+        AppAttachTask::TaskFunc task;
+    };
+    void queueLaunch(vector<PendingLaunch>& launches, PendingLaunch&& launch);
+    // the launches that wait for the process to attach, in the order that they are requested
+    map<pid_t, vector<PendingLaunch>> mPendingLaunches;
+    // the launches of the processes that the spawner thread is spawning, by the process name
+    map<string, vector<PendingLaunch>> mSpawningLaunches;
 };
 
-ActivityManagerInner::ActivityManagerInner(uv_loop_t* looper) : mPriorityPolicy(&mLmk) {
+#ifdef CONFIG_AM_STATE_JOURNAL
+class AppDeathRecipient : public IBinder::DeathRecipient {
+public:
+    AppDeathRecipient(ActivityManagerInner* inner, pid_t pid) : mInner(inner), mPid(pid) {}
+
+    void binderDied(const android::wp<IBinder>& who) override {
+        mInner->onProcessExit(mPid);
+    }
+
+private:
+    ActivityManagerInner* mInner;
+    const pid_t mPid;
+};
+
+static bool isProcessAlive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+#endif
+
+ActivityManagerInner::ActivityManagerInner(uv_loop_t* looper)
+      : mPriorityPolicy(&mLmk),
+        mLaunchTrace(AM_LAUNCH_TRACE_NUM),
+        mPreloader(AM_PRELOAD_BUDGET) {
     mRunMode = NORMAL_MODE;
     if (std::filesystem::exists(AMS_RUNMODE_FILE)) {
         std::ifstream file;
@@ -173,9 +321,50 @@ ActivityManagerInner::ActivityManagerInner(uv_loop_t* looper) : mPriorityPolicy(
             apprecord->stopApplication();
         }
     });
+    mLmk.setTrimMemoryExecutor([this](pid_t pid, int level) { trimApplication(pid, level); });
+    // the application that is out of its own limit is handled alone
+    mMemoryCgroup.init(
+            mLooper, [this](pid_t pid, int level) { trimApplication(pid, level); },
+            [this](pid_t pid) {
+                if (auto apprecord = mAppInfo.findAppInfo(pid)) {
+                    apprecord->stopApplication();
+                }
+            });
+    if (mMemoryCgroup.isEnabled()) {
+        mPriorityPolicy.getCpuClassPolicy().disableCgroup();
+        mPriorityPolicy.getCpuClassPolicy().addBandChangedCallback(
+                [this](pid_t pid, CpuClassPolicy::Band band) {
+                    mMemoryCgroup.onBandChanged(pid, band);
+                });
+    }
+    mFreezer.init(
+            mLooper, [this](pid_t pid) { return isFreezable(pid); },
+            [this](pid_t pid, bool isFrozen) {
+                if (auto apprecord = mAppInfo.findAppInfoWithAlive(pid)) {
+                    apprecord->mAppThread->setFrozenApplication(isFrozen);
+                }
+            });
+    mBooster.init(mLooper, [this] { return mPriorityPolicy.getBackgroundPids(); });
+    // the boosted processes get their CPU class when the boost ends
+    mPriorityPolicy.getCpuClassPolicy().setOverride(
+            [this](pid_t pid, int level) { return mBooster.rebase(pid, level); });
+    mPriorityPolicy.addForegroundChangedCallback([this](pid_t pid, bool isForeground) {
+        mFreezer.onForegroundChanged(pid, isForeground);
+    });
+#ifdef CONFIG_AM_STATE_JOURNAL
+    if (mJournal.open(AM_STATE_JOURNAL_FILE, AM_STATE_JOURNAL_SIZE)) {
+        mJournal.recover(mRecovered);
+        for (auto it = mRecovered.apps.begin(); it != mRecovered.apps.end();) {
+            it = isProcessAlive(it->first) ? std::next(it) : mRecovered.apps.erase(it);
+        }
+        // the processes that are gone are dropped, the others are kept until they attach
+        mJournal.reset(mRecovered);
+    }
+#endif
 }
 
-int ActivityManagerInner::attachApplication(const sp<IApplicationThread>& app) {
+int ActivityManagerInner::attachApplication(const sp<IApplicationThread>& app,
+                                            std::vector<FusedLaunch>& launches) {
     AM_PROFILER_BEGIN();
     const int callerPid = android::IPCThreadState::self()->getCallingPid();
     auto appRecord = mAppInfo.findAppInfo(callerPid);
@@ -188,31 +377,242 @@ int ActivityManagerInner::attachApplication(const sp<IApplicationThread>& app) {
     const int callerUid = android::IPCThreadState::self()->getCallingUid();
 
     string packageName;
+    if (!mAppInfo.getAttachingAppName(callerPid, packageName) && !mSpawningLaunches.empty()) {
+        // the new process runs before the spawn completion gets to the loop
+        mAppSpawn.deliverSpawned();
+    }
     if (mAppInfo.getAttachingAppName(callerPid, packageName)) {
         PackageInfo packageinfo;
         mPm.getPackageInfo(packageName, &packageinfo);
         appRecord = std::make_shared<AppRecord>(app, packageName, packageinfo.isSystemUI, callerPid,
-                                                callerUid, &mAppInfo, &mPriorityPolicy);
+                                                callerUid, &mAppInfo, &mPriorityPolicy, &mFreezer);
         ALOGI("attachApplication. pid:%d packagename:[%s]", callerPid,
               appRecord->mPackageName.data());
         mAppInfo.deleteAppWaitingAttach(callerPid);
         mAppInfo.addAppInfo(appRecord);
+        AM_JOURNAL(appAttached(callerPid, callerUid, packageinfo.isSystemUI, packageName));
+        // the activities that wait for the attachment are launched with the reply
         const AppAttachTask::Event event(callerPid, appRecord);
+        appRecord->mFusedLaunches = &launches;
         mPendTask.eventTrigger(event);
+        appRecord->mFusedLaunches = nullptr;
+        for (const auto& launch : launches) {
+            // scheduleLaunchActivity, and scheduleStartActivity/scheduleResumeActivity
+            const int saved = 1 + (launch.targetStatus >= ActivityRecord::STARTED) +
+                    (launch.targetStatus >= ActivityRecord::RESUMED);
+            mLaunchTrace.addSavedRequests(launch.activity->getLaunchId(), saved);
+        }
 
         // broadcast app start
         Intent intent;
         intent.setAction(Intent::BROADCAST_APP_START);
         intent.setData(packageName);
         sendBroadcast(intent);
+#ifdef CONFIG_AM_STATE_JOURNAL
+    } else if (const auto it = mRecovered.apps.find(callerPid); it != mRecovered.apps.end()) {
+        const RecoveredApp recovered = std::move(it->second);
+        mRecovered.apps.erase(it);
+        reattachApplication(app, recovered);
+#endif
+    } else if (!mSpawningLaunches.empty() && mAppSpawn.isSpawning()) {
+        // posix_spawn of it may not return yet, the loop isn't blocked, it attaches again
+        ALOGW("the application:%d attaches before its spawn completes", callerPid);
+        AM_PROFILER_END();
+        return android::WOULD_BLOCK;
     } else {
         ALOGE("the application:%d attaching is illegally", callerPid);
+#ifdef CONFIG_AM_STATE_JOURNAL
+        // the process of the last run that isn't adopted must not run without its components
+        AM_PROFILER_END();
+        return android::BAD_VALUE;
+#endif
     }
 
     AM_PROFILER_END();
     return android::OK;
 }
 
+#ifdef CONFIG_AM_STATE_JOURNAL
+void ActivityManagerInner::reattachApplication(const sp<IApplicationThread>& app,
+                                               const RecoveredApp& recovered) {
+    ALOGW("reattachApplication. pid:%d packagename:[%s]", recovered.pid,
+          recovered.packageName.c_str());
+    const auto appRecord =
+            std::make_shared<AppRecord>(app, recovered.packageName, recovered.isSystemUI,
+                                        recovered.pid, recovered.uid, &mAppInfo, &mPriorityPolicy,
+                                        &mFreezer);
+    mAppInfo.addAppInfo(appRecord);
+    if (recovered.priority >= 0) {
+        mPriorityPolicy.add(recovered.pid, false, (ProcessPriority)recovered.priority);
+    }
+    const sp<IBinder::DeathRecipient> recipient(new AppDeathRecipient(this, recovered.pid));
+    if (android::IInterface::asBinder(app)->linkToDeath(recipient) == android::OK) {
+        mDeathRecipients[recovered.pid] = recipient;
+    }
+
+    vector<string> activityNames;
+    vector<sp<IBinder>> activityTokens;
+    restoreTasks(appRecord, recovered, activityNames, activityTokens);
+
+    // the connections are kept by the clients, the bound service stays until it's stopped
+    vector<string> serviceNames;
+    vector<sp<IBinder>> serviceTokens;
+    for (const auto& it : recovered.services) {
+        if (it.startFlag == ServiceRecord::F_UNKNOW) {
+            continue;
+        }
+        const sp<IBinder> token(new android::BBinder());
+        const auto service = std::make_shared<ServiceRecord>(
+                it.name, token, (ProcessPriority)it.priority, appRecord);
+        service->mStatus = it.status;
+        service->mStartFlag = it.startFlag;
+        mServices.addService(service);
+        appRecord->addService(service);
+        mJournal.bindId(token.get(), it.id);
+        serviceNames.push_back(it.name);
+        serviceTokens.push_back(token);
+    }
+    // the application maps its components to the new tokens before any other request
+    app->scheduleReattachApplication(activityNames, activityTokens, serviceNames, serviceTokens);
+
+    // only the top Activity of the front task is resumed, whatever the application thinks
+    auto taskmanager = getTaskManager(recovered.isSystemUI);
+    if (!recovered.isSystemUI) {
+        const auto activeTask = taskmanager->getActiveTask();
+        for (const auto& task : taskmanager->getTasks()) {
+            const auto top = task->getTopActivity();
+            if (!top || top->getAppRecord() != appRecord) {
+                continue;
+            }
+            if (task == activeTask && top->getStatus() != ActivityRecord::RESUMED) {
+                top->lifecycleTransition(ActivityRecord::RESUMED);
+            } else if (task != activeTask && top->getStatus() == ActivityRecord::RESUMED) {
+                top->lifecycleTransition(ActivityRecord::STOPPED);
+            }
+        }
+    }
+    journalTaskOrder();
+    if (mRecovered.apps.empty()) {
+        mRestoredTasks.clear();
+    }
+}
+
+void ActivityManagerInner::restoreTasks(const std::shared_ptr<AppRecord>& appRecord,
+                                        const RecoveredApp& recovered,
+                                        vector<string>& activityNames,
+                                        vector<sp<IBinder>>& activityTokens) {
+    auto taskmanager = getTaskManager(recovered.isSystemUI);
+    vector<std::pair<uint32_t, ActivityStackHandler>> newTasks;
+    vector<ActivityStackHandler> sharedTasks;
+    for (const auto& it : recovered.activities) {
+        ActivityStackHandler task;
+        if (const auto restored = mRestoredTasks.find(it.taskId);
+            restored != mRestoredTasks.end()) {
+            task = restored->second.lock();
+        }
+        if (!task) {
+            task = std::make_shared<ActivityStack>(it.taskTag);
+            mRestoredTasks[it.taskId] = task;
+            mJournal.bindId(task.get(), it.taskId);
+            newTasks.emplace_back(it.taskId, task);
+        } else if (std::find(sharedTasks.begin(), sharedTasks.end(), task) == sharedTasks.end()) {
+            sharedTasks.push_back(task);
+        }
+
+        const auto activity = std::make_shared<ActivityRecord>(
+                it.name, nullptr, ActivityManager::NO_REQUEST,
+                (ActivityRecord::LaunchMode)it.launchMode, task, Intent(), mWindowManager,
+                taskmanager, &mPendTask);
+        activity->setAppThread(appRecord);
+        appRecord->addActivity(activity);
+        // the launch in flight is completed by the application, or it reports destroyed
+        activity->restoreStatus(
+                (ActivityRecord::Status)std::max(it.status, (int)ActivityRecord::CREATED));
+        mJournal.bindId(activity->getToken().get(), it.id);
+        mActivityMap[activity->getToken()] = activity;
+        task->pushActivity(activity);
+        if (std::find(sharedTasks.begin(), sharedTasks.end(), task) != sharedTasks.end() &&
+            task == taskmanager->getActiveTask()) {
+            appRecord->setForeground(true);
+        }
+
+        const auto pos = it.name.find_first_of('/');
+        activityNames.push_back(it.name.substr(pos + 1, std::string::npos));
+        activityTokens.push_back(activity->getToken());
+    }
+
+    // the task is shared with the processes that attached earlier, the order is the push order
+    for (const auto& task : sharedTasks) {
+        auto activities = task->getActivityArray();
+        std::stable_sort(activities.begin(), activities.end(),
+                         [this](const ActivityHandler& a, const ActivityHandler& b) {
+                             return mJournal.getId(a->getToken().get()) <
+                                     mJournal.getId(b->getToken().get());
+                         });
+        while (task->getSize() > 0) {
+            task->popActivity();
+        }
+        for (const auto& activity : activities) {
+            task->pushActivity(activity);
+        }
+    }
+
+    // the task is restored in front of the next one in the recovered order
+    const auto& order = mRecovered.taskOrder;
+    for (const auto& [taskId, task] : newTasks) {
+        ActivityStackHandler before;
+        for (auto next = std::find(order.begin(), order.end(), taskId);
+             next != order.end() && !before; ++next) {
+            if (const auto restored = mRestoredTasks.find(*next);
+                *next != taskId && restored != mRestoredTasks.end()) {
+                before = restored->second.lock();
+            }
+        }
+        taskmanager->restoreTask(task, before, taskId == mRecovered.homeTaskId);
+    }
+}
+
+void ActivityManagerInner::onReattachTimeout() {
+    for (const auto& [pid, app] : mRecovered.apps) {
+        // the pid may belong to another process now, so it's never killed
+        ALOGW("the application:%s[%d] doesn't attach again, give it up", app.packageName.c_str(),
+              pid);
+        mJournal.appExited(pid);
+    }
+    mRecovered.apps.clear();
+    mRestoredTasks.clear();
+    if (!mTaskManager.getManager(StandardMode)->getActiveTask() && mRunMode == NORMAL_MODE) {
+        startHomeActivity();
+    }
+}
+#endif
+
+void ActivityManagerInner::journalActivityAdded(const ActivityHandler& activity) {
+#ifdef CONFIG_AM_STATE_JOURNAL
+    const auto appRecord = activity->getAppRecord();
+    const auto task = activity->getTask();
+    if (appRecord && task) {
+        mJournal.activityAdded(appRecord->mPid, activity->getToken().get(), task.get(),
+                               task->getTaskTag(), activity->getLaunchMode(),
+                               activity->getName());
+        journalTaskOrder();
+    }
+#endif
+}
+
+void ActivityManagerInner::journalTaskOrder() {
+#ifdef CONFIG_AM_STATE_JOURNAL
+    if (!mJournal.isOpen()) {
+        return;
+    }
+    vector<const void*> tasks;
+    for (const auto& task : mTaskManager.getManager(StandardMode)->getTasks()) {
+        tasks.push_back(task.get());
+    }
+    mJournal.taskOrder(tasks, mTaskManager.getHomeTask().get());
+#endif
+}
+
 int ActivityManagerInner::startActivity(const sp<IBinder>& caller, const Intent& intent,
                                         int32_t requestCode) {
     AM_PROFILER_BEGIN();
@@ -221,8 +621,11 @@ int ActivityManagerInner::startActivity(const sp<IBinder>& caller, const Intent&
     int ret = android::OK;
     PackageInfo packageInfo;
     string activityName;
+    const uint32_t launchId =
+            mLaunchTrace.beginLaunch(intent.mTarget.empty() ? intent.mAction : intent.mTarget);
     if (intentToSingleTarget(intent, packageInfo, activityName, IntentAction::COMP_TYPE_ACTIVITY) !=
         0) {
+        mLaunchTrace.leaveLaunch(true);
         AM_PROFILER_END();
         return android::BAD_VALUE;
     }
@@ -236,7 +639,27 @@ int ActivityManagerInner::startActivity(const sp<IBinder>& caller, const Intent&
             activityName = packageInfo.entry;
         }
     }
+    mLaunchTrace.setName(launchId, activityName.empty()
+                                           ? packageInfo.packageName
+                                           : packageInfo.packageName + "/" + activityName);
     if (apptask) {
+        pid_t pid = 0;
+        if (const auto root = apptask->getRootActivity()) {
+            if (const auto appRecord = root->getAppRecord()) {
+                pid = appRecord->mPid;
+                mFreezer.thaw(pid);
+            }
+        }
+        mLaunchTrace.setType(launchId, LaunchTrace::HOT);
+        if (const auto top = apptask->getTopActivity()) {
+            top->setLaunchId(launchId);
+            if (top->getStatus() == ActivityRecord::RESUMED) {
+                // it's already in front, nothing to wait for
+                mLaunchTrace.mark(launchId, LaunchTrace::RESUMED);
+            } else {
+                boostLaunch(pid, launchId);
+            }
+        }
         taskmanager->switchTaskToActive(apptask, intent);
     } else {
         ret = startActivityReal(taskmanager, activityName, packageInfo, intent, caller,
@@ -248,19 +671,20 @@ int ActivityManagerInner::startActivity(const sp<IBinder>& caller, const Intent&
         mTaskManager.getManager(SystemUIMode)->onEvent(TaskManagerEvent::StartActivityEvent);
     }
 
+    mLaunchTrace.leaveLaunch(ret != android::OK);
     AM_PROFILER_END();
     return ret;
 }
 
 int ActivityManagerInner::startActivityReal(ITaskManager* taskmanager, const string& activityName,
-                                            PackageInfo& packageInfo, const Intent& intent,
+                                            const PackageInfo& packageInfo, const Intent& intent,
                                             const sp<IBinder>& caller, const int32_t requestCode) {
     AM_PROFILER_BEGIN();
     /** We need to check that the Intent.flag makes sense and perhaps modify it */
     string taskAffinity;
     int startFlag = intent.mFlag;
     ActivityRecord::LaunchMode launchMode = ActivityRecord::LaunchMode::SINGLE_TASK;
-    std::vector<ActivityInfo>::iterator it = packageInfo.activitiesInfo.begin();
+    auto it = packageInfo.activitiesInfo.begin();
     for (; it != packageInfo.activitiesInfo.end(); ++it) {
         if (it->name == activityName) {
             launchMode = ActivityRecord::launchModeToInt(it->launchMode);
@@ -326,32 +750,49 @@ int ActivityManagerInner::startActivityReal(ITaskManager* taskmanager, const str
         }
     }
 
+    // it's 0 if the Activity isn't started by startActivity
+    const uint32_t launchId = mLaunchTrace.currentLaunch();
     if (!targetActivity) {
         auto newActivity =
                 std::make_shared<ActivityRecord>(activityUniqueName, caller, requestCode,
                                                  launchMode, targetTask, intent, mWindowManager,
                                                  taskmanager, &mPendTask);
+        newActivity->setLaunchId(launchId);
         const auto appInfo = mAppInfo.findAppInfoWithAlive(packageInfo.packageName);
         if (appInfo) {
+            mLaunchTrace.setType(launchId, LaunchTrace::WARM);
+            boostLaunch(appInfo->mPid, launchId);
             newActivity->setAppThread(appInfo);
             taskmanager->pushNewActivity(targetTask, newActivity, startFlag);
+            journalActivityAdded(newActivity);
+            mLaunchTrace.mark(launchId, LaunchTrace::LAUNCH_SCHEDULED);
         } else {
             // Check the system environment is adequate for starting the application
             if (!mLmk.isOkToLaunch()) {
-                ALOGE("check launch envirnoment, can't start new application");
+                ALOGD("check launch environment, can't start new application");
                 AM_PROFILER_END();
                 return android::INVALID_OPERATION;
             }
 
+            mLaunchTrace.setType(launchId, LaunchTrace::COLD);
             const ProcessPriority priority = (ProcessPriority)packageInfo.priority;
-            const auto task = [this, taskmanager, targetTask, newActivity, startFlag,
-                               priority](const AppAttachTask::Event* e) {
-                mPriorityPolicy.add(e->mPid, true, priority);
+            const bool isSystemUI = packageInfo.isSystemUI;
+            auto prepare = [this, newActivity, priority, isSystemUI](pid_t pid) {
+                mPriorityPolicy.add(pid, true, priority);
+                newActivity->addWindowToken(isSystemUI);
+            };
+            auto task = [this, taskmanager, targetTask, newActivity, startFlag, priority,
+                         launchId](const AppAttachTask::Event* e) {
+                mLaunchTrace.mark(launchId, LaunchTrace::APP_ATTACHED);
+                AM_JOURNAL(priorityChanged(e->mPid, priority));
                 newActivity->setAppThread(e->mAppRecord);
                 taskmanager->pushNewActivity(targetTask, newActivity, startFlag);
+                journalActivityAdded(newActivity);
+                mLaunchTrace.mark(launchId, LaunchTrace::LAUNCH_SCHEDULED);
             };
             if (submitAppStartupTask(packageInfo.packageName, packageInfo.packageName,
-                                     packageInfo.execfile, std::move(task), false) != 0) {
+                                     packageInfo.execfile, activityName, std::move(prepare),
+                                     std::move(task), newActivity) != 0) {
                 ALOGW("submitAppStartupTask failure");
                 AM_PROFILER_END();
                 return android::INVALID_OPERATION;
@@ -361,6 +802,11 @@ int ActivityManagerInner::startActivityReal(ITaskManager* taskmanager, const str
 
     } else {
         /** if there is no need to create an Activity, caller/requestCode is invalid */
+        mLaunchTrace.setType(launchId, LaunchTrace::HOT);
+        targetActivity->setLaunchId(launchId);
+        if (targetActivity->getStatus() == ActivityRecord::RESUMED) {
+            mLaunchTrace.mark(launchId, LaunchTrace::RESUMED);
+        }
         taskmanager->turnToActivity(targetTask, targetActivity, intent, startFlag);
     }
 
@@ -480,6 +926,7 @@ bool ActivityManagerInner::moveActivityTaskToBackground(const sp<IBinder>& token
         if (activityTask && (nonRoot || activityTask->getRootActivity() == activity)) {
             auto taskmanager = getTaskManager(activity->getAppRecord()->mIsSystemUI);
             ret = taskmanager->moveTaskToBackground(activityTask);
+            journalTaskOrder();
         }
     } else {
         ALOGE("moveActivityTaskToBackground: The token is invalid");
@@ -500,6 +947,30 @@ void ActivityManagerInner::reportActivityStatus(const sp<IBinder>& token, int32_
     ALOGI("reportActivityStatus called by %s [%s]", getActivity(token)->getName().c_str(),
           ActivityRecord::statusToStr(status));
 
+    if (const uint32_t launchId = activity->getLaunchId()) {
+        switch (status) {
+            case ActivityRecord::CREATED:
+                mLaunchTrace.mark(launchId, LaunchTrace::CREATED);
+                break;
+            case ActivityRecord::STARTED:
+                mLaunchTrace.mark(launchId, LaunchTrace::STARTED);
+                break;
+            case ActivityRecord::RESUMED:
+                mLaunchTrace.mark(launchId, LaunchTrace::RESUMED);
+                mBooster.end(launchId);
+                activity->setLaunchId(0);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (status == ActivityRecord::DESTROYED) {
+        AM_JOURNAL(activityRemoved(token.get()));
+    } else {
+        AM_JOURNAL(activityStatus(token.get(), status));
+    }
+
     const ActivityLifeCycleTask::Event event((ActivityRecord::Status)status, token);
     mPendTask.eventTrigger(event);
 
@@ -511,9 +982,28 @@ void ActivityManagerInner::reportActivityStatus(const sp<IBinder>& token, int32_
         sendBroadcast(intent);
     };
 
+    // The caller is waiting for the result, it is kept alive as long as the activity.
+    const auto bindResultCaller = [this, &activity](bool isBind) {
+        if (activity->getRequestCode() == ActivityManager::NO_REQUEST) {
+            return;
+        }
+        const auto callActivity = getActivity(activity->getCaller());
+        const auto appRecord = activity->getAppRecord();
+        const auto callerApp = callActivity ? callActivity->getAppRecord() : nullptr;
+        if (appRecord && callerApp && appRecord != callerApp) {
+            if (isBind) {
+                mPriorityPolicy.bindProcess(appRecord->mPid, callerApp->mPid);
+            } else {
+                mPriorityPolicy.unbindProcess(appRecord->mPid, callerApp->mPid);
+            }
+        }
+    };
+
     // Only "destroy" need special process.
     switch (status) {
         case ActivityRecord::CREATED:
+            bindResultCaller(true);
+            break;
         case ActivityRecord::STARTED:
             break;
         case ActivityRecord::RESUMED: {
@@ -523,7 +1013,12 @@ void ActivityManagerInner::reportActivityStatus(const sp<IBinder>& token, int32_
                 const auto activetask = getTaskManager(appRecord->mIsSystemUI)->getActiveTask();
                 if (activetask && activity == activetask->getTopActivity()) {
                     broadcastTopActivity(activity->getName());
+                    if (!appRecord->mIsSystemUI) {
+                        mBoot.onHomeResumed();
+                    }
                 }
+                const auto pos = activity->getName().find_first_of('/');
+                mBoot.onReady(appRecord->mPackageName, activity->getName().substr(pos + 1));
 
                 if (!appRecord->mIsSystemUI) {
                     const ActivityWaitResume::Event event2(token);
@@ -550,6 +1045,7 @@ void ActivityManagerInner::reportActivityStatus(const sp<IBinder>& token, int32_
             break;
         }
         case ActivityRecord::DESTROYED: {
+            bindResultCaller(false);
             activity->setStatus(ActivityRecord::DESTROYED);
             if (const auto appRecord = activity->getAppRecord()) {
                 bool isSystemUI = appRecord->mIsSystemUI;
@@ -569,6 +1065,9 @@ void ActivityManagerInner::reportActivityStatus(const sp<IBinder>& token, int32_
             break;
         }
     }
+    if (status == ActivityRecord::RESUMED || status == ActivityRecord::DESTROYED) {
+        journalTaskOrder();
+    }
 
     AM_PROFILER_END();
     return;
@@ -582,9 +1081,10 @@ int ActivityManagerInner::startService(const Intent& intent) {
     PackageInfo packageInfo;
     string serviceName;
     int ret = android::BAD_VALUE;
+    // a started service isn't bound to its caller, the caller doesn't promote it
     if (intentToSingleTarget(intent, packageInfo, serviceName, IntentAction::COMP_TYPE_SERVICE) ==
                 0 &&
-        startServiceReal(serviceName, packageInfo, intent, false, nullptr, nullptr) == 0) {
+        startServiceReal(serviceName, packageInfo, intent, false, nullptr, nullptr, 0) == 0) {
         ret = android::OK;
     }
 
@@ -592,13 +1092,15 @@ int ActivityManagerInner::startService(const Intent& intent) {
     return ret;
 }
 
-int ActivityManagerInner::startServiceReal(const string& serviceName, PackageInfo& packageInfo,
+int ActivityManagerInner::startServiceReal(const string& serviceName,
+                                           const PackageInfo& packageInfo,
                                            const Intent& intent, bool isBind,
                                            const sp<IBinder>& caller,
-                                           const sp<IServiceConnection>& conn) {
+                                           const sp<IServiceConnection>& conn,
+                                           const int callerPid) {
     ProcessPriority priority = ProcessPriority::PERSISTENT;
-    std::vector<ServiceInfo>::iterator it;
-    for (it = packageInfo.servicesInfo.begin(); it != packageInfo.servicesInfo.end(); ++it) {
+    auto it = packageInfo.servicesInfo.begin();
+    for (; it != packageInfo.servicesInfo.end(); ++it) {
         if (it->name == serviceName) {
             priority = (ProcessPriority)it->priority;
             break;
@@ -609,6 +1111,12 @@ int ActivityManagerInner::startServiceReal(const string& serviceName, PackageInf
               serviceName.c_str());
         return -1;
     }
+#ifdef CONFIG_AM_SERVICE_START_MODE
+    const auto startMode = ServiceRecord::startModeFromStr(it->startMode);
+#else
+    // the PackageManager doesn't provide the start mode, every start command is delivered
+    const auto startMode = ServiceRecord::START_DIRECT;
+#endif
 
     // service maybe runs in a stand-alone process
     string servicePackageName;
@@ -622,46 +1130,53 @@ int ActivityManagerInner::startServiceReal(const string& serviceName, PackageInf
         serviceExecBin = packageInfo.execfile;
     }
 
-    ServiceHandler service = mServices.findService(servicePackageName, serviceName);
-    if (service) {
+    const auto startOrBind = [intent, isBind, caller, conn, callerPid](ServiceHandler service) {
         if (!isBind) {
             service->start(intent);
         } else {
-            service->bind(caller, conn, intent);
+            service->bind(caller, conn, intent, callerPid);
         }
+    };
+
+    ServiceHandler service = mServices.findService(servicePackageName, serviceName);
+    if (service) {
+        startOrBind(service);
     } else {
         std::shared_ptr<AppRecord> appRecord;
         appRecord = mAppInfo.findAppInfoWithAlive(servicePackageName);
         if (appRecord) {
             const sp<IBinder> token(new android::BBinder());
-            service = std::make_shared<ServiceRecord>(serviceName, token, priority, appRecord);
+            service = std::make_shared<ServiceRecord>(serviceName, token, priority, appRecord,
+                                                      startMode);
             if (auto prioritynode = mPriorityPolicy.get(appRecord->mPid)) {
                 if (prioritynode->priorityLevel < priority) {
                     prioritynode->priorityLevel = priority;
+                    AM_JOURNAL(priorityChanged(appRecord->mPid, priority));
                 }
             }
             mServices.addService(service);
-            if (!isBind) {
-                service->start(intent);
-            } else {
-                service->bind(caller, conn, intent);
-            }
+            AM_JOURNAL(serviceAdded(appRecord->mPid, token.get(), priority, serviceName));
+            startOrBind(service);
         } else {
-            const auto task = [this, serviceName, intent, priority, caller, conn,
-                               isBind](const AppAttachTask::Event* e) {
+            auto prepare = [this, priority](pid_t pid) {
+                mPriorityPolicy.add(pid, false, priority);
+            };
+            auto task = [this, serviceName, intent, priority, startMode, caller, conn, isBind,
+                         callerPid](const AppAttachTask::Event* e) {
                 const sp<IBinder> token(new android::BBinder());
                 auto serviceHandler = std::make_shared<ServiceRecord>(serviceName, token, priority,
-                                                                      e->mAppRecord);
-                mPriorityPolicy.add(e->mPid, false, priority);
+                                                                      e->mAppRecord, startMode);
+                AM_JOURNAL(priorityChanged(e->mPid, priority));
                 mServices.addService(serviceHandler);
+                AM_JOURNAL(serviceAdded(e->mPid, token.get(), priority, serviceName));
                 if (!isBind) {
                     serviceHandler->start(intent);
                 } else {
-                    serviceHandler->bind(caller, conn, intent);
+                    serviceHandler->bind(caller, conn, intent, callerPid);
                 }
             };
             if (submitAppStartupTask(packageInfo.packageName, servicePackageName, serviceExecBin,
-                                     std::move(task), true) != 0) {
+                                     serviceName, std::move(prepare), std::move(task)) != 0) {
                 ALOGW("submitAppStartupTask failure");
                 return -2;
             }
@@ -710,12 +1225,14 @@ int ActivityManagerInner::bindService(const sp<IBinder>& caller, const Intent& i
     ALOGI("bindService, target:%s action:%s data:%s flag:%" PRId32 "", intent.mTarget.c_str(),
           intent.mAction.c_str(), intent.mData.c_str(), intent.mFlag);
 
+    const int callerPid = android::IPCThreadState::self()->getCallingPid();
     PackageInfo packageInfo;
     string serviceName;
     int ret = android::OK;
     if (intentToSingleTarget(intent, packageInfo, serviceName, IntentAction::COMP_TYPE_SERVICE) ==
         0) {
-        if (startServiceReal(serviceName, packageInfo, intent, true, caller, conn) != 0) {
+        if (startServiceReal(serviceName, packageInfo, intent, true, caller, conn, callerPid) !=
+            0) {
             ret = android::INVALID_OPERATION;
         }
     } else {
@@ -740,7 +1257,7 @@ void ActivityManagerInner::publishService(const sp<IBinder>& token,
     ALOGI("publishService service[%p]", token.get());
     auto service = mServices.getService(token);
     if (service) {
-        service->mServiceBinder = serviceBinder;
+        service->publish(serviceBinder);
     } else {
         ALOGE("publishService error. the Service token[%p] does not exist", token.get());
     }
@@ -805,6 +1322,16 @@ void ActivityManagerInner::reportServiceStatus(const sp<IBinder>& token, int32_t
         }
     }
     service->mStatus = status;
+    if (status == ServiceRecord::CREATED) {
+        mBoot.onReady(*service->getPackageName(), service->mServiceName);
+    } else if (status == ServiceRecord::STARTED) {
+        service->onStarted();
+    }
+    if (status == ServiceRecord::DESTROYED) {
+        AM_JOURNAL(serviceRemoved(token.get()));
+    } else {
+        AM_JOURNAL(serviceStatus(token.get(), status, service->mStartFlag));
+    }
     const ServiceReportStatusTask::Event event(status, token);
     mPendTask.eventTrigger(event);
     AM_PROFILER_END();
@@ -854,8 +1381,9 @@ int32_t ActivityManagerInner::sendBroadcast(const Intent& intent) {
     ALOGD("sendBroadcast:%s", intent.mAction.c_str());
     auto receivers = mReceivers.find(intent.mAction);
     if (receivers != mReceivers.end()) {
-        for (auto& receiver : receivers->second) {
-            receiver->receiveBroadcast(intent);
+        for (auto& record : receivers->second) {
+            const auto receiver = record.receiver;
+            mFreezer.post(record.pid, [receiver, intent] { receiver->receiveBroadcast(intent); });
         }
     }
     AM_PROFILER_END();
@@ -866,13 +1394,14 @@ int32_t ActivityManagerInner::registerReceiver(const std::string& action,
                                                const sp<IBroadcastReceiver>& receiver) {
     AM_PROFILER_BEGIN();
     ALOGI("registerReceiver:%s", action.c_str());
+    const ReceiverRecord record = {receiver, android::IPCThreadState::self()->getCallingPid()};
     auto receivers = mReceivers.find(action);
     if (receivers != mReceivers.end()) {
-        receivers->second.emplace_back(receiver);
+        receivers->second.emplace_back(record);
         ALOGI("register success, cnt:%zu", receivers->second.size());
     } else {
-        std::list<sp<IBroadcastReceiver>> receiverList;
-        receiverList.emplace_back(receiver);
+        std::list<ReceiverRecord> receiverList;
+        receiverList.emplace_back(record);
         mReceivers.emplace(action, std::move(receiverList));
         ALOGD("add new receiver success");
     }
@@ -885,7 +1414,8 @@ void ActivityManagerInner::unregisterReceiver(const sp<IBroadcastReceiver>& rece
     ALOGI("unregisterReceiver");
     for (auto iter = mReceivers.begin(); iter != mReceivers.end();) {
         for (auto it = iter->second.begin(); it != iter->second.end(); ++it) {
-            if (android::IInterface::asBinder(*it) == android::IInterface::asBinder(receiver)) {
+            if (android::IInterface::asBinder(it->receiver) ==
+                android::IInterface::asBinder(receiver)) {
                 iter->second.erase(it);
                 break;
             }
@@ -912,45 +1442,40 @@ int ActivityManagerInner::intentToSingleTarget(const Intent& intent, PackageInfo
     } else {
         getPackageAndComponentName(intent.mTarget, packageName, componentName);
     }
+    mLaunchTrace.mark(LaunchTrace::INTENT_RESOLVED);
 
     if (packageName.empty() || mPm.getPackageInfo(packageName, &packageInfo) != 0) {
         ALOGE("can't find target by intent[%s,%s]", intent.mTarget.c_str(), intent.mAction.c_str());
         AM_PROFILER_END();
         return -1;
     }
+    mLaunchTrace.mark(LaunchTrace::PACKAGE_RESOLVED);
     AM_PROFILER_END();
     return 0;
 }
 
-int ActivityManagerInner::intentToMultiTarget(const Intent& intent,
-                                              vector<PackageInfo>& packageInfoList,
-                                              vector<string>& componentNameList,
+int ActivityManagerInner::intentToMultiTarget(const Intent& intent, vector<IntentTarget>& targets,
                                               const IntentAction::ComponentType type) {
     AM_PROFILER_BEGIN();
-    vector<string> targetlist;
+    targets.clear();
     if (intent.mTarget.empty()) {
-        string target;
-        mActionFilter.getMultiTargetByAction(intent.mAction, targetlist, type);
-    } else {
-        targetlist.push_back(intent.mTarget);
+        // the packages come with the action filter's query, no binder call for each target
+        mActionFilter.getMultiTargetByAction(intent.mAction, targets, type);
+        AM_PROFILER_END();
+        return 0;
     }
 
     string packageName;
     string componentName;
-    PackageInfo packageInfo;
-    componentNameList.clear();
-    packageInfoList.clear();
-    for (auto& target : targetlist) {
-        getPackageAndComponentName(target, packageName, componentName);
-        if (packageName.empty() || mPm.getPackageInfo(packageName, &packageInfo) != 0) {
-            ALOGE("can't find target by intent[%s,%s]", intent.mTarget.c_str(),
-                  intent.mAction.c_str());
-            AM_PROFILER_END();
-            return -1;
-        }
-        packageInfoList.push_back(packageInfo);
-        componentNameList.push_back(componentName);
+    getPackageAndComponentName(intent.mTarget, packageName, componentName);
+    auto packageInfo = std::make_shared<PackageInfo>();
+    if (packageName.empty() || mPm.getPackageInfo(packageName, packageInfo.get()) != 0) {
+        ALOGE("can't find target by intent[%s,%s]", intent.mTarget.c_str(),
+              intent.mAction.c_str());
+        AM_PROFILER_END();
+        return -1;
     }
+    targets.push_back({std::move(packageInfo), componentName});
     AM_PROFILER_END();
     return 0;
 }
@@ -958,19 +1483,25 @@ int ActivityManagerInner::intentToMultiTarget(const Intent& intent,
 int ActivityManagerInner::broadcastIntent(const Intent& intent,
                                           const IntentAction::ComponentType type) {
     AM_PROFILER_BEGIN();
-    vector<PackageInfo> packageList;
-    vector<string> componentList;
-    if (intentToMultiTarget(intent, packageList, componentList, type) != 0) {
+    vector<IntentTarget> targets;
+    if (intentToMultiTarget(intent, targets, type) != 0) {
         AM_PROFILER_END();
         return -1;
     }
-    const int size = componentList.size();
-    for (int i = 0; i < size; i++) {
-        auto taskmanager = getTaskManager(packageList[i].isSystemUI);
+    for (const auto& target : targets) {
+        const auto& packageInfo = *target.packageInfo;
+        if (intent.mAction == Intent::ACTION_BOOT_READY &&
+            mBoot.contains(packageInfo.packageName, target.componentName)) {
+            // it's started by the boot manifest
+            continue;
+        }
+        auto taskmanager = getTaskManager(packageInfo.isSystemUI);
         if (type == IntentAction::COMP_TYPE_ACTIVITY) {
-            startActivityReal(taskmanager, componentList[i], packageList[i], intent, nullptr, -1);
+            startActivityReal(taskmanager, target.componentName, packageInfo, intent, nullptr, -1);
         } else if (type == IntentAction::COMP_TYPE_SERVICE) {
-            startServiceReal(componentList[i], packageList[i], intent, false, nullptr, nullptr);
+            // the system sends the broadcast, there is no client process
+            startServiceReal(target.componentName, packageInfo, intent, false, nullptr, nullptr,
+                             0);
         }
     }
     AM_PROFILER_END();
@@ -982,51 +1513,101 @@ void ActivityManagerInner::systemReady() {
     ALOGD("### systemReady ### ");
     mAppSpawn.signalInit(mLooper->get(), [this](int pid) {
         ALOGW("AppSpawn pid:%d had exit", pid);
-        auto app = mAppInfo.findAppInfo(pid);
-        if (app) {
-            procAppTerminated(app);
-            mAppInfo.deleteAppInfo(pid);
-            mPriorityPolicy.remove(pid);
-        } else {
-            string packagename;
-            if (mAppInfo.getAttachingAppName(pid, packagename)) {
-                ALOGE("App:%s abnormal exit without attachApplication", packagename.c_str());
-                mAppInfo.deleteAppWaitingAttach(pid);
-            }
-        }
-
-        if (!mTaskManager.getManager(StandardMode)->getActiveTask() && mRunMode == NORMAL_MODE) {
-            startHomeActivity();
-        }
+        onProcessExit(pid);
     });
 
+#ifdef CONFIG_AM_STATE_JOURNAL
+    if (!mRecovered.apps.empty()) {
+        // the applications of the last run are still running, it isn't a boot
+        ALOGW("restarted, wait for %zu applications to attach again", mRecovered.apps.size());
+        mLooper->postDelayTask([this](void*) { onReattachTimeout(); }, REATTACH_TIMEOUT_MS);
+        AM_PROFILER_END();
+        return;
+    }
+#endif
+
     if (mRunMode > NORMAL_MODE) {
         ALOGW("AMS run mode[%d], apps don't start automatically", mRunMode);
         AM_PROFILER_END();
         return;
     }
 
-    // After the system ready, broadcast ACTION_BOOT_READY to start Activity and Service
+    // the persistent components of the boot manifest are started at once, then the others
     Intent intent;
     intent.setAction(Intent::ACTION_BOOT_READY);
-    broadcastIntent(intent, IntentAction::COMP_TYPE_SERVICE);
-    broadcastIntent(intent, IntentAction::COMP_TYPE_ACTIVITY);
-
-    if (startBootGuide() == false) {
-        startHomeActivity();
+    mBoot.begin(AM_BOOT_MANIFEST, mPm,
+                [this, intent](const BootEntry& entry, const PackageInfo& packageInfo) {
+                    if (entry.isActivity) {
+                        return startActivityReal(getTaskManager(packageInfo.isSystemUI),
+                                                 entry.componentName, packageInfo, intent,
+                                                 nullptr, ActivityManager::NO_REQUEST);
+                    }
+                    return startServiceReal(entry.componentName, packageInfo, intent, false,
+                                            nullptr, nullptr, 0);
+                });
+    // the entries that wait for others will be spawned soon
+    for (const auto& execfile : mBoot.getWaitingExecfiles()) {
+        mPreloader.preload(execfile);
     }
 
-    //  broadcast ACTION_BOOT_COMPLETED to start Activity and Service
-    intent.setAction(Intent::ACTION_BOOT_COMPLETED);
+    // After the system ready, broadcast ACTION_BOOT_READY to start Activity and Service
     broadcastIntent(intent, IntentAction::COMP_TYPE_SERVICE);
     broadcastIntent(intent, IntentAction::COMP_TYPE_ACTIVITY);
 
+    const bool isHomeStarted = startBootGuide() || startHomeActivity() == 0;
+
+    // broadcast ACTION_BOOT_COMPLETED to start Activity and Service, when the boot entries
+    // and the home are ready
+    mBoot.waitForCompletion(isHomeStarted, [this]() {
+        Intent intent;
+        intent.setAction(Intent::ACTION_BOOT_COMPLETED);
+        broadcastIntent(intent, IntentAction::COMP_TYPE_SERVICE);
+        broadcastIntent(intent, IntentAction::COMP_TYPE_ACTIVITY);
+    });
+    if (mBoot.isBooting()) {
+        mLooper->postDelayTask([this](void*) { mBoot.timeout(); }, BOOT_TIMEOUT_MS);
+    }
+
     AM_PROFILER_END();
     return;
 }
 
+void ActivityManagerInner::onProcessExit(pid_t pid) {
+#ifdef CONFIG_AM_STATE_JOURNAL
+    mDeathRecipients.erase(pid);
+#endif
+    auto app = mAppInfo.findAppInfo(pid);
+    if (app) {
+        if (app->mStatus == APP_RUNNING && isInRecentTasks(app) && !mLmk.isUnderPressure() &&
+            !mMemoryCgroup.isOutOfMemory(pid)) {
+            // it's killed rather than stopped, the user may switch back to it soon, but the
+            // memory that is freed by a kill for memory isn't taken again
+            mPreloader.preloadPackage(app->mPackageName);
+        }
+        procAppTerminated(app);
+        mAppInfo.deleteAppInfo(pid);
+        mPriorityPolicy.remove(pid);
+        mFreezer.remove(pid);
+        mBooster.remove(pid);
+        mMemoryCgroup.remove(pid);
+    } else {
+        // the exit of a process never gets here before its spawn completion
+        string packagename;
+        if (mAppInfo.getAttachingAppName(pid, packagename)) {
+            ALOGE("App:%s abnormal exit without attachApplication", packagename.c_str());
+            mAppInfo.deleteAppWaitingAttach(pid);
+            dropPendingLaunches(pid);
+        }
+    }
+
+    if (!mTaskManager.getManager(StandardMode)->getActiveTask() && mRunMode == NORMAL_MODE) {
+        startHomeActivity();
+    }
+}
+
 void ActivityManagerInner::procAppTerminated(const std::shared_ptr<AppRecord>& appRecord) {
     AM_PROFILER_BEGIN();
+    AM_JOURNAL(appExited(appRecord->mPid));
     /** All activity needs to be destroyed from the stack */
     appRecord->mStatus = APP_STOPPED;
     std::vector<std::weak_ptr<ActivityRecord>> needDeleteActivity;
@@ -1067,9 +1648,143 @@ void ActivityManagerInner::procAppTerminated(const std::shared_ptr<AppRecord>& a
 }
 
 void ActivityManagerInner::dump(int fd, const android::Vector<android::String16>& args) {
-    std::ostringstream os;
-    os << mTaskManager << mServices << mPriorityPolicy;
-    write(fd, os.str().c_str(), os.str().size());
+    enum {
+        DUMP_TASKS = 1 << 0,
+        DUMP_SERVICES = 1 << 1,
+        DUMP_APPS = 1 << 2,
+        DUMP_LMK = 1 << 3,
+        DUMP_RECEIVERS = 1 << 4,
+        DUMP_STATS = 1 << 5,
+        DUMP_BOOT = 1 << 6,
+        DUMP_ALL = (1 << 7) - 1,
+    };
+    static const std::pair<const char*, int> sections[] = {
+            {"tasks", DUMP_TASKS}, {"services", DUMP_SERVICES},   {"apps", DUMP_APPS},
+            {"lmk", DUMP_LMK},     {"receivers", DUMP_RECEIVERS}, {"stats", DUMP_STATS},
+            {"boot", DUMP_BOOT},
+    };
+
+    FdStreamBuf buf(fd);
+    std::ostream os(&buf);
+    bool isJson = false;
+    bool isReset = false;
+    int flags = 0;
+    for (size_t i = 0; i < args.size(); i++) {
+        const string arg = android::String8(args[i]).c_str();
+        if (arg == "--json") {
+            isJson = true;
+            continue;
+        }
+        if (arg == "--reset") {
+            isReset = true;
+            continue;
+        }
+        const auto it = std::find_if(std::begin(sections), std::end(sections),
+                                     [&arg](const auto& section) { return arg == section.first; });
+        if (it == std::end(sections)) {
+            os << "unknown dump section:" << arg
+               << ", usage: dump [--json] [--reset] "
+                  "[tasks|services|apps|lmk|receivers|stats|boot]..."
+               << endl;
+            return;
+        }
+        flags |= it->second;
+    }
+    if (flags == 0) {
+        flags = DUMP_ALL;
+    }
+
+    if (isJson) {
+        // the collectors rely on the schema version, increase it for incompatible changes
+        JsonWriter writer(os);
+        writer.beginObject().field("version", DUMP_SCHEMA_VERSION);
+        if (flags & DUMP_TASKS) {
+            mTaskManager.dumpJson(writer);
+        }
+        if (flags & DUMP_SERVICES) {
+            mServices.dumpJson(writer);
+        }
+        if (flags & DUMP_APPS) {
+            mAppInfo.dumpJson(writer);
+            mPriorityPolicy.dumpJson(writer);
+            mFreezer.dumpJson(writer);
+            mMemoryCgroup.dumpJson(writer);
+        }
+        if (flags & DUMP_LMK) {
+            mLmk.dumpJson(writer);
+        }
+        if (flags & DUMP_RECEIVERS) {
+            writer.beginArray("receivers");
+            for (const auto& [action, receivers] : mReceivers) {
+                writer.beginObject().field("action", action).beginArray("pids");
+                for (const auto& record : receivers) {
+                    writer.field(nullptr, record.pid);
+                }
+                writer.endArray().endObject();
+            }
+            writer.endArray();
+        }
+        if (flags & DUMP_STATS) {
+            writer.beginObject("stats");
+            writer.field("pendingTasks", mPendTask.getPendingCount());
+            mLaunchTrace.dumpJson(writer);
+            mPreloader.dumpJson(writer);
+            mBooster.dumpJson(writer);
+#ifdef CONFIG_AM_BINDER_STATS
+            mBinderStats.dumpJson(writer);
+#endif
+            writer.endObject();
+        }
+        if (flags & DUMP_BOOT) {
+            mBoot.dumpJson(writer);
+        }
+        writer.endObject();
+        os << endl;
+    } else {
+        // the colours are only for the terminal, not for the tools that collect the dump
+        enableDumpColor(os, isatty(fd));
+        if (flags & DUMP_TASKS) {
+            os << mTaskManager;
+        }
+        if (flags & DUMP_SERVICES) {
+            os << mServices;
+        }
+        if (flags & DUMP_APPS) {
+            os << mAppInfo << mPriorityPolicy << mFreezer << mMemoryCgroup;
+        }
+        if (flags & DUMP_LMK) {
+            os << mLmk;
+        }
+        if (flags & DUMP_RECEIVERS) {
+            os << "\nBroadcast receivers:" << endl;
+            for (const auto& [action, receivers] : mReceivers) {
+                os << "\t" << action << " pid:[";
+                for (const auto& record : receivers) {
+                    os << " " << record.pid;
+                }
+                os << " ]" << endl;
+            }
+        }
+        if (flags & DUMP_STATS) {
+            os << "\nPending tasks: " << mPendTask.getPendingCount() << endl;
+            os << mLaunchTrace << mPreloader << mBooster;
+#ifdef CONFIG_AM_BINDER_STATS
+            os << mBinderStats;
+#endif
+        }
+        if (flags & DUMP_BOOT) {
+            os << mBoot;
+        }
+    }
+
+    if (isReset) {
+#ifdef CONFIG_AM_BINDER_STATS
+        // the snapshot is written above, count the calls from now on
+        mBinderStats.reset();
+#else
+        os << "binder stats is disabled, see CONFIG_AM_BINDER_STATS" << endl;
+#endif
+    }
 }
 
 bool ActivityManagerInner::startBootGuide() {
@@ -1108,32 +1823,169 @@ int ActivityManagerInner::startHomeActivity() {
 
 int ActivityManagerInner::submitAppStartupTask(const string& packageName,
                                                const string& prcocessName, const string& execfile,
+                                               const string& componentName, PrepareFunc&& prepare,
                                                AppAttachTask::TaskFunc&& task,
-                                               bool isSupportMultiTask) {
+                                               const ActivityHandler& activity) {
     AM_PROFILER_BEGIN();
-    int pid = mAppInfo.getAttachingAppPid(prcocessName);
-    if (pid < 0) {
-        pid = mAppSpawn.appSpawn(execfile.c_str(), {packageName});
-        if (pid > 0) {
-            mAppInfo.addAppWaitingAttach(prcocessName, pid);
-        } else {
-            ALOGE("appSpawn App:%s error", execfile.c_str());
-            AM_PROFILER_END();
-            return -1;
-        }
-    } else if (!isSupportMultiTask) {
-        ALOGW("the Application:%s[%d] is waitting for attach, please wait a moment before "
-              "requesting again",
-              packageName.c_str(), pid);
+    const int pid = mAppInfo.getAttachingAppPid(prcocessName);
+    if (pid > 0) {
+        // the process is attaching, the launch is queued for it
+        queueLaunch(mPendingLaunches[pid],
+                    {activity, componentName, std::move(prepare), std::move(task)});
+        mLooper->postTask([this, pid] { prepareLaunches(pid); });
         AM_PROFILER_END();
-        return -1;
+        return 0;
+    }
+    if (const auto it = mSpawningLaunches.find(prcocessName); it != mSpawningLaunches.end()) {
+        // it's prepared when the spawn is completed
+        queueLaunch(it->second, {activity, componentName, std::move(prepare), std::move(task)});
+        AM_PROFILER_END();
+        return 0;
     }
 
-    mPendTask.commitTask(std::make_shared<AppAttachTask>(pid, task));
+    mSpawningLaunches[prcocessName].push_back({activity, componentName, std::move(prepare),
+                                               std::move(task)});
+    mPreloader.onSpawn(packageName, execfile);
+    const uint64_t beginTime = uv_now(mLooper->get());
+    mAppSpawn.appSpawnAsync(execfile, {packageName},
+                            [this, packageName, prcocessName, execfile, beginTime](int newPid) {
+                                onAppSpawned(packageName, prcocessName, execfile, newPid,
+                                             beginTime);
+                            });
     AM_PROFILER_END();
     return 0;
 }
 
+void ActivityManagerInner::queueLaunch(vector<PendingLaunch>& launches, PendingLaunch&& launch) {
+    if (launch.activity) {
+        const auto it = std::find_if(launches.begin(), launches.end(), [&](const auto& l) {
+            return l.activity && l.activity->getName() == launch.activity->getName();
+        });
+        if (it != launches.end()) {
+            // the latest intent wins, the replaced one is never launched
+            ALOGI("the launch of %s is merged while the process is starting",
+                  launch.activity->getName().c_str());
+            const uint32_t launchId = it->activity->getLaunchId();
+            mLaunchTrace.dropLaunch(launchId);
+            mBooster.end(launchId);
+            mActivityMap.erase(it->activity->getToken());
+            it->activity->removeWindowToken();
+            *it = std::move(launch);
+            return;
+        }
+    }
+    launches.push_back(std::move(launch));
+}
+
+void ActivityManagerInner::onAppSpawned(const string& packageName, const string& processName,
+                                        const string& execfile, int pid, uint64_t beginTime) {
+    const auto it = mSpawningLaunches.find(processName);
+    if (it == mSpawningLaunches.end()) {
+        return;
+    }
+    auto launches = std::move(it->second);
+    mSpawningLaunches.erase(it);
+    if (pid <= 0) {
+        ALOGE("appSpawn App:%s error, %zu launches are dropped", execfile.c_str(),
+              launches.size());
+        // the launches fail like they did when the spawn was synchronous
+        for (const auto& launch : launches) {
+            if (launch.activity) {
+                mLaunchTrace.dropLaunch(launch.activity->getLaunchId());
+                mActivityMap.erase(launch.activity->getToken());
+            }
+            mBoot.onFailed(packageName, launch.componentName);
+        }
+        return;
+    }
+
+    ALOGI("spawn %s[%d] in %" PRIu64 "ms", processName.c_str(), pid,
+          uv_now(mLooper->get()) - beginTime);
+    for (const auto& launch : launches) {
+        if (launch.activity) {
+            mLaunchTrace.mark(launch.activity->getLaunchId(), LaunchTrace::PROCESS_SPAWNED);
+            // the loading and linking run boosted as well
+            boostLaunch(pid, launch.activity->getLaunchId());
+        }
+    }
+    mAppInfo.addAppWaitingAttach(processName, pid);
+    mPendingLaunches[pid] = std::move(launches);
+    // a single attach task replays all the launches of the process
+    mPendTask.commitTask(std::make_shared<AppAttachTask>(
+            pid, [this](const AppAttachTask::Event* e) { replayPendingLaunches(e); }));
+    // the process is loading and linking now
+    prepareLaunches(pid);
+    if (const auto pnode = mPriorityPolicy.get(pid)) {
+        mMemoryCgroup.add(pid, pnode->priorityLevel,
+                          mPriorityPolicy.getCpuClassPolicy().getBand(pid));
+    }
+}
+
+void ActivityManagerInner::trimApplication(pid_t pid, int level) {
+    if (auto apprecord = mAppInfo.findAppInfoWithAlive(pid)) {
+        // the frozen application must run to release memory
+        apprecord->post([app = apprecord->mAppThread, level] { app->scheduleTrimMemory(level); });
+    }
+}
+
+void ActivityManagerInner::boostLaunch(pid_t pid, const uint32_t launchId) {
+    if (mBooster.boost(pid, launchId)) {
+        mLaunchTrace.setBoosted(launchId);
+    }
+}
+
+void ActivityManagerInner::prepareLaunches(pid_t pid) {
+    const auto it = mPendingLaunches.find(pid);
+    if (it == mPendingLaunches.end()) {
+        // the process attached or exited already
+        return;
+    }
+    for (auto& launch : it->second) {
+        if (launch.prepare) {
+            const uint32_t launchId = launch.activity ? launch.activity->getLaunchId() : 0;
+            mLaunchTrace.beginPrepare(launchId);
+            launch.prepare(pid);
+            launch.prepare = nullptr;
+            mLaunchTrace.endPrepare(launchId);
+        }
+    }
+}
+
+void ActivityManagerInner::replayPendingLaunches(const AppAttachTask::Event* e) {
+    // the process may attach before the loop gets to the preparation
+    prepareLaunches(e->mPid);
+    const auto it = mPendingLaunches.find(e->mPid);
+    if (it == mPendingLaunches.end()) {
+        return;
+    }
+    const auto launches = std::move(it->second);
+    mPendingLaunches.erase(it);
+    ALOGI("replay %zu launches of %s[%d]", launches.size(), e->mAppRecord->mPackageName.c_str(),
+          e->mPid);
+    for (const auto& launch : launches) {
+        launch.task(e);
+    }
+}
+
+void ActivityManagerInner::dropPendingLaunches(pid_t pid) {
+    // the priority, the boost and the cgroup are prepared before the attachment
+    mPriorityPolicy.remove(pid);
+    mBooster.remove(pid);
+    mMemoryCgroup.remove(pid);
+    const auto it = mPendingLaunches.find(pid);
+    if (it == mPendingLaunches.end()) {
+        return;
+    }
+    for (const auto& launch : it->second) {
+        if (launch.activity) {
+            mLaunchTrace.dropLaunch(launch.activity->getLaunchId());
+            mActivityMap.erase(launch.activity->getToken());
+            launch.activity->removeWindowToken();
+        }
+    }
+    mPendingLaunches.erase(it);
+}
+
 int ActivityManagerInner::findSystemTarget(const string& targetAlias,
                                            std::shared_ptr<AppRecord>& app, sp<IBinder>& token) {
     ALOGI("findSystemTarget:%s", targetAlias.c_str());
@@ -1173,6 +2025,33 @@ ActivityHandler ActivityManagerInner::getActivity(const sp<IBinder>& token) {
     }
 }
 
+bool ActivityManagerInner::isFreezable(pid_t pid) {
+    // only the application that nobody cares about can be frozen
+    const auto app = mAppInfo.findAppInfoWithAlive(pid);
+    if (!app || app->mIsSystemUI || !app->mExistService.empty()) {
+        return false;
+    }
+    if (const auto homeTask = mTaskManager.getHomeTask()) {
+        const auto homeActivity = homeTask->getRootActivity();
+        if (homeActivity && homeActivity->getAppRecord() == app) {
+            return false;
+        }
+    }
+    const auto priorityNode = mPriorityPolicy.get(pid);
+    return priorityNode && priorityNode->clients.empty() &&
+            priorityNode->priorityLevel < ProcessPriority::PERSISTENT;
+}
+
+bool ActivityManagerInner::isInRecentTasks(const std::shared_ptr<AppRecord>& app) {
+    for (const auto& task : getTaskManager(app->mIsSystemUI)->getTasks()) {
+        const auto root = task->getRootActivity();
+        if (root && root->getAppRecord() == app) {
+            return true;
+        }
+    }
+    return false;
+}
+
 inline ITaskManager* ActivityManagerInner::getTaskManager(bool isSystemUI) {
     return isSystemUI ? mTaskManager.getManager(TaskManagerType::SystemUIMode)
                       : mTaskManager.getManager(TaskManagerType::StandardMode);
@@ -1206,88 +2085,113 @@ ActivityManagerService::~ActivityManagerService() {
     delete mInner;
 }
 
-Status ActivityManagerService::attachApplication(const sp<IApplicationThread>& app, int32_t* ret) {
-    *ret = mInner->attachApplication(app);
+Status ActivityManagerService::attachApplication(const sp<IApplicationThread>& app,
+                                                 std::vector<os::app::ActivityLaunch>* launches,
+                                                 int32_t* ret) {
+    AM_BINDER_STATS(ATTACH_APPLICATION);
+    std::vector<FusedLaunch> fusedLaunches;
+    *ret = mInner->attachApplication(app, fusedLaunches);
+    for (const auto& launch : fusedLaunches) {
+        const auto& name = launch.activity->getName();
+        launches->emplace_back(name.substr(name.find_first_of('/') + 1),
+                               launch.activity->getToken(), launch.activity->getIntent(),
+                               launch.targetStatus);
+    }
     return Status::ok();
 }
 
 Status ActivityManagerService::startActivity(const sp<IBinder>& token, const Intent& intent,
                                              int32_t requestCode, int32_t* ret) {
+    AM_BINDER_STATS(START_ACTIVITY);
     *ret = mInner->startActivity(token, intent, requestCode);
     return Status::ok();
 }
 
 Status ActivityManagerService::stopActivity(const Intent& intent, int32_t resultCode,
                                             int32_t* ret) {
+    AM_BINDER_STATS(STOP_ACTIVITY);
     *ret = mInner->stopActivity(intent, resultCode);
     return Status::ok();
 }
 
 Status ActivityManagerService::stopApplication(const sp<IBinder>& token, int32_t* ret) {
+    AM_BINDER_STATS(STOP_APPLICATION);
     *ret = mInner->stopApplication(token);
     return Status::ok();
 }
 
 Status ActivityManagerService::finishActivity(const sp<IBinder>& token, int32_t resultCode,
                                               const std::optional<Intent>& resultData, bool* ret) {
+    AM_BINDER_STATS(FINISH_ACTIVITY);
     *ret = mInner->finishActivity(token, resultCode, resultData);
     return Status::ok();
 }
 
 Status ActivityManagerService::moveActivityTaskToBackground(const sp<IBinder>& token, bool nonRoot,
                                                             bool* ret) {
+    AM_BINDER_STATS(MOVE_ACTIVITY_TASK_TO_BACKGROUND);
     *ret = mInner->moveActivityTaskToBackground(token, nonRoot);
     return Status::ok();
 }
 
 Status ActivityManagerService::reportActivityStatus(const sp<IBinder>& token, int32_t status) {
+    AM_BINDER_STATS(REPORT_ACTIVITY_STATUS);
     mInner->reportActivityStatus(token, status);
     return Status::ok();
 }
 
 Status ActivityManagerService::startService(const Intent& intent, int32_t* ret) {
+    AM_BINDER_STATS(START_SERVICE);
     *ret = mInner->startService(intent);
     return Status::ok();
 }
 
 Status ActivityManagerService::stopService(const Intent& intent, int32_t* ret) {
+    AM_BINDER_STATS(STOP_SERVICE);
     *ret = mInner->stopService(intent);
     return Status::ok();
 }
 
 Status ActivityManagerService::stopServiceByToken(const sp<IBinder>& token, int32_t* ret) {
+    AM_BINDER_STATS(STOP_SERVICE_BY_TOKEN);
     *ret = mInner->stopServiceByToken(token);
     return Status::ok();
 }
 
 Status ActivityManagerService::reportServiceStatus(const sp<IBinder>& token, int32_t status) {
+    AM_BINDER_STATS(REPORT_SERVICE_STATUS);
     mInner->reportServiceStatus(token, status);
     return Status::ok();
 }
 
 Status ActivityManagerService::bindService(const sp<IBinder>& token, const Intent& intent,
                                            const sp<IServiceConnection>& conn, int32_t* ret) {
+    AM_BINDER_STATS(BIND_SERVICE);
     *ret = mInner->bindService(token, intent, conn);
     return Status::ok();
 }
 
 Status ActivityManagerService::unbindService(const sp<IServiceConnection>& conn) {
+    AM_BINDER_STATS(UNBIND_SERVICE);
     mInner->unbindService(conn);
     return Status::ok();
 }
 
 Status ActivityManagerService::publishService(const sp<IBinder>& token,
                                               const sp<IBinder>& service) {
+    AM_BINDER_STATS(PUBLISH_SERVICE);
     mInner->publishService(token, service);
     return Status::ok();
 }
 
 Status ActivityManagerService::postIntent(const Intent& intent, int32_t* ret) {
+    AM_BINDER_STATS(POST_INTENT);
     *ret = mInner->postIntent(intent);
     return Status::ok();
 }
 
 Status ActivityManagerService::sendBroadcast(const Intent& intent, int32_t* ret) {
+    AM_BINDER_STATS(SEND_BROADCAST);
     *ret = mInner->sendBroadcast(intent);
     return Status::ok();
 }
@@ -1295,11 +2199,13 @@ Status ActivityManagerService::sendBroadcast(const Intent& intent, int32_t* ret)
 Status ActivityManagerService::registerReceiver(const std::string& action,
                                                 const sp<IBroadcastReceiver>& receiver,
                                                 int32_t* ret) {
+    AM_BINDER_STATS(REGISTER_RECEIVER);
     *ret = mInner->registerReceiver(action, receiver);
     return Status::ok();
 }
 
 Status ActivityManagerService::unregisterReceiver(const sp<IBroadcastReceiver>& receiver) {
+    AM_BINDER_STATS(UNREGISTER_RECEIVER);
     mInner->unregisterReceiver(receiver);
     return Status::ok();
 }
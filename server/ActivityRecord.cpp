@@ -49,6 +49,9 @@ ActivityRecord::ActivityRecord(const std::string& name, const sp<IBinder>& calle
     mTaskManager = tm;
     mPendTask = tb;
     mNewIntentFlag = true;
+    mIsWindowTokenAdded = false;
+    mLaunchId = 0;
+    mFusedTarget = INIT;
 }
 
 const sp<IBinder>& ActivityRecord::getToken() const {
@@ -93,7 +96,27 @@ const Intent& ActivityRecord::getIntent() const {
 }
 
 void ActivityRecord::setStatus(Status status) {
+    const bool isResumedChanged = (mStatus == RESUMED) != (status == RESUMED);
     mStatus = status;
+    if (isResumedChanged && mTaskManager) {
+        mTaskManager->onEvent(TaskManagerEvent::ActivityResumedChangedEvent, this);
+    }
+
+    if (!mResumeWaiters.empty() && !isPausing()) {
+        std::vector<std::weak_ptr<ActivityRecord>> waiters;
+        waiters.swap(mResumeWaiters);
+        for (auto& it : waiters) {
+            auto waiter = it.lock();
+            if (waiter && waiter->mStatus % 2 == 0) {
+                waiter->continueTransition();
+            }
+        }
+    }
+}
+
+void ActivityRecord::restoreStatus(Status status) {
+    mTargetStatus = status;
+    setStatus(status);
 }
 
 ActivityRecord::Status ActivityRecord::getStatus() const {
@@ -106,10 +129,60 @@ ActivityRecord::Status ActivityRecord::getTargetStatus() const {
 
 void ActivityRecord::reportError() {
     mIsError = true;
-    mStatus = (Status)(mStatus - 1);
+    mFusedTarget = INIT;
+    setStatus((Status)(mStatus - 1));
 }
 
 void ActivityRecord::lifecycleTransition(const Status toStatus) {
+    if (mTargetStatus == RESUMED && toStatus > RESUMED && mStatus < RESUMING) {
+        // Other Activity wait for this Activity "resume", but it can't to resume.
+        // then we trigger the "ActivityWaitResume" task.
+        const ActivityWaitResume::Event event(mToken);
+        mPendTask->eventTrigger(event);
+    }
+
+    queueTargetStatus(toStatus);
+    mTargetStatus = mPendingStatus.empty() ? toStatus : mPendingStatus.back();
+
+    if (mStatus % 2 == 1) {
+        // when Activity status is:creating, starting, resuming, **ing.
+        // we can't do anything except wait for it to report
+        return;
+    }
+    continueTransition();
+}
+
+void ActivityRecord::queueTargetStatus(const Status toStatus) {
+    if (!mPendingStatus.empty()) {
+        if (mPendingStatus.back() == DESTROYED) {
+            ALOGW("%s is going to be destroyed, ignore [%s]", mName.c_str(),
+                  statusToStr(toStatus));
+            return;
+        }
+        // the front status is in flight while the Activity is busy, it can't be dropped
+        const size_t issued = mStatus % 2 == 1 ? 1 : 0;
+        if (toStatus == DESTROYED) {
+            // the transition in flight still completes, then goes to destroy directly
+            mPendingStatus.clear();
+            if (issued > 0) {
+                mPendingStatus.push_back((Status)(mStatus + 1));
+            }
+        } else if (mPendingStatus.back() == toStatus) {
+            return;
+        } else if (mPendingStatus.size() > issued) {
+            const size_t size = mPendingStatus.size();
+            const Status last = size > 1 ? mPendingStatus[size - 2] : mStatus;
+            if (last == toStatus) {
+                // the round trip "last->back->last" is redundant
+                mPendingStatus.pop_back();
+                return;
+            }
+        }
+    }
+    mPendingStatus.push_back(toStatus);
+}
+
+void ActivityRecord::continueTransition() {
     enum { NONE = 0, CREATE, START, RESUME, PAUSE, STOP, DESTROY };
     static int lifeCycleTable[7][7] = {
             /*      →  X :toStatus, targetStatus                        */
@@ -124,49 +197,88 @@ void ActivityRecord::lifecycleTransition(const Status toStatus) {
             /*destroy*/ {NONE, NONE, NONE, NONE, NONE, NONE, NONE},
     };
 
-    if (mTargetStatus == RESUMED && toStatus > RESUMED && mStatus < RESUMING) {
-        // Other Activity wait for this Activity "resume", but it can't to resume.
-        // then we trigger the "ActivityWaitResume" task.
-        const ActivityWaitResume::Event event(mToken);
-        mPendTask->eventTrigger(event);
+    if (mStatus >= mFusedTarget) {
+        mFusedTarget = INIT;
     }
+    while (!mPendingStatus.empty()) {
+        const Status toStatus = mPendingStatus.front();
+        int turnTo = lifeCycleTable[(mStatus + 1) >> 1][(toStatus + 1) >> 1];
+        if (mStatus < mFusedTarget) {
+            // the client goes on to the fused target whatever is requested meanwhile
+            turnTo = mStatus == CREATED ? START : RESUME;
+        } else if (turnTo == NONE) {
+            ALOGD("lifecycleTransition %s[%s] done", mName.c_str(), getStatusStr());
+            mPendingStatus.pop_front();
+            continue;
+        }
+        if (turnTo == RESUME && mFusedTarget != RESUMED) {
+            if (auto pausingActivity = mWaitPauseActivity.lock()) {
+                if (pausingActivity->isPausing()) {
+                    ALOGI("%s wait for %s to pause before resuming", mName.c_str(),
+                          pausingActivity->getName().c_str());
+                    pausingActivity->mResumeWaiters.emplace_back(weak_from_this());
+                    return;
+                }
+            }
+            mWaitPauseActivity.reset();
+        }
 
-    if (mStatus % 2 == 1) {
-        // when Activity status is:creating, starting, resuming, **ing.
-        // we can't do anything except wait for it to report
-        mTargetStatus = toStatus;
+        switch (turnTo) {
+            case CREATE:
+                create();
+                break;
+            case START:
+                start();
+                break;
+            case RESUME:
+                resume();
+                break;
+            case PAUSE:
+                pause();
+                break;
+            case STOP:
+                stop();
+                break;
+            case DESTROY:
+                destroy();
+                break;
+        }
+        ALOGI("lifecycleTransition %s [%s] to [%s]", mName.c_str(), getStatusStr(),
+              statusToStr(toStatus));
+        const auto task = std::make_shared<ActivityLifeCycleTask>(shared_from_this(), mTaskManager);
+        mPendTask->commitTask(task, REQUEST_TIMEOUT_MS);
         return;
     }
+}
 
-    const int turnTo = lifeCycleTable[(mStatus + 1) >> 1][(toStatus + 1) >> 1];
-    switch (turnTo) {
-        case CREATE:
-            create();
-            break;
-        case START:
-            start();
-            break;
-        case RESUME:
-            resume();
-            break;
-        case PAUSE:
-            pause();
-            break;
-        case STOP:
-            stop();
-            break;
-        case DESTROY:
-            destroy();
-            break;
-        case NONE:
-            ALOGD("lifecycleTransition %s[%s] done", mName.c_str(), getStatusStr());
-            return;
+void ActivityRecord::setResumeAfterPause(const std::shared_ptr<ActivityRecord>& pausingActivity) {
+    mWaitPauseActivity = pausingActivity;
+}
+
+bool ActivityRecord::isPausing() const {
+    if (mStatus < RESUMING || mStatus >= PAUSED) {
+        return false;
+    }
+    // the front status is in flight or the next one, a resume before it still ends in the pause
+    for (const auto status : mPendingStatus) {
+        if (status != RESUMED) {
+            return status >= PAUSED;
+        }
+    }
+    return mStatus == PAUSING;
+}
+
+ActivityRecord::Status ActivityRecord::getFusedTarget() const {
+    const Status target = mPendingStatus.empty() ? CREATED : mPendingStatus.front();
+    if (target != STARTED && target != RESUMED) {
+        // going to pause or stop at once isn't worth fusing
+        return CREATED;
     }
-    mTargetStatus = toStatus;
-    ALOGI("lifecycleTransition %s [%s] to [%s]", mName.c_str(), getStatusStr(),
-          statusToStr(toStatus));
-    const auto task = std::make_shared<ActivityLifeCycleTask>(shared_from_this(), mTaskManager);
-    mPendTask->commitTask(task, REQUEST_TIMEOUT_MS);
+    const auto pausingActivity = mWaitPauseActivity.lock();
+    if (target == RESUMED && pausingActivity && pausingActivity->isPausing()) {
+        return STARTED;
+    }
+    return target;
 }
 
 void ActivityRecord::create() {
@@ -174,14 +286,21 @@ void ActivityRecord::create() {
         mStatus = CREATING;
         const auto appRecord = mApp.lock();
         if (appRecord && appRecord->mStatus != APP_STOPPED) {
-            int windowtype = appRecord->mIsSystemUI ? LayoutParams::TYPE_SYSTEM_WINDOW
-                                                    : LayoutParams::TYPE_APPLICATION;
-            mWindowService->addWindowToken(mToken, windowtype, 0);
-            ALOGD("scheduleLaunchActivity: %s", mName.c_str());
+            addWindowToken(appRecord->mIsSystemUI);
             appRecord->addActivity(shared_from_this());
-            const auto pos = mName.find_first_of('/');
-            appRecord->mAppThread->scheduleLaunchActivity(mName.substr(pos + 1, std::string::npos),
-                                                          mToken, mIntent);
+            if (appRecord->mFusedLaunches) {
+                // it goes with the attachApplication reply
+                mFusedTarget = getFusedTarget();
+                ALOGD("fused launch: %s to %s", mName.c_str(), statusToStr(mFusedTarget));
+                appRecord->mFusedLaunches->push_back({shared_from_this(), mFusedTarget});
+            } else {
+                ALOGD("scheduleLaunchActivity: %s", mName.c_str());
+                const auto pos = mName.find_first_of('/');
+                appRecord->post([app = appRecord->mAppThread, name = mName.substr(pos + 1),
+                                 token = mToken, intent = mIntent] {
+                    app->scheduleLaunchActivity(name, token, intent);
+                });
+            }
             mNewIntentFlag = false;
         }
     }
@@ -191,12 +310,14 @@ void ActivityRecord::start() {
     if (mStatus > CREATING && mStatus < DESTROYED) {
         mStatus = STARTING;
         const auto appRecord = mApp.lock();
-        if (appRecord && appRecord->mStatus != APP_STOPPED) {
+        if (mFusedTarget >= STARTED) {
+            ALOGD("%s is starting by the fused launch", mName.c_str());
+        } else if (appRecord && appRecord->mStatus != APP_STOPPED) {
             ALOGD("scheduleStartActivity: %s", mName.c_str());
-            const std::optional<Intent> intent = mNewIntentFlag
-                    ? std::optional<std::reference_wrapper<Intent>>(mIntent)
-                    : std::nullopt;
-            appRecord->mAppThread->scheduleStartActivity(mToken, intent);
+            auto intent = mNewIntentFlag ? std::optional<Intent>(mIntent) : std::nullopt;
+            appRecord->post([app = appRecord->mAppThread, token = mToken, intent] {
+                app->scheduleStartActivity(token, intent);
+            });
             mNewIntentFlag = false;
         }
     }
@@ -206,71 +327,104 @@ void ActivityRecord::resume() {
     if (mStatus >= STARTING && mStatus <= STOPPED) {
         mStatus = RESUMING;
         const auto appRecord = mApp.lock();
-        if (appRecord && appRecord->mStatus != APP_STOPPED) {
+        if (mFusedTarget == RESUMED) {
+            ALOGD("%s is resuming by the fused launch", mName.c_str());
+        } else if (appRecord && appRecord->mStatus != APP_STOPPED) {
             ALOGD("scheduleResumeActivity: %s", mName.c_str());
-            const std::optional<Intent> intent = mNewIntentFlag
-                    ? std::optional<std::reference_wrapper<Intent>>(mIntent)
-                    : std::nullopt;
-            appRecord->mAppThread->scheduleResumeActivity(mToken, intent);
+            auto intent = mNewIntentFlag ? std::optional<Intent>(mIntent) : std::nullopt;
+            appRecord->post([app = appRecord->mAppThread, token = mToken, intent] {
+                app->scheduleResumeActivity(token, intent);
+            });
             mNewIntentFlag = false;
         }
-        mWindowService->updateWindowTokenVisibility(mToken, LayoutParams::WINDOW_VISIBLE);
+        if (mWindowService) {
+            mWindowService->updateWindowTokenVisibility(mToken, LayoutParams::WINDOW_VISIBLE);
+        }
         return;
     }
 }
 
 void ActivityRecord::pause() {
     if (mStatus > STARTING && mStatus < PAUSING) {
-        mStatus = PAUSING;
+        setStatus(PAUSING);
         const auto appRecord = mApp.lock();
         if (appRecord && appRecord->mStatus != APP_STOPPED) {
             ALOGD("schedulePauseActivity: %s", mName.c_str());
-            appRecord->mAppThread->schedulePauseActivity(mToken);
+            appRecord->post([app = appRecord->mAppThread, token = mToken] {
+                app->schedulePauseActivity(token);
+            });
+        }
+        if (mWindowService) {
+            mWindowService->updateWindowTokenVisibility(mToken, LayoutParams::WINDOW_INVISIBLE);
         }
-        mWindowService->updateWindowTokenVisibility(mToken, LayoutParams::WINDOW_INVISIBLE);
     }
 }
 
 void ActivityRecord::stop() {
     if (mStatus > CREATING && mStatus < STOPPING) {
-        mStatus = STOPPING;
+        setStatus(STOPPING);
         const auto appRecord = mApp.lock();
         if (appRecord && appRecord->mStatus != APP_STOPPED) {
             ALOGD("scheduleStopActivity: %s", mName.c_str());
-            appRecord->mAppThread->scheduleStopActivity(mToken);
+            appRecord->post([app = appRecord->mAppThread, token = mToken] {
+                app->scheduleStopActivity(token);
+            });
+        }
+        if (mWindowService) {
+            mWindowService->updateWindowTokenVisibility(mToken, LayoutParams::WINDOW_GONE);
         }
-        mWindowService->updateWindowTokenVisibility(mToken, LayoutParams::WINDOW_GONE);
     }
 }
 
 void ActivityRecord::destroy() {
     if (mStatus > CREATING && mStatus < DESTROYING) {
-        mStatus = DESTROYING;
+        setStatus(DESTROYING);
         const auto appRecord = mApp.lock();
         if (appRecord && appRecord->mStatus != APP_STOPPED) {
             ALOGD("scheduleDestroyActivity: %s", mName.c_str());
-            appRecord->mAppThread->scheduleDestroyActivity(mToken);
+            appRecord->post([app = appRecord->mAppThread, token = mToken] {
+                app->scheduleDestroyActivity(token);
+            });
         }
-        mWindowService->removeWindowToken(mToken, 0);
+        removeWindowToken();
     }
 }
 
 void ActivityRecord::abnormalExit() {
-    mStatus = DESTROYED;
+    setStatus(DESTROYED);
     if (auto appRecord = mApp.lock()) {
         ALOGW("Activity:%s abnormal exit!", mName.c_str());
         appRecord->deleteActivity(shared_from_this());
-        mWindowService->removeWindowToken(mToken, 0);
+        removeWindowToken();
         appRecord->stopApplication();
     }
 }
 
+void ActivityRecord::addWindowToken(const bool isSystemUI) {
+    if (mWindowService && !mIsWindowTokenAdded) {
+        const int windowType =
+                isSystemUI ? LayoutParams::TYPE_SYSTEM_WINDOW : LayoutParams::TYPE_APPLICATION;
+        mWindowService->addWindowToken(mToken, windowType, 0);
+        mIsWindowTokenAdded = true;
+    }
+}
+
+void ActivityRecord::removeWindowToken() {
+    if (mWindowService && mIsWindowTokenAdded) {
+        mWindowService->removeWindowToken(mToken, 0);
+        mIsWindowTokenAdded = false;
+    }
+}
+
 void ActivityRecord::onResult(int32_t requestCode, int32_t resultCode, const Intent& resultData) {
     const auto appRecord = mApp.lock();
     if (appRecord && appRecord->mStatus != APP_STOPPED) {
         ALOGD("%s onActivityResult: %" PRId32 " %" PRId32 "", mName.c_str(), requestCode,
               resultCode);
-        appRecord->mAppThread->onActivityResult(mToken, requestCode, resultCode, resultData);
+        appRecord->post([app = appRecord->mAppThread, token = mToken, requestCode, resultCode,
+                         resultData] {
+            app->onActivityResult(token, requestCode, resultCode, resultData);
+        });
     }
 }
 
@@ -281,6 +435,14 @@ const std::string* ActivityRecord::getPackageName() const {
     return nullptr;
 }
 
+void ActivityRecord::setLaunchId(const uint32_t launchId) {
+    mLaunchId = launchId;
+}
+
+uint32_t ActivityRecord::getLaunchId() const {
+    return mLaunchId;
+}
+
 ActivityRecord::LaunchMode ActivityRecord::launchModeToInt(const std::string& launchMode) {
     if (launchMode == "standard") {
         return ActivityRecord::STANDARD;
@@ -363,7 +525,7 @@ void ActivityLifeCycleTask::execute(const Label& e) {
         mTaskManager->deleteActivity(mActivity);
     } else {
         mActivity->setStatus(event->status);
-        mActivity->lifecycleTransition(mActivity->getTargetStatus());
+        mActivity->continueTransition();
     }
 }
 
@@ -18,8 +18,10 @@
 
 #include <binder/IBinder.h>
 
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 #include "TaskBoard.h"
 #include "app/Intent.h"
@@ -64,10 +66,26 @@ public:
                    const Intent& intent, sp<::os::wm::IWindowManager> wm, ITaskManager* tm,
                    TaskBoard* tb);
 
-    /** Lifecycle state management, let Activity goto status */
+    /**
+     * Lifecycle state management, let Activity goto status.
+     * The requested statuses are queued, and the ordering guarantees are:
+     * 1. Only one transition is in flight, the next one is issued after the client reports.
+     * 2. The statuses are reached in the order they are requested. Except that the round trip
+     *    which isn't issued yet is dropped(e.g. resumed->paused->resumed), and "destroyed"
+     *    drops all the statuses requested before it.
+     * 3. "destroyed" is final, the requests after it are ignored.
+     * 4. The Activity that waits for another to pause(setResumeAfterPause) can be created and
+     *    started meanwhile, but it's resumed only after the other one isn't pausing anymore.
+     */
     void lifecycleTransition(const Status toStatus);
+    /** Go on with the queued statuses, after the client reported */
+    void continueTransition();
+    void setResumeAfterPause(const std::shared_ptr<ActivityRecord>& pausingActivity);
 
     void abnormalExit();
+    /** The window token can be added before the application attaches, it's added once */
+    void addWindowToken(const bool isSystemUI);
+    void removeWindowToken();
     void onResult(int32_t requestCode, int32_t resultCode, const Intent& resultData);
 
     const sp<IBinder>& getToken() const;
@@ -85,12 +103,18 @@ public:
     const Intent& getIntent() const;
 
     void setStatus(Status status);
+    /** The Activity is adopted from the last run of the service, it's already in the status */
+    void restoreStatus(Status status);
     Status getStatus() const;
     Status getTargetStatus() const;
     void reportError();
 
     const std::string* getPackageName() const;
 
+    /** The launch which brings this Activity to resumed, see LaunchTrace */
+    void setLaunchId(const uint32_t launchId);
+    uint32_t getLaunchId() const;
+
     const char* getStatusStr() const;
     static const char* statusToStr(const int status);
     static LaunchMode launchModeToInt(const std::string& launchModeStr);
@@ -98,6 +122,10 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const ActivityRecord& record);
 
 private:
+    void queueTargetStatus(const Status toStatus);
+    bool isPausing() const;
+    Status getFusedTarget() const;
+
     void create();
     void start();
     void resume();
@@ -118,6 +146,12 @@ private:
     std::weak_ptr<ActivityStack> mInTask;
     Intent mIntent;
     bool mNewIntentFlag;
+    bool mIsWindowTokenAdded;
+    uint32_t mLaunchId;
+    Status mFusedTarget; // the client goes on to it without requests, INIT if it isn't fused
+    std::deque<Status> mPendingStatus; // the front one is in flight if the status is "**ing"
+    std::weak_ptr<ActivityRecord> mWaitPauseActivity;
+    std::vector<std::weak_ptr<ActivityRecord>> mResumeWaiters;
 
     sp<::os::wm::IWindowManager> mWindowService;
     ITaskManager* mTaskManager;
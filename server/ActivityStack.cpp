@@ -32,21 +32,50 @@ const int ActivityStack::getSize() const {
 }
 
 void ActivityStack::pushActivity(const ActivityHandler& activity) {
+    const int position = mStack.size();
     mStack.push_back(activity);
+    mTokenIndex[activity->getToken().get()] = position;
+    mNameIndex[activity->getName()].push_back(position);
 }
 
 void ActivityStack::popActivity() {
+    if (mStack.empty()) {
+        return;
+    }
+    const auto& top = mStack.back();
+    mTokenIndex.erase(top->getToken().get());
+    auto iter = mNameIndex.find(top->getName());
+    if (iter != mNameIndex.end()) {
+        // the top Activity is always the last one of the same name
+        iter->second.pop_back();
+        if (iter->second.empty()) {
+            mNameIndex.erase(iter);
+        }
+    }
     mStack.pop_back();
 }
 
 void ActivityStack::removeActivity(const ActivityHandler& activity) {
+    const int position = getActivityPosition(activity->getToken());
+    if (position < 0) {
+        return;
+    }
+    if (position == (int)mStack.size() - 1) {
+        popActivity();
+    } else {
+        // keep the order of the others, the positions above it are changed
+        mStack.erase(mStack.begin() + position);
+        rebuildIndex();
+    }
+}
+
+void ActivityStack::rebuildIndex() {
+    mTokenIndex.clear();
+    mNameIndex.clear();
     const int size = mStack.size();
     for (int i = 0; i < size; ++i) {
-        if (mStack[i] == activity) {
-            mStack[i] = mStack[size - 1];
-            mStack.pop_back();
-            break;
-        }
+        mTokenIndex[mStack[i]->getToken().get()] = i;
+        mNameIndex[mStack[i]->getName()].push_back(i);
     }
 }
 
@@ -59,21 +88,18 @@ ActivityHandler ActivityStack::getRootActivity() {
 }
 
 ActivityHandler ActivityStack::findActivity(const string& name) {
-    for (const auto& it : mStack) {
-        if (it->getName() == name) {
-            return it;
-        }
-    }
-    return nullptr;
+    auto iter = mNameIndex.find(name);
+    return iter != mNameIndex.end() ? mStack[iter->second.front()] : nullptr;
 }
 
 ActivityHandler ActivityStack::findActivity(const sp<IBinder>& token) {
-    for (const auto& it : mStack) {
-        if (it->getToken() == token) {
-            return it;
-        }
-    }
-    return nullptr;
+    const int position = getActivityPosition(token);
+    return position >= 0 ? mStack[position] : nullptr;
+}
+
+int ActivityStack::getActivityPosition(const sp<IBinder>& token) const {
+    auto iter = mTokenIndex.find(token.get());
+    return iter != mTokenIndex.end() ? iter->second : -1;
 }
 
 void ActivityStack::setForeground(const bool isForeground) {
@@ -99,5 +125,24 @@ std::ostream& operator<<(std::ostream& os, const ActivityStack& activityStack) {
     return os;
 }
 
+void ActivityStack::dumpJson(JsonWriter& writer, const char* position) const {
+    int pid = -1;
+    if (!mStack.empty()) {
+        if (auto app = mStack[0]->getAppRecord()) {
+            pid = app->mPid;
+        }
+    }
+    writer.beginObject().field("tag", mTag).field("pid", pid).field("position", position);
+    writer.beginArray("activities");
+    // from the top to the root
+    for (auto it = mStack.rbegin(); it != mStack.rend(); ++it) {
+        writer.beginObject()
+                .field("name", (*it)->getName())
+                .field("status", (*it)->getStatusStr())
+                .endObject();
+    }
+    writer.endArray().endObject();
+}
+
 } // namespace am
 } // namespace os
@@ -20,8 +20,11 @@
 #include <memory>
 #include <stack>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "ActivityRecord.h"
+#include "DumpWriter.h"
 
 namespace os {
 namespace am {
@@ -48,13 +51,23 @@ public:
     ActivityHandler getRootActivity();
     ActivityHandler findActivity(const std::string& activityName);
     ActivityHandler findActivity(const sp<IBinder>& token);
+    /** The position from the root(0) of the task, -1 if the Activity isn't in the task */
+    int getActivityPosition(const sp<IBinder>& token) const;
     void setForeground(const bool isForeground);
 
     friend std::ostream& operator<<(std::ostream& os, const ActivityStack& obj);
+    /** position: where the task is in the task list, e.g. "home" */
+    void dumpJson(JsonWriter& writer, const char* position) const;
 
 private:
+    void rebuildIndex();
+
     std::vector<ActivityHandler> mStack;
     std::string mTag;
+    // token -> position in mStack
+    std::unordered_map<IBinder*, int> mTokenIndex;
+    // activity name -> positions in mStack, from bottom to top
+    std::unordered_map<std::string, std::vector<int>> mNameIndex;
 };
 
 } // namespace am
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AppFreezer.h"
+
+#include <signal.h>
+
+#include <fstream>
+#include <string>
+
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+#ifdef CONFIG_AM_APP_FREEZER_DELAY
+const static uint64_t FREEZE_DELAY_MS = CONFIG_AM_APP_FREEZER_DELAY;
+#else
+const static uint64_t FREEZE_DELAY_MS = 10000;
+#endif
+// Give the application a moment to handle the freeze notification before it stops running
+const static uint64_t FREEZE_SETTLE_MS = 200;
+
+#ifndef __NuttX__
+// cgroup v2 freezer, it's only used when the process is in the cgroup that AMS created for it
+static std::string getCgroupPath(pid_t pid) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            return line.substr(3);
+        }
+    }
+    return "";
+}
+
+static bool cgroupFreeze(pid_t pid, bool isFreeze) {
+    const std::string path = getCgroupPath(pid);
+    const std::string name = "/app-" + std::to_string(pid);
+    if (path.size() <= name.size() || path.compare(path.size() - name.size(), name.size(), name)) {
+        // a shared cgroup (the session, the service, AMS itself) is never frozen, use SIGSTOP
+        return false;
+    }
+    std::ofstream file("/sys/fs/cgroup" + path + "/cgroup.freeze");
+    if (!file.is_open()) {
+        return false;
+    }
+    file << (isFreeze ? "1" : "0");
+    return file.good();
+}
+#endif
+
+#ifdef CONFIG_AM_APP_FREEZER
+AppFreezer::AppFreezer() : AppFreezer(true, FREEZE_DELAY_MS) {}
+#else
+AppFreezer::AppFreezer() : AppFreezer(false, FREEZE_DELAY_MS) {}
+#endif
+
+AppFreezer::AppFreezer(const bool isEnabled, const uint64_t freezeDelayMs)
+      : mEnabled(isEnabled), mFreezeDelayMs(freezeDelayMs) {}
+
+void AppFreezer::init(const std::shared_ptr<os::app::UvLoop>& looper,
+                      const FreezableCB& isFreezable, const NotifyCB& notify) {
+    mLooper = looper;
+    mIsFreezable = isFreezable;
+    mNotify = notify;
+}
+
+AppFreezer::FreezeRecord& AppFreezer::getRecord(pid_t pid) {
+    auto& record = mRecords[pid];
+    if (!record.timer) {
+        record.timer = std::make_unique<os::app::UvTimer>(mLooper->get(), [this, pid](void*) {
+            onFreezeTimeout(pid);
+        });
+    }
+    return record;
+}
+
+void AppFreezer::onForegroundChanged(pid_t pid, bool isForeground) {
+    if (!mEnabled) {
+        return;
+    }
+    auto& record = getRecord(pid);
+    record.isForeground = isForeground;
+    if (isForeground) {
+        thaw(pid);
+    } else {
+        scheduleFreeze(pid, record);
+    }
+}
+
+void AppFreezer::scheduleFreeze(pid_t pid, FreezeRecord& record) {
+    if (record.status == RUNNING && !record.isForeground) {
+        record.timer->start(mFreezeDelayMs);
+    }
+}
+
+void AppFreezer::onFreezeTimeout(pid_t pid) {
+    auto it = mRecords.find(pid);
+    if (it == mRecords.end() || it->second.isForeground) {
+        return;
+    }
+    auto& record = it->second;
+    switch (record.status) {
+        case RUNNING: {
+            if (mIsFreezable && !mIsFreezable(pid)) {
+                // try again later, the process may be serving others now
+                record.timer->start(mFreezeDelayMs);
+                return;
+            }
+            ALOGD("AppFreezer notify pid:%d that it will be frozen", pid);
+            record.status = FREEZING;
+            mNotify(pid, true);
+            record.timer->start(FREEZE_SETTLE_MS);
+            break;
+        }
+        case FREEZING: {
+            if (freezeProcess(pid, true)) {
+                ALOGI("AppFreezer freeze pid:%d", pid);
+                record.status = FROZEN;
+                record.frozenCount++;
+            } else {
+                ALOGW("AppFreezer freeze pid:%d failure", pid);
+                record.status = RUNNING;
+                mNotify(pid, false);
+            }
+            break;
+        }
+        case FROZEN:
+            break;
+    }
+}
+
+void AppFreezer::post(pid_t pid, DeliveryFunc&& delivery) {
+    auto it = mRecords.find(pid);
+    if (it == mRecords.end() || it->second.status == RUNNING) {
+        if (it != mRecords.end()) {
+            // the application is in use, postpone freezing
+            scheduleFreeze(pid, it->second);
+        }
+        delivery();
+        return;
+    }
+    it->second.pendingDelivery.emplace_back(std::move(delivery));
+    thaw(pid);
+}
+
+void AppFreezer::thaw(pid_t pid) {
+    auto it = mRecords.find(pid);
+    if (it == mRecords.end()) {
+        return;
+    }
+    auto& record = it->second;
+    record.timer->stop();
+    if (record.status == FROZEN) {
+        if (!freezeProcess(pid, false)) {
+            ALOGE("AppFreezer thaw pid:%d failure", pid);
+            return;
+        }
+        ALOGI("AppFreezer thaw pid:%d, pending delivery:%zu", pid, record.pendingDelivery.size());
+    }
+    if (record.status != RUNNING) {
+        record.status = RUNNING;
+        mNotify(pid, false);
+    }
+
+    // deliver in the original order after the application is running again
+    std::vector<DeliveryFunc> pending;
+    pending.swap(record.pendingDelivery);
+    for (auto& delivery : pending) {
+        delivery();
+    }
+    scheduleFreeze(pid, record);
+}
+
+bool AppFreezer::isFrozen(pid_t pid) const {
+    auto it = mRecords.find(pid);
+    return it != mRecords.end() && it->second.status == FROZEN;
+}
+
+void AppFreezer::remove(pid_t pid) {
+    auto it = mRecords.find(pid);
+    if (it != mRecords.end()) {
+        if (!it->second.pendingDelivery.empty()) {
+            ALOGW("AppFreezer pid:%d exit with %zu pending delivery", pid,
+                  it->second.pendingDelivery.size());
+        }
+        mRecords.erase(it);
+    }
+}
+
+bool AppFreezer::freezeProcess(pid_t pid, bool isFreeze) {
+#ifndef __NuttX__
+    if (cgroupFreeze(pid, isFreeze)) {
+        return true;
+    }
+#endif
+    return kill(pid, isFreeze ? SIGSTOP : SIGCONT) == 0;
+}
+
+static const char* freezeStatusStr[] = {"running", "freezing", "frozen"};
+
+std::ostream& operator<<(std::ostream& os, const AppFreezer& freezer) {
+    os << "Freezer:" << (freezer.mEnabled ? "" : " disabled") << std::endl;
+    for (const auto& [pid, record] : freezer.mRecords) {
+        os << "\tpid:" << pid << " " << freezeStatusStr[record.status]
+           << (record.isForeground ? " foreground" : " background")
+           << " frozenCount:" << record.frozenCount
+           << " pending:" << record.pendingDelivery.size() << std::endl;
+    }
+    return os;
+}
+
+void AppFreezer::dumpJson(JsonWriter& writer) const {
+    writer.beginObject("freezer").field("enabled", mEnabled);
+    writer.beginArray("processes");
+    for (const auto& [pid, record] : mRecords) {
+        writer.beginObject()
+                .field("pid", pid)
+                .field("status", freezeStatusStr[record.status])
+                .field("foreground", record.isForeground)
+                .field("frozenCount", record.frozenCount)
+                .field("pending", record.pendingDelivery.size())
+                .endObject();
+    }
+    writer.endArray().endObject();
+}
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "DumpWriter.h"
+#include "app/UvLoop.h"
+
+namespace os {
+namespace am {
+
+/**
+ * AppFreezer: stop scheduling the applications that stay in background for a while.
+ *
+ * running --(background timeout)--> freezing --(notified app)--> frozen
+ *    ^                                  |                          |
+ *    +----------(delivery/foreground)---+-------------(thaw)-------+
+ *
+ * Everything delivered to a frozen application is queued, and flushed in order after it's thawed.
+ */
+class AppFreezer {
+public:
+    using FreezableCB = std::function<bool(pid_t)>;
+    using NotifyCB = std::function<void(pid_t, bool isFrozen)>;
+    using DeliveryFunc = std::function<void()>;
+
+    AppFreezer();
+    AppFreezer(const bool isEnabled, const uint64_t freezeDelayMs);
+
+    void init(const std::shared_ptr<os::app::UvLoop>& looper, const FreezableCB& isFreezable,
+              const NotifyCB& notify);
+    bool isEnabled() const {
+        return mEnabled;
+    }
+
+    void onForegroundChanged(pid_t pid, bool isForeground);
+    /** Deliver immediately, or thaw the application before delivering */
+    void post(pid_t pid, DeliveryFunc&& delivery);
+    void thaw(pid_t pid);
+    bool isFrozen(pid_t pid) const;
+    void remove(pid_t pid);
+
+    friend std::ostream& operator<<(std::ostream& os, const AppFreezer& freezer);
+    void dumpJson(JsonWriter& writer) const;
+
+private:
+    enum FreezeStatus { RUNNING, FREEZING, FROZEN };
+    struct FreezeRecord {
+        FreezeStatus status = RUNNING;
+        bool isForeground = true;
+        int frozenCount = 0;
+        std::unique_ptr<os::app::UvTimer> timer;
+        std::vector<DeliveryFunc> pendingDelivery;
+    };
+
+    FreezeRecord& getRecord(pid_t pid);
+    void scheduleFreeze(pid_t pid, FreezeRecord& record);
+    void onFreezeTimeout(pid_t pid);
+    bool freezeProcess(pid_t pid, bool isFreeze);
+
+    bool mEnabled;
+    uint64_t mFreezeDelayMs;
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    FreezableCB mIsFreezable;
+    NotifyCB mNotify;
+    std::unordered_map<pid_t, FreezeRecord> mRecords;
+};
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AppPreloader"
+
+#include "AppPreloader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+#include "app/Logger.h"
+
+#ifdef CONFIG_AM_PRELOADER_STACKSIZE
+#define AM_PRELOADER_STACKSIZE CONFIG_AM_PRELOADER_STACKSIZE
+#else
+#define AM_PRELOADER_STACKSIZE 4096
+#endif
+
+namespace os {
+namespace am {
+
+static constexpr size_t READ_CHUNK_SIZE = 4096;
+
+AppPreloader::AppPreloader(const size_t budgetKb)
+      : mBudget(budgetKb * 1024),
+        mUsed(0),
+        mIsExiting(false),
+        mIsStarted(false),
+        mHits(0),
+        mLateHits(0),
+        mMisses(0),
+        mEvictions(0),
+        mFailures(0),
+        mReadBytes(0) {}
+
+AppPreloader::~AppPreloader() {
+    if (mIsStarted) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mIsExiting = true;
+        }
+        mCond.notify_all();
+        pthread_join(mThread, nullptr);
+    }
+}
+
+AppPreloader::EntryIterator AppPreloader::findEntry(const std::string& execfile) {
+    return std::find_if(mEntries.begin(), mEntries.end(),
+                        [&execfile](const Entry& entry) { return entry.execfile == execfile; });
+}
+
+void AppPreloader::preload(const std::string& execfile) {
+    if (!isEnabled() || execfile.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = findEntry(execfile);
+    if (it != mEntries.end()) {
+        mEntries.splice(mEntries.begin(), mEntries, it);
+        return;
+    }
+    if (!mIsStarted) {
+        // the thread only reads, a small stack is enough
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, AM_PRELOADER_STACKSIZE);
+        mIsStarted = pthread_create(
+                             &mThread, &attr,
+                             [](void* arg) -> void* {
+                                 ((AppPreloader*)arg)->preloaderLoop();
+                                 return nullptr;
+                             },
+                             this) == 0;
+        pthread_attr_destroy(&attr);
+        if (!mIsStarted) {
+            ALOGE("can't create the preloader thread");
+            return;
+        }
+        pthread_setname_np(mThread, "am_preloader");
+    }
+    ALOGD("preload %s", execfile.c_str());
+    mEntries.push_front({execfile});
+    mQueue.push_back(execfile);
+    mCond.notify_all();
+}
+
+void AppPreloader::preloadPackage(const std::string& packageName) {
+    std::string execfile;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const auto it = mExecfiles.find(packageName);
+        if (it == mExecfiles.end()) {
+            return;
+        }
+        execfile = it->second;
+    }
+    preload(execfile);
+}
+
+void AppPreloader::onSpawn(const std::string& packageName, const std::string& execfile) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mExecfiles[packageName] = execfile;
+    const auto it = findEntry(execfile);
+    if (it == mEntries.end()) {
+        mMisses++;
+        return;
+    }
+    if (it->isLoaded) {
+        mHits++;
+    } else {
+        mLateHits++;
+        mQueue.erase(std::remove(mQueue.begin(), mQueue.end(), execfile), mQueue.end());
+    }
+    // the program is in use, it doesn't take the budget anymore
+    mUsed -= it->size;
+    mEntries.erase(it);
+}
+
+void AppPreloader::preloaderLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCond.wait(lock, [this] { return mIsExiting || !mQueue.empty(); });
+        if (mIsExiting) {
+            return;
+        }
+        const std::string execfile = std::move(mQueue.front());
+        mQueue.pop_front();
+        lock.unlock();
+        const bool isLoaded = load(execfile);
+        lock.lock();
+        const auto it = findEntry(execfile);
+        if (it == mEntries.end()) {
+            // it's spawned during the load
+            continue;
+        }
+        if (isLoaded) {
+            it->isLoaded = true;
+        } else {
+            mFailures++;
+            mUsed -= it->size;
+            mEntries.erase(it);
+        }
+    }
+}
+
+bool AppPreloader::load(const std::string& execfile) {
+    const int fd = open(execfile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGW("can't preload %s", execfile.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size > mBudget) {
+        close(fd);
+        return false;
+    }
+
+    // take the budget before reading, the released ones are dropped from the cache
+    const size_t size = st.st_size;
+    std::vector<std::string> released;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const auto it = findEntry(execfile);
+        if (it == mEntries.end()) {
+            close(fd);
+            return false;
+        }
+        for (auto victim = mEntries.end(); mUsed + size > mBudget && victim != mEntries.begin();) {
+            if ((--victim)->isLoaded) {
+                released.push_back(victim->execfile);
+                mUsed -= victim->size;
+                victim = mEntries.erase(victim);
+                mEvictions++;
+            }
+        }
+        if (mUsed + size > mBudget) {
+            // the others are loading, or the released ones aren't enough
+            ALOGW("no budget to preload %s %zuKB", execfile.c_str(), size / 1024);
+            close(fd);
+            return false;
+        }
+        it->size = size;
+        mUsed += size;
+    }
+    for (const auto& file : released) {
+        const int releasedFd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (releasedFd >= 0) {
+            posix_fadvise(releasedFd, 0, 0, POSIX_FADV_DONTNEED);
+            close(releasedFd);
+        }
+    }
+
+    // the hint is enough where the page cache reads ahead, otherwise the read fills the cache
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    std::unique_ptr<char[]> buffer(new char[READ_CHUNK_SIZE]);
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(fd, buffer.get(), READ_CHUNK_SIZE)) > 0) {
+        total += n;
+    }
+    close(fd);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReadBytes += total;
+    }
+    ALOGD("preloaded %s %zuKB", execfile.c_str(), total / 1024);
+    return n == 0;
+}
+
+std::ostream& operator<<(std::ostream& os, AppPreloader& preloader) {
+    std::lock_guard<std::mutex> lock(preloader.mMutex);
+    const int spawns = preloader.mHits + preloader.mLateHits + preloader.mMisses;
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << "\nPreloader: budget:" << preloader.mBudget / 1024 << "KB used:" << preloader.mUsed / 1024
+       << "KB read:" << preloader.mReadBytes / 1024 << "KB" << std::endl;
+    os << "\tspawns:" << spawns << " hits:" << preloader.mHits
+       << " late:" << preloader.mLateHits << " misses:" << preloader.mMisses
+       << " evictions:" << preloader.mEvictions << " failures:" << preloader.mFailures;
+    if (spawns > 0) {
+        os << std::fixed << std::setprecision(1)
+           << " hitRate:" << preloader.mHits * 100.0 / spawns << "%";
+    }
+    os << std::endl;
+    for (const auto& entry : preloader.mEntries) {
+        os << "\t\t" << entry.execfile << " " << entry.size / 1024 << "KB"
+           << (entry.isLoaded ? "" : " (loading)") << std::endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+}
+
+void AppPreloader::dumpJson(JsonWriter& writer) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    writer.beginObject("preloader")
+            .field("budgetKb", mBudget / 1024)
+            .field("usedKb", mUsed / 1024)
+            .field("readKb", mReadBytes / 1024)
+            .field("hits", mHits)
+            .field("lateHits", mLateHits)
+            .field("misses", mMisses)
+            .field("evictions", mEvictions)
+            .field("failures", mFailures);
+    writer.beginArray("entries");
+    for (const auto& entry : mEntries) {
+        writer.beginObject()
+                .field("execfile", entry.execfile)
+                .field("sizeKb", entry.size / 1024)
+                .field("loaded", entry.isLoaded)
+                .endObject();
+    }
+    writer.endArray().endObject();
+}
+
+} // namespace am
+} // namespace os
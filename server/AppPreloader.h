@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "DumpWriter.h"
+
+namespace os {
+namespace am {
+
+/**
+ * Read the programs of the applications that are likely to start ahead, the spawn doesn't wait
+ * for the flash then. The files are read by a background thread, the preloaded ones are kept
+ * in a budget, the least recently requested one is released when it's exceeded.
+ * A spawn is a hit if its program is completely preloaded.
+ */
+class AppPreloader {
+public:
+    explicit AppPreloader(const size_t budgetKb);
+    ~AppPreloader();
+
+    bool isEnabled() const {
+        return mBudget > 0;
+    }
+
+    /** The program of a package is only known after the package is spawned */
+    void preload(const std::string& execfile);
+    void preloadPackage(const std::string& packageName);
+    void onSpawn(const std::string& packageName, const std::string& execfile);
+
+    friend std::ostream& operator<<(std::ostream& os, AppPreloader& preloader);
+    void dumpJson(JsonWriter& writer);
+
+private:
+    struct Entry {
+        std::string execfile;
+        size_t size = 0;
+        bool isLoaded = false;
+    };
+    using EntryIterator = std::list<Entry>::iterator;
+
+    EntryIterator findEntry(const std::string& execfile);
+    void preloaderLoop();
+    bool load(const std::string& execfile);
+
+    const size_t mBudget; // bytes
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::list<Entry> mEntries; // the recently requested one is at the front
+    std::deque<std::string> mQueue;
+    std::unordered_map<std::string, std::string> mExecfiles; // package -> execfile
+    size_t mUsed;
+    bool mIsExiting;
+    bool mIsStarted;
+    pthread_t mThread;
+
+    int mHits;
+    int mLateHits; // it's still loading when spawned
+    int mMisses;
+    int mEvictions;
+    int mFailures;
+    uint64_t mReadBytes;
+};
+
+} // namespace am
+} // namespace os
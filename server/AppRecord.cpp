@@ -79,12 +79,13 @@ void AppRecord::setForeground(const bool isForegroundActivity) {
     }
     if (isForegroundActivity) {
         if (++mForegroundActivityCnt == 1) {
-            mAppThread->setForegroundApplication(true);
+            // the process may be frozen in background, it must be running before notified
             mPriorityPolicy->pushForeground(mPid);
+            post([app = mAppThread] { app->setForegroundApplication(true); });
         }
     } else {
         if (--mForegroundActivityCnt == 0) {
-            mAppThread->setForegroundApplication(false);
+            post([app = mAppThread] { app->setForegroundApplication(false); });
             mPriorityPolicy->intoBackground(mPid);
         }
     }
@@ -93,7 +94,15 @@ void AppRecord::setForeground(const bool isForegroundActivity) {
 
 void AppRecord::scheduleReceiveIntent(const sp<IBinder>& token, const Intent& intent) {
     if (mStatus != APP_STOPPED) {
-        mAppThread->scheduleReceiveIntent(token, intent);
+        post([app = mAppThread, token, intent] { app->scheduleReceiveIntent(token, intent); });
+    }
+}
+
+void AppRecord::post(AppFreezer::DeliveryFunc&& delivery) {
+    if (mFreezer) {
+        mFreezer->post(mPid, std::move(delivery));
+    } else {
+        delivery();
     }
 }
 
@@ -106,7 +115,7 @@ bool AppRecord::checkActiveStatus() const {
 
 void AppRecord::stopApplication() {
     if (mStatus == APP_RUNNING) {
-        mAppThread->terminateApplication();
+        post([app = mAppThread] { app->terminateApplication(); });
         mStatus = APP_STOPPING;
     }
 }
@@ -200,5 +209,54 @@ bool AppInfoList::getAttachingAppName(int pid, std::string& packageName) {
     return false;
 }
 
+static const char* appStatusToStr(const AppStatus status) {
+    switch (status) {
+        case APP_RUNNING:
+            return "running";
+        case APP_STOPPING:
+            return "stopping";
+        case APP_STOPPED:
+            return "stopped";
+    }
+    return "unknown";
+}
+
+std::ostream& operator<<(std::ostream& os, const AppInfoList& apps) {
+    os << "\n\nApplications:" << std::endl;
+    for (const auto& app : apps.mAppList) {
+        os << "\t" << app->mPackageName << " [ " << app->mPid << " ] uid:" << app->mUid
+           << (app->mIsSystemUI ? " systemui" : "") << " [" << appStatusToStr(app->mStatus) << "]"
+           << " activities:" << app->mExistActivity.size()
+           << " services:" << app->mExistService.size() << std::endl;
+    }
+    for (const auto& [packageName, pid] : apps.mAppWaitingAttach) {
+        os << "\t" << packageName << " [ " << pid << " ] [attaching]" << std::endl;
+    }
+    return os;
+}
+
+void AppInfoList::dumpJson(JsonWriter& writer) const {
+    writer.beginArray("apps");
+    for (const auto& app : mAppList) {
+        writer.beginObject()
+                .field("package", app->mPackageName)
+                .field("pid", app->mPid)
+                .field("uid", app->mUid)
+                .field("systemui", app->mIsSystemUI)
+                .field("status", appStatusToStr(app->mStatus))
+                .field("activities", app->mExistActivity.size())
+                .field("services", app->mExistService.size())
+                .endObject();
+    }
+    for (const auto& [packageName, pid] : mAppWaitingAttach) {
+        writer.beginObject()
+                .field("package", packageName)
+                .field("pid", pid)
+                .field("status", "attaching")
+                .endObject();
+    }
+    writer.endArray();
+}
+
 } // namespace am
 } // namespace os
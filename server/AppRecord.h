@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "ActivityRecord.h"
+#include "AppFreezer.h"
 #include "ProcessPriorityPolicy.h"
 #include "ServiceRecord.h"
 #include "TaskBoard.h"
@@ -37,6 +38,12 @@ class AppInfoList;
 
 enum AppStatus { APP_RUNNING, APP_STOPPING, APP_STOPPED };
 
+/** The activity that is launched with the attachApplication reply */
+struct FusedLaunch {
+    std::shared_ptr<ActivityRecord> activity;
+    ActivityRecord::Status targetStatus;
+};
+
 struct AppRecord {
     sp<IApplicationThread> mAppThread;
     std::string mPackageName;
@@ -45,13 +52,16 @@ struct AppRecord {
     int mUid;
     AppInfoList* mAppList;
     ProcessPriorityPolicy* mPriorityPolicy;
+    AppFreezer* mFreezer; // null if the application is never frozen
     int mForegroundActivityCnt;
     AppStatus mStatus;
     std::vector<std::weak_ptr<ActivityRecord>> mExistActivity;
     std::vector<std::weak_ptr<ServiceRecord>> mExistService;
+    std::vector<FusedLaunch>* mFusedLaunches; // it's only set in attachApplication
 
     AppRecord(sp<IApplicationThread> app, std::string packageName, const bool systemui, int pid,
-              int uid, AppInfoList* applist, ProcessPriorityPolicy* policy)
+              int uid, AppInfoList* applist, ProcessPriorityPolicy* policy,
+              AppFreezer* freezer = nullptr)
           : mAppThread(app),
             mPackageName(packageName),
             mIsSystemUI(systemui),
@@ -59,8 +69,10 @@ struct AppRecord {
             mUid(uid),
             mAppList(applist),
             mPriorityPolicy(policy),
+            mFreezer(freezer),
             mForegroundActivityCnt(0),
-            mStatus(APP_RUNNING) {}
+            mStatus(APP_RUNNING),
+            mFusedLaunches(nullptr) {}
 
     ActivityHandler checkActivity(const std::string& activityName);
     ServiceHandler checkService(const std::string& serviceName);
@@ -69,6 +81,8 @@ struct AppRecord {
     void stopApplication();
     void setForeground(const bool isForegroundActivity);
     void scheduleReceiveIntent(const sp<IBinder>& token, const Intent& intent);
+    /** Every call to the application goes through it, a frozen application is thawed first */
+    void post(AppFreezer::DeliveryFunc&& delivery);
 
     void addActivity(const std::shared_ptr<ActivityRecord>& activity);
     int deleteActivity(const std::shared_ptr<ActivityRecord>& activity);
@@ -91,6 +105,9 @@ public:
     int getAttachingAppPid(const std::string& packageName);
     bool getAttachingAppName(int pid, std::string& packageName);
 
+    friend std::ostream& operator<<(std::ostream& os, const AppInfoList& apps);
+    void dumpJson(JsonWriter& writer) const;
+
 private:
     std::vector<std::shared_ptr<AppRecord>> mAppList;
     // app had spawn but does't attach
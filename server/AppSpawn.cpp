@@ -24,13 +24,70 @@
 #include <string.h>
 #include <sys/wait.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include "app/Logger.h"
+#include "app/UvLoop.h"
+
+#ifdef CONFIG_AM_SPAWNER_STACKSIZE
+#define AM_SPAWNER_STACKSIZE CONFIG_AM_SPAWNER_STACKSIZE
+#else
+#define AM_SPAWNER_STACKSIZE 8192
+#endif
 
 namespace os {
 namespace app {
 
+AppSpawn::AppSpawn()
+      : mIsSpawning(false),
+        mSpawnCount(0),
+        mCompletedCount(0),
+        mIsExiting(false),
+        mIsSpawnerStarted(false),
+        mIsAsyncInit(false) {}
+
+AppSpawn::~AppSpawn() {
+    if (mIsSpawnerStarted) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mIsExiting = true;
+        }
+        mCond.notify_all();
+        pthread_join(mSpawner, nullptr);
+    }
+    if (mIsAsyncInit) {
+        uvCloseHandle((uv_handle_t*)&mCompletionAsync);
+    }
+}
+
 int AppSpawn::signalInit(uv_loop_t* looper, const ChildPidExitCB& cb) {
     mChildPidExitCB = cb;
+    mCompletionAsync.data = this;
+    uv_async_init(looper, &mCompletionAsync,
+                  [](uv_async_t* handle) { ((AppSpawn*)handle->data)->deliver(); });
+    // the loop doesn't wait for the spawns
+    uv_unref((uv_handle_t*)&mCompletionAsync);
+    mIsAsyncInit = true;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, AM_SPAWNER_STACKSIZE);
+    const int ret = pthread_create(
+            &mSpawner, &attr,
+            [](void* arg) -> void* {
+                ((AppSpawn*)arg)->spawnerLoop();
+                return nullptr;
+            },
+            this);
+    pthread_attr_destroy(&attr);
+    if (ret == 0) {
+        pthread_setname_np(mSpawner, "am_spawner");
+        mIsSpawnerStarted = true;
+    } else {
+        ALOGE("can't create the spawner thread:%d, spawn on the looper", ret);
+    }
+
     uv_signal_init(looper, &mSignalHandler);
     mSignalHandler.data = this;
     return uv_signal_start(
@@ -40,7 +97,7 @@ int AppSpawn::signalInit(uv_loop_t* looper, const ChildPidExitCB& cb) {
                 int status;
                 AppSpawn* asp = (AppSpawn*)handle->data;
                 while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
-                    asp->mChildPidExitCB((int)pid);
+                    asp->onChildExit((int)pid);
                     if (WIFEXITED(status)) {
                         ALOGW("child process:%d normal exit:%d", pid, WEXITSTATUS(status));
                     } else if (WIFSIGNALED(status)) {
@@ -53,23 +110,118 @@ int AppSpawn::signalInit(uv_loop_t* looper, const ChildPidExitCB& cb) {
 }
 
 int AppSpawn::appSpawn(const char* execfile, std::initializer_list<std::string> argvlist) {
+    return spawn(execfile, std::vector<std::string>(argvlist));
+}
+
+void AppSpawn::appSpawnAsync(const std::string& execfile, std::vector<std::string>&& args,
+                             SpawnCB&& cb) {
+    if (!mIsSpawnerStarted) {
+        const int pid = spawn(execfile, args);
+        if (!mIsAsyncInit) {
+            cb(pid);
+            return;
+        }
+        // the spawn is done on the looper, but the callback is still called later, the caller
+        // records the launch after the request
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCompletions.push_back({execfile, std::move(args), std::move(cb), pid});
+        }
+        uv_async_send(&mCompletionAsync);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRequests.push_back({execfile, std::move(args), std::move(cb), -1});
+    }
+    mCond.notify_all();
+}
+
+void AppSpawn::deliverSpawned() {
+    deliver();
+}
+
+bool AppSpawn::isSpawning() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIsSpawning;
+}
+
+int AppSpawn::spawn(const std::string& execfile, const std::vector<std::string>& args) {
     int pid = -1;
-    char* argv[argvlist.size() + 2]; /** 2 = program name + null ptr */
+    char* argv[args.size() + 2]; /** 2 = program name + null ptr */
     int i = 1;
-    argv[0] = const_cast<char*>(execfile);
-    for (auto it = argvlist.begin(); it != argvlist.end(); ++it) {
-        argv[i++] = const_cast<char*>(it->c_str());
+    argv[0] = const_cast<char*>(execfile.c_str());
+    for (const auto& arg : args) {
+        argv[i++] = const_cast<char*>(arg.c_str());
     }
     argv[i] = nullptr;
     ALOGD("appSpawn :%s %s", argv[0], argv[1]);
 
-    const int ret = posix_spawn(&pid, execfile, NULL, NULL, argv, NULL);
+    const int ret = posix_spawn(&pid, argv[0], NULL, NULL, argv, NULL);
     if (ret != 0) {
-        ALOGE("posix_spawn %s failed error:%d", execfile, ret);
+        ALOGE("posix_spawn %s failed error:%d", argv[0], ret);
         return ret > 0 ? -ret : ret;
     }
     return pid;
 }
 
+void AppSpawn::spawnerLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCond.wait(lock, [this] { return mIsExiting || !mRequests.empty(); });
+        if (mIsExiting) {
+            return;
+        }
+        auto request = std::move(mRequests.front());
+        mRequests.pop_front();
+        mIsSpawning = true;
+        mSpawnCount++;
+        lock.unlock();
+        request.pid = spawn(request.execfile, request.args);
+        lock.lock();
+        mIsSpawning = false;
+        mCompletedCount++;
+        mCompletions.push_back(std::move(request));
+        uv_async_send(&mCompletionAsync);
+    }
+}
+
+int AppSpawn::deliver() {
+    std::deque<SpawnRequest> completions;
+    std::vector<int> exits;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        completions.swap(mCompletions);
+        // the spawns that the exits waited for are delivered with these completions
+        const auto it = std::partition(mExits.begin(), mExits.end(), [this](const auto& exit) {
+            return exit.second > mCompletedCount;
+        });
+        std::transform(it, mExits.end(), std::back_inserter(exits),
+                       [](const auto& exit) { return exit.first; });
+        mExits.erase(it, mExits.end());
+    }
+    for (auto& completion : completions) {
+        completion.callback(completion.pid);
+    }
+    for (const int pid : exits) {
+        mChildPidExitCB(pid);
+    }
+    return completions.size();
+}
+
+void AppSpawn::onChildExit(int pid) {
+    // the completion of its spawn may be queued still
+    deliver();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mIsSpawning) {
+            // it may be the process in flight, whose pid isn't delivered yet
+            mExits.emplace_back(pid, mSpawnCount);
+            return;
+        }
+    }
+    mChildPidExitCB(pid);
+}
+
 } // namespace app
 } // namespace os
\ No newline at end of file
@@ -16,24 +16,77 @@
 
 #pragma once
 
+#include <pthread.h>
 #include <uv.h>
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <initializer_list>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace os {
 namespace app {
 
 using ChildPidExitCB = std::function<void(int)>;
+/** The pid of the new process, or a negative errno */
+using SpawnCB = std::function<void(int)>;
 
 class AppSpawn {
 public:
+    AppSpawn();
+    ~AppSpawn();
+
     int signalInit(uv_loop_t* looper, const ChildPidExitCB& cb);
     int appSpawn(const char* execfile, std::initializer_list<std::string> argvlist);
+    /**
+     * Loading a large program takes a while, so it's spawned on the spawner thread and the
+     * looper goes on. The callback is called on the looper, never before it returns, even if
+     * the spawner thread can't start.
+     */
+    void appSpawnAsync(const std::string& execfile, std::vector<std::string>&& args,
+                       SpawnCB&& cb);
+    /**
+     * The process may run before its spawn completion gets to the looper. Call the callbacks
+     * of the completed spawns now, the spawn in flight is never waited for.
+     */
+    void deliverSpawned();
+    /** True if posix_spawn is in flight, the pid of the new process isn't known yet */
+    bool isSpawning();
 
     uv_signal_t mSignalHandler;
     ChildPidExitCB mChildPidExitCB;
+
+private:
+    struct SpawnRequest {
+        std::string execfile;
+        std::vector<std::string> args;
+        SpawnCB callback;
+        int pid;
+    };
+
+    int spawn(const std::string& execfile, const std::vector<std::string>& args);
+    void spawnerLoop();
+    int deliver();
+    void onChildExit(int pid);
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<SpawnRequest> mRequests;
+    std::deque<SpawnRequest> mCompletions;
+    bool mIsSpawning; // a request is taken by the spawner thread
+    uint32_t mSpawnCount;     // the requests that are taken by the spawner thread
+    uint32_t mCompletedCount; // the ones of them that are completed
+    // the exits while a spawn is in flight, with the count of it, they wait for its completion
+    std::vector<std::pair<int, uint32_t>> mExits;
+    bool mIsExiting;
+    bool mIsSpawnerStarted;
+    pthread_t mSpawner;
+    bool mIsAsyncInit;
+    uv_async_t mCompletionAsync;
 };
 
 } // namespace app
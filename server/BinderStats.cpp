@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BinderStats.h"
+
+#include <binder/IPCThreadState.h>
+
+#include <algorithm>
+#include <iomanip>
+
+#include "Clock.h"
+
+namespace os {
+namespace am {
+
+static const char* methodStr[] = {
+        "attachApplication",            "startActivity",
+        "stopActivity",                 "stopApplication",
+        "finishActivity",               "moveActivityTaskToBackground",
+        "reportActivityStatus",         "startService",
+        "stopService",                  "stopServiceByToken",
+        "reportServiceStatus",          "bindService",
+        "unbindService",                "publishService",
+        "postIntent",                   "sendBroadcast",
+        "registerReceiver",             "unregisterReceiver",
+};
+
+BinderStats::Scope::Scope(BinderStats& stats, const Method method)
+      : mStats(stats), mMethod(method), mBeginTime(clock_us()) {}
+
+BinderStats::Scope::~Scope() {
+    mStats.record(mMethod, android::IPCThreadState::self()->getCallingUid(),
+                  clock_us() - mBeginTime);
+}
+
+int BinderStats::getBucket(const uint64_t latencyUs) {
+    if (latencyUs < (1 << SUB_BUCKET_BITS)) {
+        return latencyUs;
+    }
+    const int msb = 63 - __builtin_clzll(latencyUs);
+    if (msb >= MAX_LATENCY_BITS) {
+        return BUCKET_NUM - 1;
+    }
+    const int sub = (latencyUs >> (msb - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+    return ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub;
+}
+
+/** The latency in the bucket is less than the upper bound */
+uint64_t BinderStats::getBucketUpperBound(const int bucket) {
+    if (bucket < (1 << SUB_BUCKET_BITS)) {
+        return bucket + 1;
+    }
+    const int msb = (bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    const int sub = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+    return (uint64_t)((1 << SUB_BUCKET_BITS) + sub + 1) << (msb - SUB_BUCKET_BITS);
+}
+
+void BinderStats::record(const Method method, const uid_t uid, const uint64_t latencyUs) {
+    auto& stats = mStats[method];
+    stats.totalUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    stats.buckets[getBucket(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+
+    const uint32_t latency = latencyUs > UINT32_MAX ? UINT32_MAX : latencyUs;
+    uint32_t maxUs = stats.maxUs.load(std::memory_order_relaxed);
+    while (latency > maxUs &&
+           !stats.maxUs.compare_exchange_weak(maxUs, latency, std::memory_order_relaxed)) {
+    }
+
+    for (auto& slot : stats.uids) {
+        uint32_t slotUid = slot.uid.load(std::memory_order_relaxed);
+        if (slotUid == INVALID_UID) {
+            // take the free slot, or another thread has taken it
+            slot.uid.compare_exchange_strong(slotUid, uid, std::memory_order_relaxed);
+            slotUid = slot.uid.load(std::memory_order_relaxed);
+        }
+        if (slotUid == uid) {
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    stats.otherUidCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BinderStats::reset() {
+    for (auto& stats : mStats) {
+        stats.totalUs.store(0, std::memory_order_relaxed);
+        stats.maxUs.store(0, std::memory_order_relaxed);
+        for (auto& bucket : stats.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        for (auto& slot : stats.uids) {
+            slot.count.store(0, std::memory_order_relaxed);
+            slot.uid.store(INVALID_UID, std::memory_order_relaxed);
+        }
+        stats.otherUidCount.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t BinderStats::percentile(const MethodStats& stats, const uint32_t count, const int p) {
+    // nearest-rank, the counters may be increased meanwhile, so count is from the buckets
+    const uint64_t rank = ((uint64_t)count * p + 99) / 100;
+    uint64_t sum = 0;
+    for (int i = 0; i < BUCKET_NUM - 1; i++) {
+        sum += stats.buckets[i].load(std::memory_order_relaxed);
+        if (sum >= rank) {
+            return std::min<uint64_t>(getBucketUpperBound(i),
+                                      stats.maxUs.load(std::memory_order_relaxed));
+        }
+    }
+    return stats.maxUs.load(std::memory_order_relaxed);
+}
+
+std::ostream& operator<<(std::ostream& os, const BinderStats& stats) {
+    os << "\nBinder stats(us): method count avg p50 p90 p99 max [uid:count]" << std::endl;
+    for (int i = 0; i < BinderStats::METHOD_NUM; i++) {
+        const auto& method = stats.mStats[i];
+        uint32_t count = 0;
+        for (const auto& bucket : method.buckets) {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+        if (count == 0) {
+            continue;
+        }
+        os << "\t" << std::left << std::setw(30) << methodStr[i] << std::right;
+        os << " " << std::setw(7) << count;
+        os << " " << std::setw(7) << method.totalUs.load(std::memory_order_relaxed) / count;
+        for (const int p : {50, 90, 99}) {
+            os << " " << std::setw(7) << BinderStats::percentile(method, count, p);
+        }
+        os << " " << std::setw(7) << method.maxUs.load(std::memory_order_relaxed) << " [";
+        for (const auto& slot : method.uids) {
+            const uint32_t uid = slot.uid.load(std::memory_order_relaxed);
+            if (uid != BinderStats::INVALID_UID) {
+                os << " " << uid << ":" << slot.count.load(std::memory_order_relaxed);
+            }
+        }
+        if (const uint32_t other = method.otherUidCount.load(std::memory_order_relaxed)) {
+            os << " other:" << other;
+        }
+        os << " ]" << std::endl;
+    }
+    return os;
+}
+
+void BinderStats::dumpJson(JsonWriter& writer) const {
+    writer.beginArray("binder");
+    for (int i = 0; i < METHOD_NUM; i++) {
+        const auto& method = mStats[i];
+        uint32_t count = 0;
+        for (const auto& bucket : method.buckets) {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+        if (count == 0) {
+            continue;
+        }
+        writer.beginObject()
+                .field("method", methodStr[i])
+                .field("count", count)
+                .field("totalUs", method.totalUs.load(std::memory_order_relaxed))
+                .field("p50Us", percentile(method, count, 50))
+                .field("p90Us", percentile(method, count, 90))
+                .field("p99Us", percentile(method, count, 99))
+                .field("maxUs", method.maxUs.load(std::memory_order_relaxed));
+        // the non-empty buckets as [upper bound, count], the last one is unbounded(0)
+        writer.beginArray("histogram");
+        for (int b = 0; b < BUCKET_NUM; b++) {
+            if (const uint32_t n = method.buckets[b].load(std::memory_order_relaxed)) {
+                writer.beginArray()
+                        .field(nullptr, b == BUCKET_NUM - 1 ? 0 : getBucketUpperBound(b))
+                        .field(nullptr, n)
+                        .endArray();
+            }
+        }
+        writer.endArray();
+        writer.beginArray("uids");
+        for (const auto& slot : method.uids) {
+            const uint32_t uid = slot.uid.load(std::memory_order_relaxed);
+            if (uid != INVALID_UID) {
+                writer.beginObject()
+                        .field("uid", uid)
+                        .field("count", slot.count.load(std::memory_order_relaxed))
+                        .endObject();
+            }
+        }
+        writer.endArray();
+        writer.field("otherUidCount", method.otherUidCount.load(std::memory_order_relaxed));
+        writer.endObject();
+    }
+    writer.endArray();
+}
+
+} // namespace am
+} // namespace os
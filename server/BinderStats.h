@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <iostream>
+
+#include "DumpWriter.h"
+
+namespace os {
+namespace am {
+
+/**
+ * The call count, latency histogram and calling uids of each IActivityManager method.
+ * The counters are atomic, the binder threads record without lock.
+ */
+class BinderStats {
+public:
+    enum Method {
+        ATTACH_APPLICATION = 0,
+        START_ACTIVITY,
+        STOP_ACTIVITY,
+        STOP_APPLICATION,
+        FINISH_ACTIVITY,
+        MOVE_ACTIVITY_TASK_TO_BACKGROUND,
+        REPORT_ACTIVITY_STATUS,
+        START_SERVICE,
+        STOP_SERVICE,
+        STOP_SERVICE_BY_TOKEN,
+        REPORT_SERVICE_STATUS,
+        BIND_SERVICE,
+        UNBIND_SERVICE,
+        PUBLISH_SERVICE,
+        POST_INTENT,
+        SEND_BROADCAST,
+        REGISTER_RECEIVER,
+        UNREGISTER_RECEIVER,
+        METHOD_NUM,
+    };
+
+    /** Record the method call from the construction to the destruction */
+    class Scope {
+    public:
+        Scope(BinderStats& stats, const Method method);
+        ~Scope();
+
+    private:
+        BinderStats& mStats;
+        const Method mMethod;
+        const uint64_t mBeginTime;
+    };
+
+    void record(const Method method, const uid_t uid, const uint64_t latencyUs);
+    void reset();
+
+    friend std::ostream& operator<<(std::ostream& os, const BinderStats& stats);
+    void dumpJson(JsonWriter& writer) const;
+
+    /**
+     * Log-linear buckets: [0, 4)us is linear, then every power of two is split into 4 buckets.
+     * The last bucket holds all the latency above 2^24us(about 16s).
+     */
+    const static int SUB_BUCKET_BITS = 2;
+    const static int MAX_LATENCY_BITS = 24;
+    const static int BUCKET_NUM =
+            ((MAX_LATENCY_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + 1;
+    static int getBucket(const uint64_t latencyUs);
+    static uint64_t getBucketUpperBound(const int bucket);
+
+private:
+    // the calls from more uids are counted in the "other"
+    const static int UID_SLOT_NUM = 8;
+    const static uint32_t INVALID_UID = UINT32_MAX;
+
+    struct UidSlot {
+        std::atomic<uint32_t> uid{INVALID_UID};
+        std::atomic<uint32_t> count{0};
+    };
+
+    struct MethodStats {
+        std::atomic<uint64_t> totalUs{0};
+        std::atomic<uint32_t> maxUs{0};
+        std::atomic<uint32_t> buckets[BUCKET_NUM] = {};
+        UidSlot uids[UID_SLOT_NUM];
+        std::atomic<uint32_t> otherUidCount{0};
+    };
+
+    static uint64_t percentile(const MethodStats& stats, const uint32_t count, const int p);
+
+    MethodStats mStats[METHOD_NUM];
+};
+
+} // namespace am
+} // namespace os
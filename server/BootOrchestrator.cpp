@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BootOrchestrator"
+
+#include "BootOrchestrator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "Clock.h"
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+static const char* pointStr[BootOrchestrator::POINT_NUM] = {
+        "begin", "resolved", "homeStarted", "homeResumed", "completed",
+};
+
+static const char* entryStatusStr[] = {"pending", "starting", "ready", "failed"};
+
+BootOrchestrator::BootOrchestrator() : mIsBooting(false), mIsHomeStarted(false) {
+    std::fill(std::begin(mTimestamp), std::end(mTimestamp), 0);
+}
+
+void BootOrchestrator::begin(const std::string& manifest, PackageManager& pm,
+                             const StartFunc& startFunc) {
+    mIsBooting = true;
+    mark(BOOT_BEGIN);
+    mStartFunc = startFunc;
+    if (loadManifest(manifest)) {
+        resolve(pm);
+        startEntries();
+    }
+}
+
+void BootOrchestrator::waitForCompletion(const bool isHomeStarted,
+                                         const CompleteFunc& completeFunc) {
+    // without a manifest, the boot is completed once the home is started, as it always was
+    mIsHomeStarted = isHomeStarted && !mEntries.empty();
+    if (isHomeStarted) {
+        mark(HOME_STARTED);
+    }
+    mCompleteFunc = completeFunc;
+    checkCompleted();
+}
+
+void BootOrchestrator::timeout() {
+    if (!mIsBooting) {
+        return;
+    }
+    for (auto& entry : mEntries) {
+        if (entry.status == BootEntry::PENDING || entry.status == BootEntry::STARTING) {
+            ALOGE("boot entry %s/%s isn't ready in time", entry.packageName.c_str(),
+                  entry.componentName.c_str());
+            entry.status = BootEntry::FAILED;
+        }
+    }
+    if (!mTimestamp[HOME_RESUMED]) {
+        ALOGE("the home isn't resumed in time");
+    }
+    mIsHomeStarted = false;
+    checkCompleted();
+}
+
+void BootOrchestrator::onReady(const std::string& packageName, const std::string& componentName) {
+    if (!mIsBooting) {
+        return;
+    }
+    for (auto& entry : mEntries) {
+        if (entry.packageName == packageName && entry.componentName == componentName &&
+            entry.status != BootEntry::READY) {
+            // it may be started by others before its dependencies are ready
+            entry.status = BootEntry::READY;
+            entry.readyUs = clock_us();
+            startEntries();
+            return;
+        }
+    }
+}
+
+void BootOrchestrator::onFailed(const std::string& packageName,
+                                const std::string& componentName) {
+    if (!mIsBooting) {
+        return;
+    }
+    for (auto& entry : mEntries) {
+        if (entry.packageName == packageName && entry.componentName == componentName &&
+            entry.status == BootEntry::STARTING) {
+            ALOGE("boot entry %s/%s start failure", packageName.c_str(), componentName.c_str());
+            // the entries that depend on it start without it
+            entry.status = BootEntry::FAILED;
+            startEntries();
+            return;
+        }
+    }
+}
+
+void BootOrchestrator::onHomeResumed() {
+    if (mIsBooting && !mTimestamp[HOME_RESUMED]) {
+        mark(HOME_RESUMED);
+        checkCompleted();
+    }
+}
+
+bool BootOrchestrator::contains(const std::string& packageName,
+                                const std::string& componentName) const {
+    return std::any_of(mEntries.begin(), mEntries.end(), [&](const BootEntry& entry) {
+        return entry.packageName == packageName && entry.componentName == componentName;
+    });
+}
+
+std::vector<std::string> BootOrchestrator::getWaitingExecfiles() const {
+    std::vector<std::string> execfiles;
+    for (const auto& entry : mEntries) {
+        const auto it = mPackages.find(entry.packageName);
+        if (entry.status == BootEntry::PENDING && it != mPackages.end() &&
+            std::find(execfiles.begin(), execfiles.end(), it->second.execfile) == execfiles.end()) {
+            execfiles.push_back(it->second.execfile);
+        }
+    }
+    return execfiles;
+}
+
+bool BootOrchestrator::loadManifest(const std::string& manifest) {
+    std::ifstream file(manifest);
+    if (!file.is_open()) {
+        ALOGI("no boot manifest:%s", manifest.c_str());
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string type;
+        std::string component;
+        if (!(fields >> type >> component) || type[0] == '#') {
+            continue;
+        }
+        const auto pos = component.find('/');
+        if ((type != "service" && type != "activity") || pos == std::string::npos) {
+            ALOGE("illegal boot manifest line:%s", line.c_str());
+            continue;
+        }
+        BootEntry entry;
+        entry.isActivity = type == "activity";
+        entry.packageName = component.substr(0, pos);
+        entry.componentName = component.substr(pos + 1);
+        for (std::string dependency; fields >> dependency;) {
+            entry.after.push_back(dependency);
+        }
+        mEntries.push_back(std::move(entry));
+    }
+
+    for (auto& entry : mEntries) {
+        for (const auto& dependency : entry.after) {
+            const auto it = std::find_if(mEntries.begin(), mEntries.end(), [&](const auto& e) {
+                return e.packageName + '/' + e.componentName == dependency;
+            });
+            if (it != mEntries.end()) {
+                entry.dependencies.push_back(it - mEntries.begin());
+            } else {
+                ALOGW("the dependency %s isn't in the boot manifest", dependency.c_str());
+            }
+        }
+    }
+
+    // the entries that can't be sorted are in a cycle, they never start by themselves
+    std::vector<bool> isSorted(mEntries.size(), false);
+    for (bool isChanged = true; isChanged;) {
+        isChanged = false;
+        for (size_t i = 0; i < mEntries.size(); i++) {
+            const auto& deps = mEntries[i].dependencies;
+            if (!isSorted[i] &&
+                std::all_of(deps.begin(), deps.end(), [&](size_t d) { return isSorted[d]; })) {
+                isSorted[i] = isChanged = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < mEntries.size(); i++) {
+        if (!isSorted[i]) {
+            ALOGE("boot entry %s/%s is in a dependency cycle", mEntries[i].packageName.c_str(),
+                  mEntries[i].componentName.c_str());
+            mEntries[i].status = BootEntry::FAILED;
+        }
+    }
+    ALOGI("boot manifest:%s has %zu entries", manifest.c_str(), mEntries.size());
+    return !mEntries.empty();
+}
+
+void BootOrchestrator::resolve(PackageManager& pm) {
+    // a query for all the packages, rather than a binder call for each entry
+    std::vector<PackageInfo> allPackages;
+    if (pm.getAllPackageInfo(&allPackages) != 0) {
+        ALOGE("can't get the packages for the boot manifest");
+    }
+    for (auto& packageInfo : allPackages) {
+        const bool isInManifest =
+                std::any_of(mEntries.begin(), mEntries.end(), [&](const BootEntry& entry) {
+                    return entry.packageName == packageInfo.packageName;
+                });
+        if (isInManifest) {
+            mPackages.emplace(packageInfo.packageName, std::move(packageInfo));
+        }
+    }
+    mark(MANIFEST_RESOLVED);
+}
+
+void BootOrchestrator::startEntries() {
+    for (bool isChanged = true; isChanged;) {
+        isChanged = false;
+        for (auto& entry : mEntries) {
+            if (entry.status != BootEntry::PENDING) {
+                continue;
+            }
+            // the failed dependency doesn't block the others, they start without it
+            const bool isWaiting =
+                    std::any_of(entry.dependencies.begin(), entry.dependencies.end(),
+                                [this](size_t d) { return mEntries[d].status < BootEntry::READY; });
+            if (isWaiting) {
+                continue;
+            }
+            entry.status = BootEntry::STARTING;
+            entry.startUs = clock_us();
+            const auto it = mPackages.find(entry.packageName);
+            if (it == mPackages.end() || mStartFunc(entry, it->second) != 0) {
+                ALOGE("boot entry %s/%s start failure", entry.packageName.c_str(),
+                      entry.componentName.c_str());
+                entry.status = BootEntry::FAILED;
+                isChanged = true;
+            }
+        }
+    }
+    checkCompleted();
+}
+
+void BootOrchestrator::checkCompleted() {
+    if (!mIsBooting || !mCompleteFunc) {
+        return;
+    }
+    const bool isSettled = std::all_of(mEntries.begin(), mEntries.end(), [](const auto& entry) {
+        return entry.status >= BootEntry::READY;
+    });
+    if (!isSettled || (mIsHomeStarted && !mTimestamp[HOME_RESUMED])) {
+        return;
+    }
+    mIsBooting = false;
+    mark(BOOT_COMPLETED);
+    ALOGI("boot completed in %.1fms", toMs(mTimestamp[BOOT_COMPLETED]));
+    const auto completeFunc = std::move(mCompleteFunc);
+    mCompleteFunc = nullptr;
+    mStartFunc = nullptr;
+    completeFunc();
+}
+
+void BootOrchestrator::mark(const Point point) {
+    mTimestamp[point] = clock_us();
+}
+
+double BootOrchestrator::toMs(const uint64_t timestamp) const {
+    return timestamp ? (timestamp - mTimestamp[BOOT_BEGIN]) / 1000.0 : 0;
+}
+
+std::ostream& operator<<(std::ostream& os, const BootOrchestrator& boot) {
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << "\nBoot timeline(ms):" << std::endl << std::fixed << std::setprecision(1) << "\t";
+    for (int point = BootOrchestrator::MANIFEST_RESOLVED; point < BootOrchestrator::POINT_NUM;
+         point++) {
+        if (boot.mTimestamp[point]) {
+            os << pointStr[point] << ":" << boot.toMs(boot.mTimestamp[point]) << " ";
+        }
+    }
+    os << (boot.mIsBooting ? "booting" : "") << std::endl;
+    for (const auto& entry : boot.mEntries) {
+        os << "\t" << (entry.isActivity ? "activity " : "service ") << entry.packageName << "/"
+           << entry.componentName << " " << entryStatusStr[entry.status];
+        if (entry.startUs) {
+            os << " start:" << boot.toMs(entry.startUs);
+        }
+        if (entry.readyUs) {
+            os << " ready:" << boot.toMs(entry.readyUs);
+        }
+        if (!entry.after.empty()) {
+            os << " after:[";
+            for (const auto& dependency : entry.after) {
+                os << " " << dependency;
+            }
+            os << " ]";
+        }
+        os << std::endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+}
+
+void BootOrchestrator::dumpJson(JsonWriter& writer) const {
+    writer.beginObject("boot").field("isBooting", mIsBooting);
+    for (int point = MANIFEST_RESOLVED; point < POINT_NUM; point++) {
+        if (mTimestamp[point]) {
+            writer.field(pointStr[point], toMs(mTimestamp[point]));
+        }
+    }
+    writer.beginArray("entries");
+    for (const auto& entry : mEntries) {
+        writer.beginObject()
+                .field("name", entry.packageName + "/" + entry.componentName)
+                .field("type", entry.isActivity ? "activity" : "service")
+                .field("status", entryStatusStr[entry.status])
+                .field("startMs", toMs(entry.startUs))
+                .field("readyMs", toMs(entry.readyUs))
+                .endObject();
+    }
+    writer.endArray().endObject();
+}
+
+} // namespace am
+} // namespace os
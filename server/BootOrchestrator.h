@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pm/PackageManager.h>
+#include <stdint.h>
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "DumpWriter.h"
+
+namespace os {
+namespace am {
+
+using os::pm::PackageInfo;
+using os::pm::PackageManager;
+
+struct BootEntry {
+    enum Status {
+        PENDING = 0, // waiting for the dependencies
+        STARTING,
+        READY, // the service is created, or the activity is resumed
+        FAILED,
+    };
+
+    bool isActivity;
+    std::string packageName;
+    std::string componentName;
+    std::vector<std::string> after;   // the components that it depends on
+    std::vector<size_t> dependencies; // the indexes of "after" in the manifest
+    Status status = PENDING;
+    uint64_t startUs = 0; // monotonic, 0 means it isn't reached
+    uint64_t readyUs = 0;
+};
+
+/**
+ * Start the persistent components of the boot manifest as soon as their dependencies are
+ * ready, the independent ones are all spawned at once. The manifest has an entry per line:
+ *     service <package>/<Service> [<dependency>...]
+ *     activity <package>/<Activity> [<dependency>...]
+ * a dependency is the component of a previous or later entry. The boot is completed when all
+ * the entries are ready or failed, and the home is resumed. Without a manifest, it's completed
+ * as soon as the home is started.
+ */
+class BootOrchestrator {
+public:
+    enum Point {
+        BOOT_BEGIN = 0,    // systemReady
+        MANIFEST_RESOLVED, // the packages of the manifest are resolved
+        HOME_STARTED,      // the home or the boot guide is started
+        HOME_RESUMED,
+        BOOT_COMPLETED,
+        POINT_NUM,
+    };
+
+    using StartFunc = std::function<int(const BootEntry& entry, const PackageInfo& packageInfo)>;
+    using CompleteFunc = std::function<void()>;
+
+    BootOrchestrator();
+
+    /** Load the manifest and start the entries that don't wait for others, it's optional */
+    void begin(const std::string& manifest, PackageManager& pm, const StartFunc& startFunc);
+    /** Nothing else is started by the boot, the callback is called when it's completed */
+    void waitForCompletion(const bool isHomeStarted, const CompleteFunc& completeFunc);
+    /** Give up the entries that aren't ready, the boot is completed anyway */
+    void timeout();
+
+    void onReady(const std::string& packageName, const std::string& componentName);
+    /** The entry that is starting fails later, e.g. its process can't be spawned */
+    void onFailed(const std::string& packageName, const std::string& componentName);
+    void onHomeResumed();
+
+    bool isBooting() const {
+        return mIsBooting;
+    }
+    /** The component is started by the manifest, not by the boot broadcast */
+    bool contains(const std::string& packageName, const std::string& componentName) const;
+    /** The programs of the entries that wait for their dependencies */
+    std::vector<std::string> getWaitingExecfiles() const;
+
+    friend std::ostream& operator<<(std::ostream& os, const BootOrchestrator& boot);
+    void dumpJson(JsonWriter& writer) const;
+
+private:
+    bool loadManifest(const std::string& manifest);
+    void resolve(PackageManager& pm);
+    void startEntries();
+    void checkCompleted();
+    void mark(const Point point);
+    double toMs(const uint64_t timestamp) const;
+
+    std::vector<BootEntry> mEntries;
+    std::map<std::string, PackageInfo> mPackages;
+    StartFunc mStartFunc;
+    CompleteFunc mCompleteFunc;
+    bool mIsBooting;
+    bool mIsHomeStarted;
+    uint64_t mTimestamp[POINT_NUM]; // monotonic us, 0 means it isn't reached
+};
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CpuClassPolicy"
+
+#include "CpuClassPolicy.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifndef __NuttX__
+#include <sys/stat.h>
+#endif
+
+#include "ProcessPriorityPolicy.h"
+#include "SchedLevel.h"
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+// the sched_priority on NuttX, the nice value on Linux, in the order of the bands
+#ifdef CONFIG_AM_CPU_CLASS_LEVELS
+#define AM_CPU_CLASS_LEVELS CONFIG_AM_CPU_CLASS_LEVELS
+#elif defined(__NuttX__)
+#define AM_CPU_CLASS_LEVELS "100,100,100,90,80,70"
+#else
+#define AM_CPU_CLASS_LEVELS "0,0,0,2,5,10"
+#endif
+
+#ifdef CONFIG_AM_CPU_CLASS_WEIGHTS
+#define AM_CPU_CLASS_WEIGHTS CONFIG_AM_CPU_CLASS_WEIGHTS
+#else
+#define AM_CPU_CLASS_WEIGHTS "400,200,100,50,20,10"
+#endif
+
+#ifdef CONFIG_AM_CPU_CLASS_CGROUP
+#define AM_CPU_CLASS_CGROUP CONFIG_AM_CPU_CLASS_CGROUP
+#else
+#define AM_CPU_CLASS_CGROUP ""
+#endif
+
+#ifdef CONFIG_AM_AFFINITY_CFG
+#define AM_AFFINITY_CFG CONFIG_AM_AFFINITY_CFG
+#else
+#define AM_AFFINITY_CFG "/etc/affinity.cfg"
+#endif
+// it's easy to modify for test, like "/data/lmk.cfg"
+#define AM_AFFINITY_CFG_DEBUG "/data/affinity.cfg"
+
+#if !defined(__NuttX__) || defined(CONFIG_SMP)
+#define AM_HAVE_AFFINITY
+#endif
+
+#ifdef __NuttX__
+static const char* levelStr = "priority";
+#else
+static const char* levelStr = "nice";
+#endif
+
+static const char* bandStr[CpuClassPolicy::BAND_NUM] = {
+        "foreground", "home", "high", "middle", "low", "cached",
+};
+
+CpuClassPolicy::CpuClassPolicy() : mChangeCount(0), mFailureCount(0) {
+#ifdef CONFIG_AM_CPU_CLASS
+    mEnabled = true;
+#else
+    mEnabled = false;
+#endif
+    mEnabled = parseConfig(AM_CPU_CLASS_LEVELS, mLevels) && mEnabled;
+    if (mEnabled && !canRaiseSchedLevel()) {
+        ALOGW("no privilege to raise the priority, the CPU classes are disabled");
+        mEnabled = false;
+    }
+    std::fill(std::begin(mWeights), std::end(mWeights), 0);
+#ifndef __NuttX__
+    if (mEnabled && parseConfig(AM_CPU_CLASS_WEIGHTS, mWeights) &&
+        initCgroups(AM_CPU_CLASS_CGROUP)) {
+        mCgroupRoot = AM_CPU_CLASS_CGROUP;
+    }
+#endif
+#ifdef AM_HAVE_AFFINITY
+    if (!loadAffinity(AM_AFFINITY_CFG_DEBUG)) {
+        loadAffinity(AM_AFFINITY_CFG);
+    }
+#endif
+}
+
+#ifdef AM_HAVE_AFFINITY
+/** "0-1,3" is the cores 0, 1 and 3, the ones that aren't online are dropped */
+static bool parseCpus(const std::string& cpus, std::vector<int>& cpuList) {
+    const long onlineCpus = std::min<long>(sysconf(_SC_NPROCESSORS_ONLN), CPU_SETSIZE);
+    std::istringstream ranges(cpus);
+    for (std::string range; std::getline(ranges, range, ',');) {
+        int first, last;
+        const int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (n < 1 || first < 0) {
+            return false;
+        }
+        if (n == 1) {
+            last = first;
+        }
+        for (int cpu = first; cpu <= last && cpu < onlineCpus; cpu++) {
+            cpuList.push_back(cpu);
+        }
+    }
+    return !cpuList.empty();
+}
+#endif
+
+bool CpuClassPolicy::loadAffinity(const std::string& file) {
+#ifdef AM_HAVE_AFFINITY
+    std::ifstream cfg(file);
+    if (!cfg.is_open()) {
+        return false;
+    }
+    ALOGI("CPU affinity policy read \"%s\" file", file.c_str());
+    std::string line;
+    while (std::getline(cfg, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        std::string cpus;
+        std::vector<int> cpuList;
+        if (!(fields >> name >> cpus) || name[0] == '#') {
+            continue;
+        }
+        if (!parseCpus(cpus, cpuList)) {
+            ALOGE("illegal CPU affinity line:%s", line.c_str());
+            continue;
+        }
+        std::vector<Band> bands;
+        if (name == "foreground") {
+            bands = {FOREGROUND, HOME};
+        } else if (name == "background") {
+            bands = {HIGH, MIDDLE, LOW};
+        } else if (name == "cached") {
+            // a single core, the first one
+            bands = {CACHED};
+            cpus = std::to_string(cpuList[0]);
+            cpuList.resize(1);
+        } else {
+            ALOGE("unknown band of CPU affinity:%s", name.c_str());
+            continue;
+        }
+        for (const auto band : bands) {
+            mCpus[band] = cpus;
+            mCpuList[band] = cpuList;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool CpuClassPolicy::setAffinity(pid_t pid, Band band) {
+#ifdef AM_HAVE_AFFINITY
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (const int cpu : mCpuList[band]) {
+        CPU_SET(cpu, &cpuset);
+    }
+    if (mCpuList[band].empty()) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpuset);
+        }
+    }
+    return sched_setaffinity(pid, sizeof(cpuset), &cpuset) == 0;
+#else
+    return false;
+#endif
+}
+
+bool CpuClassPolicy::parseConfig(const char* config, int values[BAND_NUM]) {
+    const char* str = config;
+    for (int band = 0; band < BAND_NUM; band++) {
+        char* end;
+        values[band] = strtol(str, &end, 10);
+        if (end == str || *end != (band < BAND_NUM - 1 ? ',' : '\0')) {
+            ALOGE("illegal CPU class config:%s, %d values are expected", config, BAND_NUM);
+            std::fill(values, values + BAND_NUM, 0);
+            return false;
+        }
+        str = end + 1;
+    }
+    return true;
+}
+
+#ifndef __NuttX__
+/** A child cgroup for each band, its cpu.weight is written once */
+bool CpuClassPolicy::initCgroups(const std::string& root) {
+    if (root.empty()) {
+        return false;
+    }
+    for (int band = 0; band < BAND_NUM; band++) {
+        const std::string dir = root + "/" + bandStr[band];
+        mkdir(dir.c_str(), 0755);
+        std::ofstream weight(dir + "/cpu.weight");
+        if (!(weight << mWeights[band] << std::flush)) {
+            ALOGE("can't set %s/cpu.weight, is the cpu controller enabled?", dir.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+CpuClassPolicy::Band CpuClassPolicy::toBand(int oomScore) {
+    if (oomScore <= OS_FOREGROUND_APP_ADJ) {
+        return FOREGROUND;
+    } else if (oomScore == OS_SYSTEM_HOME_APP_ADJ) {
+        return HOME;
+    } else if (oomScore < OS_MIDDLE_LEVEL_MIN_ADJ) {
+        return HIGH;
+    } else if (oomScore < OS_LOW_LEVEL_MIN_ADJ) {
+        return MIDDLE;
+    } else if (oomScore < OS_CACHE_PROCESS_ADJ) {
+        return LOW;
+    }
+    return CACHED;
+}
+
+void CpuClassPolicy::apply(pid_t pid, int oomScore) {
+    const Band band = toBand(oomScore);
+    auto [it, isNew] = mBands.emplace(pid, band);
+    Band oldBand = BAND_NUM;
+    if (!isNew) {
+        if (it->second == band) {
+            return;
+        }
+        oldBand = it->second;
+        it->second = band;
+    }
+    for (auto& callback : mBandChangedCallbacks) {
+        callback(pid, band);
+    }
+    // a new process runs on all the cores
+    const bool isAffinityChanged = oldBand == BAND_NUM ? !mCpus[band].empty()
+                                                       : mCpus[band] != mCpus[oldBand];
+    if (!mEnabled && !isAffinityChanged) {
+        return;
+    }
+    mChangeCount++;
+    ALOGD("pid:%d into the %s CPU class", pid, bandStr[band]);
+    bool isApplied = true;
+    if (mEnabled) {
+        const int level = configToSchedLevel(mLevels[band]);
+        isApplied = (mOverride && mOverride(pid, level)) || setSchedLevel(pid, level);
+    }
+    if (isAffinityChanged) {
+        isApplied = setAffinity(pid, band) && isApplied;
+    }
+#ifndef __NuttX__
+    if (!mCgroupRoot.empty()) {
+        std::ofstream procs(mCgroupRoot + "/" + bandStr[band] + "/cgroup.procs");
+        isApplied = (procs << pid << std::flush) && isApplied;
+    }
+#endif
+    if (!isApplied) {
+        mFailureCount++;
+    }
+}
+
+void CpuClassPolicy::remove(pid_t pid) {
+    mBands.erase(pid);
+}
+
+CpuClassPolicy::Band CpuClassPolicy::getBand(pid_t pid) const {
+    const auto it = mBands.find(pid);
+    return it != mBands.end() ? it->second : BAND_NUM;
+}
+
+std::ostream& operator<<(std::ostream& os, const CpuClassPolicy& policy) {
+    int counts[CpuClassPolicy::BAND_NUM] = {0};
+    for (const auto& [pid, band] : policy.mBands) {
+        counts[band]++;
+    }
+    os << "\nCPU classes:" << (policy.mEnabled ? "" : " disabled")
+       << " changes:" << policy.mChangeCount << " failures:" << policy.mFailureCount << std::endl;
+    for (int band = 0; band < CpuClassPolicy::BAND_NUM; band++) {
+        os << "\t" << std::left << std::setw(12) << bandStr[band] << std::right
+           << levelStr << ":" << policy.mLevels[band];
+        if (!policy.mCgroupRoot.empty()) {
+            os << " weight:" << policy.mWeights[band];
+        }
+        os << " cpus:" << (policy.mCpus[band].empty() ? "all" : policy.mCpus[band]);
+        os << " processes:" << counts[band] << std::endl;
+    }
+    return os;
+}
+
+void CpuClassPolicy::dumpJson(JsonWriter& writer) const {
+    int counts[BAND_NUM] = {0};
+    for (const auto& [pid, band] : mBands) {
+        counts[band]++;
+    }
+    writer.beginObject("cpuClass")
+            .field("enabled", mEnabled)
+            .field("changes", mChangeCount)
+            .field("failures", mFailureCount);
+    writer.beginArray("bands");
+    for (int band = 0; band < BAND_NUM; band++) {
+        writer.beginObject().field("band", bandStr[band]).field(levelStr, mLevels[band]);
+        if (!mCgroupRoot.empty()) {
+            writer.field("weight", mWeights[band]);
+        }
+        if (!mCpus[band].empty()) {
+            writer.field("cpus", mCpus[band]);
+        }
+        writer.field("processes", counts[band]).endObject();
+    }
+    writer.endArray().endObject();
+}
+
+} // namespace am
+} // namespace os
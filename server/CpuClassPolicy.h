@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DumpWriter.h"
+
+namespace os {
+namespace am {
+
+/**
+ * CpuClassPolicy: the processes in an oom-adj band share a CPU scheduling class, the scheduling
+ * level, the cores they run on and, on the Linux host, the cgroup cpu.weight of the band. A class
+ * is only applied when the band of a process is changed.
+ */
+class CpuClassPolicy {
+public:
+    enum Band {
+        FOREGROUND, // the foreground and persistent ones
+        HOME,
+        HIGH,
+        MIDDLE,
+        LOW,
+        CACHED,
+        BAND_NUM,
+    };
+    /** Return true if the level is taken over, the boosted processes for instance */
+    using OverrideFunc = std::function<bool(pid_t pid, int level)>;
+    using BandChangedCB = std::function<void(pid_t pid, Band band)>;
+
+    CpuClassPolicy();
+
+    bool isEnabled() const {
+        return mEnabled;
+    }
+    void setOverride(const OverrideFunc& override) {
+        mOverride = override;
+    }
+    void addBandChangedCallback(const BandChangedCB& callback) {
+        mBandChangedCallbacks.push_back(callback);
+    }
+    /** The processes stay in the cgroups of others, cpu.weight isn't used */
+    void disableCgroup() {
+        mCgroupRoot.clear();
+    }
+
+    /**
+     * The core sets of the "foreground" (and home), "background" and "cached" bands, a line for
+     * each like "foreground 2-3". The cached ones are pinned to the first core of theirs, the
+     * bands that aren't configured run on all the cores. False if the file can't be read, or
+     * the cores can't be set.
+     */
+    bool loadAffinity(const std::string& file);
+    /** The cores of the band, empty for all of them */
+    const std::vector<int>& getCpus(Band band) const {
+        return mCpuList[band];
+    }
+
+    static Band toBand(int oomScore);
+    void apply(pid_t pid, int oomScore);
+    void remove(pid_t pid);
+    /** BAND_NUM if the process isn't known */
+    Band getBand(pid_t pid) const;
+
+    friend std::ostream& operator<<(std::ostream& os, const CpuClassPolicy& policy);
+    void dumpJson(JsonWriter& writer) const;
+
+private:
+    bool parseConfig(const char* config, int values[BAND_NUM]);
+    bool setAffinity(pid_t pid, Band band);
+#ifndef __NuttX__
+    bool initCgroups(const std::string& root);
+#endif
+
+    bool mEnabled;
+    int mLevels[BAND_NUM]; // as configured, see configToSchedLevel
+    int mWeights[BAND_NUM];
+    std::string mCgroupRoot; // empty if cpu.weight isn't used
+    std::string mCpus[BAND_NUM]; // as configured, empty for all the cores
+    std::vector<int> mCpuList[BAND_NUM];
+    OverrideFunc mOverride;
+    std::vector<BandChangedCB> mBandChangedCallbacks;
+    std::unordered_map<pid_t, Band> mBands;
+    int mChangeCount;
+    int mFailureCount;
+};
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DumpWriter.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <cmath>
+
+namespace os {
+namespace am {
+
+FdStreamBuf::FdStreamBuf(int fd) : mFd(fd) {
+    setp(mBuffer, mBuffer + sizeof(mBuffer));
+}
+
+FdStreamBuf::~FdStreamBuf() {
+    flushBuffer();
+}
+
+bool FdStreamBuf::flushBuffer() {
+    const char* data = pbase();
+    size_t size = pptr() - pbase();
+    while (size > 0) {
+        const ssize_t ret = write(mFd, data, size);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            // the reader is gone, drop the rest
+            setp(mBuffer, mBuffer + sizeof(mBuffer));
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    setp(mBuffer, mBuffer + sizeof(mBuffer));
+    return true;
+}
+
+FdStreamBuf::int_type FdStreamBuf::overflow(int_type ch) {
+    if (!flushBuffer()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int FdStreamBuf::sync() {
+    return flushBuffer() ? 0 : -1;
+}
+
+const DumpColor COLOR_RESET = {"\033[0m"};
+const DumpColor COLOR_RED = {"\033[31m"};
+const DumpColor COLOR_GREEN = {"\033[32m"};
+const DumpColor COLOR_YELLOW = {"\033[33m"};
+const DumpColor COLOR_BLUE = {"\033[34m"};
+
+static int colorIndex() {
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+void enableDumpColor(std::ostream& os, const bool enable) {
+    os.iword(colorIndex()) = enable;
+}
+
+std::ostream& operator<<(std::ostream& os, const DumpColor& color) {
+    if (os.iword(colorIndex())) {
+        os << color.code;
+    }
+    return os;
+}
+
+void JsonWriter::writeKey(const char* key) {
+    if (!mIsFirst.empty()) {
+        if (!mIsFirst.back()) {
+            mOs << ",";
+        }
+        mIsFirst.back() = false;
+    }
+    if (key) {
+        writeString(key);
+        mOs << ":";
+    }
+}
+
+void JsonWriter::writeString(const std::string& str) {
+    mOs << '"';
+    for (const char c : str) {
+        switch (c) {
+            case '"':
+                mOs << "\\\"";
+                break;
+            case '\\':
+                mOs << "\\\\";
+                break;
+            case '\n':
+                mOs << "\\n";
+                break;
+            case '\t':
+                mOs << "\\t";
+                break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    mOs << buf;
+                } else {
+                    mOs << c;
+                }
+                break;
+        }
+    }
+    mOs << '"';
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+    writeKey(key);
+    mOs << "{";
+    mIsFirst.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    mIsFirst.pop_back();
+    mOs << "}";
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* key) {
+    writeKey(key);
+    mOs << "[";
+    mIsFirst.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    mIsFirst.pop_back();
+    mOs << "]";
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const std::string& value) {
+    writeKey(key);
+    writeString(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const char* value) {
+    writeKey(key);
+    if (value) {
+        writeString(value);
+    } else {
+        mOs << "null";
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const bool value) {
+    writeKey(key);
+    mOs << (value ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const double value) {
+    writeKey(key);
+    // NaN and infinity have no JSON form
+    if (std::isfinite(value)) {
+        mOs << value;
+    } else {
+        mOs << "null";
+    }
+    return *this;
+}
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace os {
+namespace am {
+
+/** Write the dump to the fd piece by piece, rather than building the whole text at first */
+class FdStreamBuf : public std::streambuf {
+public:
+    explicit FdStreamBuf(int fd);
+    ~FdStreamBuf() override;
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    bool flushBuffer();
+
+    int mFd;
+    char mBuffer[256];
+};
+
+/** The ANSI colour is only written when it's enabled, e.g. the dump is shown on a terminal */
+struct DumpColor {
+    const char* code;
+};
+
+extern const DumpColor COLOR_RESET;
+extern const DumpColor COLOR_RED;
+extern const DumpColor COLOR_GREEN;
+extern const DumpColor COLOR_YELLOW;
+extern const DumpColor COLOR_BLUE;
+
+void enableDumpColor(std::ostream& os, const bool enable);
+std::ostream& operator<<(std::ostream& os, const DumpColor& color);
+
+/**
+ * Stream the JSON to the ostream, the commas and escapes are handled here.
+ * The key is nullptr for the array element.
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& os) : mOs(os) {}
+
+    JsonWriter& beginObject(const char* key = nullptr);
+    JsonWriter& endObject();
+    JsonWriter& beginArray(const char* key = nullptr);
+    JsonWriter& endArray();
+
+    JsonWriter& field(const char* key, const std::string& value);
+    JsonWriter& field(const char* key, const char* value);
+    JsonWriter& field(const char* key, const bool value);
+    JsonWriter& field(const char* key, const double value);
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    JsonWriter& field(const char* key, const T value) {
+        writeKey(key);
+        mOs << +value;
+        return *this;
+    }
+
+private:
+    void writeKey(const char* key);
+    void writeString(const std::string& str);
+
+    std::ostream& mOs;
+    std::vector<bool> mIsFirst; // whether the current object/array is still empty
+};
+
+} // namespace am
+} // namespace os
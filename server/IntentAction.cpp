@@ -57,7 +57,7 @@ bool IntentAction::getSingleTargetByAction(const string& action, string& outTarg
     return false;
 }
 
-bool IntentAction::getMultiTargetByAction(const string& action, vector<string>& targetlist,
+bool IntentAction::getMultiTargetByAction(const string& action, vector<IntentTarget>& targets,
                                           const ComponentType type) {
     PackageManager pm;
     std::vector<PackageInfo> allPackages;
@@ -65,33 +65,34 @@ bool IntentAction::getMultiTargetByAction(const string& action, vector<string>&
         return false;
     }
 
-    string onetarget;
+    const size_t size = targets.size();
     for (auto& packageInfo : allPackages) {
+        vector<string> names;
         if (type == COMP_TYPE_ACTIVITY) {
             for (auto& activity : packageInfo.activitiesInfo) {
                 for (auto& a : activity.actions) {
                     if (a == action) {
-                        onetarget = COMPONENT_NAME_SPLICE(packageInfo.packageName, activity.name);
-                        targetlist.push_back(onetarget);
+                        names.push_back(activity.name);
                     }
                 }
             }
-
         } else if (type == COMP_TYPE_SERVICE) {
             for (auto& service : packageInfo.servicesInfo) {
                 for (auto& a : service.actions) {
                     if (a == action) {
-                        onetarget = COMPONENT_NAME_SPLICE(packageInfo.packageName, service.name);
-                        targetlist.push_back(onetarget);
+                        names.push_back(service.name);
                     }
                 }
             }
         }
+        if (!names.empty()) {
+            const auto shared = std::make_shared<const PackageInfo>(std::move(packageInfo));
+            for (auto& name : names) {
+                targets.push_back({shared, std::move(name)});
+            }
+        }
     }
-    if (!targetlist.empty()) {
-        return true;
-    }
-    return false;
+    return targets.size() > size;
 }
 
 } // namespace am
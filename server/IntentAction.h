@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <pm/PackageInfo.h>
+
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -29,6 +32,12 @@ using std::vector;
 
 #define COMPONENT_NAME_SPLICE(p, c) (p + '/' + c)
 
+/** The resolved component, the components of a package share the immutable PackageInfo */
+struct IntentTarget {
+    std::shared_ptr<const os::pm::PackageInfo> packageInfo;
+    string componentName;
+};
+
 class IntentAction {
 public:
     enum ComponentType {
@@ -36,7 +45,8 @@ public:
         COMP_TYPE_SERVICE,
     };
     bool getSingleTargetByAction(const string& action, string& target, const ComponentType type);
-    bool getMultiTargetByAction(const string& action, vector<string>& targetlist,
+    /** The targets and their packages are resolved by a single PackageManager query */
+    bool getMultiTargetByAction(const string& action, vector<IntentTarget>& targets,
                                 const ComponentType type);
 };
 
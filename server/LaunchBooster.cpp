@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LaunchBooster"
+
+#include "LaunchBooster.h"
+
+#include <inttypes.h>
+
+#include "SchedLevel.h"
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+#ifdef CONFIG_AM_LAUNCH_BOOST_TIMEOUT
+const static uint64_t BOOST_TIMEOUT_MS = CONFIG_AM_LAUNCH_BOOST_TIMEOUT;
+#else
+const static uint64_t BOOST_TIMEOUT_MS = 1000;
+#endif
+
+#ifdef __NuttX__
+const static int BOOST_STEP = 20;
+const static int DEMOTE_STEP = 10;
+#else
+const static int BOOST_STEP = 5;
+const static int DEMOTE_STEP = 5;
+#endif
+
+#ifdef CONFIG_AM_LAUNCH_BOOST
+LaunchBooster::LaunchBooster() : LaunchBooster(true, BOOST_TIMEOUT_MS) {}
+#else
+LaunchBooster::LaunchBooster() : LaunchBooster(false, BOOST_TIMEOUT_MS) {}
+#endif
+
+LaunchBooster::LaunchBooster(const bool isEnabled, const uint64_t timeoutMs)
+      : mEnabled(isEnabled),
+        mTimeoutMs(timeoutMs),
+        mBoostCount(0),
+        mTimeoutCount(0),
+        mFailureCount(0) {}
+
+void LaunchBooster::init(const std::shared_ptr<os::app::UvLoop>& looper,
+                         const BackgroundFunc& getBackground) {
+    mLooper = looper;
+    mGetBackground = getBackground;
+    if (mEnabled && !canRaiseSchedLevel()) {
+        ALOGW("no privilege to raise the priority, the launch booster is disabled");
+        mEnabled = false;
+    }
+}
+
+bool LaunchBooster::boost(pid_t pid, const uint32_t launchId) {
+    if (!mEnabled || launchId == 0 || pid <= 0 || mLaunches.count(launchId)) {
+        return false;
+    }
+    if (!raise(pid)) {
+        // activity manager still drives the launch at the higher priority
+        ALOGW("can't raise the priority of %d", pid);
+        mFailureCount++;
+    }
+    if (mLaunches.empty()) {
+        raise(0);
+        demoteBackground();
+    }
+    mLaunches[launchId] = pid;
+    mBoostCount++;
+    mLooper->postDelayTask([this, launchId](void*) { onTimeout(launchId); }, mTimeoutMs);
+    return true;
+}
+
+void LaunchBooster::end(const uint32_t launchId) {
+    const auto it = mLaunches.find(launchId);
+    if (it == mLaunches.end()) {
+        return;
+    }
+    restore(it->second);
+    mLaunches.erase(it);
+    if (mLaunches.empty()) {
+        restore(0);
+        restoreBackground();
+    }
+}
+
+void LaunchBooster::onTimeout(const uint32_t launchId) {
+    if (mLaunches.count(launchId)) {
+        ALOGW("the boost of launch #%" PRIu32 " times out", launchId);
+        mTimeoutCount++;
+        end(launchId);
+    }
+}
+
+void LaunchBooster::remove(pid_t pid) {
+    mBoosted.erase(pid);
+    mDemoted.erase(pid);
+    // its launches end without it
+    bool isEnded = false;
+    for (auto it = mLaunches.begin(); it != mLaunches.end();) {
+        if (it->second == pid) {
+            it = mLaunches.erase(it);
+            isEnded = true;
+        } else {
+            ++it;
+        }
+    }
+    if (isEnded && mLaunches.empty()) {
+        restore(0);
+        restoreBackground();
+    }
+}
+
+bool LaunchBooster::rebase(pid_t pid, int level) {
+    const auto boosted = mBoosted.find(pid);
+    if (boosted != mBoosted.end()) {
+        boosted->second.level = level;
+        setSchedLevel(pid, clampSchedLevel(level + BOOST_STEP));
+        return true;
+    }
+    const auto demoted = mDemoted.find(pid);
+    if (demoted != mDemoted.end()) {
+        demoted->second = level;
+        setSchedLevel(pid, clampSchedLevel(level - DEMOTE_STEP));
+        return true;
+    }
+    return false;
+}
+
+bool LaunchBooster::raise(pid_t pid) {
+    const auto it = mBoosted.find(pid);
+    if (it != mBoosted.end()) {
+        it->second.refCount++;
+        return true;
+    }
+    int level;
+    if (!getSchedLevel(pid, level)) {
+        return false;
+    }
+    // a demoted background process is launching now
+    const auto demoted = mDemoted.find(pid);
+    if (demoted != mDemoted.end()) {
+        level = demoted->second;
+        mDemoted.erase(demoted);
+    }
+    if (!setSchedLevel(pid, clampSchedLevel(level + BOOST_STEP))) {
+        return false;
+    }
+    mBoosted[pid] = {level, 1};
+    return true;
+}
+
+void LaunchBooster::restore(pid_t pid) {
+    const auto it = mBoosted.find(pid);
+    if (it != mBoosted.end() && --it->second.refCount == 0) {
+        setSchedLevel(pid, it->second.level);
+        mBoosted.erase(it);
+    }
+}
+
+void LaunchBooster::demoteBackground() {
+    for (const pid_t pid : mGetBackground()) {
+        int level;
+        if (!mBoosted.count(pid) && !mDemoted.count(pid) && getSchedLevel(pid, level) &&
+            setSchedLevel(pid, clampSchedLevel(level - DEMOTE_STEP))) {
+            mDemoted[pid] = level;
+        }
+    }
+}
+
+void LaunchBooster::restoreBackground() {
+    for (const auto& [pid, level] : mDemoted) {
+        setSchedLevel(pid, level);
+    }
+    mDemoted.clear();
+}
+
+std::ostream& operator<<(std::ostream& os, const LaunchBooster& booster) {
+    os << "\nLaunch booster:" << (booster.mEnabled ? "" : " disabled")
+       << " boosts:" << booster.mBoostCount << " timeouts:" << booster.mTimeoutCount
+       << " failures:" << booster.mFailureCount << " active:" << booster.mLaunches.size()
+       << " demoted:" << booster.mDemoted.size() << std::endl;
+    return os;
+}
+
+void LaunchBooster::dumpJson(JsonWriter& writer) const {
+    writer.beginObject("booster")
+            .field("enabled", mEnabled)
+            .field("boosts", mBoostCount)
+            .field("timeouts", mTimeoutCount)
+            .field("failures", mFailureCount)
+            .field("active", mLaunches.size())
+            .field("demoted", mDemoted.size())
+            .endObject();
+}
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "DumpWriter.h"
+#include "app/UvLoop.h"
+
+namespace os {
+namespace am {
+
+/**
+ * LaunchBooster: the launching application and activity manager run at a higher scheduling
+ * priority until the activity is resumed or the boost times out, the background processes run
+ * at a lower one meanwhile. The priorities are restored when the last launch ends.
+ * The booster is disabled if the priority can't be restored, see SchedLevel.
+ */
+class LaunchBooster {
+public:
+    using BackgroundFunc = std::function<std::vector<pid_t>()>;
+
+    LaunchBooster();
+    LaunchBooster(const bool isEnabled, const uint64_t timeoutMs);
+
+    void init(const std::shared_ptr<os::app::UvLoop>& looper, const BackgroundFunc& getBackground);
+    bool isEnabled() const {
+        return mEnabled;
+    }
+
+    /** Return false if the booster is disabled or the launch is boosted already */
+    bool boost(pid_t pid, const uint32_t launchId);
+    /** The launch is resumed, or it's dropped */
+    void end(const uint32_t launchId);
+    /** The process exits, its priority isn't restored and its launches end */
+    void remove(pid_t pid);
+    /**
+     * The base level of a boosted or demoted process is changed, it's restored to the new one.
+     * Return false if the process isn't affected by the booster.
+     */
+    bool rebase(pid_t pid, int level);
+
+    friend std::ostream& operator<<(std::ostream& os, const LaunchBooster& booster);
+    void dumpJson(JsonWriter& writer) const;
+
+private:
+    struct SavedPriority {
+        int level; // the larger the more important, whatever the backend is
+        int refCount;
+    };
+
+    bool raise(pid_t pid);
+    void restore(pid_t pid);
+    void demoteBackground();
+    void restoreBackground();
+    void onTimeout(const uint32_t launchId);
+
+    bool mEnabled;
+    uint64_t mTimeoutMs;
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    BackgroundFunc mGetBackground;
+    std::unordered_map<uint32_t, pid_t> mLaunches;
+    std::unordered_map<pid_t, SavedPriority> mBoosted; // 0 is activity manager itself
+    std::unordered_map<pid_t, int> mDemoted;
+    int mBoostCount;
+    int mTimeoutCount;
+    int mFailureCount;
+};
+
+} // namespace am
+} // namespace os
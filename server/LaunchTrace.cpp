@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LaunchTrace.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "Clock.h"
+
+namespace os {
+namespace am {
+
+LaunchTrace::LaunchTrace(const size_t capacity) {
+    mRecords.resize(capacity > 0 ? capacity : 1);
+    mNextId = 1;
+    mCurrent = 0;
+}
+
+uint32_t LaunchTrace::beginLaunch(const std::string& target) {
+    const uint32_t id = mNextId++;
+    if (mNextId == 0) {
+        mNextId = 1;
+    }
+    auto& record = mRecords[id % mRecords.size()];
+    record = LaunchRecord();
+    record.id = id;
+    record.name = target;
+    record.timestamp[BEGIN] = clock_us();
+    mCurrent = id;
+    return id;
+}
+
+void LaunchTrace::leaveLaunch(const bool isFailed) {
+    if (isFailed) {
+        dropLaunch(mCurrent);
+    }
+    mCurrent = 0;
+}
+
+void LaunchTrace::dropLaunch(const uint32_t id) {
+    if (auto record = getRecord(id)) {
+        record->id = 0;
+    }
+}
+
+LaunchTrace::LaunchRecord* LaunchTrace::getRecord(const uint32_t id) {
+    if (id == 0) {
+        return nullptr;
+    }
+    // the record had been overwritten by the newer launch
+    auto& record = mRecords[id % mRecords.size()];
+    return record.id == id ? &record : nullptr;
+}
+
+void LaunchTrace::mark(const uint32_t id, const Point point) {
+    auto record = getRecord(id);
+    if (!record || record->isFinished || record->timestamp[point] != 0) {
+        return;
+    }
+    record->timestamp[point] = clock_us();
+    if (point == RESUMED) {
+        record->isFinished = true;
+    }
+}
+
+void LaunchTrace::setType(const uint32_t id, const LaunchType type) {
+    if (auto record = getRecord(id)) {
+        record->type = type;
+    }
+}
+
+void LaunchTrace::setName(const uint32_t id, const std::string& name) {
+    if (auto record = getRecord(id)) {
+        record->name = name;
+    }
+}
+
+void LaunchTrace::setBoosted(const uint32_t id) {
+    if (auto record = getRecord(id)) {
+        record->isBoosted = true;
+    }
+}
+
+void LaunchTrace::beginPrepare(const uint32_t id) {
+    auto record = getRecord(id);
+    // only the first preparation is measured, like the points
+    if (record && record->prepareUs == 0) {
+        record->prepareUs = clock_us();
+    }
+}
+
+void LaunchTrace::endPrepare(const uint32_t id) {
+    auto record = getRecord(id);
+    if (record && record->prepareUs != 0 && record->preparedAt == 0) {
+        record->preparedAt = clock_us();
+        record->prepareUs = record->preparedAt - record->prepareUs;
+    }
+}
+
+void LaunchTrace::addSavedRequests(const uint32_t id, const int count) {
+    if (auto record = getRecord(id)) {
+        record->savedRequests += count;
+    }
+}
+
+/** The time from the previous reached point, 0 means that the phase is skipped */
+uint64_t LaunchTrace::getPhaseTime(const LaunchRecord& record, const Point point) {
+    if (record.timestamp[point] == 0) {
+        return 0;
+    }
+    for (int prev = point - 1; prev >= BEGIN; prev--) {
+        if (record.timestamp[prev] != 0) {
+            return record.timestamp[point] - record.timestamp[prev];
+        }
+    }
+    return 0;
+}
+
+uint64_t LaunchTrace::getCriticalPath(const LaunchRecord& record, bool& isPrepareCritical) {
+    const uint64_t attachedAt = record.timestamp[APP_ATTACHED];
+    if (attachedAt == 0) {
+        // the launch waits for the attachment, it isn't ready yet
+        isPrepareCritical = false;
+        return 0;
+    }
+    isPrepareCritical = record.preparedAt > attachedAt;
+    return std::max(attachedAt, record.preparedAt) - record.timestamp[BEGIN];
+}
+
+LaunchTrace::PhaseSamples LaunchTrace::getPhaseSamples(const LaunchType type) const {
+    PhaseSamples result;
+    for (const auto& record : mRecords) {
+        if (record.id == 0 || !record.isFinished || record.type != type) {
+            continue;
+        }
+        result.count++;
+        result.savedRequests += record.savedRequests;
+        for (int point = INTENT_RESOLVED; point < POINT_NUM; point++) {
+            if (record.timestamp[point] != 0) {
+                result.phases[point].push_back(getPhaseTime(record, (Point)point));
+            }
+        }
+        result.phases[POINT_NUM].push_back(record.timestamp[RESUMED] - record.timestamp[BEGIN]);
+        result.totals[record.isBoosted].push_back(result.phases[POINT_NUM].back());
+    }
+    for (auto& samples : result.phases) {
+        std::sort(samples.begin(), samples.end());
+    }
+    for (auto& samples : result.totals) {
+        std::sort(samples.begin(), samples.end());
+    }
+    return result;
+}
+
+uint64_t LaunchTrace::percentile(const std::vector<uint64_t>& sorted, const int p) {
+    const size_t rank = (sorted.size() * p + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static const char* launchTypeStr[] = {"unknown", "cold", "warm", "hot"};
+static const char* launchPhaseStr[] = {"begin",    "resolve", "pm",    "spawn",  "attach",
+                                       "schedule", "create",  "start", "resume", "total"};
+
+std::ostream& operator<<(std::ostream& os, const LaunchTrace& trace) {
+    const auto toMs = [](uint64_t us) { return us / 1000.0; };
+    const auto percentile = LaunchTrace::percentile;
+
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << "\nLaunch trace(ms), last " << trace.mRecords.size() << " launches:" << std::endl;
+    os << std::fixed << std::setprecision(1);
+    for (int type = LaunchTrace::COLD; type < LaunchTrace::TYPE_NUM; type++) {
+        const auto result = trace.getPhaseSamples((LaunchTrace::LaunchType)type);
+        if (result.count == 0) {
+            continue;
+        }
+        os << "\t" << launchTypeStr[type] << " count:" << result.count;
+        if (result.savedRequests) {
+            os << " savedRequests:" << result.savedRequests;
+        }
+        os << std::endl;
+        os << "\t\t" << std::left << std::setw(10) << "phase" << std::right << std::setw(10)
+           << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::endl;
+        for (int point = LaunchTrace::INTENT_RESOLVED; point <= LaunchTrace::POINT_NUM; point++) {
+            const auto& samples = result.phases[point];
+            if (samples.empty()) {
+                continue;
+            }
+            os << "\t\t" << std::left << std::setw(10) << launchPhaseStr[point] << std::right
+               << std::setw(10) << toMs(percentile(samples, 50)) << std::setw(10)
+               << toMs(percentile(samples, 90)) << std::setw(10) << toMs(percentile(samples, 99))
+               << std::endl;
+        }
+        if (!result.totals[true].empty()) {
+            // compare the launches with and without the boost
+            for (const bool isBoosted : {true, false}) {
+                const auto& samples = result.totals[isBoosted];
+                if (samples.empty()) {
+                    continue;
+                }
+                os << "\t\t" << std::left << std::setw(10) << (isBoosted ? "boosted" : "unboosted")
+                   << std::right << std::setw(10) << toMs(percentile(samples, 50)) << std::setw(10)
+                   << toMs(percentile(samples, 90)) << std::setw(10)
+                   << toMs(percentile(samples, 99)) << "  count:" << samples.size() << std::endl;
+            }
+        }
+    }
+
+    os << "\trecent:" << std::endl;
+    const size_t capacity = trace.mRecords.size();
+    for (size_t i = 0; i < capacity; i++) {
+        // from the oldest to the newest
+        const auto& record = trace.mRecords[(trace.mNextId + i) % capacity];
+        if (record.id == 0) {
+            continue;
+        }
+        os << "\t\t#" << record.id << " " << record.name << " " << launchTypeStr[record.type];
+        for (int point = LaunchTrace::INTENT_RESOLVED; point < LaunchTrace::POINT_NUM; point++) {
+            if (record.timestamp[point] != 0) {
+                os << " " << launchPhaseStr[point] << ":"
+                   << toMs(LaunchTrace::getPhaseTime(record, (LaunchTrace::Point)point));
+            }
+        }
+        if (record.preparedAt != 0) {
+            bool isPrepareCritical;
+            const auto critical = LaunchTrace::getCriticalPath(record, isPrepareCritical);
+            os << " prepare:" << toMs(record.prepareUs) << " critical:" << toMs(critical)
+               << (isPrepareCritical ? "(prepare)" : "(attach)");
+        }
+        if (record.savedRequests) {
+            os << " saved:" << record.savedRequests;
+        }
+        if (record.isFinished) {
+            os << " total:"
+               << toMs(record.timestamp[LaunchTrace::RESUMED] -
+                       record.timestamp[LaunchTrace::BEGIN]);
+        } else {
+            os << " (unfinished)";
+        }
+        os << std::endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+}
+
+void LaunchTrace::dumpJson(JsonWriter& writer) const {
+    writer.beginObject("launches").field("capacity", mRecords.size());
+    writer.beginArray("percentiles");
+    for (int type = COLD; type < TYPE_NUM; type++) {
+        const auto result = getPhaseSamples((LaunchType)type);
+        if (result.count == 0) {
+            continue;
+        }
+        writer.beginObject()
+                .field("type", launchTypeStr[type])
+                .field("count", result.count)
+                .field("savedRequests", result.savedRequests);
+        writer.beginArray("phases");
+        for (int point = INTENT_RESOLVED; point <= POINT_NUM; point++) {
+            const auto& samples = result.phases[point];
+            if (samples.empty()) {
+                continue;
+            }
+            writer.beginObject()
+                    .field("phase", launchPhaseStr[point])
+                    .field("p50Us", percentile(samples, 50))
+                    .field("p90Us", percentile(samples, 90))
+                    .field("p99Us", percentile(samples, 99))
+                    .endObject();
+        }
+        writer.endArray();
+        for (const bool isBoosted : {true, false}) {
+            const auto& samples = result.totals[isBoosted];
+            if (!samples.empty()) {
+                writer.beginObject(isBoosted ? "boosted" : "unboosted")
+                        .field("count", samples.size())
+                        .field("p50Us", percentile(samples, 50))
+                        .field("p90Us", percentile(samples, 90))
+                        .field("p99Us", percentile(samples, 99))
+                        .endObject();
+            }
+        }
+        writer.endObject();
+    }
+    writer.endArray();
+
+    writer.beginArray("recent");
+    const size_t capacity = mRecords.size();
+    for (size_t i = 0; i < capacity; i++) {
+        const auto& record = mRecords[(mNextId + i) % capacity];
+        if (record.id == 0) {
+            continue;
+        }
+        writer.beginObject()
+                .field("id", record.id)
+                .field("name", record.name)
+                .field("type", launchTypeStr[record.type])
+                .field("finished", record.isFinished)
+                .field("boosted", record.isBoosted)
+                .field("savedRequests", record.savedRequests);
+        if (record.preparedAt != 0) {
+            bool isPrepareCritical;
+            writer.field("prepareUs", record.prepareUs)
+                    .field("criticalPathUs", getCriticalPath(record, isPrepareCritical))
+                    .field("criticalPath", isPrepareCritical ? "prepare" : "attach");
+        }
+        writer.beginObject("phasesUs");
+        for (int point = INTENT_RESOLVED; point < POINT_NUM; point++) {
+            if (record.timestamp[point] != 0) {
+                writer.field(launchPhaseStr[point], getPhaseTime(record, (Point)point));
+            }
+        }
+        writer.endObject().endObject();
+    }
+    writer.endArray().endObject();
+}
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DumpWriter.h"
+
+namespace os {
+namespace am {
+
+/**
+ * Record the timestamps of each launch phase for the last N activity launches.
+ * The launch is traced from startActivity until the activity reports resumed.
+ */
+class LaunchTrace {
+public:
+    enum Point {
+        BEGIN = 0,        // startActivity is called
+        INTENT_RESOLVED,  // the intent is resolved to the target
+        PACKAGE_RESOLVED, // PackageManager returns the package info
+        PROCESS_SPAWNED,  // the application process is spawned
+        APP_ATTACHED,     // the application attached
+        LAUNCH_SCHEDULED, // scheduleLaunchActivity is sent
+        CREATED,          // the activity reports
+        STARTED,
+        RESUMED,
+        POINT_NUM,
+    };
+
+    enum LaunchType {
+        UNKNOWN = 0,
+        COLD, // the process has to be spawned
+        WARM, // the process is alive, the activity has to be created
+        HOT,  // the activity exists, it's only brought to front
+        TYPE_NUM,
+    };
+
+    explicit LaunchTrace(const size_t capacity);
+
+    /** Begin a new launch, it's the current one until leaveLaunch is called */
+    uint32_t beginLaunch(const std::string& target);
+    /** startActivity returns, the failed launch is dropped */
+    void leaveLaunch(const bool isFailed);
+    /** The launch fails after startActivity returns, e.g. its process can't be spawned */
+    void dropLaunch(const uint32_t id);
+    /** The launch is in startActivity, 0 means that there is no launch */
+    uint32_t currentLaunch() const {
+        return mCurrent;
+    }
+
+    void mark(const uint32_t id, const Point point);
+    void mark(const Point point) {
+        mark(mCurrent, point);
+    }
+    void setType(const uint32_t id, const LaunchType type);
+    void setName(const uint32_t id, const std::string& name);
+    /** The launch runs with the boost, see LaunchBooster */
+    void setBoosted(const uint32_t id);
+    /**
+     * The cold launch prepares its records while the process is spawning, the launch can be
+     * scheduled when both the preparation and the attachment are done.
+     */
+    void beginPrepare(const uint32_t id);
+    void endPrepare(const uint32_t id);
+    /** The lifecycle requests that the launch didn't send, they go with the attach reply */
+    void addSavedRequests(const uint32_t id, const int count);
+
+    friend std::ostream& operator<<(std::ostream& os, const LaunchTrace& trace);
+    void dumpJson(JsonWriter& writer) const;
+
+    /** The nearest-rank percentile of the sorted samples, they can't be empty */
+    static uint64_t percentile(const std::vector<uint64_t>& sorted, const int p);
+
+private:
+    struct LaunchRecord {
+        uint32_t id = 0;
+        std::string name;
+        LaunchType type = UNKNOWN;
+        bool isFinished = false;
+        bool isBoosted = false;
+        int savedRequests = 0;
+        uint64_t timestamp[POINT_NUM] = {0}; // us, 0 means that the point isn't reached
+        uint64_t prepareUs = 0;              // the time of the preparation
+        uint64_t preparedAt = 0;
+    };
+
+    // the sorted phase time(us) of the finished launches, the last one is the total time
+    struct PhaseSamples {
+        int count = 0;
+        int savedRequests = 0;
+        std::vector<uint64_t> phases[POINT_NUM + 1];
+        std::vector<uint64_t> totals[2]; // without and with the boost
+    };
+
+    LaunchRecord* getRecord(const uint32_t id);
+    static uint64_t getPhaseTime(const LaunchRecord& record, const Point point);
+    /** The time until the launch can be scheduled, and whether the preparation is on the path */
+    static uint64_t getCriticalPath(const LaunchRecord& record, bool& isPrepareCritical);
+    PhaseSamples getPhaseSamples(const LaunchType type) const;
+
+    std::vector<LaunchRecord> mRecords; // ring buffer, indexed by id % capacity
+    uint32_t mNextId;
+    uint32_t mCurrent;
+};
+
+} // namespace am
+} // namespace os
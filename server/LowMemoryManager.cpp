@@ -19,16 +19,25 @@
 #include <signal.h>
 #include <string.h>
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 
+#include "app/ActivityManager.h"
 #include "app/Logger.h"
 
 namespace os {
 namespace am {
 
 const int DELAYED_KILLING_TIMEOUT = 12000;
-const float MIN_MEM_THRESH = 0.022; // Used to calculate the minimum memory available to the system
+// The application is killed if the memory is still low after it's trimmed for a while
+const uint64_t TRIM_RECLAIM_TIMEOUT = 3000;
+// The trim is out of date, the memory pressure has been relieved since then
+const uint64_t TRIM_RECORD_EXPIRE = 30000;
+// The system can't afford a new application above it
+const int LAUNCH_PRESSURE_LIMIT = 98;
+// The pressure is read again after a trim, a notified source may not report while it stays
+const uint64_t TRIM_RECHECK_PERIOD = 500;
 
 #ifdef CONFIG_AM_LMK_CFG
 const std::string lmkcfg = CONFIG_AM_LMK_CFG;
@@ -38,120 +47,142 @@ const static std::string lmkcfg = "/etc/lmk.cfg";
 // The configuration "/data/lmk.cfg" is easy to modify for test
 const static std::string lmkcfg_debug = "/data/lmk.cfg";
 
+#ifdef CONFIG_AM_LMK_SOURCE
+const static std::string lmkSource = CONFIG_AM_LMK_SOURCE;
+#else
+const static std::string lmkSource;
+#endif
+
+// The kernel notifies the pressure if it can, otherwise it's polled
+#if defined(CONFIG_MM_DEFAULT_MANAGER) && defined(CONFIG_FS_PROCFS_INCLUDE_PRESSURE)
+const static std::string defaultLmkSource = "procfs";
+#elif defined(CONFIG_MM_DEFAULT_MANAGER)
+const static std::string defaultLmkSource = "mallinfo";
+#elif !defined(__NuttX__)
+const static std::string defaultLmkSource = "psi";
+#else
+const static std::string defaultLmkSource;
+#endif
+
+// The source that polls, when the one that is notified isn't available
+static std::string getFallbackSource(const std::string& spec) {
+    if (spec == "procfs") {
+        return "mallinfo";
+    } else if (spec == "psi") {
+        return "meminfo";
+    }
+    return "";
+}
+
+LowMemoryManager::LowMemoryManager()
+      : LowMemoryManager(lmkSource.empty() ? defaultLmkSource : lmkSource, "") {}
+
+LowMemoryManager::LowMemoryManager(const std::string& sourceSpec, const std::string& root)
+      : mSourceSpec(sourceSpec), mRoot(root) {}
+
+void LowMemoryManager::setPressureSource(std::unique_ptr<MemoryPressureSource> source) {
+    mSource = std::move(source);
+}
+
 bool LowMemoryManager::init(const std::shared_ptr<os::app::UvLoop>& looper) {
     mLooper = looper;
-    memset(mOomScoreThreshold, 0, sizeof(mOomScoreThreshold));
+    mRecheckTimer.init(looper->get(), [this](void*) {
+        const int pressure = mSource ? mSource->getPressure() : -1;
+        if (pressure >= 0) {
+            executeLMK(pressure);
+        }
+    });
+    const std::string& spec = mSourceSpec;
+    if (!mSource && !spec.empty()) {
+        mSource = MemoryPressureSource::create(spec, mRoot);
+    }
+    loadThresholds();
+    if (mSource && !startPressureSource()) {
+        const std::string fallback = getFallbackSource(spec);
+        ALOGW("memory pressure source:%s isn't available, fallback:%s", spec.c_str(),
+              fallback.c_str());
+        mSource = fallback.empty() ? nullptr : MemoryPressureSource::create(fallback, mRoot);
+        if (mSource) {
+            // the legacy thresholds are converted by the source that is used
+            loadThresholds();
+            if (!startPressureSource()) {
+                mSource = nullptr;
+            }
+        }
+    }
+    if (!mSource) {
+        ALOGW("lmk has no memory pressure source");
+    }
+    return true;
+}
 
+/**
+ * A line of lmk.cfg is "pressure oomScore", the processes whose score is at least the oomScore
+ * are trimmed or killed when the pressure is at least that. The legacy "freeMemory maxBlock
+ * oomScore" is converted to the pressure of the source, the maxBlock is dropped.
+ */
+void LowMemoryManager::loadThresholds() {
     std::ifstream cfg;
-    int cnt = 0;
-    cfg.open(lmkcfg_debug);
+    cfg.open(mRoot + lmkcfg_debug);
     if (!cfg.is_open()) {
         ALOGW("LowMemoryManager policy read \"%s\" file", lmkcfg.c_str());
-        cfg.open(lmkcfg);
-    }
-    if (cfg.is_open()) {
-        std::string line;
-        while (std::getline(cfg, line)) {
-            int freeMemory, oomScore, maxBlock;
-            if (3 == sscanf(line.c_str(), "%d %d %d", &freeMemory, &maxBlock, &oomScore)) {
-                mOomScoreThreshold[cnt][0] = freeMemory;
-                mOomScoreThreshold[cnt][1] = maxBlock;
-                mOomScoreThreshold[cnt][2] = oomScore;
-                if (++cnt >= MAX_ADJUST_NUM) {
-                    break;
-                }
+        cfg.open(mRoot + lmkcfg);
+    }
+    int cnt = 0;
+    std::string line;
+    while (cfg.is_open() && cnt < MAX_ADJUST_NUM && std::getline(cfg, line)) {
+        int first, second, third;
+        const int fields = sscanf(line.c_str(), "%d %d %d", &first, &second, &third);
+        if (fields == 3) {
+            const int pressure = mSource ? mSource->bytesToPressure(first) : -1;
+            ALOGW("legacy lmk threshold:%s, it's pressure:%d", line.c_str(), pressure);
+            if (pressure >= 0) {
+                mOomScoreThreshold[cnt++] = {pressure, third};
             }
+        } else if (fields == 2) {
+            mOomScoreThreshold[cnt++] = {std::clamp(first, 0, 100), second};
         }
     }
 
-    struct mallinfo info = mallinfo();
-    mMinMemoryThreshold = info.arena * MIN_MEM_THRESH;
-
     if (cnt == 0) {
-        ALOGI("system total memory:%d, used:%d free:%d", info.arena, info.uordblks, info.fordblks);
-        // if "/etc/lmk.cfg" no configuration data, the lmk warning thresholds are set to 40%, 20%,
-        // 10% of system memory.
-        int memorylevel[3] = {1, 2, 4};
-        int scorethreshold[3] = {10, 102, 500};
-        for (unsigned int i = 0; i < sizeof(memorylevel) / sizeof(int); i++) {
-            mOomScoreThreshold[i][0] = info.arena * memorylevel[i] / 10;
-            mOomScoreThreshold[i][1] = mOomScoreThreshold[i][0] - 1024 * 1024 * 2;
-            mOomScoreThreshold[i][2] = scorethreshold[i];
+        // if "/etc/lmk.cfg" no configuration data, the lmk warning thresholds are set to 60%, 80%,
+        // 90% of the pressure, it's 40%, 20%, 10% of free memory for the memory manager.
+        const Threshold defaultThresholds[] = {{90, 10}, {80, 102}, {60, 500}};
+        for (const auto& threshold : defaultThresholds) {
+            mOomScoreThreshold[cnt++] = threshold;
         }
-        cnt = 3;
-    }
-
-#ifdef CONFIG_MM_DEFAULT_MANAGER
-#ifdef CONFIG_FS_PROCFS_INCLUDE_PRESSURE
-    int fd = open("/proc/pressure/memory", O_RDWR);
-    if (fd > 0) {
-        ALOGW("lmk is reported by poll \"/proc/pressure/memory\"");
-        // write maximum oom threshold[cnt-1] and report period".
-        dprintf(fd, "%d 2000000", mOomScoreThreshold[cnt - 1][0]);
-        auto pollfd = std::make_shared<os::app::UvPoll>(mLooper->get(), fd);
-        pollfd->start(
-                UV_READABLE | UV_PRIORITIZED,
-                [this](int f, int status, int events, void* data) {
-                    char buffer[128];
-                    const int len = read(f, buffer, 128);
-                    if (len > 0) {
-                        buffer[len] = 0;
-                        ALOGD("poll pressure:%s", buffer);
-                        int freememory, maxblock;
-                        if (2 ==
-                            sscanf(buffer, "remaining %d, largest:%d", &freememory, &maxblock)) {
-                            executeLMK(freememory, maxblock);
-                        }
-                    }
-                },
-                nullptr);
-        mPollPressureFds.push_back(pollfd);
-
-    } else
-#endif
-    {
-        ALOGW("lmk is reported by cycle query");
-        // Periodicity monitoring:just for test lmk when kernel doesn't provide notifications.
-        mTimer.init(mLooper->get(), [this](void*) {
-            struct mallinfo meminfo = mallinfo();
-            executeLMK(meminfo.fordblks, meminfo.mxordblk);
-        });
-        mTimer.start(2000, 2000); // 2 seconds per cycle
     }
-#endif
+    std::sort(mOomScoreThreshold, mOomScoreThreshold + cnt,
+              [](const auto& a, const auto& b) { return a.pressure > b.pressure; });
+    mThresholdNum = cnt;
+}
+
+bool LowMemoryManager::startPressureSource() {
+    // the least critical level is where lmk starts to act
+    const int threshold = mOomScoreThreshold[mThresholdNum - 1].pressure;
+    if (!mSource->start(mLooper, threshold, [this](int pressure) { executeLMK(pressure); })) {
+        return false;
+    }
+    ALOGI("lmk is reported by %s, threshold:%d", mSource->getName(), threshold);
     return true;
-} // namespace am
+}
 
 bool LowMemoryManager::isOkToLaunch() {
-    // check memory
-    unsigned int maxblock = -1;
-#ifdef CONFIG_FS_PROCFS_INCLUDE_PRESSURE
-    int fd = open("/proc/pressure/memory", O_RDONLY);
-    if (fd > 0) {
-        char buf[256];
-        const int len = read(fd, buf, 256);
-        if (len > 0) {
-            buf[len] = 0;
-            int free;
-            if (sscanf(buf, "remaining %d, largest:%d", &free, &maxblock) == 2) {
-                ALOGW("pressure format error:%s", buf);
-            }
-        }
-        close(fd);
-    }
-#else
-    struct mallinfo info = mallinfo();
-    maxblock = info.mxordblk;
-#endif
-    if (maxblock < mMinMemoryThreshold) {
-        ALOGW("system memory less then min use threshold! current:%d, threshold:%d", maxblock,
-              mMinMemoryThreshold);
+    const int pressure = mSource ? mSource->getPressure() : -1;
+    if (pressure >= LAUNCH_PRESSURE_LIMIT) {
+        ALOGW("system memory pressure is too high to launch! current:%d, limit:%d", pressure,
+              LAUNCH_PRESSURE_LIMIT);
         return false;
     }
 
     return true;
 }
 
+bool LowMemoryManager::isUnderPressure() const {
+    return mSource && mThresholdNum > 0 &&
+            mSource->getPressure() >= mOomScoreThreshold[mThresholdNum - 1].pressure;
+}
+
 int LowMemoryManager::setPidOomScore(pid_t pid, int score) {
     auto iter = mPidOomScore.find(pid);
     if (iter != mPidOomScore.end()) {
@@ -167,6 +198,7 @@ int LowMemoryManager::cancelMonitorPid(pid_t pid) {
     if (iter != mPidOomScore.end()) {
         mPidOomScore.erase(iter);
     }
+    mTrimRecords.erase(pid);
     return 0;
 }
 
@@ -178,20 +210,85 @@ void LowMemoryManager::setLMKExecutor(const LMKExectorCB& lmkExectorFunc) {
     mExectorCallback = lmkExectorFunc;
 }
 
-void LowMemoryManager::executeLMK(const int freememory, const int maxblock) {
+void LowMemoryManager::setTrimMemoryExecutor(const TrimMemoryCB& trimMemoryFunc) {
+    mTrimCallback = trimMemoryFunc;
+}
+
+void LowMemoryManager::executeLMK(const int pressure) {
+    if (!mLooper) {
+        // the pressure is handled on the looper after init
+        return;
+    }
     ALOGD("execute low memory kill");
+    if (const auto iter = mTrimRecords.find(mMeasuringPid); iter != mTrimRecords.end()) {
+        auto& record = iter->second;
+        record.systemRelief += std::max(record.pressureBefore - pressure, 0);
+    }
+    mMeasuringPid = 0;
+    int level = -1;
+    for (int i = 0; i < mThresholdNum; i++) {
+        if (pressure >= mOomScoreThreshold[i].pressure) {
+            level = i;
+            break;
+        }
+    }
+    checkTrimEffect(pressure, level);
+    if (level < 0) {
+        mRecheckTimer.stop();
+        return;
+    }
+    // the next candidate is trimmed on the next report, or on the recheck without it
+    mRecheckTimer.start(TRIM_RECHECK_PERIOD);
+
+    if (mPrepareCallback) mPrepareCallback();
+    // the processes in background(higher score) are handled first
+    std::vector<std::pair<pid_t, int>> candidates;
+    for (auto iter = mPidOomScore.begin(); iter != mPidOomScore.end(); ++iter) {
+        if (iter->second >= mOomScoreThreshold[level].oomScore) {
+            candidates.emplace_back(iter->first, iter->second);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    // the most critical level asks all the applications at once to release everything they can,
+    // they're killed together when the memory is still low after the reclaim timeout
+    const bool isCritical = level == 0;
+    int trimLevel = os::app::ActivityManager::TRIM_MEMORY_BACKGROUND;
+    if (isCritical) {
+        trimLevel = os::app::ActivityManager::TRIM_MEMORY_COMPLETE;
+    } else if (level == 1) {
+        trimLevel = os::app::ActivityManager::TRIM_MEMORY_MODERATE;
+    }
+    const uint64_t now = uv_now(mLooper->get());
     std::vector<pid_t> killPidVec;
-    for (int i = 0; i < MAX_ADJUST_NUM; i++) {
-        if (freememory <= mOomScoreThreshold[i][0] || maxblock <= mOomScoreThreshold[i][1]) {
-            if (mPrepareCallback) mPrepareCallback();
-            for (auto iter = mPidOomScore.begin(); iter != mPidOomScore.end(); ++iter) {
-                if (iter->second >= mOomScoreThreshold[i][2]) {
-                    ALOGI("LMK free:%d maxblock:%d score:%d, kill pid:%d score:%d", freememory,
-                          maxblock, mOomScoreThreshold[i][2], iter->first, iter->second);
-                    killPidVec.push_back(iter->first);
-                }
+    for (const auto& [pid, score] : candidates) {
+        const auto iter = mTrimRecords.find(pid);
+        const bool isPending = iter != mTrimRecords.end() && iter->second.isPending;
+        const uint64_t elapsed = isPending ? now - iter->second.trimTime : 0;
+        if (mTrimCallback &&
+            (!isPending || elapsed > TRIM_RECORD_EXPIRE || trimLevel > iter->second.level)) {
+            if (mMeasuringPid > 0 && !isCritical) {
+                // one application a pass, the pressure is checked again before the next one
+                continue;
             }
-            break;
+            // give the application a chance to release memory before killing it
+            auto& record = mTrimRecords[pid];
+            ALOGI("LMK pressure:%d score:%d, trim pid:%d score:%d level:%d", pressure,
+                  mOomScoreThreshold[level].oomScore, pid, score, trimLevel);
+            record.isPending = true;
+            record.level = trimLevel;
+            record.trimTime = now;
+            record.pressureBefore = pressure;
+            record.trimCount++;
+            mTotalTrimCount++;
+            // the relief of the trims together isn't attributed to any of them
+            mMeasuringPid = isCritical ? 0 : pid;
+            mTrimCallback(pid, trimLevel);
+        } else if (!mTrimCallback || elapsed >= TRIM_RECLAIM_TIMEOUT) {
+            ALOGI("LMK pressure:%d score:%d, kill pid:%d score:%d", pressure,
+                  mOomScoreThreshold[level].oomScore, pid, score);
+            killPidVec.push_back(pid);
         }
     }
 
@@ -210,7 +307,58 @@ void LowMemoryManager::executeLMK(const int freememory, const int maxblock) {
         //         },
         //         DELAYED_KILLING_TIMEOUT);
         mPidOomScore.erase(pid);
+        mTrimRecords.erase(pid);
+        mTotalKilledCount++;
+    }
+}
+
+void LowMemoryManager::checkTrimEffect(const int pressure, const int level) {
+    for (auto& [pid, record] : mTrimRecords) {
+        if (!record.isPending) {
+            continue;
+        }
+        const auto iter = mPidOomScore.find(pid);
+        if (level < 0 || iter == mPidOomScore.end() ||
+            iter->second < mOomScoreThreshold[level].oomScore) {
+            // the memory pressure is relieved, the application is spared
+            record.isPending = false;
+            record.sparedCount++;
+            mTotalSparedCount++;
+        }
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const LowMemoryManager& lmk) {
+    os << "\nLow memory trim: source:" << (lmk.mSource ? lmk.mSource->getName() : "none")
+       << " pressure:" << (lmk.mSource ? lmk.mSource->getPressure() : -1)
+       << " trimmed:" << lmk.mTotalTrimCount << " spared:" << lmk.mTotalSparedCount
+       << " killed:" << lmk.mTotalKilledCount << std::endl;
+    for (const auto& [pid, record] : lmk.mTrimRecords) {
+        os << "\tpid:" << pid << " trimmed:" << record.trimCount << " spared:" << record.sparedCount
+           << " systemRelief:" << record.systemRelief << (record.isPending ? " pending" : "")
+           << std::endl;
+    }
+    return os;
+}
+
+void LowMemoryManager::dumpJson(JsonWriter& writer) const {
+    writer.beginObject("lmk")
+            .field("source", mSource ? mSource->getName() : "none")
+            .field("pressure", mSource ? mSource->getPressure() : -1)
+            .field("trimmed", mTotalTrimCount)
+            .field("spared", mTotalSparedCount)
+            .field("killed", mTotalKilledCount);
+    writer.beginArray("processes");
+    for (const auto& [pid, record] : mTrimRecords) {
+        writer.beginObject()
+                .field("pid", pid)
+                .field("trimmed", record.trimCount)
+                .field("spared", record.sparedCount)
+                .field("systemRelief", record.systemRelief)
+                .field("pending", record.isPending)
+                .endObject();
     }
+    writer.endArray().endObject();
 }
 
 } // namespace am
@@ -15,13 +15,17 @@
  */
 #pragma once
 
-#include <malloc.h>
 #include <sys/types.h>
 
 #include <functional>
+#include <iostream>
 #include <list>
+#include <memory>
+#include <string>
 #include <unordered_map>
 
+#include "DumpWriter.h"
+#include "MemoryPressureSource.h"
 #include "app/UvLoop.h"
 
 namespace os {
@@ -31,27 +35,66 @@ class LowMemoryManager {
 public:
     using PrepareLMKCB = std::function<void()>;
     using LMKExectorCB = std::function<void(pid_t)>;
-    LowMemoryManager() = default;
+    using TrimMemoryCB = std::function<void(pid_t, int level)>;
+    LowMemoryManager();
+    /** The spec of the source, and the root of lmk.cfg and the files of the source, for test */
+    LowMemoryManager(const std::string& sourceSpec, const std::string& root);
 
+    /** The source is set before init, or it's created by CONFIG_AM_LMK_SOURCE */
+    void setPressureSource(std::unique_ptr<MemoryPressureSource> source);
     bool init(const std::shared_ptr<os::app::UvLoop>& looper);
     bool isOkToLaunch();
+    /** True if the pressure is at the least critical threshold, lmk is acting */
+    bool isUnderPressure() const;
     void setPrepareLMKCallback(const PrepareLMKCB& callback);
     void setLMKExecutor(const LMKExectorCB& lmkExectorFunc);
+    void setTrimMemoryExecutor(const TrimMemoryCB& trimMemoryFunc);
 
     int setPidOomScore(pid_t pid, int score);
     int cancelMonitorPid(pid_t pid);
-    void executeLMK(const int freememory, const int maxblock);
+    /** The pressure is from 0 to 100, see MemoryPressureSource */
+    void executeLMK(const int pressure);
+
+    friend std::ostream& operator<<(std::ostream& os, const LowMemoryManager& lmk);
+    void dumpJson(JsonWriter& writer) const;
 
 private:
+    struct TrimRecord {
+        bool isPending = false; // waiting for the application to release memory
+        int level = 0;
+        uint64_t trimTime = 0;
+        int pressureBefore = 0;
+        int trimCount = 0;
+        int sparedCount = 0;
+        // the drop of the system-wide pressure until the report after each of its trims, the
+        // applications are trimmed one at a time to tell them apart, but the others count too
+        int64_t systemRelief = 0;
+    };
+    struct Threshold {
+        int pressure;
+        int oomScore;
+    };
+    void loadThresholds();
+    bool startPressureSource();
+    void checkTrimEffect(const int pressure, const int level);
+
     const static int MAX_ADJUST_NUM = 5;
-    unsigned int mMinMemoryThreshold; // Minimum memory value to support system operation
+    const std::string mSourceSpec;
+    const std::string mRoot;
     std::shared_ptr<os::app::UvLoop> mLooper;
+    std::unique_ptr<MemoryPressureSource> mSource;
     std::unordered_map<pid_t, int> mPidOomScore;
     PrepareLMKCB mPrepareCallback;
     LMKExectorCB mExectorCallback;
-    int mOomScoreThreshold[MAX_ADJUST_NUM][3];
-    os::app::UvTimer mTimer;
-    std::vector<std::shared_ptr<os::app::UvPoll>> mPollPressureFds;
+    TrimMemoryCB mTrimCallback;
+    std::unordered_map<pid_t, TrimRecord> mTrimRecords;
+    int mTotalTrimCount = 0;
+    int mTotalSparedCount = 0;
+    int mTotalKilledCount = 0;
+    pid_t mMeasuringPid = 0; // the latest trim, the next report measures it
+    os::app::UvTimer mRecheckTimer;
+    Threshold mOomScoreThreshold[MAX_ADJUST_NUM]; // the most critical level is the first
+    int mThresholdNum = 0;
 };
 
 } // namespace am
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MemoryCgroup"
+
+#include "MemoryCgroup.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#ifndef __NuttX__
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#endif
+
+#include "app/ActivityManager.h"
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+// the parent of the application cgroups, with the memory controller enabled
+#ifdef CONFIG_AM_MEMORY_CGROUP
+#define AM_MEMORY_CGROUP CONFIG_AM_MEMORY_CGROUP
+#else
+#define AM_MEMORY_CGROUP ""
+#endif
+
+// memory.max(MB) of the low, middle, high and persistent applications, 0 is unlimited
+#ifdef CONFIG_AM_MEMORY_CGROUP_LIMITS
+#define AM_MEMORY_CGROUP_LIMITS CONFIG_AM_MEMORY_CGROUP_LIMITS
+#else
+#define AM_MEMORY_CGROUP_LIMITS "64,128,256,0"
+#endif
+
+// memory.high is the percentage of memory.max by the band, the background ones are trimmed sooner
+static const int HIGH_PERCENT[CpuClassPolicy::BAND_NUM] = {90, 90, 80, 70, 60, 50};
+// memory.high may be exceeded again and again, the application has a moment to release memory
+static const uint64_t TRIM_INTERVAL_MS = 1000;
+// the cgroup is busy until its process is reaped, which may be after AMS learns the exit
+static const uint64_t REMOVE_RETRY_MS = 500;
+static const int REMOVE_RETRY_NUM = 10;
+
+MemoryCgroup::MemoryCgroup() : MemoryCgroup(AM_MEMORY_CGROUP, AM_MEMORY_CGROUP_LIMITS) {}
+
+MemoryCgroup::MemoryCgroup(const std::string& root, const std::string& limits)
+      : mEnabled(false),
+        mRoot(root),
+        mLimitsStr(limits),
+        mNotifyFd(-1),
+        mTrimCount(0),
+        mKillCount(0),
+        mOomKillCount(0) {
+    std::fill(std::begin(mLimits), std::end(mLimits), 0);
+}
+
+MemoryCgroup::~MemoryCgroup() {
+    mPoll.reset();
+    if (mNotifyFd >= 0) {
+        close(mNotifyFd);
+    }
+}
+
+void MemoryCgroup::init(const std::shared_ptr<os::app::UvLoop>& looper, const TrimFunc& trim,
+                        const KillFunc& kill) {
+    mLooper = looper;
+    mTrim = trim;
+    mKill = kill;
+#ifndef __NuttX__
+    if (mRoot.empty()) {
+        return;
+    }
+    std::istringstream limits(mLimitsStr);
+    std::string limit;
+    for (int priority = ProcessPriority::LOW;
+         priority <= ProcessPriority::PERSISTENT && std::getline(limits, limit, ','); priority++) {
+        mLimits[priority] = strtoull(limit.c_str(), nullptr, 10) * 1024 * 1024;
+    }
+    std::ofstream controllers(mRoot + "/cgroup.subtree_control");
+    if (!(controllers << "+memory" << std::flush)) {
+        ALOGE("can't enable the memory controller of %s", mRoot.c_str());
+        return;
+    }
+    mNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mNotifyFd < 0) {
+        ALOGE("can't watch the memory events");
+        return;
+    }
+    mPoll = std::make_unique<os::app::UvPoll>(mLooper->get(), mNotifyFd);
+    mPoll->start(UV_READABLE, [this](int fd, int status, int events, void* data) { onEvents(); });
+    mEnabled = true;
+#endif
+}
+
+void MemoryCgroup::add(pid_t pid, ProcessPriority priority, CpuClassPolicy::Band band) {
+#ifndef __NuttX__
+    if (!mEnabled || mApps.count(pid)) {
+        return;
+    }
+    AppCgroup app;
+    app.path = mRoot + "/app-" + std::to_string(pid);
+    app.max = mLimits[priority];
+    if (mkdir(app.path.c_str(), 0755) != 0 && errno != EEXIST) {
+        ALOGE("can't create the cgroup of %d", pid);
+        return;
+    }
+    std::ofstream max(app.path + "/memory.max");
+    max << (app.max ? std::to_string(app.max) : "max") << std::flush;
+    std::ofstream procs(app.path + "/cgroup.procs");
+    if (!max || !setLimit(app, band) || !(procs << pid << std::flush)) {
+        ALOGE("can't move %d into its cgroup", pid);
+        rmdir(app.path.c_str());
+        return;
+    }
+    app.watch = inotify_add_watch(mNotifyFd, (app.path + "/memory.events").c_str(), IN_MODIFY);
+    if (app.watch >= 0) {
+        mWatches[app.watch] = pid;
+    }
+    ALOGD("pid:%d into its cgroup, max:%" PRIu64 " high:%" PRIu64, pid, app.max, app.high);
+    mApps.emplace(pid, std::move(app));
+#endif
+}
+
+void MemoryCgroup::onBandChanged(pid_t pid, CpuClassPolicy::Band band) {
+    const auto it = mApps.find(pid);
+    if (it != mApps.end()) {
+        setLimit(it->second, band);
+    }
+}
+
+bool MemoryCgroup::setLimit(AppCgroup& app, CpuClassPolicy::Band band) {
+    app.high = app.max * HIGH_PERCENT[band] / 100;
+    std::ofstream high(app.path + "/memory.high");
+    high << (app.high ? std::to_string(app.high) : "max") << std::flush;
+    return high.good();
+}
+
+void MemoryCgroup::remove(pid_t pid) {
+#ifndef __NuttX__
+    const auto it = mApps.find(pid);
+    if (it == mApps.end()) {
+        return;
+    }
+    if (it->second.watch >= 0) {
+        inotify_rm_watch(mNotifyFd, it->second.watch);
+        mWatches.erase(it->second.watch);
+    }
+    removeCgroup(it->second.path, REMOVE_RETRY_NUM);
+    mApps.erase(it);
+#endif
+}
+
+bool MemoryCgroup::isOutOfMemory(pid_t pid) {
+#ifndef __NuttX__
+    auto it = mApps.find(pid);
+    if (it == mApps.end()) {
+        return false;
+    }
+    // the last events may be still in the inotify queue
+    checkEvents(pid, it->second);
+    return it->second.oomEvents > 0 || it->second.oomKillEvents > 0;
+#else
+    return false;
+#endif
+}
+
+void MemoryCgroup::removeCgroup(const std::string& path, const int retries) {
+#ifndef __NuttX__
+    if (rmdir(path.c_str()) == 0 || errno == ENOENT) {
+        return;
+    }
+    if (errno != EBUSY || retries <= 0) {
+        ALOGW("can't remove the cgroup %s:%d", path.c_str(), errno);
+        return;
+    }
+    mLooper->postDelayTask([this, path, retries](void*) { removeCgroup(path, retries - 1); },
+                           REMOVE_RETRY_MS);
+#endif
+}
+
+void MemoryCgroup::onEvents() {
+#ifndef __NuttX__
+    alignas(struct inotify_event) char buffer[1024];
+    ssize_t len;
+    while ((len = read(mNotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char* ptr = buffer; ptr < buffer + len;) {
+            const auto event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+            const auto watch = mWatches.find(event->wd);
+            if (watch == mWatches.end()) {
+                continue;
+            }
+            const auto app = mApps.find(watch->second);
+            if (app != mApps.end()) {
+                checkEvents(app->first, app->second);
+            }
+        }
+    }
+#endif
+}
+
+void MemoryCgroup::checkEvents(pid_t pid, AppCgroup& app) {
+    std::ifstream file(app.path + "/memory.events");
+    std::string key;
+    uint64_t value;
+    uint64_t highEvents = app.highEvents, maxEvents = app.maxEvents, oomEvents = app.oomEvents,
+             oomKillEvents = app.oomKillEvents;
+    while (file >> key >> value) {
+        if (key == "high") {
+            highEvents = value;
+        } else if (key == "max") {
+            maxEvents = value;
+        } else if (key == "oom") {
+            oomEvents = value;
+        } else if (key == "oom_kill") {
+            oomKillEvents = value;
+        }
+    }
+
+    if (oomKillEvents > app.oomKillEvents) {
+        ALOGW("pid:%d is killed by the cgroup OOM", pid);
+        mOomKillCount++;
+    } else if (oomEvents > app.oomEvents) {
+        // it can't be kept under memory.max
+        ALOGW("pid:%d is out of its memory.max, stop it", pid);
+        mKillCount++;
+        mKill(pid);
+    } else if (highEvents > app.highEvents || maxEvents > app.maxEvents) {
+        const uint64_t now = uv_now(mLooper->get());
+        if (now - app.lastTrimTime >= TRIM_INTERVAL_MS) {
+            app.lastTrimTime = now;
+            mTrimCount++;
+            mTrim(pid, maxEvents > app.maxEvents ? os::app::ActivityManager::TRIM_MEMORY_COMPLETE
+                                                 : os::app::ActivityManager::TRIM_MEMORY_MODERATE);
+        }
+    }
+    app.highEvents = highEvents;
+    app.maxEvents = maxEvents;
+    app.oomEvents = oomEvents;
+    app.oomKillEvents = oomKillEvents;
+}
+
+static uint64_t readCurrent(const std::string& path) {
+    std::ifstream file(path + "/memory.current");
+    uint64_t current = 0;
+    file >> current;
+    return current;
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryCgroup& cgroup) {
+    if (!cgroup.mEnabled) {
+        return os;
+    }
+    os << "\nMemory cgroups: " << cgroup.mRoot << " trims:" << cgroup.mTrimCount
+       << " kills:" << cgroup.mKillCount << " oomKills:" << cgroup.mOomKillCount << std::endl;
+    for (const auto& [pid, app] : cgroup.mApps) {
+        os << "\tpid:" << pid << " current:" << readCurrent(app.path) / 1024
+           << "KB high:" << app.high / 1024 << "KB max:" << app.max / 1024
+           << "KB events(high:" << app.highEvents << " max:" << app.maxEvents
+           << " oom:" << app.oomEvents << ")" << std::endl;
+    }
+    return os;
+}
+
+void MemoryCgroup::dumpJson(JsonWriter& writer) const {
+    writer.beginObject("memoryCgroup")
+            .field("enabled", mEnabled)
+            .field("trims", mTrimCount)
+            .field("kills", mKillCount)
+            .field("oomKills", mOomKillCount);
+    writer.beginArray("apps");
+    for (const auto& [pid, app] : mApps) {
+        writer.beginObject()
+                .field("pid", pid)
+                .field("currentKb", readCurrent(app.path) / 1024)
+                .field("highKb", app.high / 1024)
+                .field("maxKb", app.max / 1024)
+                .field("highEvents", app.highEvents)
+                .field("maxEvents", app.maxEvents)
+                .field("oomEvents", app.oomEvents)
+                .endObject();
+    }
+    writer.endArray().endObject();
+}
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "CpuClassPolicy.h"
+#include "DumpWriter.h"
+#include "ProcessPriorityPolicy.h"
+#include "app/UvLoop.h"
+
+namespace os {
+namespace am {
+
+/**
+ * MemoryCgroup: every application has its own cgroup v2 on the Linux host, its memory.max is
+ * from its ProcessPriority and its memory.high is a part of that by its band. The memory.events
+ * of the application is watched, the application that exceeds its memory.high is trimmed, and
+ * the one that can't be kept under its memory.max is stopped, rather than a system-wide LMK pass.
+ */
+class MemoryCgroup {
+public:
+    using TrimFunc = std::function<void(pid_t, int level)>;
+    using KillFunc = std::function<void(pid_t)>;
+
+    MemoryCgroup();
+    /** root: the parent cgroup, limits: memory.max(MB) by ProcessPriority, e.g. "64,128,256,0" */
+    MemoryCgroup(const std::string& root, const std::string& limits);
+    ~MemoryCgroup();
+
+    void init(const std::shared_ptr<os::app::UvLoop>& looper, const TrimFunc& trim,
+              const KillFunc& kill);
+    bool isEnabled() const {
+        return mEnabled;
+    }
+
+    /** Move a spawned application into its own cgroup */
+    void add(pid_t pid, ProcessPriority priority, CpuClassPolicy::Band band);
+    void onBandChanged(pid_t pid, CpuClassPolicy::Band band);
+    void remove(pid_t pid);
+    /** True if the application ran out of its memory.max, it's called before remove */
+    bool isOutOfMemory(pid_t pid);
+
+    friend std::ostream& operator<<(std::ostream& os, const MemoryCgroup& cgroup);
+    void dumpJson(JsonWriter& writer) const;
+
+private:
+    struct AppCgroup {
+        std::string path;
+        int watch = -1;
+        uint64_t max = 0; // 0 is unlimited
+        uint64_t high = 0;
+        // the counters of memory.events
+        uint64_t highEvents = 0;
+        uint64_t maxEvents = 0;
+        uint64_t oomEvents = 0;
+        uint64_t oomKillEvents = 0;
+        uint64_t lastTrimTime = 0;
+    };
+
+    bool setLimit(AppCgroup& app, CpuClassPolicy::Band band);
+    void removeCgroup(const std::string& path, const int retries);
+    void onEvents();
+    void checkEvents(pid_t pid, AppCgroup& app);
+
+    bool mEnabled;
+    std::string mRoot;
+    std::string mLimitsStr;
+    uint64_t mLimits[ProcessPriority::PERSISTENT + 1]; // bytes
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    TrimFunc mTrim;
+    KillFunc mKill;
+    int mNotifyFd;
+    std::unique_ptr<os::app::UvPoll> mPoll;
+    std::unordered_map<pid_t, AppCgroup> mApps;
+    std::unordered_map<int, pid_t> mWatches;
+    int mTrimCount;
+    int mKillCount;
+    int mOomKillCount;
+};
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MemoryPressure"
+
+#include "MemoryPressureSource.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#ifndef __NuttX__
+#include <sys/inotify.h>
+#endif
+
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+// the sources that aren't notified are polled
+static const uint64_t POLL_PERIOD_MS = 2000;
+// a notified source is polled until the pressure is below it, so LMK sees the relief
+static const int RELIEF_PRESSURE = 50;
+
+static const char* PRESSURE_FILE = "/proc/pressure/memory";
+static const char* MEMINFO_FILE = "/proc/meminfo";
+
+static int toPressure(int64_t free, int64_t total) {
+    if (total <= 0) {
+        return -1;
+    }
+    return (int)std::clamp<int64_t>(100 - free * 100 / total, 0, 100);
+}
+
+/** The free memory of the heap, the total is the heap size when it's created */
+class HeapSource : public MemoryPressureSource {
+public:
+    int bytesToPressure(int64_t freeBytes) const override {
+        return toPressure(freeBytes, mTotal);
+    }
+
+protected:
+    const int64_t mTotal = mallinfo().arena;
+};
+
+class MallinfoSource : public HeapSource {
+public:
+    const char* getName() const override {
+        return "mallinfo";
+    }
+
+    bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+               const ReportFunc& report) override {
+        mTimer.init(looper->get(), [this, report](void*) { report(getPressure()); });
+        mTimer.start(POLL_PERIOD_MS, POLL_PERIOD_MS);
+        return true;
+    }
+
+    int getPressure() override {
+        return toPressure(mallinfo().fordblks, mTotal);
+    }
+
+private:
+    os::app::UvTimer mTimer;
+};
+
+/** NuttX reports when the free memory is below the threshold, "remaining %d, largest:%d" */
+class ProcfsSource : public HeapSource {
+public:
+    explicit ProcfsSource(const std::string& root) : mPath(root + PRESSURE_FILE) {}
+    ~ProcfsSource() {
+        mPoll.reset();
+        if (mFd >= 0) {
+            close(mFd);
+        }
+    }
+
+    const char* getName() const override {
+        return "procfs";
+    }
+
+    bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+               const ReportFunc& report) override {
+        mFd = open(mPath.c_str(), O_RDWR);
+        if (mFd < 0) {
+            return false;
+        }
+        // the free memory threshold and the report period(us)
+        dprintf(mFd, "%" PRId64 " 2000000", mTotal * (100 - threshold) / 100);
+        mPoll = std::make_unique<os::app::UvPoll>(looper->get(), mFd);
+        mPoll->start(UV_READABLE | UV_PRIORITIZED,
+                     [this, report](int fd, int status, int events, void* data) {
+                         const int pressure = parse(fd);
+                         if (pressure >= 0) {
+                             report(pressure);
+                         }
+                     });
+        return true;
+    }
+
+    int getPressure() override {
+        const int fd = open(mPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return -1;
+        }
+        const int pressure = parse(fd);
+        close(fd);
+        return pressure;
+    }
+
+private:
+    int parse(int fd) {
+        char buffer[128];
+        const int len = read(fd, buffer, sizeof(buffer) - 1);
+        if (len <= 0) {
+            return -1;
+        }
+        buffer[len] = 0;
+        ALOGD("poll pressure:%s", buffer);
+        int remaining, largest;
+        if (sscanf(buffer, "remaining %d, largest:%d", &remaining, &largest) != 2) {
+            ALOGW("pressure format error:%s", buffer);
+            return -1;
+        }
+        return toPressure(remaining, mTotal);
+    }
+
+    const std::string mPath;
+    int mFd = -1;
+    std::unique_ptr<os::app::UvPoll> mPoll;
+};
+
+#ifndef __NuttX__
+/** The kernel tells the pressure is high, it's polled since then until it's relieved */
+class TriggeredSource : public MemoryPressureSource {
+public:
+    ~TriggeredSource() {
+        mPolls.clear();
+        for (const int fd : mFds) {
+            close(fd);
+        }
+    }
+
+protected:
+    void watch(const std::shared_ptr<os::app::UvLoop>& looper, const ReportFunc& report) {
+        mLooper = looper;
+        mReport = report;
+        mTimer.init(looper->get(), [this](void*) {
+            const int pressure = getPressure();
+            mReport(pressure);
+            if (pressure < RELIEF_PRESSURE) {
+                mTimer.stop();
+            }
+        });
+    }
+
+    void addFd(int fd, const std::function<void()>& onEvent) {
+        mFds.push_back(fd);
+        auto poll = std::make_unique<os::app::UvPoll>(mLooper->get(), fd);
+        poll->start(UV_PRIORITIZED | UV_READABLE,
+                    [onEvent](int fd, int status, int events, void* data) { onEvent(); });
+        mPolls.push_back(std::move(poll));
+    }
+
+    /** The trigger tells the pressure is at least that */
+    void onTrigger(int pressure) {
+        mReport(std::max(pressure, getPressure()));
+        mTimer.start(POLL_PERIOD_MS, POLL_PERIOD_MS);
+    }
+
+private:
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    ReportFunc mReport;
+    os::app::UvTimer mTimer;
+    std::vector<int> mFds;
+    std::vector<std::unique_ptr<os::app::UvPoll>> mPolls;
+};
+
+#ifdef CONFIG_AM_LMK_PSI_SOME_US
+#define AM_LMK_PSI_SOME_US CONFIG_AM_LMK_PSI_SOME_US
+#else
+#define AM_LMK_PSI_SOME_US 150000
+#endif
+
+#ifdef CONFIG_AM_LMK_PSI_FULL_US
+#define AM_LMK_PSI_FULL_US CONFIG_AM_LMK_PSI_FULL_US
+#else
+#define AM_LMK_PSI_FULL_US 70000
+#endif
+
+/**
+ * Linux PSI, a trigger for "some" and "full" stall time in a 1s window. The pressure is 70 at
+ * the "some" threshold and 90 at the "full" one, in proportion to the avg10 stall time between.
+ */
+class PsiSource : public TriggeredSource {
+public:
+    explicit PsiSource(const std::string& root) : mPath(root + PRESSURE_FILE) {}
+
+    const char* getName() const override {
+        return "psi";
+    }
+
+    bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+               const ReportFunc& report) override {
+        watch(looper, report);
+        const std::pair<const char*, int> triggers[] = {{"some", AM_LMK_PSI_SOME_US},
+                                                        {"full", AM_LMK_PSI_FULL_US}};
+        for (const auto& [kind, stallUs] : triggers) {
+            const int fd = open(mPath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            char trigger[64];
+            snprintf(trigger, sizeof(trigger), "%s %d %d", kind, stallUs, WINDOW_US);
+            if (fd < 0 || write(fd, trigger, strlen(trigger) + 1) < 0) {
+                ALOGW("can't set the PSI trigger:%s", trigger);
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return false;
+            }
+            const int pressure = strcmp(kind, "full") == 0 ? FULL_PRESSURE : SOME_PRESSURE;
+            addFd(fd, [this, pressure] { onTrigger(pressure); });
+        }
+        return true;
+    }
+
+    int getPressure() override {
+        std::ifstream file(mPath);
+        std::string kind;
+        std::string avg10;
+        std::string rest;
+        double some = 0, full = 0;
+        while (file >> kind >> avg10 && std::getline(file, rest)) {
+            // "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+            const double value = atof(avg10.c_str() + strlen("avg10="));
+            (kind == "full" ? full : some) = value;
+        }
+        if (!file.eof()) {
+            return -1;
+        }
+        const double somePressure = some * SOME_PRESSURE * WINDOW_US / 100 / AM_LMK_PSI_SOME_US;
+        const double fullPressure = full * FULL_PRESSURE * WINDOW_US / 100 / AM_LMK_PSI_FULL_US;
+        return (int)std::min(100.0, std::max(somePressure, fullPressure));
+    }
+
+private:
+    static const int WINDOW_US = 1000000;
+    static const int SOME_PRESSURE = 70;
+    static const int FULL_PRESSURE = 90;
+
+    const std::string mPath;
+};
+
+/** MemAvailable of /proc/meminfo, it's polled */
+class MeminfoSource : public MemoryPressureSource {
+public:
+    explicit MeminfoSource(const std::string& root) : mPath(root + MEMINFO_FILE) {}
+
+    const char* getName() const override {
+        return "meminfo";
+    }
+
+    bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+               const ReportFunc& report) override {
+        if (getPressure() < 0) {
+            return false;
+        }
+        mTimer.init(looper->get(), [this, report](void*) { report(getPressure()); });
+        mTimer.start(POLL_PERIOD_MS, POLL_PERIOD_MS);
+        return true;
+    }
+
+    int getPressure() override {
+        int64_t total, available;
+        return read(total, available) ? toPressure(available, total) : -1;
+    }
+
+    int bytesToPressure(int64_t freeBytes) const override {
+        int64_t total, available;
+        return read(total, available) ? toPressure(freeBytes / 1024, total) : -1;
+    }
+
+private:
+    bool read(int64_t& totalKb, int64_t& availableKb) const {
+        std::ifstream file(mPath);
+        std::string key;
+        int64_t value;
+        std::string unit;
+        totalKb = availableKb = -1;
+        while (file >> key >> value >> unit) {
+            if (key == "MemTotal:") {
+                totalKb = value;
+            } else if (key == "MemAvailable:") {
+                availableKb = value;
+                break;
+            }
+        }
+        return totalKb > 0 && availableKb >= 0;
+    }
+
+    const std::string mPath;
+    os::app::UvTimer mTimer;
+};
+
+/**
+ * A cgroup v2, the usage against its memory.max or memory.high. Its memory.events tell the
+ * pressure is 80 at least for "high", 90 for "max" and 100 for "oom".
+ */
+class CgroupSource : public TriggeredSource {
+public:
+    explicit CgroupSource(const std::string& dir) : mDir(dir) {}
+
+    const char* getName() const override {
+        return "cgroup";
+    }
+
+    bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+               const ReportFunc& report) override {
+        watch(looper, report);
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0 || inotify_add_watch(fd, (mDir + "/memory.events").c_str(), IN_MODIFY) < 0) {
+            ALOGW("can't watch %s/memory.events", mDir.c_str());
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        readEvents(mEvents);
+        addFd(fd, [this, fd] {
+            char buffer[256];
+            while (::read(fd, buffer, sizeof(buffer)) > 0) {
+            }
+            uint64_t events[EVENT_NUM];
+            readEvents(events);
+            for (int i = EVENT_NUM - 1; i >= 0; i--) {
+                if (events[i] > mEvents[i]) {
+                    std::copy(std::begin(events), std::end(events), std::begin(mEvents));
+                    onTrigger(EVENT_PRESSURE[i]);
+                    return;
+                }
+            }
+        });
+        return true;
+    }
+
+    int getPressure() override {
+        const int64_t limit = getLimit();
+        return limit > 0 ? toPressure(limit - readValue("memory.current"), limit) : -1;
+    }
+
+    int bytesToPressure(int64_t freeBytes) const override {
+        return toPressure(freeBytes, getLimit());
+    }
+
+private:
+    enum { HIGH, MAX, OOM, EVENT_NUM };
+    static constexpr int EVENT_PRESSURE[EVENT_NUM] = {80, 90, 100};
+
+    int64_t readValue(const char* name) const {
+        std::ifstream file(mDir + "/" + name);
+        int64_t value = -1; // "max" is unlimited
+        file >> value;
+        return value;
+    }
+
+    int64_t getLimit() const {
+        const int64_t max = readValue("memory.max");
+        return max > 0 ? max : readValue("memory.high");
+    }
+
+    void readEvents(uint64_t events[EVENT_NUM]) {
+        std::ifstream file(mDir + "/memory.events");
+        std::string key;
+        uint64_t value;
+        std::fill(events, events + EVENT_NUM, 0);
+        while (file >> key >> value) {
+            if (key == "high") {
+                events[HIGH] = value;
+            } else if (key == "max") {
+                events[MAX] = value;
+            } else if (key == "oom") {
+                events[OOM] = value;
+            }
+        }
+    }
+
+    const std::string mDir;
+    uint64_t mEvents[EVENT_NUM] = {0};
+};
+#endif
+
+/** Play a script "MS=PRESSURE,...", the time is from the start */
+class FakeSource : public MemoryPressureSource {
+public:
+    explicit FakeSource(const std::string& script) {
+        std::istringstream steps(script);
+        for (std::string step; std::getline(steps, step, ',');) {
+            uint64_t ms;
+            int pressure;
+            if (sscanf(step.c_str(), "%" SCNu64 "=%d", &ms, &pressure) == 2) {
+                mSteps.emplace_back(ms, std::clamp(pressure, 0, 100));
+            } else {
+                ALOGE("illegal fake pressure step:%s", step.c_str());
+            }
+        }
+        std::stable_sort(mSteps.begin(), mSteps.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+
+    const char* getName() const override {
+        return "fake";
+    }
+
+    bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+               const ReportFunc& report) override {
+        mTimer.init(looper->get(), [this, report](void*) {
+            mPressure = mSteps[mNext].second;
+            report(mPressure);
+            if (++mNext < mSteps.size()) {
+                mTimer.start(mSteps[mNext].first - mSteps[mNext - 1].first);
+            }
+        });
+        if (!mSteps.empty()) {
+            mTimer.start(mSteps[0].first);
+        }
+        return true;
+    }
+
+    int getPressure() override {
+        return mPressure;
+    }
+
+private:
+    std::vector<std::pair<uint64_t, int>> mSteps;
+    size_t mNext = 0;
+    int mPressure = 0;
+    os::app::UvTimer mTimer;
+};
+
+std::unique_ptr<MemoryPressureSource> MemoryPressureSource::create(const std::string& spec,
+                                                                   const std::string& root) {
+    if (spec == "mallinfo") {
+        return std::make_unique<MallinfoSource>();
+    } else if (spec == "procfs") {
+        return std::make_unique<ProcfsSource>(root);
+    } else if (spec.compare(0, 5, "fake:") == 0) {
+        return std::make_unique<FakeSource>(spec.substr(5));
+    }
+#ifndef __NuttX__
+    if (spec == "psi") {
+        return std::make_unique<PsiSource>(root);
+    } else if (spec == "meminfo") {
+        return std::make_unique<MeminfoSource>(root);
+    } else if (spec.compare(0, 7, "cgroup:") == 0) {
+        return std::make_unique<CgroupSource>(root + spec.substr(7));
+    }
+#endif
+    ALOGE("unknown memory pressure source:%s", spec.c_str());
+    return nullptr;
+}
+
+} // namespace am
+} // namespace os
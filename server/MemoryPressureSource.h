@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "app/UvLoop.h"
+
+namespace os {
+namespace am {
+
+/**
+ * MemoryPressureSource: where LowMemoryManager learns the memory pressure from. The pressure is
+ * from 0, plenty of memory, to 100, exhausted, whatever the source is, the LMK thresholds are in
+ * it. The sources:
+ *   procfs         NuttX /proc/pressure/memory, the free memory of the heap
+ *   mallinfo       poll the free memory of the heap, it's the system memory on NuttX
+ *   psi            Linux PSI triggers, the stall time of "some" and "full"
+ *   meminfo        poll MemAvailable of Linux /proc/meminfo
+ *   cgroup:DIR     the usage and memory.events of a Linux cgroup v2
+ *   fake:MS=P,...  play the pressure P at MS after the start, for test
+ */
+class MemoryPressureSource {
+public:
+    using ReportFunc = std::function<void(int pressure)>;
+
+    virtual ~MemoryPressureSource() = default;
+
+    /** nullptr if the source isn't available here, the root of its files is for test */
+    static std::unique_ptr<MemoryPressureSource> create(const std::string& spec,
+                                                        const std::string& root = "");
+
+    virtual const char* getName() const = 0;
+    /**
+     * The pressure is reported when it's changed, or polled. The threshold is where LMK starts to
+     * act, the source that is notified by the kernel is armed with it.
+     */
+    virtual bool start(const std::shared_ptr<os::app::UvLoop>& looper, const int threshold,
+                       const ReportFunc& report) = 0;
+    /** -1 if it's unknown */
+    virtual int getPressure() = 0;
+    /** The free bytes of the legacy lmk.cfg, -1 if the source doesn't count bytes */
+    virtual int bytesToPressure(int64_t freeBytes) const {
+        return -1;
+    }
+};
+
+} // namespace am
+} // namespace os
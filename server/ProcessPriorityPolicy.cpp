@@ -37,7 +37,7 @@ static int calculateScore(PidPriorityInfo* pnode, int& levelCnt, ProcessStatus l
     int score = 1000;
 
     if (location == FOREGROUND_PROCESS) {
-        score = pnode->oomScore > OS_FOREGROUND_APP_ADJ ? OS_FOREGROUND_APP_ADJ : pnode->oomScore;
+        score = pnode->adjScore > OS_FOREGROUND_APP_ADJ ? OS_FOREGROUND_APP_ADJ : pnode->adjScore;
         return score;
     } else if (location == SYSTEM_HOME_PROCESS) {
         if (pnode->priorityLevel < ProcessPriority::PERSISTENT) {
@@ -97,15 +97,115 @@ void ProcessPriorityPolicy::analyseProcessPriority() {
         if (pnode->next == mBackgroundPos && processStatus != FOREGROUND_PROCESS) {
             processStatus = SYSTEM_HOME_PROCESS;
         }
-        const int score = calculateScore(pnode, levelcnt, processStatus);
-        if (pnode->oomScore != score) {
-            pnode->oomScore = score;
-            mLmk->setPidOomScore(pnode->pid, pnode->oomScore);
-        }
+        pnode->adjScore = calculateScore(pnode, levelcnt, processStatus);
         // only one foreground process
         processStatus = BACKGROUND_PROCESS;
         pnode = pnode->next;
     }
+
+    // The provider gets the best score of its clients, repeat until nothing changes for the
+    // provider may be the client of others.
+    std::unordered_map<pid_t, int> scores;
+    for (pnode = mHead; pnode; pnode = pnode->next) {
+        scores[pnode->pid] = pnode->adjScore;
+    }
+    bool isChanged = true;
+    while (isChanged) {
+        isChanged = false;
+        for (pnode = mHead; pnode; pnode = pnode->next) {
+            int& score = scores[pnode->pid];
+            for (const auto& client : pnode->clients) {
+                const auto iter = scores.find(client.first);
+                if (iter != scores.end() && iter->second < score) {
+                    score = iter->second;
+                    isChanged = true;
+                }
+            }
+        }
+    }
+
+    for (pnode = mHead; pnode; pnode = pnode->next) {
+        const int score = scores[pnode->pid];
+        if (pnode->oomScore != score) {
+            setOomScore(pnode, score);
+        }
+    }
+}
+
+void ProcessPriorityPolicy::setOomScore(PidPriorityInfo* pnode, int score) {
+    pnode->oomScore = score;
+    mLmk->setPidOomScore(pnode->pid, score);
+    mCpuClass.apply(pnode->pid, score);
+}
+
+/** The score on the next analyseProcessPriority, only its band is exact */
+int ProcessPriorityPolicy::estimateScore(PidPriorityInfo* pnode) {
+    int levelCnt = 0;
+    const ProcessStatus location = pnode == mHead ? FOREGROUND_PROCESS
+            : pnode->next == mBackgroundPos       ? SYSTEM_HOME_PROCESS
+                                                  : BACKGROUND_PROCESS;
+    int score = calculateScore(pnode, levelCnt, location);
+    for (const auto& client : pnode->clients) {
+        if (const auto clientNode = get(client.first)) {
+            score = clientNode->oomScore < score ? clientNode->oomScore : score;
+        }
+    }
+    return score;
+}
+
+void ProcessPriorityPolicy::updateScore(PidPriorityInfo* pnode) {
+    int score = pnode->adjScore;
+    for (const auto& client : pnode->clients) {
+        if (const auto clientNode = get(client.first)) {
+            score = clientNode->oomScore < score ? clientNode->oomScore : score;
+        }
+    }
+    if (pnode->oomScore != score) {
+        setOomScore(pnode, score);
+        // only the changed score need to be passed on
+        for (const auto provider : pnode->providers) {
+            if (const auto providerNode = get(provider)) {
+                updateScore(providerNode);
+            }
+        }
+    }
+}
+
+void ProcessPriorityPolicy::bindProcess(pid_t clientPid, pid_t providerPid) {
+    PidPriorityInfo* pnode = get(providerPid);
+    // the system and the unknown processes don't promote anything
+    PidPriorityInfo* clientNode = clientPid > 0 ? get(clientPid) : nullptr;
+    if (pnode == nullptr || clientNode == nullptr || clientPid == providerPid) {
+        if (clientPid > 0 && clientPid != providerPid) {
+            ALOGD("bindProcess client:%d provider:%d isn't promoted, %s has no priority",
+                  clientPid, providerPid, pnode ? "the client" : "the provider");
+        }
+        return;
+    }
+    if (++pnode->clients[clientPid] == 1) {
+        clientNode->providers.insert(providerPid);
+    }
+    ALOGD("bindProcess client:%d provider:%d", clientPid, providerPid);
+    updateScore(pnode);
+}
+
+void ProcessPriorityPolicy::unbindProcess(pid_t clientPid, pid_t providerPid) {
+    PidPriorityInfo* pnode = get(providerPid);
+    if (pnode == nullptr) {
+        return;
+    }
+    const auto iter = pnode->clients.find(clientPid);
+    if (iter == pnode->clients.end()) {
+        return;
+    }
+    if (--iter->second <= 0) {
+        pnode->clients.erase(iter);
+        if (const auto clientNode = get(clientPid)) {
+            clientNode->providers.erase(providerPid);
+        }
+    }
+    ALOGD("unbindProcess client:%d provider:%d", clientPid, providerPid);
+    updateScore(pnode);
 }
 
 PidPriorityInfo* ProcessPriorityPolicy::get(pid_t pid) {
@@ -122,8 +222,10 @@ PidPriorityInfo* ProcessPriorityPolicy::get(pid_t pid) {
 PidPriorityInfo* ProcessPriorityPolicy::add(pid_t pid, bool isForeground, ProcessPriority level) {
     PidPriorityInfo* pnode = get(pid);
     if (pnode == nullptr) {
-        pnode = new PidPriorityInfo{pid, level, OS_MIDDLE_LEVEL_MIN_ADJ, clock(), nullptr, nullptr};
+        pnode = new PidPriorityInfo{pid, level, OS_MIDDLE_LEVEL_MIN_ADJ, OS_MIDDLE_LEVEL_MIN_ADJ,
+                                    clock(), nullptr, nullptr, {}, {}};
         mLmk->setPidOomScore(pid, OS_MIDDLE_LEVEL_MIN_ADJ); // set default
+        mCpuClass.apply(pid, OS_MIDDLE_LEVEL_MIN_ADJ);
         if (isForeground) {
             pnode->next = mHead;
             if (mHead) mHead->last = pnode;
@@ -159,6 +261,12 @@ PidPriorityInfo* ProcessPriorityPolicy::add(pid_t pid, bool isForeground, Proces
 void ProcessPriorityPolicy::remove(pid_t pid) {
     PidPriorityInfo* pnode = get(pid);
     if (pnode != nullptr) {
+        const auto providers = std::move(pnode->providers);
+        for (const auto& client : pnode->clients) {
+            if (const auto clientNode = get(client.first)) {
+                clientNode->providers.erase(pid);
+            }
+        }
         if (mHead == pnode) {
             mHead = pnode->next;
         }
@@ -181,6 +289,15 @@ void ProcessPriorityPolicy::remove(pid_t pid) {
         }
 
         delete pnode;
+        mCpuClass.remove(pid);
+
+        // the providers lose a client
+        for (const auto provider : providers) {
+            if (const auto providerNode = get(provider)) {
+                providerNode->clients.erase(pid);
+                updateScore(providerNode);
+            }
+        }
     }
 
     mLmk->cancelMonitorPid(pid);
@@ -210,16 +327,38 @@ void ProcessPriorityPolicy::pushForeground(pid_t pid) {
             mHead = pnode;
         }
         pnode->lastWakeUptime = clock();
+
+        // promote immediately, so do the processes that are serving it
+        if (pnode->adjScore > OS_FOREGROUND_APP_ADJ) {
+            pnode->adjScore = OS_FOREGROUND_APP_ADJ;
+        }
+        updateScore(pnode);
+        // the score may be unchanged if it's demoted by intoBackground only
+        mCpuClass.apply(pid, pnode->oomScore);
+        notifyForegroundChanged(pid, true);
     }
 }
 
+std::vector<pid_t> ProcessPriorityPolicy::getBackgroundPids() const {
+    std::vector<pid_t> pids;
+    for (auto pnode = mBackgroundPos; pnode; pnode = pnode->next) {
+        if (pnode->clients.empty() && pnode->priorityLevel < ProcessPriority::PERSISTENT) {
+            pids.push_back(pnode->pid);
+        }
+    }
+    return pids;
+}
+
+/**
+ * The demotion takes effect on the next analyseProcessPriority, which is run before LMK. The CPU
+ * class doesn't wait for it.
+ */
 void ProcessPriorityPolicy::intoBackground(pid_t pid) {
     PidPriorityInfo* pnode = get(pid);
     if (pnode) {
-        if (pnode != mTail && pnode != mBackgroundPos) {
-            if (mBackgroundPos && mBackgroundPos->last == pnode) {
-                return;
-            }
+        notifyForegroundChanged(pid, false);
+        if (pnode != mTail && pnode != mBackgroundPos &&
+            !(mBackgroundPos && mBackgroundPos->last == pnode)) {
             if (pnode->last) pnode->last->next = pnode->next;
             if (pnode->next) {
                 pnode->next->last = pnode->last;
@@ -240,20 +379,57 @@ void ProcessPriorityPolicy::intoBackground(pid_t pid) {
             }
             mBackgroundPos = pnode;
         }
+        mCpuClass.apply(pid, estimateScore(pnode));
+    }
+}
+
+void ProcessPriorityPolicy::addForegroundChangedCallback(const ForegroundChangedCB& callback) {
+    mForegroundChangedCallbacks.push_back(callback);
+}
+
+void ProcessPriorityPolicy::notifyForegroundChanged(pid_t pid, bool isForeground) {
+    for (auto& callback : mForegroundChangedCallbacks) {
+        callback(pid, isForeground);
     }
 }
 
 std::ostream& operator<<(std::ostream& os, ProcessPriorityPolicy& policy) {
     policy.analyseProcessPriority();
     PidPriorityInfo* pnode = policy.mHead;
-    os << "\n\nProcess priority OomAdjScore: (pid, score)" << std::endl;
+    os << "\n\nProcess priority OomAdjScore: (pid, score)<-[clients]" << std::endl;
     while (pnode) {
-        os << "(" << pnode->pid << "," << pnode->oomScore << ") ";
+        os << "(" << pnode->pid << "," << pnode->oomScore << ")";
+        if (!pnode->clients.empty()) {
+            os << "<-[";
+            for (const auto& client : pnode->clients) {
+                os << " " << client.first;
+            }
+            os << " ]";
+        }
+        os << " ";
         pnode = pnode->next;
     }
-    os << std::endl;
+    os << std::endl << policy.mCpuClass;
     return os;
 }
 
+void ProcessPriorityPolicy::dumpJson(JsonWriter& writer) {
+    analyseProcessPriority();
+    writer.beginArray("priority");
+    for (PidPriorityInfo* pnode = mHead; pnode; pnode = pnode->next) {
+        writer.beginObject()
+                .field("pid", pnode->pid)
+                .field("oomScore", pnode->oomScore)
+                .field("adjScore", pnode->adjScore);
+        writer.beginArray("clients");
+        for (const auto& client : pnode->clients) {
+            writer.field(nullptr, client.first);
+        }
+        writer.endArray().endObject();
+    }
+    writer.endArray();
+    mCpuClass.dumpJson(writer);
+}
+
 } // namespace am
 } // namespace os
@@ -20,10 +20,15 @@
 #include <sys/types.h>
 #include <time.h>
 
+#include <functional>
 #include <iostream>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "CpuClassPolicy.h"
+#include "DumpWriter.h"
 #include "LowMemoryManager.h"
 
 namespace os {
@@ -48,11 +53,17 @@ using os::pm::ProcessPriority;
 struct PidPriorityInfo {
     pid_t pid;
     ProcessPriority priorityLevel;
-    int oomScore;
+    int oomScore; // effective score that reported to lmk
+    int adjScore; // the process own score, without the promotion from its clients
     clock_t lastWakeUptime;
 
     PidPriorityInfo* next;
     PidPriorityInfo* last;
+
+    // the processes that use this process(bind service, wait for activity result), and the count
+    std::unordered_map<pid_t, int> clients;
+    // the processes that this process is using
+    std::unordered_set<pid_t> providers;
 };
 
 /*********************************************
@@ -64,6 +75,7 @@ struct PidPriorityInfo {
  *********************************************/
 class ProcessPriorityPolicy {
 public:
+    using ForegroundChangedCB = std::function<void(pid_t, bool isForeground)>;
     ProcessPriorityPolicy(LowMemoryManager* lmk);
     ~ProcessPriorityPolicy();
 
@@ -73,16 +85,34 @@ public:
     void remove(pid_t pid);
     void pushForeground(pid_t pid);
     void intoBackground(pid_t pid);
+    /** The background processes that nobody is using */
+    std::vector<pid_t> getBackgroundPids() const;
+
+    /** The provider process is at least as important as the client that is using it */
+    void bindProcess(pid_t clientPid, pid_t providerPid);
+    void unbindProcess(pid_t clientPid, pid_t providerPid);
 
     void analyseProcessPriority();
+    void addForegroundChangedCallback(const ForegroundChangedCB& callback);
+    CpuClassPolicy& getCpuClassPolicy() {
+        return mCpuClass;
+    }
 
     friend std::ostream& operator<<(std::ostream& os, ProcessPriorityPolicy& policy);
+    void dumpJson(JsonWriter& writer);
 
 private:
+    void updateScore(PidPriorityInfo* pnode);
+    void setOomScore(PidPriorityInfo* pnode, int score);
+    int estimateScore(PidPriorityInfo* pnode);
+    void notifyForegroundChanged(pid_t pid, bool isForeground);
+
     LowMemoryManager* mLmk;
     PidPriorityInfo* mHead;
     PidPriorityInfo* mTail;
     PidPriorityInfo* mBackgroundPos;
+    std::vector<ForegroundChangedCB> mForegroundChangedCallbacks;
+    CpuClassPolicy mCpuClass;
 };
 
 } // namespace am
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SchedLevel.h"
+
+#include <errno.h>
+#include <sched.h>
+
+#include <algorithm>
+
+#ifndef __NuttX__
+#include <sys/resource.h>
+#endif
+
+namespace os {
+namespace am {
+
+#ifdef __NuttX__
+const static int MIN_LEVEL = SCHED_PRIORITY_MIN + 1;
+const static int MAX_LEVEL = SCHED_PRIORITY_MAX - 1;
+
+bool getSchedLevel(pid_t pid, int& level) {
+    struct sched_param param;
+    if (sched_getparam(pid, &param) != 0) {
+        return false;
+    }
+    level = param.sched_priority;
+    return true;
+}
+
+bool setSchedLevel(pid_t pid, int level) {
+    struct sched_param param;
+    param.sched_priority = level;
+    return sched_setparam(pid, &param) == 0;
+}
+
+int configToSchedLevel(int value) {
+    return clampSchedLevel(value);
+}
+
+bool canRaiseSchedLevel() {
+    return true;
+}
+#else
+const static int MIN_LEVEL = -19;
+const static int MAX_LEVEL = 20;
+
+bool getSchedLevel(pid_t pid, int& level) {
+    errno = 0;
+    const int nice = getpriority(PRIO_PROCESS, pid);
+    if (nice == -1 && errno != 0) {
+        return false;
+    }
+    level = -nice;
+    return true;
+}
+
+bool setSchedLevel(pid_t pid, int level) {
+    return setpriority(PRIO_PROCESS, pid, -level) == 0;
+}
+
+int configToSchedLevel(int value) {
+    return clampSchedLevel(-value);
+}
+
+bool canRaiseSchedLevel() {
+    int level;
+    if (!getSchedLevel(0, level) || level >= MAX_LEVEL || !setSchedLevel(0, level + 1)) {
+        return false;
+    }
+    setSchedLevel(0, level);
+    return true;
+}
+#endif
+
+int clampSchedLevel(int level) {
+    return std::clamp(level, MIN_LEVEL, MAX_LEVEL);
+}
+
+} // namespace am
+} // namespace os
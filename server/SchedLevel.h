@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+namespace os {
+namespace am {
+
+/**
+ * The scheduling level of a process, the larger the more important whatever the backend is.
+ * It's the sched_priority on NuttX, and the negative nice value on Linux where raising the level
+ * needs CAP_SYS_NICE. The pid 0 is the calling thread.
+ */
+int clampSchedLevel(int level);
+bool getSchedLevel(pid_t pid, int& level);
+bool setSchedLevel(pid_t pid, int level);
+/** The configured value is the sched_priority on NuttX, the nice value on Linux */
+int configToSchedLevel(int value);
+/** Whether a lowered level can be restored */
+bool canRaiseSchedLevel();
+
+} // namespace am
+} // namespace os
@@ -18,84 +18,216 @@
 
 #include <binder/IInterface.h>
 
+#include <algorithm>
 #include <optional>
 
 #include "AppRecord.h"
 
+#ifdef CONFIG_AM_SERVICE_START_BATCH
+#define AM_SERVICE_START_BATCH CONFIG_AM_SERVICE_START_BATCH
+#else
+#define AM_SERVICE_START_BATCH 32
+#endif
+
 namespace os {
 namespace am {
 
 using std::string;
 
+/** Unbind the connection of a dead client */
+class ConnectionDeathRecipient : public IBinder::DeathRecipient {
+public:
+    ConnectionDeathRecipient(const std::weak_ptr<ServiceRecord>& service, const IBinder* connection)
+          : mService(service), mConnection(connection) {}
+
+    void binderDied(const android::wp<IBinder>& who) override {
+        if (const auto service = mService.lock()) {
+            service->onConnectionDied(mConnection);
+        }
+    }
+
+private:
+    std::weak_ptr<ServiceRecord> mService;
+    const IBinder* mConnection;
+};
+
 void ServiceRecord::start(const Intent& intent) {
     if (auto appRecord = mApp.lock()) {
         mStartFlag |= F_STARTED;
         appRecord->addService(shared_from_this());
-        appRecord->mAppThread->scheduleStartService(mServiceName, mToken, intent);
+        mStartRequests++;
+        if (mIsStartPending) {
+            if (mStartMode == START_LATEST) {
+                mPendingIntents.clear();
+            } else if (mPendingIntents.size() >= AM_SERVICE_START_BATCH) {
+                // the service doesn't report its start, the oldest of the batch is dropped
+                if (mStartDrops++ == 0) {
+                    ALOGW("Service:%s is busy, the start commands are dropped",
+                          mServiceName.c_str());
+                }
+                mPendingIntents.erase(mPendingIntents.begin());
+            }
+            mPendingIntents.push_back(intent);
+            return;
+        }
+        deliverStart(appRecord, {intent});
     }
 }
 
-void ServiceRecord::stop() {
-    for (auto iter : mConnectRecord) {
-        iter->onServiceDisconnected(mServiceBinder);
+void ServiceRecord::onStarted() {
+    mIsStartPending = false;
+    if (mPendingIntents.empty()) {
+        return;
     }
     if (auto appRecord = mApp.lock()) {
-        appRecord->deleteService(shared_from_this());
-        appRecord->mAppThread->scheduleStopService(mToken);
+        const auto intents = std::move(mPendingIntents);
+        mPendingIntents.clear();
+        deliverStart(appRecord, intents);
     }
 }
 
-void ServiceRecord::bind(const sp<IBinder>& caller, const sp<IServiceConnection>& conn,
-                         const Intent& intent) {
-    if (auto appRecord = mApp.lock()) {
-        if (mStartFlag == F_UNKNOW) {
-            appRecord->addService(shared_from_this());
-        }
-        mStartFlag |= F_BINDED;
-        if (mServiceBinder) {
-            conn->onServiceConnected(mServiceBinder);
+void ServiceRecord::deliverStart(const std::shared_ptr<AppRecord>& appRecord,
+                                 const std::vector<Intent>& intents) {
+    mIsStartPending = mStartMode != START_DIRECT;
+    mStartDeliveries++;
+    appRecord->post([app = appRecord->mAppThread, name = mServiceName, token = mToken, intents] {
+        if (intents.size() == 1) {
+            app->scheduleStartService(name, token, intents[0]);
         } else {
-            appRecord->mAppThread->scheduleBindService(mServiceName, mToken, intent, conn);
+            app->scheduleStartServiceBatch(name, token, intents);
         }
-        bool isExist = false;
-        for (auto iter : mConnectRecord) {
-            if (android::IInterface::asBinder(iter) == android::IInterface::asBinder(conn)) {
-                isExist = true;
-                break;
-            }
+    });
+}
+
+void ServiceRecord::stop() {
+    mPendingIntents.clear();
+    clearConnections();
+    if (auto appRecord = mApp.lock()) {
+        appRecord->deleteService(shared_from_this());
+        appRecord->post([app = appRecord->mAppThread, token = mToken] {
+            app->scheduleStopService(token);
+        });
+    }
+}
+
+void ServiceRecord::bind(const sp<IBinder>& caller, const sp<IServiceConnection>& conn,
+                         const Intent& intent, const int callerPid) {
+    auto appRecord = mApp.lock();
+    if (!appRecord) {
+        return;
+    }
+    if (mStartFlag == F_UNKNOW) {
+        appRecord->addService(shared_from_this());
+    }
+    mStartFlag |= F_BINDED;
+
+    const sp<IBinder> binder = android::IInterface::asBinder(conn);
+    const bool isExist = std::any_of(mConnectRecord.begin(), mConnectRecord.end(),
+                                     [&binder](const ConnectionRecord& record) {
+                                         return android::IInterface::asBinder(record.conn) ==
+                                                 binder;
+                                     });
+    if (!isExist) {
+        sp<IBinder::DeathRecipient> recipient(
+                new ConnectionDeathRecipient(weak_from_this(), binder.get()));
+        if (binder->linkToDeath(recipient) != android::OK) {
+            recipient = nullptr;
         }
-        if (!isExist) mConnectRecord.emplace_back(conn);
+        mConnectRecord.push_back({conn, callerPid, recipient});
+        appRecord->mPriorityPolicy->bindProcess(callerPid, appRecord->mPid);
+    }
+
+    switch (mBindState) {
+        case BIND_NONE:
+            mBindState = BIND_REQUESTED;
+            appRecord->post([app = appRecord->mAppThread, name = mServiceName, token = mToken,
+                             intent, conn] {
+                app->scheduleBindService(name, token, intent, conn);
+            });
+            break;
+        case BIND_REQUESTED:
+            // it's connected when the service publishes
+            break;
+        case BIND_PUBLISHED:
+            connect(conn);
+            break;
+    }
+}
+
+void ServiceRecord::publish(const sp<IBinder>& serviceBinder) {
+    if (mBindState != BIND_REQUESTED) {
+        // all the connections were gone before onBind returned
+        ALOGW("Service:%s isn't waiting for the binder", mServiceName.c_str());
+        return;
+    }
+    mServiceBinder = serviceBinder;
+    mBindState = BIND_PUBLISHED;
+    for (const auto& iter : mConnectRecord) {
+        connect(iter.conn);
+    }
+}
+
+void ServiceRecord::connect(const sp<IServiceConnection>& conn) {
+    // IServiceConnection is oneway, the slow client doesn't block the others
+    if (mServiceBinder) {
+        conn->onServiceConnected(mServiceBinder);
+    } else {
+        ALOGW("Service:%s is bound with a null binder", mServiceName.c_str());
     }
 }
 
 void ServiceRecord::unbind(const sp<IServiceConnection>& conn) {
-    if (mStartFlag & F_BINDED) {
+    const auto binder = android::IInterface::asBinder(conn);
+    const auto it = std::find_if(mConnectRecord.begin(), mConnectRecord.end(),
+                                 [&binder](const ConnectionRecord& record) {
+                                     return android::IInterface::asBinder(record.conn) == binder;
+                                 });
+    if (it != mConnectRecord.end()) {
         conn->onServiceDisconnected(mServiceBinder);
-        const int size = mConnectRecord.size();
-        for (int i = 0; i < size; ++i) {
-            if (android::IInterface::asBinder(mConnectRecord[i]) ==
-                android::IInterface::asBinder(conn)) {
-                mConnectRecord[i] = mConnectRecord[size - 1];
-                mConnectRecord.pop_back();
-                break;
-            }
+        removeConnection(it);
+    }
+}
+
+void ServiceRecord::onConnectionDied(const IBinder* connection) {
+    const auto it = std::find_if(mConnectRecord.begin(), mConnectRecord.end(),
+                                 [connection](const ConnectionRecord& record) {
+                                     return android::IInterface::asBinder(record.conn).get() ==
+                                             connection;
+                                 });
+    if (it != mConnectRecord.end()) {
+        ALOGW("the connection of Service:%s is dead, pid:%d", mServiceName.c_str(),
+              it->callerPid);
+        removeConnection(it);
+    }
+}
+
+void ServiceRecord::removeConnection(const std::vector<ConnectionRecord>::iterator& it) {
+    const int callerPid = it->callerPid;
+    if (it->recipient) {
+        android::IInterface::asBinder(it->conn)->unlinkToDeath(it->recipient);
+    }
+    *it = mConnectRecord.back();
+    mConnectRecord.pop_back();
+    if (auto appRecord = mApp.lock()) {
+        appRecord->mPriorityPolicy->unbindProcess(callerPid, appRecord->mPid);
+        if (mConnectRecord.empty()) {
+            // the service unbinds, the next bind asks it again
+            mStartFlag &= ~F_BINDED;
+            mBindState = BIND_NONE;
+            mServiceBinder = nullptr;
+            appRecord->post([app = appRecord->mAppThread, token = mToken] {
+                app->scheduleUnbindService(token);
+            });
         }
-        if (auto appRecord = mApp.lock()) {
-            if (mConnectRecord.empty()) {
-                mStartFlag &= ~F_BINDED;
-                appRecord->mAppThread->scheduleUnbindService(mToken);
-            }
-            if (mStartFlag == F_UNKNOW) {
-                appRecord->deleteService(shared_from_this());
-            }
+        if (mStartFlag == F_UNKNOW) {
+            appRecord->deleteService(shared_from_this());
         }
     }
 }
 
 void ServiceRecord::abnormalExit() {
-    for (auto iter : mConnectRecord) {
-        iter->onServiceDisconnected(mServiceBinder);
-    }
+    mPendingIntents.clear();
+    clearConnections();
     if (auto appRecord = mApp.lock()) {
         ALOGW("Service:%s/%s abnormal exit!", mApp.lock()->mPackageName.c_str(),
               mServiceName.c_str());
@@ -103,6 +235,22 @@ void ServiceRecord::abnormalExit() {
     }
 }
 
+void ServiceRecord::clearConnections() {
+    const auto appRecord = mApp.lock();
+    for (auto& iter : mConnectRecord) {
+        if (iter.recipient) {
+            android::IInterface::asBinder(iter.conn)->unlinkToDeath(iter.recipient);
+        }
+        iter.conn->onServiceDisconnected(mServiceBinder);
+        if (appRecord) {
+            appRecord->mPriorityPolicy->unbindProcess(iter.callerPid, appRecord->mPid);
+        }
+    }
+    mConnectRecord.clear();
+    mBindState = BIND_NONE;
+    mServiceBinder = nullptr;
+}
+
 bool ServiceRecord::isAlive() {
     return mStartFlag != F_UNKNOW;
 }
@@ -144,6 +292,26 @@ const char* ServiceRecord::statusToStr(const int status) {
     }
 }
 
+ServiceRecord::StartMode ServiceRecord::startModeFromStr(const string& mode) {
+    if (mode == "latest") {
+        return START_LATEST;
+    } else if (mode == "append") {
+        return START_APPEND;
+    }
+    return START_DIRECT;
+}
+
+const char* ServiceRecord::startModeToStr(const StartMode mode) {
+    switch (mode) {
+        case START_LATEST:
+            return "latest";
+        case START_APPEND:
+            return "append";
+        default:
+            return "direct";
+    }
+}
+
 ServiceHandler ServiceList::findService(const string& packageName, const string& serviceName) {
     for (auto it : mServiceList) {
         if (it->mServiceName == serviceName) {
@@ -194,10 +362,38 @@ std::ostream& operator<<(std::ostream& os, const ServiceList& services) {
            << serviceRecord->getPid() << " ]" << " |"
            << ((serviceRecord->mStartFlag & ServiceRecord::F_STARTED) ? "start|" : "")
            << ((serviceRecord->mStartFlag & ServiceRecord::F_BINDED) ? "binded|" : "") << " ["
-           << ServiceRecord::statusToStr(serviceRecord->mStatus) << "]" << std::endl;
+           << ServiceRecord::statusToStr(serviceRecord->mStatus) << "]";
+        if (serviceRecord->mStartMode != ServiceRecord::START_DIRECT) {
+            // the start requests per delivered start command
+            os << " coalesce:" << ServiceRecord::startModeToStr(serviceRecord->mStartMode) << " "
+               << serviceRecord->mStartRequests << "/" << serviceRecord->mStartDeliveries
+               << " dropped:" << serviceRecord->mStartDrops;
+        }
+        os << std::endl;
     }
     return os;
 }
 
+void ServiceList::dumpJson(JsonWriter& writer) const {
+    writer.beginArray("services");
+    for (const auto& serviceRecord : mServiceList) {
+        if (serviceRecord->getPackageName() == nullptr) continue;
+        writer.beginObject()
+                .field("package", *serviceRecord->getPackageName())
+                .field("name", serviceRecord->mServiceName)
+                .field("pid", serviceRecord->getPid())
+                .field("started", (serviceRecord->mStartFlag & ServiceRecord::F_STARTED) != 0)
+                .field("binded", (serviceRecord->mStartFlag & ServiceRecord::F_BINDED) != 0)
+                .field("connections", serviceRecord->mConnectRecord.size())
+                .field("status", ServiceRecord::statusToStr(serviceRecord->mStatus))
+                .field("startMode", ServiceRecord::startModeToStr(serviceRecord->mStartMode))
+                .field("startRequests", serviceRecord->mStartRequests)
+                .field("startDeliveries", serviceRecord->mStartDeliveries)
+                .field("startDrops", serviceRecord->mStartDrops)
+                .endObject();
+    }
+    writer.endArray();
+}
+
 } // namespace am
 } // namespace os
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "DumpWriter.h"
 #include "TaskBoard.h"
 #include "app/Intent.h"
 #include "os/app/IServiceConnection.h"
@@ -55,37 +56,94 @@ public:
         F_STARTED = 0b1,
         F_BINDED = 0b10,
     };
+    /**
+     * How the start commands reach the service. A coalescing service has at most one start
+     * in flight, the intents that come meanwhile are merged and delivered together when the
+     * service reports it's started.
+     */
+    enum StartMode {
+        START_DIRECT = 0, // every start is a scheduleStartService
+        START_LATEST,     // only the latest of the merged intents is delivered
+        START_APPEND,     // all the merged intents are delivered in order as a batch
+    };
+    /**
+     * The service is asked to bind once for all the connections. The connections wait for its
+     * binder until it's published, then they are connected at once; the later ones are
+     * connected with the published binder directly.
+     */
+    enum BindState {
+        BIND_NONE = 0,  // not bound, or all the connections are gone
+        BIND_REQUESTED, // all the connections are pending
+        BIND_PUBLISHED,
+    };
 
     ServiceRecord(const std::string& name, const sp<IBinder>& token, const ProcessPriority priority,
-                  const std::shared_ptr<AppRecord>& appRecord)
+                  const std::shared_ptr<AppRecord>& appRecord,
+                  const StartMode startMode = START_DIRECT)
           : mServiceName(name),
             mToken(token),
             mServiceBinder(nullptr),
+            mBindState(BIND_NONE),
             mStatus(CREATING),
             mStartFlag(F_UNKNOW),
             mPriority(priority),
-            mApp(appRecord) {}
+            mApp(appRecord),
+            mStartMode(startMode),
+            mIsStartPending(false),
+            mStartRequests(0),
+            mStartDeliveries(0),
+            mStartDrops(0) {}
+
+    struct ConnectionRecord {
+        sp<IServiceConnection> conn;
+        int callerPid; // the client process, it keeps the service process alive, 0 if none
+        sp<IBinder::DeathRecipient> recipient; // null if the connection can't be linked
+    };
 
     void start(const Intent& intent);
+    /** The service reported STARTED, the merged intents are delivered now */
+    void onStarted();
     void stop();
-    void bind(const sp<IBinder>& caller, const sp<IServiceConnection>& conn, const Intent& intent);
+    void bind(const sp<IBinder>& caller, const sp<IServiceConnection>& conn, const Intent& intent,
+              const int callerPid);
     void unbind(const sp<IServiceConnection>& conn);
+    /** The service published its binder for the bind request */
+    void publish(const sp<IBinder>& serviceBinder);
+    /** The client of the connection is dead, it's unbound without any callback */
+    void onConnectionDied(const IBinder* connection);
 
     void abnormalExit();
     const std::string* getPackageName() const;
-    int getPid() const; 
+    int getPid() const;
     bool isAlive();
     static const char* statusToStr(int status);
+    /** The "startMode" of the service in the manifest: "latest", "append" or none */
+    static StartMode startModeFromStr(const std::string& mode);
+    static const char* startModeToStr(const StartMode mode);
+
+private:
+    void clearConnections();
+    void connect(const sp<IServiceConnection>& conn);
+    void removeConnection(const std::vector<ConnectionRecord>::iterator& it);
+    void deliverStart(const std::shared_ptr<AppRecord>& appRecord,
+                      const std::vector<Intent>& intents);
 
 public:
     const std::string mServiceName;
     sp<IBinder> mToken;
     sp<IBinder> mServiceBinder;
-    std::vector<sp<IServiceConnection>> mConnectRecord;
+    std::vector<ConnectionRecord> mConnectRecord;
+    BindState mBindState;
     int mStatus;
     int mStartFlag; // started or binded
     ProcessPriority mPriority;
     std::weak_ptr<AppRecord> mApp;
+    const StartMode mStartMode;
+    bool mIsStartPending;                // a start is delivered, the service hasn't reported it
+    std::vector<Intent> mPendingIntents; // merged while a start is pending
+    uint32_t mStartRequests;
+    uint32_t mStartDeliveries; // the ratio of the requests to it is the coalescing ratio
+    uint32_t mStartDrops;      // dropped from a full batch
 };
 
 using ServiceHandler = std::shared_ptr<ServiceRecord>;
@@ -99,6 +157,7 @@ public:
     void unbindConnection(const sp<IServiceConnection>& conn);
 
     friend std::ostream& operator<<(std::ostream& os, const ServiceList& services);
+    void dumpJson(JsonWriter& writer) const;
 
 private:
     std::vector<ServiceHandler> mServiceList;
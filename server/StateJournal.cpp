@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "StateJournal"
+
+#include "StateJournal.h"
+
+#ifdef CONFIG_AM_STATE_JOURNAL
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "app/Logger.h"
+
+namespace os {
+namespace am {
+
+static const uint32_t JOURNAL_MAGIC = 0x4a534d41; // "AMSJ"
+static const uint32_t JOURNAL_VERSION = 2;
+
+// the records are in one of the two regions after the header, the cursor of the header holds
+// the region in the top bit and the bytes of the records in it
+static const uint32_t CURSOR_REGION = 0x80000000;
+static const uint32_t CURSOR_USED = ~CURSOR_REGION;
+
+struct StateJournal::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity; // the size of the file
+    uint32_t cursor;
+};
+
+// the record is {uint16_t type, uint16_t size, payload}
+static const size_t RECORD_HEAD_SIZE = 2 * sizeof(uint16_t);
+
+class StateJournal::Writer {
+public:
+    explicit Writer(const RecordType type) {
+        put16(type);
+        put16(0);
+    }
+
+    Writer& put(const uint32_t value) {
+        mData.append((const char*)&value, sizeof(value));
+        return *this;
+    }
+    Writer& put(const std::string& value) {
+        put16(value.size());
+        mData.append(value);
+        return *this;
+    }
+
+    /** Fill the payload size in the head, false if the payload is too large for it */
+    bool finish() {
+        if (mData.size() - RECORD_HEAD_SIZE > UINT16_MAX) {
+            return false;
+        }
+        const uint16_t size = mData.size() - RECORD_HEAD_SIZE;
+        memcpy(&mData[sizeof(uint16_t)], &size, sizeof(size));
+        return true;
+    }
+    const std::string& data() const {
+        return mData;
+    }
+
+private:
+    void put16(const uint16_t value) {
+        mData.append((const char*)&value, sizeof(value));
+    }
+
+    std::string mData;
+};
+
+class StateJournal::Reader {
+public:
+    Reader(const uint8_t* data, const size_t size) : mData(data), mSize(size), mPos(0) {}
+
+    uint32_t get() {
+        uint32_t value = 0;
+        read(&value, sizeof(value));
+        return value;
+    }
+    std::string getString() {
+        uint16_t size = 0;
+        read(&size, sizeof(size));
+        if (mPos + size > mSize) {
+            mPos = mSize + 1;
+            return "";
+        }
+        std::string value((const char*)mData + mPos, size);
+        mPos += size;
+        return value;
+    }
+    bool isValid() const {
+        return mPos <= mSize;
+    }
+
+private:
+    void read(void* value, const size_t size) {
+        if (mPos + size <= mSize) {
+            memcpy(value, mData + mPos, size);
+        }
+        mPos += size;
+    }
+
+    const uint8_t* mData;
+    const size_t mSize;
+    size_t mPos;
+};
+
+StateJournal::StateJournal()
+      : mHeader(nullptr), mCapacity(0), mRegionSize(0), mFd(-1), mNextId(1), mHomeTaskId(0) {}
+
+StateJournal::~StateJournal() {
+    close();
+}
+
+bool StateJournal::open(const char* path, const size_t capacity) {
+    close();
+    if (capacity <= sizeof(Header) + 2 * RECORD_HEAD_SIZE) {
+        return false;
+    }
+    mFd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (mFd < 0) {
+        ALOGE("open journal:%s failure:%d", path, errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(mFd, &st) != 0 || (st.st_size != (off_t)capacity && ftruncate(mFd, capacity) != 0)) {
+        ALOGE("resize journal:%s failure:%d", path, errno);
+        close();
+        return false;
+    }
+    void* addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (addr == MAP_FAILED) {
+        ALOGE("mmap journal:%s failure:%d", path, errno);
+        close();
+        return false;
+    }
+    mHeader = (Header*)addr;
+    mCapacity = capacity;
+    mRegionSize = (capacity - sizeof(Header)) / 2;
+    if (mHeader->magic != JOURNAL_MAGIC || mHeader->version != JOURNAL_VERSION ||
+        mHeader->capacity != capacity || (mHeader->cursor & CURSOR_USED) > mRegionSize) {
+        // nothing is left by the last run, or it can't be trusted
+        mHeader->cursor = 0;
+        mHeader->capacity = capacity;
+        mHeader->version = JOURNAL_VERSION;
+        mHeader->magic = JOURNAL_MAGIC;
+    }
+    return true;
+}
+
+void StateJournal::close() {
+    if (mHeader) {
+        munmap(mHeader, mCapacity);
+        mHeader = nullptr;
+    }
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+    mNextId = 1;
+    mIds.clear();
+    mTaskOrder.clear();
+    mHomeTaskId = 0;
+}
+
+void StateJournal::recover(RecoveredState& state) {
+    if (!mHeader) {
+        return;
+    }
+    replay(state);
+    // the new ids never collide with the recovered ones
+    uint32_t maxId = state.homeTaskId;
+    for (const auto id : state.taskOrder) {
+        maxId = std::max(maxId, id);
+    }
+    for (const auto& [pid, app] : state.apps) {
+        for (const auto& activity : app.activities) {
+            maxId = std::max({maxId, activity.id, activity.taskId});
+        }
+        for (const auto& service : app.services) {
+            maxId = std::max(maxId, service.id);
+        }
+    }
+    mNextId = maxId + 1;
+}
+
+void StateJournal::reset(const RecoveredState& state) {
+    if (mHeader && !writeState(state)) {
+        disable();
+    }
+}
+
+uint32_t StateJournal::getId(const void* object) const {
+    const auto it = mIds.find(object);
+    return it != mIds.end() ? it->second : 0;
+}
+
+void StateJournal::bindId(const void* object, const uint32_t id) {
+    mIds[object] = id;
+}
+
+uint32_t StateJournal::assignId(const void* object, const bool isNew) {
+    // the address of a new token may be reused from the one that has gone with its process
+    auto& id = mIds[object];
+    if (id == 0 || isNew) {
+        id = mNextId++;
+    }
+    return id;
+}
+
+void StateJournal::forgetId(const void* object) {
+    mIds.erase(object);
+}
+
+void StateJournal::appAttached(const pid_t pid, const int uid, const bool isSystemUI,
+                               const std::string& packageName) {
+    append(Writer(APP_ATTACHED).put(pid).put(uid).put(isSystemUI).put(packageName));
+}
+
+void StateJournal::appExited(const pid_t pid) {
+    append(Writer(APP_EXITED).put(pid));
+}
+
+void StateJournal::priorityChanged(const pid_t pid, const int priority) {
+    append(Writer(PRIORITY).put(pid).put(priority));
+}
+
+void StateJournal::activityAdded(const pid_t pid, const void* token, const void* task,
+                                 const std::string& taskTag, const int launchMode,
+                                 const std::string& name) {
+    if (!mHeader) {
+        return;
+    }
+    const uint32_t id = assignId(token, true);
+    const uint32_t taskId = assignId(task, false);
+    append(Writer(ACTIVITY_ADDED).put(id).put(pid).put(taskId).put(launchMode).put(taskTag).put(
+            name));
+}
+
+void StateJournal::activityStatus(const void* token, const int status) {
+    if (const uint32_t id = getId(token)) {
+        append(Writer(ACTIVITY_STATUS).put(id).put(status));
+    }
+}
+
+void StateJournal::activityRemoved(const void* token) {
+    if (const uint32_t id = getId(token)) {
+        append(Writer(ACTIVITY_REMOVED).put(id));
+        forgetId(token);
+    }
+}
+
+void StateJournal::serviceAdded(const pid_t pid, const void* token, const int priority,
+                                const std::string& name) {
+    if (!mHeader) {
+        return;
+    }
+    append(Writer(SERVICE_ADDED).put(assignId(token, true)).put(pid).put(priority).put(name));
+}
+
+void StateJournal::serviceStatus(const void* token, const int status, const int startFlag) {
+    if (const uint32_t id = getId(token)) {
+        append(Writer(SERVICE_STATUS).put(id).put(status).put(startFlag));
+    }
+}
+
+void StateJournal::serviceRemoved(const void* token) {
+    if (const uint32_t id = getId(token)) {
+        append(Writer(SERVICE_REMOVED).put(id));
+        forgetId(token);
+    }
+}
+
+void StateJournal::taskOrder(const std::vector<const void*>& tasks, const void* homeTask) {
+    if (!mHeader) {
+        return;
+    }
+    std::vector<uint32_t> order;
+    for (const auto task : tasks) {
+        if (const uint32_t id = getId(task)) {
+            order.push_back(id);
+        }
+    }
+    const uint32_t homeTaskId = getId(homeTask);
+    if (order == mTaskOrder && homeTaskId == mHomeTaskId) {
+        return;
+    }
+    mTaskOrder = order;
+    mHomeTaskId = homeTaskId;
+    Writer record(TASK_ORDER);
+    record.put(homeTaskId).put(order.size());
+    for (const auto id : order) {
+        record.put(id);
+    }
+    append(record);
+}
+
+void StateJournal::append(Writer& record) {
+    if (!mHeader) {
+        return;
+    }
+    if (!record.finish()) {
+        ALOGE("the journal record of %zu bytes is too large", record.data().size());
+        disable();
+        return;
+    }
+    if (!write(record.data()) && (!compact() || !write(record.data()))) {
+        ALOGE("the journal is too small for the state");
+        disable();
+    }
+}
+
+bool StateJournal::write(const std::string& data) {
+    const uint32_t cursor = mHeader->cursor;
+    const size_t used = cursor & CURSOR_USED;
+    if (used + data.size() > mRegionSize) {
+        return false;
+    }
+    memcpy(region(cursor) + used, data.data(), data.size());
+    // the record is visible after it's completely written
+    __atomic_store_n(&mHeader->cursor, cursor + data.size(), __ATOMIC_RELEASE);
+    return true;
+}
+
+uint8_t* StateJournal::region(const uint32_t cursor) const {
+    return (uint8_t*)(mHeader + 1) + (cursor & CURSOR_REGION ? mRegionSize : 0);
+}
+
+void StateJournal::disable() {
+    // the state can't be recorded completely, it must not be adopted
+    ALOGE("the journal is disabled");
+    mHeader->magic = 0;
+    close();
+}
+
+bool StateJournal::compact() {
+    RecoveredState state;
+    replay(state);
+
+    std::unordered_set<uint32_t> liveIds;
+    for (const auto& [pid, app] : state.apps) {
+        for (const auto& activity : app.activities) {
+            liveIds.insert(activity.id);
+            liveIds.insert(activity.taskId);
+        }
+        for (const auto& service : app.services) {
+            liveIds.insert(service.id);
+        }
+    }
+    for (auto it = mIds.begin(); it != mIds.end();) {
+        it = liveIds.count(it->second) ? std::next(it) : mIds.erase(it);
+    }
+    ALOGI("compact the journal, %zu bytes are used", (size_t)(mHeader->cursor & CURSOR_USED));
+    return writeState(state);
+}
+
+bool StateJournal::writeState(const RecoveredState& state) {
+    std::string snapshot;
+    bool isValid = true;
+    const auto add = [&snapshot, &isValid](Writer& record) {
+        isValid = isValid && record.finish();
+        snapshot += record.data();
+    };
+    for (const auto& [pid, app] : state.apps) {
+        add(Writer(APP_ATTACHED).put(pid).put(app.uid).put(app.isSystemUI).put(app.packageName));
+        if (app.priority >= 0) {
+            add(Writer(PRIORITY).put(pid).put(app.priority));
+        }
+        for (const auto& activity : app.activities) {
+            add(Writer(ACTIVITY_ADDED)
+                        .put(activity.id)
+                        .put(pid)
+                        .put(activity.taskId)
+                        .put(activity.launchMode)
+                        .put(activity.taskTag)
+                        .put(activity.name));
+            add(Writer(ACTIVITY_STATUS).put(activity.id).put(activity.status));
+        }
+        for (const auto& service : app.services) {
+            add(Writer(SERVICE_ADDED).put(service.id).put(pid).put(service.priority).put(
+                    service.name));
+            add(Writer(SERVICE_STATUS).put(service.id).put(service.status).put(service.startFlag));
+        }
+    }
+    Writer order(TASK_ORDER);
+    order.put(state.homeTaskId).put(state.taskOrder.size());
+    for (const auto id : state.taskOrder) {
+        order.put(id);
+    }
+    add(order);
+    if (!isValid || snapshot.size() > mRegionSize) {
+        return false;
+    }
+
+    // the snapshot goes to the other region, and the header is switched to it by one store,
+    // the old records stay in use if the service crashes before that
+    const uint32_t next = (mHeader->cursor & CURSOR_REGION) ^ CURSOR_REGION;
+    memcpy(region(next), snapshot.data(), snapshot.size());
+    __atomic_store_n(&mHeader->cursor, next | snapshot.size(), __ATOMIC_RELEASE);
+    mTaskOrder = state.taskOrder;
+    mHomeTaskId = state.homeTaskId;
+    return true;
+}
+
+void StateJournal::replay(RecoveredState& state) const {
+    // the owner process of every activity and service
+    std::unordered_map<uint32_t, pid_t> owners;
+    const auto findActivity = [&state, &owners](const uint32_t id) -> RecoveredActivity* {
+        const auto owner = owners.find(id);
+        const auto app = owner != owners.end() ? state.apps.find(owner->second) : state.apps.end();
+        if (app != state.apps.end()) {
+            for (auto& activity : app->second.activities) {
+                if (activity.id == id) {
+                    return &activity;
+                }
+            }
+        }
+        return nullptr;
+    };
+    const auto findService = [&state, &owners](const uint32_t id) -> RecoveredService* {
+        const auto owner = owners.find(id);
+        const auto app = owner != owners.end() ? state.apps.find(owner->second) : state.apps.end();
+        if (app != state.apps.end()) {
+            for (auto& service : app->second.services) {
+                if (service.id == id) {
+                    return &service;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    const uint32_t cursor = __atomic_load_n(&mHeader->cursor, __ATOMIC_ACQUIRE);
+    const uint8_t* records = region(cursor);
+    const size_t used = cursor & CURSOR_USED;
+    size_t pos = 0;
+    while (pos + RECORD_HEAD_SIZE <= used) {
+        uint16_t type;
+        uint16_t size;
+        memcpy(&type, records + pos, sizeof(type));
+        memcpy(&size, records + pos + sizeof(type), sizeof(size));
+        if (pos + RECORD_HEAD_SIZE + size > used) {
+            break;
+        }
+        Reader reader(records + pos + RECORD_HEAD_SIZE, size);
+        pos += RECORD_HEAD_SIZE + size;
+
+        switch (type) {
+            case APP_ATTACHED: {
+                RecoveredApp app;
+                app.pid = reader.get();
+                app.uid = reader.get();
+                app.isSystemUI = reader.get();
+                app.packageName = reader.getString();
+                if (reader.isValid()) {
+                    state.apps[app.pid] = std::move(app);
+                }
+                break;
+            }
+            case APP_EXITED:
+                state.apps.erase(reader.get());
+                break;
+            case PRIORITY: {
+                const pid_t pid = reader.get();
+                const int priority = reader.get();
+                const auto app = state.apps.find(pid);
+                if (reader.isValid() && app != state.apps.end()) {
+                    app->second.priority = priority;
+                }
+                break;
+            }
+            case ACTIVITY_ADDED: {
+                RecoveredActivity activity;
+                activity.id = reader.get();
+                const pid_t pid = reader.get();
+                activity.taskId = reader.get();
+                activity.launchMode = reader.get();
+                activity.taskTag = reader.getString();
+                activity.name = reader.getString();
+                activity.status = 0;
+                const auto app = state.apps.find(pid);
+                if (reader.isValid() && app != state.apps.end()) {
+                    owners[activity.id] = pid;
+                    app->second.activities.push_back(std::move(activity));
+                }
+                break;
+            }
+            case ACTIVITY_STATUS: {
+                const uint32_t id = reader.get();
+                const int status = reader.get();
+                if (auto activity = findActivity(id); activity && reader.isValid()) {
+                    activity->status = status;
+                }
+                break;
+            }
+            case ACTIVITY_REMOVED: {
+                const uint32_t id = reader.get();
+                if (findActivity(id)) {
+                    auto& activities = state.apps[owners[id]].activities;
+                    activities.erase(std::find_if(activities.begin(), activities.end(),
+                                                  [id](const auto& it) { return it.id == id; }));
+                }
+                break;
+            }
+            case SERVICE_ADDED: {
+                RecoveredService service;
+                service.id = reader.get();
+                const pid_t pid = reader.get();
+                service.priority = reader.get();
+                service.name = reader.getString();
+                service.status = 0;
+                service.startFlag = 0;
+                const auto app = state.apps.find(pid);
+                if (reader.isValid() && app != state.apps.end()) {
+                    owners[service.id] = pid;
+                    app->second.services.push_back(std::move(service));
+                }
+                break;
+            }
+            case SERVICE_STATUS: {
+                const uint32_t id = reader.get();
+                const int status = reader.get();
+                const int startFlag = reader.get();
+                if (auto service = findService(id); service && reader.isValid()) {
+                    service->status = status;
+                    service->startFlag = startFlag;
+                }
+                break;
+            }
+            case SERVICE_REMOVED: {
+                const uint32_t id = reader.get();
+                if (findService(id)) {
+                    auto& services = state.apps[owners[id]].services;
+                    services.erase(std::find_if(services.begin(), services.end(),
+                                                [id](const auto& it) { return it.id == id; }));
+                }
+                break;
+            }
+            case TASK_ORDER: {
+                const uint32_t homeTaskId = reader.get();
+                const uint32_t count = reader.get();
+                std::vector<uint32_t> order;
+                for (uint32_t i = 0; i < count && reader.isValid(); i++) {
+                    order.push_back(reader.get());
+                }
+                if (reader.isValid()) {
+                    state.homeTaskId = homeTaskId;
+                    state.taskOrder = std::move(order);
+                }
+                break;
+            }
+            default:
+                ALOGW("unknown journal record:%d", type);
+                break;
+        }
+    }
+
+    // the tasks that have no activity are gone
+    std::unordered_set<uint32_t> liveTasks;
+    for (const auto& [pid, app] : state.apps) {
+        for (const auto& activity : app.activities) {
+            liveTasks.insert(activity.taskId);
+        }
+    }
+    state.taskOrder.erase(std::remove_if(state.taskOrder.begin(), state.taskOrder.end(),
+                                         [&liveTasks](uint32_t id) {
+                                             return liveTasks.count(id) == 0;
+                                         }),
+                          state.taskOrder.end());
+    if (liveTasks.count(state.homeTaskId) == 0) {
+        state.homeTaskId = 0;
+    }
+}
+
+} // namespace am
+} // namespace os
+
+#endif // CONFIG_AM_STATE_JOURNAL
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace os {
+namespace am {
+
+/** The state that the last run of the service left in the journal */
+struct RecoveredActivity {
+    uint32_t id;
+    uint32_t taskId;
+    std::string name; // "package/Activity"
+    std::string taskTag;
+    int launchMode;
+    int status; // the last status that the application reported
+};
+
+struct RecoveredService {
+    uint32_t id;
+    std::string name;
+    int priority;
+    int status;
+    int startFlag;
+};
+
+struct RecoveredApp {
+    pid_t pid;
+    int uid;
+    bool isSystemUI;
+    std::string packageName;
+    int priority = -1; // -1: the process isn't in ProcessPriorityPolicy
+    std::vector<RecoveredActivity> activities; // in the order that they were pushed to the tasks
+    std::vector<RecoveredService> services;
+};
+
+struct RecoveredState {
+    std::map<pid_t, RecoveredApp> apps;
+    std::vector<uint32_t> taskOrder; // the standard tasks from the front
+    uint32_t homeTaskId = 0;
+};
+
+/**
+ * A compact journal of the state that a restarted service needs to adopt the running
+ * applications: the processes, their activities and tasks, services and priorities.
+ * The records are appended to a mmap'd file as the state changes. When it's full, the live state
+ * is rewritten to the other half of the file, which takes the place of the old records at once.
+ * A record or a rewrite is visible only after it's completely written, so a crash in the middle
+ * leaves the journal consistent. A record larger than 64KiB can't be journaled, the journal is
+ * disabled instead.
+ * The activities, tasks and services are identified by the ids that the journal assigns, the
+ * records of a restarted service keep the ids of the adopted ones.
+ */
+class StateJournal {
+public:
+    StateJournal();
+    ~StateJournal();
+
+    /** Map the journal, the content that the last run left is kept for recover() */
+    bool open(const char* path, const size_t capacity);
+    void close();
+    bool isOpen() const {
+        return mHeader != nullptr;
+    }
+
+    /** Replay the journal to the state at the moment that the last run stopped */
+    void recover(RecoveredState& state);
+    /** Rewrite the journal with the state only, the ids of the state are still valid */
+    void reset(const RecoveredState& state);
+
+    /** The id of a token or task, 0 if the journal doesn't know it */
+    uint32_t getId(const void* object) const;
+    /** The adopted object gets the id that it had in the last run */
+    void bindId(const void* object, const uint32_t id);
+
+    void appAttached(const pid_t pid, const int uid, const bool isSystemUI,
+                     const std::string& packageName);
+    void appExited(const pid_t pid);
+    void priorityChanged(const pid_t pid, const int priority);
+
+    void activityAdded(const pid_t pid, const void* token, const void* task,
+                       const std::string& taskTag, const int launchMode, const std::string& name);
+    void activityStatus(const void* token, const int status);
+    void activityRemoved(const void* token);
+
+    void serviceAdded(const pid_t pid, const void* token, const int priority,
+                      const std::string& name);
+    void serviceStatus(const void* token, const int status, const int startFlag);
+    void serviceRemoved(const void* token);
+
+    /** The task order is only written when it's changed */
+    void taskOrder(const std::vector<const void*>& tasks, const void* homeTask);
+
+private:
+    enum RecordType : uint16_t {
+        APP_ATTACHED = 1,
+        APP_EXITED,
+        PRIORITY,
+        ACTIVITY_ADDED,
+        ACTIVITY_STATUS,
+        ACTIVITY_REMOVED,
+        SERVICE_ADDED,
+        SERVICE_STATUS,
+        SERVICE_REMOVED,
+        TASK_ORDER,
+    };
+
+    struct Header;
+    class Writer;
+    class Reader;
+
+    uint32_t assignId(const void* object, const bool isNew);
+    void forgetId(const void* object);
+    void append(Writer& record);
+    bool write(const std::string& data);
+    uint8_t* region(const uint32_t cursor) const;
+    void disable();
+    bool compact();
+    bool writeState(const RecoveredState& state);
+    void replay(RecoveredState& state) const;
+
+    Header* mHeader;
+    size_t mCapacity;
+    size_t mRegionSize; // the records of a region
+    int mFd;
+    uint32_t mNextId;
+    std::unordered_map<const void*, uint32_t> mIds;
+    std::vector<uint32_t> mTaskOrder; // the last written one
+    uint32_t mHomeTaskId;
+};
+
+} // namespace am
+} // namespace os
@@ -46,6 +46,8 @@ void SystemUIManager::pushNewActivity(const ActivityStackHandler& task,
     task->pushActivity(activity);
     if (!findTask(task->getTaskTag())) {
         mSystemUITasks.push_front(task);
+        mTaskIndex.emplace(task->getTaskTag(), task);
+        mIsActiveTaskDirty = true;
     }
 }
 
@@ -67,35 +69,70 @@ void SystemUIManager::deleteActivity(const ActivityHandler& activity) {
         task->removeActivity(activity);
         if (task->getSize() == 0) {
             mSystemUITasks.remove(task);
+            const auto range = mTaskIndex.equal_range(task->getTaskTag());
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == task) {
+                    mTaskIndex.erase(it);
+                    break;
+                }
+            }
+            mIsActiveTaskDirty = true;
+        }
+    }
+}
+
+void SystemUIManager::restoreTask(const ActivityStackHandler& task,
+                                  const ActivityStackHandler& before, bool isHome) {
+    // the SystemUI tasks have no order, the resumed ones are in foreground
+    for (auto& activity : task->getActivityArray()) {
+        if (activity->getStatus() == ActivityRecord::RESUMED) {
+            activity->getAppRecord()->setForeground(true);
         }
     }
+    mSystemUITasks.push_front(task);
+    mTaskIndex.emplace(task->getTaskTag(), task);
+    mIsActiveTaskDirty = true;
 }
 
 ActivityStackHandler SystemUIManager::getActiveTask() {
-    for (auto& task : mSystemUITasks) {
-        for (auto activity : task->getActivityArray()) {
-            if (activity->getStatus() == ActivityRecord::RESUMED) {
-                return task;
+    if (mIsActiveTaskDirty) {
+        mIsActiveTaskDirty = false;
+        mActiveTask = nullptr;
+        for (auto& task : mSystemUITasks) {
+            for (auto activity : task->getActivityArray()) {
+                if (activity->getStatus() == ActivityRecord::RESUMED) {
+                    mActiveTask = task;
+                    return mActiveTask;
+                }
             }
         }
     }
-    return nullptr;
+    return mActiveTask;
 }
 
 ActivityStackHandler SystemUIManager::findTask(const std::string& tag) {
-    for (const auto& t : mSystemUITasks) {
-        if (t->getTaskTag() == tag) {
-            // check the taskStack is alive
-            if (auto activity = t->getRootActivity()) {
-                if (auto app = activity->getAppRecord()) {
-                    if (app->mStatus == APP_RUNNING) {
-                        return t;
-                    }
-                }
+    // the index has no order, when several alive tasks share the tag the front one is taken
+    ActivityStackHandler found;
+    bool isAmbiguous = false;
+    const auto range = mTaskIndex.equal_range(tag);
+    for (auto it = range.first; it != range.second; ++it) {
+        const auto& t = it->second;
+        if (isTaskAlive(t)) {
+            if (found) {
+                isAmbiguous = true;
+                break;
             }
+            found = t;
         }
     }
-    return nullptr;
+    if (isAmbiguous) {
+        for (const auto& t : mSystemUITasks) {
+            if (t->getTaskTag() == tag && isTaskAlive(t)) {
+                return t;
+            }
+        }
+    }
+    return found;
 }
 
 void SystemUIManager::onEvent(TaskManagerEvent event, void* data) {
@@ -104,6 +141,10 @@ void SystemUIManager::onEvent(TaskManagerEvent event, void* data) {
             onStartActivity();
             break;
         }
+        case TaskManagerEvent::ActivityResumedChangedEvent: {
+            mIsActiveTaskDirty = true;
+            break;
+        }
     }
 }
 
@@ -117,11 +158,8 @@ void SystemUIManager::onStartActivity() {
 }
 
 std::ostream& SystemUIManager::print(std::ostream& os) {
-#define RESET "\033[0m"
-#define RED "\033[31m"
-
     if (!mSystemUITasks.empty()) {
-        os << RED << "SystemUI task:" << RESET << std::endl;
+        os << COLOR_RED << "SystemUI task:" << COLOR_RESET << std::endl;
         for (auto& it : mSystemUITasks) {
             os << *it << std::endl;
         }
@@ -130,5 +168,11 @@ std::ostream& SystemUIManager::print(std::ostream& os) {
     return os;
 }
 
+void SystemUIManager::dumpJson(JsonWriter& writer) {
+    for (auto& it : mSystemUITasks) {
+        it->dumpJson(writer, "systemui");
+    }
+}
+
 } // namespace am
 } // namespace os
\ No newline at end of file
@@ -15,6 +15,9 @@
  */
 #pragma once
 
+#include <list>
+#include <unordered_map>
+
 #include "TaskManager.h"
 
 namespace os {
@@ -31,17 +34,24 @@ public:
 
     void finishActivity(const ActivityHandler& activity) override;
     void deleteActivity(const ActivityHandler& activity) override;
+    void restoreTask(const ActivityStackHandler& task, const ActivityStackHandler& before,
+                     bool isHome) override;
     ActivityStackHandler getActiveTask() override;
     ActivityStackHandler findTask(const std::string& tag) override;
 
     void onEvent(TaskManagerEvent event, void* data = nullptr) override;
 
     std::ostream& print(std::ostream& os);
+    void dumpJson(JsonWriter& writer) override;
 
 private:
     void onStartActivity();
 
     std::list<ActivityStackHandler> mSystemUITasks;
+    std::unordered_multimap<std::string, ActivityStackHandler> mTaskIndex;
+    // the active task is looked up again only after an Activity is resumed or leaves resumed
+    ActivityStackHandler mActiveTask;
+    bool mIsActiveTaskDirty = false;
 };
 
 } // namespace am
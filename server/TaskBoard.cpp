@@ -18,6 +18,7 @@
 
 #include <time.h>
 
+#include <algorithm>
 #include <limits>
 
 namespace os {
@@ -115,5 +116,10 @@ void TaskBoard::removeTask(const Label& e) {
     mTasklist.remove_if([&e](const auto& task) { return *(task->getTask()) == e; });
 }
 
+size_t TaskBoard::getPendingCount() const {
+    return std::count_if(mTasklist.begin(), mTasklist.end(),
+                         [](const auto& task) { return !task->isDone(); });
+}
+
 } // namespace am
 } // namespace os
@@ -94,6 +94,8 @@ public:
     void commitTask(const std::shared_ptr<Task>& task, const uint64_t msLimitedTime = UINT_MAX);
     void eventTrigger(const Label& e);
     void removeTask(const Label& e);
+    // the tasks still waiting for their events, the done ones are pruned later by the timer
+    size_t getPendingCount() const;
 
 private:
     void checkTimeout();
@@ -21,6 +21,15 @@
 namespace os {
 namespace am {
 
+bool ITaskManager::isTaskAlive(const ActivityStackHandler& task) {
+    if (auto activity = task->getRootActivity()) {
+        if (auto app = activity->getAppRecord()) {
+            return app->mStatus == APP_RUNNING;
+        }
+    }
+    return false;
+}
+
 bool TaskManagerFactory::init(TaskBoard& taskBoard) {
     mTaskManagers[StandardMode] = std::make_unique<TaskStackManager>(taskBoard);
     mTaskManagers[SystemUIMode] = std::make_unique<SystemUIManager>();
@@ -49,5 +58,13 @@ std::ostream& operator<<(std::ostream& os, const TaskManagerFactory& taskmanager
     return os;
 }
 
+void TaskManagerFactory::dumpJson(JsonWriter& writer) const {
+    writer.beginArray("tasks");
+    for (auto& it : mTaskManagers) {
+        it->dumpJson(writer);
+    }
+    writer.endArray();
+}
+
 } // namespace am
 } // namespace os
\ No newline at end of file
@@ -17,9 +17,11 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 
 #include "ActivityStack.h"
 #include "AppRecord.h"
+#include "DumpWriter.h"
 
 namespace os {
 namespace am {
@@ -34,6 +36,7 @@ enum TaskManagerType {
 
 enum TaskManagerEvent {
     StartActivityEvent,
+    ActivityResumedChangedEvent, // data: ActivityRecord* that enters or leaves the resumed status
 };
 
 class ITaskManager {
@@ -51,6 +54,9 @@ public:
                                 const Intent& intent, int startFlag) {}
     virtual void finishActivity(const ActivityHandler& activity) {}
     virtual void deleteActivity(const ActivityHandler& activity) {}
+    /** Put back the task adopted from the last run of the service, the Activities are in it */
+    virtual void restoreTask(const ActivityStackHandler& task, const ActivityStackHandler& before,
+                             bool isHome) {}
 
     virtual ActivityStackHandler getActiveTask() {
         return nullptr;
@@ -58,11 +64,21 @@ public:
     virtual ActivityStackHandler findTask(const std::string& tag) {
         return nullptr;
     }
+    /** All the tasks from the front */
+    virtual std::vector<ActivityStackHandler> getTasks() {
+        return {};
+    }
 
     virtual void onEvent(TaskManagerEvent event, void* data = nullptr){};
     virtual std::ostream& print(std::ostream& os) {
         return os;
     }
+    /** Append the tasks to the JSON array */
+    virtual void dumpJson(JsonWriter& writer) {}
+
+protected:
+    /** The root Activity of the task is hosted by a running app */
+    static bool isTaskAlive(const ActivityStackHandler& task);
 };
 
 class TaskManagerFactory {
@@ -76,6 +92,7 @@ public:
     void onEvent(TaskManagerEvent event, void* data = nullptr);
 
     friend std::ostream& operator<<(std::ostream& os, const TaskManagerFactory& task);
+    void dumpJson(JsonWriter& writer) const;
 
 private:
     std::array<std::unique_ptr<ITaskManager>, TYPE_NUM> mTaskManagers;
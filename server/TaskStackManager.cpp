@@ -43,6 +43,7 @@ void TaskStackManager::switchTaskToActive(const ActivityStackHandler& targetStac
             if ((intent.mFlag & Intent::FLAG_APP_SWITCH_TASK) != Intent::FLAG_APP_SWITCH_TASK) {
                 activity->setIntent(intent);
             }
+            activity->setResumeAfterPause(currentTopActivity);
             activity->lifecycleTransition(ActivityRecord::RESUMED);
             auto task = std::make_shared<ActivityWaitResume>(activity, currentTopActivity);
             mPendTask.commitTask(task, REQUEST_TIMEOUT_MS);
@@ -70,11 +71,12 @@ bool TaskStackManager::moveTaskToBackground(const ActivityStackHandler& targetSt
         auto topActivity = targetStack->getTopActivity();
         topActivity->lifecycleTransition(ActivityRecord::PAUSED);
         targetStack->setForeground(false);
-        mAllTasks.pop_front();
+        eraseTask(mAllTasks.begin());
         activeTask = getActiveTask();
         if (activeTask) {
             auto nextActivity = activeTask->getTopActivity();
             if (nextActivity) {
+                nextActivity->setResumeAfterPause(topActivity);
                 nextActivity->lifecycleTransition(ActivityRecord::RESUMED);
                 auto task = std::make_shared<ActivityWaitResume>(nextActivity, topActivity);
                 mPendTask.commitTask(task, REQUEST_TIMEOUT_MS);
@@ -89,11 +91,11 @@ bool TaskStackManager::moveTaskToBackground(const ActivityStackHandler& targetSt
             isBeforeHomeTask = true;
             auto tmp = iter;
             ++iter;
-            mAllTasks.erase(tmp);
+            eraseTask(tmp);
         } else {
             if (*iter == mHomeTask) {
                 if (isBeforeHomeTask) {
-                    mAllTasks.insert(++iter, targetStack);
+                    insertTask(++iter, targetStack);
                 }
                 return true;
             }
@@ -131,6 +133,8 @@ void TaskStackManager::pushNewActivity(const ActivityStackHandler& targetStack,
     if (targetStack == activeTask) {
         activity->getAppRecord()->setForeground(true);
     }
+    // the new Activity is created while the last one is pausing
+    activity->setResumeAfterPause(lastTopActivity);
     activity->lifecycleTransition(ActivityRecord::RESUMED);
 
     if (lastTopActivity) {
@@ -175,6 +179,7 @@ void TaskStackManager::turnToActivity(const ActivityStackHandler& targetStack,
             }
         }
         activity->setIntent(intent);
+        activity->setResumeAfterPause(lastTopActivity);
         activity->lifecycleTransition(ActivityRecord::RESUMED);
 
         if (targetStack != activeTask && lastTopActivity) {
@@ -215,7 +220,7 @@ void TaskStackManager::finishActivity(const ActivityHandler& activity) {
         activity->getAppRecord()->setForeground(false);
         auto nextActivity = activityTask->getTopActivity();
         if (!nextActivity) {
-            mAllTasks.pop_front();
+            eraseTask(mAllTasks.begin());
             activeTask = getActiveTask();
             if (activityTask == mHomeTask) {
                 ALOGW("Default desktop application exit!!!");
@@ -228,6 +233,7 @@ void TaskStackManager::finishActivity(const ActivityHandler& activity) {
         }
         if (nextActivity) {
             activity->lifecycleTransition(ActivityRecord::PAUSED);
+            nextActivity->setResumeAfterPause(activity);
             nextActivity->lifecycleTransition(ActivityRecord::RESUMED);
             const auto task = std::make_shared<ActivityDelayDestroy>(activity, nextActivity);
             mPendTask.commitTask(task, REQUEST_TIMEOUT_MS);
@@ -257,7 +263,7 @@ void TaskStackManager::deleteActivity(const ActivityHandler& activity) {
         if (task == getActiveTask()) {
             auto nextActivity = task->getTopActivity();
             if (!nextActivity) {
-                mAllTasks.pop_front();
+                eraseTask(mAllTasks.begin());
                 if (auto activeTask = getActiveTask()) {
                     nextActivity = getActiveTask()->getTopActivity();
                 }
@@ -277,6 +283,22 @@ void TaskStackManager::deleteActivity(const ActivityHandler& activity) {
     }
 }
 
+void TaskStackManager::restoreTask(const ActivityStackHandler& task,
+                                   const ActivityStackHandler& before, bool isHome) {
+    ALOGI("restoreTask taskTag:%s", task->getTaskTag().c_str());
+    auto position = before ? findTaskIterator(before) : mAllTasks.end();
+    if (position == mAllTasks.begin()) {
+        if (auto activeTask = getActiveTask()) {
+            activeTask->setForeground(false);
+        }
+        task->setForeground(true);
+    }
+    insertTask(position, task);
+    if (isHome) {
+        mHomeTask = task;
+    }
+}
+
 ActivityStackHandler TaskStackManager::getActiveTask() {
     if (!mAllTasks.empty()) {
         return mAllTasks.front();
@@ -289,27 +311,38 @@ ActivityStackHandler TaskStackManager::getHomeTask() {
 }
 
 ActivityStackHandler TaskStackManager::findTask(const std::string& tag) {
-    for (const auto& t : mAllTasks) {
-        if (t->getTaskTag() == tag) {
-            // check the taskStack is alive
-            if (auto activity = t->getRootActivity()) {
-                if (auto app = activity->getAppRecord()) {
-                    if (app->mStatus == APP_RUNNING) {
-                        return t;
-                    }
-                }
+    // the index has no order, when several alive tasks share the tag the front one is taken
+    ActivityStackHandler found;
+    bool isAmbiguous = false;
+    const auto range = mTaskIndex.equal_range(tag);
+    for (auto it = range.first; it != range.second; ++it) {
+        const auto& t = *(it->second);
+        if (isTaskAlive(t)) {
+            if (found) {
+                isAmbiguous = true;
+                break;
             }
+            found = t;
         }
     }
-    return nullptr;
+    if (isAmbiguous) {
+        for (const auto& t : mAllTasks) {
+            if (t->getTaskTag() == tag && isTaskAlive(t)) {
+                return t;
+            }
+        }
+    }
+    return found;
+}
+
+std::vector<ActivityStackHandler> TaskStackManager::getTasks() {
+    return std::vector<ActivityStackHandler>(mAllTasks.begin(), mAllTasks.end());
 }
 
 void TaskStackManager::deleteTask(const ActivityStackHandler& task) {
-    for (auto it = mAllTasks.begin(); it != mAllTasks.end(); ++it) {
-        if (*it == task) {
-            mAllTasks.erase(it);
-            break;
-        }
+    auto iter = findTaskIterator(task);
+    if (iter != mAllTasks.end()) {
+        eraseTask(iter);
     }
 }
 
@@ -319,24 +352,52 @@ void TaskStackManager::pushTaskToFront(const ActivityStackHandler& activityStack
         if (activeTask) {
             activeTask->setForeground(false);
         }
-        mAllTasks.remove(activityStack);
-        mAllTasks.push_front(activityStack);
+        auto iter = findTaskIterator(activityStack);
+        if (iter != mAllTasks.end()) {
+            mAllTasks.splice(mAllTasks.begin(), mAllTasks, iter);
+        } else {
+            insertTask(mAllTasks.begin(), activityStack);
+        }
         activityStack->setForeground(true);
     }
 }
 
-std::ostream& operator<<(std::ostream& os, const TaskStackManager& task) {
-#define RESET "\033[0m"
-#define GREEN "\033[32m"
-#define YELLOW "\033[33m"
-#define BLUE "\033[34m"
+TaskStackManager::TaskIterator TaskStackManager::insertTask(TaskIterator position,
+                                                            const ActivityStackHandler& task) {
+    auto iter = mAllTasks.insert(position, task);
+    mTaskIndex.emplace(task->getTaskTag(), iter);
+    return iter;
+}
+
+void TaskStackManager::eraseTask(TaskIterator iter) {
+    const auto range = mTaskIndex.equal_range((*iter)->getTaskTag());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == iter) {
+            mTaskIndex.erase(it);
+            break;
+        }
+    }
+    mAllTasks.erase(iter);
+}
+
+TaskStackManager::TaskIterator TaskStackManager::findTaskIterator(
+        const ActivityStackHandler& task) {
+    const auto range = mTaskIndex.equal_range(task->getTaskTag());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (*(it->second) == task) {
+            return it->second;
+        }
+    }
+    return mAllTasks.end();
+}
 
-    os << GREEN << "foreground task:" << RESET << endl;
+std::ostream& operator<<(std::ostream& os, const TaskStackManager& task) {
+    os << COLOR_GREEN << "foreground task:" << COLOR_RESET << endl;
     for (auto& it : task.mAllTasks) {
         if (it == task.mHomeTask) {
-            os << YELLOW << "home task:" << RESET << endl;
+            os << COLOR_YELLOW << "home task:" << COLOR_RESET << endl;
             os << *it << endl;
-            os << BLUE << "background task:" << RESET << endl;
+            os << COLOR_BLUE << "background task:" << COLOR_RESET << endl;
         } else {
             os << *it << endl;
         }
@@ -345,17 +406,12 @@ std::ostream& operator<<(std::ostream& os, const TaskStackManager& task) {
 }
 
 std::ostream& TaskStackManager::print(std::ostream& os) {
-#define RESET "\033[0m"
-#define RED "\033[31m"
-#define GREEN "\033[32m"
-#define YELLOW "\033[33m"
-
-    os << RED << "foreground task:" << RESET << endl;
+    os << COLOR_RED << "foreground task:" << COLOR_RESET << endl;
     for (auto& it : mAllTasks) {
         if (it == mHomeTask) {
-            os << YELLOW << "home task:" << RESET << endl;
+            os << COLOR_YELLOW << "home task:" << COLOR_RESET << endl;
             os << *it << endl;
-            os << GREEN << "background task:" << RESET << endl;
+            os << COLOR_GREEN << "background task:" << COLOR_RESET << endl;
         } else {
             os << *it << endl;
         }
@@ -363,5 +419,17 @@ std::ostream& TaskStackManager::print(std::ostream& os) {
     return os;
 }
 
+void TaskStackManager::dumpJson(JsonWriter& writer) {
+    const char* position = "foreground";
+    for (auto& it : mAllTasks) {
+        if (it == mHomeTask) {
+            it->dumpJson(writer, "home");
+            position = "background";
+        } else {
+            it->dumpJson(writer, position);
+        }
+    }
+}
+
 } // namespace am
 } // namespace os
\ No newline at end of file
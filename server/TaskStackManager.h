@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <list>
+#include <unordered_map>
+
 #include "ActivityStack.h"
 #include "AppRecord.h"
 #include "TaskBoard.h"
@@ -47,18 +50,30 @@ public:
     /** finish a Activity, set result and resume the last */
     void finishActivity(const ActivityHandler& activity) override;
     void deleteActivity(const ActivityHandler& activity) override;
+    /** The task is inserted before the other one, or at the back if it's null */
+    void restoreTask(const ActivityStackHandler& task, const ActivityStackHandler& before,
+                     bool isHome) override;
 
     ActivityStackHandler getActiveTask() override;
     ActivityStackHandler findTask(const std::string& tag) override;
+    std::vector<ActivityStackHandler> getTasks() override;
     ActivityStackHandler getHomeTask();
     void deleteTask(const ActivityStackHandler& task);
     void pushTaskToFront(const ActivityStackHandler& task);
 
     friend std::ostream& operator<<(std::ostream& os, const TaskStackManager& task);
     std::ostream& print(std::ostream& os) override;
+    void dumpJson(JsonWriter& writer) override;
 
 private:
+    using TaskIterator = std::list<ActivityStackHandler>::iterator;
+    TaskIterator insertTask(TaskIterator position, const ActivityStackHandler& task);
+    void eraseTask(TaskIterator iter);
+    TaskIterator findTaskIterator(const ActivityStackHandler& task);
+
     std::list<ActivityStackHandler> mAllTasks;
+    // taskAffinity -> the position in mAllTasks, the stopping task may share the tag with a new one
+    std::unordered_multimap<std::string, TaskIterator> mTaskIndex;
     ActivityStackHandler mHomeTask;
     TaskBoard& mPendTask;
 };
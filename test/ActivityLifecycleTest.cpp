@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "FakeApplication.h"
+
+namespace test {
+
+class ActivityLifecycleTest : public FakeAppTest {};
+
+TEST_F(ActivityLifecycleTest, oneTransitionInFlight) {
+    auto a = newActivity("A");
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:create"}));
+    report(a, ActivityRecord::CREATED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:create", "A:start"}));
+    report(a, ActivityRecord::STARTED);
+    report(a, ActivityRecord::RESUMED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:create", "A:start", "A:resume"}));
+    EXPECT_EQ(a->getStatus(), ActivityRecord::RESUMED);
+}
+
+TEST_F(ActivityLifecycleTest, collapseRoundTrip) {
+    auto a = newActivity("A");
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    // resumed->paused->resumed isn't issued yet, it's a no-op
+    a->lifecycleTransition(ActivityRecord::PAUSED);
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    report(a, ActivityRecord::CREATED);
+    report(a, ActivityRecord::STARTED);
+    report(a, ActivityRecord::RESUMED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:create", "A:start", "A:resume"}));
+    EXPECT_EQ(a->getStatus(), ActivityRecord::RESUMED);
+}
+
+TEST_F(ActivityLifecycleTest, keepRequestOrder) {
+    auto a = newActivity("A");
+    resumeActivity(a);
+    a->lifecycleTransition(ActivityRecord::PAUSED);
+    // the stop is observed before resuming again
+    a->lifecycleTransition(ActivityRecord::STOPPED);
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    report(a, ActivityRecord::PAUSED);
+    report(a, ActivityRecord::STOPPED);
+    report(a, ActivityRecord::STARTED);
+    report(a, ActivityRecord::RESUMED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "A:stop", "A:start", "A:resume"}));
+}
+
+TEST_F(ActivityLifecycleTest, destroyIsFinal) {
+    auto a = newActivity("A");
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    a->lifecycleTransition(ActivityRecord::PAUSED);
+    a->lifecycleTransition(ActivityRecord::DESTROYED);
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    EXPECT_EQ(a->getTargetStatus(), ActivityRecord::DESTROYED);
+    report(a, ActivityRecord::CREATED);
+    report(a, ActivityRecord::DESTROYED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:create", "A:destroy"}));
+}
+
+TEST_F(ActivityLifecycleTest, overlapWithPause) {
+    auto a = newActivity("A");
+    resumeActivity(a);
+
+    auto b = newActivity("B");
+    a->lifecycleTransition(ActivityRecord::PAUSED);
+    b->setResumeAfterPause(a);
+    b->lifecycleTransition(ActivityRecord::RESUMED);
+    // B is created and started while A is pausing
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "B:create"}));
+    report(b, ActivityRecord::CREATED);
+    report(b, ActivityRecord::STARTED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "B:create", "B:start"}));
+    EXPECT_EQ(b->getStatus(), ActivityRecord::STARTED);
+
+    // but B is resumed after A paused
+    report(a, ActivityRecord::PAUSED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "B:create", "B:start", "B:resume"}));
+}
+
+TEST_F(ActivityLifecycleTest, pauseInFlightBeforeDestroy) {
+    auto a = newActivity("A");
+    resumeActivity(a);
+
+    auto b = newActivity("B");
+    a->lifecycleTransition(ActivityRecord::PAUSED);
+    b->setResumeAfterPause(a);
+    b->lifecycleTransition(ActivityRecord::RESUMED);
+    // A is asked to resume again while the pause is in flight, it's still pausing
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    report(b, ActivityRecord::CREATED);
+    report(b, ActivityRecord::STARTED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "B:create", "B:start"}));
+
+    // the pause in flight is kept, B is resumed when it's done
+    a->lifecycleTransition(ActivityRecord::DESTROYED);
+    report(a, ActivityRecord::PAUSED);
+    EXPECT_EQ(mAppThread->mCalls,
+              Calls({"A:pause", "B:create", "B:start", "B:resume", "A:stop"}));
+    report(a, ActivityRecord::STOPPED);
+    report(a, ActivityRecord::DESTROYED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "B:create", "B:start", "B:resume", "A:stop",
+                                         "A:destroy"}));
+    EXPECT_EQ(a->getStatus(), ActivityRecord::DESTROYED);
+}
+
+/** The first launch of an application is fused with its attachApplication reply */
+class FusedLaunchTest : public FakeAppTest {};
+
+TEST_F(FusedLaunchTest, fuseLaunchWithAttach) {
+    auto a = newActivity("A");
+    std::vector<FusedLaunch> launches;
+    mApp->mFusedLaunches = &launches;
+    a->lifecycleTransition(ActivityRecord::RESUMED);
+    mApp->mFusedLaunches = nullptr;
+    ASSERT_EQ(launches.size(), 1u);
+    EXPECT_EQ(launches[0].targetStatus, ActivityRecord::RESUMED);
+    // the application goes on to resumed by itself, nothing is scheduled
+    report(a, ActivityRecord::CREATED);
+    report(a, ActivityRecord::STARTED);
+    report(a, ActivityRecord::RESUMED);
+    EXPECT_TRUE(mAppThread->mCalls.empty());
+    EXPECT_EQ(a->getStatus(), ActivityRecord::RESUMED);
+    a->lifecycleTransition(ActivityRecord::PAUSED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause"}));
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
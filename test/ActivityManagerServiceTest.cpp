@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/IPCThreadState.h>
+#include <gtest/gtest.h>
+#include <kvdb.h>
+#include <pm/PackageManager.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "FakeApplication.h"
+#include "HostAppSpawn.h"
+#include "am/ActivityManagerService.h"
+#include "app/ActivityManager.h"
+#include "app/UvLoop.h"
+
+namespace test {
+
+using namespace os::am;
+using os::app::ActivityManager;
+using os::pm::PackageInfo;
+using os::pm::PackageManager;
+
+const std::string PACKAGE = "test.app";
+const std::string OTHER_PACKAGE = "test.other";
+
+/** The service runs in the test process, the applications call it with their fake pids */
+class ActivityManagerServiceTest : public testing::Test {
+protected:
+    void SetUp() override {
+        PackageManager::clearPackages();
+        PackageInfo info;
+        info.packageName = PACKAGE;
+        info.entry = "Main";
+        info.execfile = "/bin/" + PACKAGE;
+        info.activitiesInfo.push_back({"Main", "singleTask", "", {}});
+        info.activitiesInfo.push_back({"Detail", "standard", "", {}});
+        PackageManager::installPackage(info);
+        PackageInfo other;
+        other.packageName = OTHER_PACKAGE;
+        other.entry = "Main";
+        other.execfile = "/bin/" + OTHER_PACKAGE;
+        other.activitiesInfo.push_back({"Main", "singleTask", "", {}});
+        other.servicesInfo.push_back({"Service", os::pm::MIDDLE, {}});
+        PackageManager::installPackage(other);
+        // the boot guide isn't part of the tests
+        property_set("persist.global.system.usersetup_complete", "1");
+        // the spawned processes attach when the test plays them
+        os::app::host::setSpawnHandler([this](const std::string&, const std::vector<std::string>&) {
+            mSpawned.push_back(os::app::host::allocFakePid());
+            return mSpawned.back();
+        });
+
+        mLooper = std::make_unique<os::app::UvLoop>();
+        mService = new ActivityManagerService(mLooper->get());
+        mService->systemReady();
+    }
+
+    void TearDown() override {
+        // the tasks that are posted by the service never run after it
+        runLoop();
+        mService.clear();
+        os::app::host::setSpawnHandler(nullptr);
+        PackageManager::clearPackages();
+        mLooper->stop();
+        mLooper->run(UV_RUN_NOWAIT);
+        mLooper->run(UV_RUN_NOWAIT);
+        mLooper->close();
+    }
+
+    int start(const std::string& activity) {
+        Intent intent;
+        intent.setTarget(PACKAGE + "/" + activity);
+        int32_t ret = 0;
+        mService->startActivity(nullptr, intent, ActivityManager::NO_REQUEST, &ret);
+        return ret;
+    }
+
+    /** Start the entry of the package, the spawned process attaches with its token */
+    pid_t startApp(const std::string& packageName, sp<IBinder>& token) {
+        Intent intent;
+        intent.setTarget(packageName + "/Main");
+        int32_t ret = 0;
+        mService->startActivity(nullptr, intent, ActivityManager::NO_REQUEST, &ret);
+        runLoop();
+        if (ret != android::OK || mSpawned.empty()) {
+            return 0;
+        }
+        const pid_t pid = mSpawned.back();
+        std::vector<sp<IBinder>> tokens;
+        if (attach(pid, new NullApplicationThread(), nullptr, &tokens) != android::OK ||
+            tokens.empty()) {
+            return 0;
+        }
+        token = tokens[0];
+        return pid;
+    }
+
+    /** The spawns and the posted tasks are done */
+    void runLoop() {
+        mLooper->run(UV_RUN_NOWAIT);
+        mLooper->run(UV_RUN_NOWAIT);
+    }
+
+    std::string dump(const std::string& section) {
+        const int fd = memfd_create("amtest", 0);
+        android::Vector<android::String16> args;
+        args.add(android::String16(section.c_str()));
+        mService->dump(fd, args);
+        std::string result(lseek(fd, 0, SEEK_CUR), '\0');
+        pread(fd, result.data(), result.size(), 0);
+        close(fd);
+        return result;
+    }
+
+    /** The recent launches of the trace, from the oldest */
+    std::vector<std::string> launchesOf(const std::string& activity) {
+        std::istringstream trace(dump("stats"));
+        const std::string name = " " + PACKAGE + "/" + activity + " ";
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(trace, line);) {
+            if (line.find("#") != std::string::npos && line.find(name) != std::string::npos) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    }
+
+    /** The binder call comes from the process */
+    void callAs(const pid_t pid, const std::function<void()>& call) {
+        auto ipc = android::IPCThreadState::self();
+        const int64_t token = ipc->clearCallingIdentity();
+        ipc->restoreCallingIdentity(((int64_t)getuid() << 32) | (uint32_t)pid);
+        call();
+        ipc->restoreCallingIdentity(token);
+    }
+
+    int32_t attach(const pid_t pid, const sp<NullApplicationThread>& app,
+                   std::vector<std::string>* launched = nullptr,
+                   std::vector<sp<IBinder>>* launchedTokens = nullptr) {
+        std::vector<os::app::ActivityLaunch> launches;
+        int32_t ret = 0;
+        callAs(pid, [&] { mService->attachApplication(app, &launches, &ret); });
+        for (const auto& launch : launches) {
+            if (launched) {
+                launched->push_back(launch.mName);
+            }
+            if (launchedTokens) {
+                launchedTokens->push_back(launch.mToken);
+            }
+        }
+        return ret;
+    }
+
+    /** The clients that the priority of the process is bound to */
+    std::vector<pid_t> clientsOf(const pid_t pid) {
+        const std::string apps = dump("apps");
+        std::vector<pid_t> clients;
+        const size_t begin = apps.find("(" + std::to_string(pid) + ",");
+        if (begin == std::string::npos) {
+            return clients;
+        }
+        // the node ends where the next one or the line begins
+        const size_t end = apps.find_first_of("(\n", begin + 1);
+        const size_t list = apps.find("<-[", begin);
+        if (list == std::string::npos || list > end) {
+            return clients;
+        }
+        std::istringstream ids(apps.substr(list + 3, apps.find(']', list) - list - 3));
+        for (pid_t client; ids >> client;) {
+            clients.push_back(client);
+        }
+        return clients;
+    }
+
+    std::unique_ptr<os::app::UvLoop> mLooper;
+    sp<ActivityManagerService> mService;
+    std::vector<pid_t> mSpawned;
+};
+
+TEST_F(ActivityManagerServiceTest, unknownPidAttach) {
+    const pid_t pid = os::app::host::allocFakePid();
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+#ifdef CONFIG_AM_STATE_JOURNAL
+    // neither spawned by activity manager nor a process of the last run, it must stop itself
+    EXPECT_EQ(attach(pid, app), android::BAD_VALUE);
+#else
+    // the process started outside activity manager runs without being managed
+    EXPECT_EQ(attach(pid, app), android::OK);
+#endif
+}
+
+TEST_F(ActivityManagerServiceTest, prepareWhileSpawning) {
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    ASSERT_EQ(mSpawned.size(), 1u);
+
+    // it's prepared before the process attaches, nothing is ready yet
+    auto launches = launchesOf("Main");
+    ASSERT_EQ(launches.size(), 1u);
+    EXPECT_NE(launches[0].find(" spawn:"), std::string::npos) << launches[0];
+    EXPECT_NE(launches[0].find(" critical:0.0(attach)"), std::string::npos) << launches[0];
+    EXPECT_EQ(launches[0].find(" attach:"), std::string::npos) << launches[0];
+
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+    EXPECT_EQ(attach(mSpawned[0], app), android::OK);
+    launches = launchesOf("Main");
+    ASSERT_EQ(launches.size(), 1u);
+    EXPECT_NE(launches[0].find(" attach:"), std::string::npos) << launches[0];
+    EXPECT_NE(launches[0].find("(attach)"), std::string::npos) << launches[0];
+}
+
+TEST_F(ActivityManagerServiceTest, prepareOnAttach) {
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    // the loop doesn't get to its preparation before the process attaches
+    ASSERT_EQ(start("Detail"), android::OK);
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+    EXPECT_EQ(attach(mSpawned[0], app), android::OK);
+    runLoop();
+
+    const auto launches = launchesOf("Detail");
+    ASSERT_EQ(launches.size(), 1u);
+    EXPECT_NE(launches[0].find(" prepare:"), std::string::npos) << launches[0];
+    EXPECT_NE(launches[0].find(" attach:"), std::string::npos) << launches[0];
+}
+
+TEST_F(ActivityManagerServiceTest, replayInRequestOrder) {
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    // the process is attaching, the launches are queued for it
+    ASSERT_EQ(start("Detail"), android::OK);
+    ASSERT_EQ(mSpawned.size(), 1u);
+
+    std::vector<std::string> launched;
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+    EXPECT_EQ(attach(mSpawned[0], app, &launched), android::OK);
+    EXPECT_EQ(launched, std::vector<std::string>({"Main", "Detail"}));
+}
+
+TEST_F(ActivityManagerServiceTest, mergeWhileAttaching) {
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    auto launches = launchesOf("Main");
+    ASSERT_EQ(launches.size(), 1u);
+    const std::string replaced = launches[0];
+    ASSERT_EQ(start("Detail"), android::OK);
+    ASSERT_EQ(start("Main"), android::OK);
+
+    // the trace of the replaced launch is dropped, the latest one takes its place in the queue
+    launches = launchesOf("Main");
+    ASSERT_EQ(launches.size(), 1u);
+    EXPECT_NE(launches[0], replaced);
+    std::vector<std::string> launched;
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+    EXPECT_EQ(attach(mSpawned[0], app, &launched), android::OK);
+    EXPECT_EQ(launched, std::vector<std::string>({"Main", "Detail"}));
+    EXPECT_EQ(launchesOf("Main").size(), 1u);
+}
+
+TEST_F(ActivityManagerServiceTest, mergeWhileSpawning) {
+    ASSERT_EQ(start("Main"), android::OK);
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    // a single process is spawned for both
+    ASSERT_EQ(mSpawned.size(), 1u);
+    EXPECT_EQ(launchesOf("Main").size(), 1u);
+
+    std::vector<std::string> launched;
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+    EXPECT_EQ(attach(mSpawned[0], app, &launched), android::OK);
+    EXPECT_EQ(launched, std::vector<std::string>({"Main"}));
+}
+
+TEST_F(ActivityManagerServiceTest, dropOnDeath) {
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    ASSERT_EQ(start("Detail"), android::OK);
+    ASSERT_EQ(mSpawned.size(), 1u);
+
+    // the process exits before it attaches, its launches are never replayed
+    os::app::host::exitProcess(mSpawned[0]);
+    runLoop();
+    EXPECT_TRUE(launchesOf("Main").empty());
+    EXPECT_TRUE(launchesOf("Detail").empty());
+
+    // the next launch spawns another process
+    ASSERT_EQ(start("Main"), android::OK);
+    runLoop();
+    ASSERT_EQ(mSpawned.size(), 2u);
+    std::vector<std::string> launched;
+    const sp<NullApplicationThread> app(new NullApplicationThread());
+    EXPECT_EQ(attach(mSpawned[1], app, &launched), android::OK);
+    EXPECT_EQ(launched, std::vector<std::string>({"Main"}));
+}
+
+TEST_F(ActivityManagerServiceTest, resultCallerBinding) {
+    sp<IBinder> callerToken;
+    const pid_t caller = startApp(PACKAGE, callerToken);
+    ASSERT_GT(caller, 0);
+
+    Intent intent;
+    intent.setTarget(OTHER_PACKAGE + "/Main");
+    int32_t ret = 0;
+    callAs(caller, [&] { mService->startActivity(callerToken, intent, 1, &ret); });
+    ASSERT_EQ(ret, android::OK);
+    runLoop();
+    const pid_t callee = mSpawned.back();
+    std::vector<sp<IBinder>> tokens;
+    ASSERT_EQ(attach(callee, new NullApplicationThread(), nullptr, &tokens), android::OK);
+    ASSERT_EQ(tokens.size(), 1u);
+
+    // the waiting caller is kept as long as the activity that returns its result
+    callAs(callee, [&] { mService->reportActivityStatus(tokens[0], ActivityRecord::CREATED); });
+    EXPECT_EQ(clientsOf(caller), std::vector<pid_t>({callee}));
+    callAs(callee, [&] { mService->reportActivityStatus(tokens[0], ActivityRecord::DESTROYED); });
+    EXPECT_TRUE(clientsOf(caller).empty());
+}
+
+TEST_F(ActivityManagerServiceTest, noResultNoBinding) {
+    sp<IBinder> callerToken;
+    const pid_t caller = startApp(PACKAGE, callerToken);
+    ASSERT_GT(caller, 0);
+
+    Intent intent;
+    intent.setTarget(OTHER_PACKAGE + "/Main");
+    int32_t ret = 0;
+    callAs(caller, [&] {
+        mService->startActivity(callerToken, intent, ActivityManager::NO_REQUEST, &ret);
+    });
+    ASSERT_EQ(ret, android::OK);
+    runLoop();
+    std::vector<sp<IBinder>> tokens;
+    ASSERT_EQ(attach(mSpawned.back(), new NullApplicationThread(), nullptr, &tokens),
+              android::OK);
+    ASSERT_EQ(tokens.size(), 1u);
+    callAs(mSpawned.back(),
+           [&] { mService->reportActivityStatus(tokens[0], ActivityRecord::CREATED); });
+    EXPECT_TRUE(clientsOf(caller).empty());
+}
+
+TEST_F(ActivityManagerServiceTest, serviceBinding) {
+    sp<IBinder> callerToken;
+    const pid_t caller = startApp(PACKAGE, callerToken);
+    ASSERT_GT(caller, 0);
+
+    // a started service isn't bound to the process that starts it
+    Intent intent;
+    intent.setTarget(OTHER_PACKAGE + "/Service");
+    int32_t ret = 0;
+    callAs(caller, [&] { mService->startService(intent, &ret); });
+    ASSERT_EQ(ret, android::OK);
+    runLoop();
+    const pid_t provider = mSpawned.back();
+    ASSERT_NE(provider, caller);
+    ASSERT_EQ(attach(provider, new NullApplicationThread()), android::OK);
+    EXPECT_TRUE(clientsOf(provider).empty());
+
+    const sp<FakeServiceConnection> conn(new FakeServiceConnection());
+    callAs(caller, [&] { mService->bindService(callerToken, intent, conn, &ret); });
+    ASSERT_EQ(ret, android::OK);
+    EXPECT_EQ(clientsOf(provider), std::vector<pid_t>({caller}));
+
+    // the system isn't a client
+    const sp<FakeServiceConnection> systemConn(new FakeServiceConnection());
+    callAs(0, [&] { mService->bindService(nullptr, intent, systemConn, &ret); });
+    EXPECT_EQ(clientsOf(provider), std::vector<pid_t>({caller}));
+
+    callAs(caller, [&] { mService->unbindService(conn); });
+    EXPECT_TRUE(clientsOf(provider).empty());
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+#include "AppFreezer.h"
+#include "FakeApplication.h"
+
+namespace test {
+
+static int idleMain(int argc, char** argv) {
+    while (true) {
+        pause();
+    }
+    return 0;
+}
+
+/** The application is a real child process, it's stopped by the freezer */
+class AppFreezerTest : public FakeAppTest {
+protected:
+    void SetUp() override {
+        FakeAppTest::SetUp();
+#ifdef __NuttX__
+        mChild = task_create("amFreezerTest", SCHED_PRIORITY_DEFAULT, 2048, idleMain, nullptr);
+#else
+        mChild = fork();
+        if (mChild == 0) {
+            _exit(idleMain(0, nullptr));
+        }
+#endif
+        ASSERT_GT(mChild, 0);
+        mLooper = std::make_shared<os::app::UvLoop>();
+        mFreezer.init(
+                mLooper, [](pid_t pid) { return true; },
+                [this](pid_t pid, bool isFrozen) { mNotified.push_back(isFrozen); });
+        mApp = std::make_shared<AppRecord>(mAppThread, "test.app", false, mChild, 1, nullptr,
+                                           &mPriorityPolicy, &mFreezer);
+    }
+
+    void TearDown() override {
+        mFreezer.remove(mChild);
+        kill(mChild, SIGKILL);
+#ifndef __NuttX__
+        waitpid(mChild, nullptr, 0);
+#endif
+    }
+
+    /** Run the loop until the background application is frozen */
+    void freeze() {
+        mFreezer.onForegroundChanged(mChild, false);
+        os::app::UvTimer timer(mLooper->get(), [this](void*) {
+            if (mFreezer.isFrozen(mChild)) {
+                mLooper->stop();
+            }
+        });
+        timer.start(10, 10);
+        mLooper->run();
+    }
+
+    /** Run the loop for a while */
+    void runFor(uint64_t timeoutMs) {
+        os::app::UvTimer timer(mLooper->get(), [this](void*) { mLooper->stop(); });
+        timer.start(timeoutMs);
+        mLooper->run();
+    }
+
+    pid_t mChild;
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    AppFreezer mFreezer{true, 20};
+    std::vector<bool> mNotified;
+};
+
+TEST_F(AppFreezerTest, lifecycleThawsApplication) {
+    auto a = newActivity("A");
+    resumeActivity(a);
+    freeze();
+    ASSERT_TRUE(mFreezer.isFrozen(mChild));
+    EXPECT_TRUE(mAppThread->mCalls.empty());
+
+    // the application is running again before the request
+    a->lifecycleTransition(ActivityRecord::STOPPED);
+    EXPECT_FALSE(mFreezer.isFrozen(mChild));
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause"}));
+    EXPECT_EQ(mNotified, std::vector<bool>({true, false}));
+
+    freeze();
+    report(a, ActivityRecord::PAUSED);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"A:pause", "A:stop"}));
+    EXPECT_FALSE(mFreezer.isFrozen(mChild));
+}
+
+TEST_F(AppFreezerTest, foregroundCancelsGracePeriod) {
+    mFreezer.onForegroundChanged(mChild, false);
+    os::app::UvTimer foreground(mLooper->get(), [this](void*) {
+        mFreezer.onForegroundChanged(mChild, true);
+    });
+    foreground.start(5);
+    runFor(100);
+    // the application is back before the timeout, it isn't even notified
+    EXPECT_FALSE(mFreezer.isFrozen(mChild));
+    EXPECT_TRUE(mNotified.empty());
+}
+
+TEST_F(AppFreezerTest, deliveryCancelsFreezing) {
+    mFreezer.onForegroundChanged(mChild, false);
+    os::app::UvTimer timer(mLooper->get(), [this](void*) {
+        if (!mNotified.empty()) {
+            mLooper->stop();
+        }
+    });
+    timer.start(1, 1);
+    mLooper->run();
+    timer.close();
+    ASSERT_EQ(mNotified, std::vector<bool>({true}));
+
+    // the delivery comes in the settle time, the application isn't stopped
+    int delivered = 0;
+    mFreezer.post(mChild, [&delivered] { delivered++; });
+    EXPECT_EQ(delivered, 1);
+    EXPECT_EQ(mNotified, std::vector<bool>({true, false}));
+    runFor(10);
+    EXPECT_FALSE(mFreezer.isFrozen(mChild));
+}
+
+TEST_F(AppFreezerTest, deliveryThawsInOrder) {
+    freeze();
+    ASSERT_TRUE(mFreezer.isFrozen(mChild));
+#ifndef __NuttX__
+    // the child isn't in a cgroup of its own, it's stopped by the signal
+    int status = 0;
+    ASSERT_EQ(waitpid(mChild, &status, WUNTRACED), mChild);
+    EXPECT_TRUE(WIFSTOPPED(status));
+#endif
+
+    std::vector<int> delivered;
+    mFreezer.post(mChild, [&delivered] { delivered.push_back(1); });
+    EXPECT_FALSE(mFreezer.isFrozen(mChild));
+    mFreezer.post(mChild, [&delivered] { delivered.push_back(2); });
+    EXPECT_EQ(delivered, std::vector<int>({1, 2}));
+    EXPECT_EQ(mNotified, std::vector<bool>({true, false}));
+#ifndef __NuttX__
+    ASSERT_EQ(waitpid(mChild, &status, WCONTINUED), mChild);
+    EXPECT_TRUE(WIFCONTINUED(status));
+#endif
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
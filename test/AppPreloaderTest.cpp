@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AppPreloader.h"
+
+using namespace os::am;
+
+namespace test {
+
+/** The programs are temporary files of some KB, the budget is 8KB */
+class AppPreloaderTest : public testing::Test {
+protected:
+    void TearDown() override {
+        for (const auto& file : mFiles) {
+            unlink(file.c_str());
+        }
+    }
+
+    std::string newProgram(const size_t sizeKb) {
+        char path[] = "/tmp/amPreload.XXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_GE(fd, 0);
+        close(fd);
+        std::ofstream(path) << std::string(sizeKb * 1024, 'x');
+        mFiles.push_back(path);
+        return path;
+    }
+
+    std::string dump() {
+        std::ostringstream os;
+        JsonWriter writer(os);
+        writer.beginObject();
+        mPreloader.dumpJson(writer);
+        writer.endObject();
+        return os.str();
+    }
+
+    /** Wait until the thread has read all the requested programs */
+    std::string waitLoaded() {
+        std::string result;
+        for (int i = 0; i < 200; i++) {
+            result = dump();
+            if (result.find("\"loaded\":false") == std::string::npos) {
+                break;
+            }
+            usleep(10000);
+        }
+        return result;
+    }
+
+    static std::string entry(const std::string& execfile, const size_t sizeKb) {
+        return "{\"execfile\":\"" + execfile + "\",\"sizeKb\":" + std::to_string(sizeKb) +
+                ",\"loaded\":true}";
+    }
+
+    std::vector<std::string> mFiles;
+    AppPreloader mPreloader{8};
+};
+
+TEST_F(AppPreloaderTest, hitAndMiss) {
+    const std::string a = newProgram(3);
+    mPreloader.preload(a);
+    EXPECT_NE(waitLoaded().find("\"entries\":[" + entry(a, 3) + "]"), std::string::npos);
+
+    mPreloader.onSpawn("a", a);
+    mPreloader.onSpawn("b", newProgram(1));
+    // the spawned program doesn't take the budget anymore
+    std::string result = dump();
+    EXPECT_NE(result.find("\"usedKb\":0,\"readKb\":3,\"hits\":1,\"lateHits\":0,\"misses\":1"),
+              std::string::npos);
+    EXPECT_NE(result.find("\"entries\":[]"), std::string::npos);
+
+    // the program of the package is known after its spawn
+    mPreloader.preloadPackage("unknown");
+    mPreloader.preloadPackage("a");
+    EXPECT_NE(waitLoaded().find("\"entries\":[" + entry(a, 3) + "]"), std::string::npos);
+}
+
+TEST_F(AppPreloaderTest, evictLeastRecent) {
+    const std::string a = newProgram(3);
+    const std::string b = newProgram(3);
+    const std::string c = newProgram(3);
+    mPreloader.preload(a);
+    waitLoaded();
+    mPreloader.preload(b);
+    waitLoaded();
+    // a is requested again, b is the least recent one
+    mPreloader.preload(a);
+    mPreloader.preload(c);
+    const std::string result = waitLoaded();
+    EXPECT_NE(result.find("\"entries\":[" + entry(c, 3) + "," + entry(a, 3) + "]"),
+              std::string::npos);
+    EXPECT_NE(result.find("\"usedKb\":6"), std::string::npos);
+    EXPECT_NE(result.find("\"evictions\":1,\"failures\":0"), std::string::npos);
+}
+
+TEST_F(AppPreloaderTest, overBudget) {
+    const std::string a = newProgram(3);
+    mPreloader.preload(a);
+    waitLoaded();
+    mPreloader.preload(newProgram(9));
+    mPreloader.preload("/nonexistent/program");
+    std::string result;
+    for (int i = 0; i < 200; i++) {
+        result = dump();
+        if (result.find("\"failures\":2") != std::string::npos) {
+            break;
+        }
+        usleep(10000);
+    }
+    // the failed ones are dropped, nothing is evicted for them
+    EXPECT_NE(result.find("\"evictions\":0,\"failures\":2"), std::string::npos);
+    EXPECT_NE(result.find("\"entries\":[" + entry(a, 3) + "]"), std::string::npos);
+}
+
+TEST(AppPreloaderDisabledTest, noBudget) {
+    AppPreloader preloader(0);
+    EXPECT_FALSE(preloader.isEnabled());
+    preloader.preload("/bin/true");
+    preloader.onSpawn("a", "/bin/true");
+    std::ostringstream os;
+    JsonWriter writer(os);
+    writer.beginObject();
+    preloader.dumpJson(writer);
+    writer.endObject();
+    EXPECT_NE(os.str().find("\"misses\":0"), std::string::npos);
+    EXPECT_NE(os.str().find("\"entries\":[]"), std::string::npos);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AppSpawn.h"
+#include "app/UvLoop.h"
+
+using namespace os::app;
+
+namespace test {
+
+/** The programs of the host are spawned on the spawner thread, their exits are real SIGCHLDs */
+class AppSpawnTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mLooper = std::make_unique<UvLoop>();
+        mSpawn = std::make_unique<AppSpawn>();
+        mSpawn->signalInit(mLooper->get(), [this](int pid) {
+            mEvents.push_back("exit:" + std::to_string(pid));
+            if (--mPendingExits == 0) {
+                mLooper->stop();
+            }
+        });
+    }
+
+    void TearDown() override {
+        uv_close((uv_handle_t*)&mSpawn->mSignalHandler, nullptr);
+        mSpawn.reset();
+        mLooper->run(UV_RUN_NOWAIT);
+        mLooper->close();
+    }
+
+    void spawn(const std::string& execfile) {
+        mSpawn->appSpawnAsync(execfile, {"test.app"}, [this](int pid) {
+            mPids.push_back(pid);
+            mEvents.push_back("spawn:" + std::to_string(pid));
+        });
+    }
+
+    /** Run the loop until the exits come, or the timeout */
+    void runLoop(int exits) {
+        mPendingExits = exits;
+        UvTimer timer(mLooper->get(), [this](void*) { mLooper->stop(); });
+        timer.start(exits > 0 ? 2000 : 200, 0);
+        mLooper->run();
+        timer.close();
+    }
+
+    std::unique_ptr<UvLoop> mLooper;
+    std::unique_ptr<AppSpawn> mSpawn;
+    std::vector<int> mPids;
+    std::vector<std::string> mEvents;
+    int mPendingExits = 0;
+};
+
+TEST_F(AppSpawnTest, spawnOnSpawner) {
+    spawn("/bin/true");
+    // the spawn completion is delivered on the loop, never in appSpawnAsync
+    EXPECT_TRUE(mPids.empty());
+    runLoop(1);
+    ASSERT_EQ(mPids.size(), 1u);
+    ASSERT_GT(mPids[0], 0);
+    // the exit of the process always comes after its spawn completion
+    const std::string pid = std::to_string(mPids[0]);
+    EXPECT_EQ(mEvents, std::vector<std::string>({"spawn:" + pid, "exit:" + pid}));
+    EXPECT_FALSE(mSpawn->isSpawning());
+}
+
+TEST_F(AppSpawnTest, spawnInOrder) {
+    spawn("/bin/true");
+    spawn("/bin/true");
+    spawn("/bin/true");
+    runLoop(3);
+    ASSERT_EQ(mPids.size(), 3u);
+    for (const int pid : mPids) {
+        const auto spawned = std::find(mEvents.begin(), mEvents.end(),
+                                       "spawn:" + std::to_string(pid));
+        const auto exited = std::find(mEvents.begin(), mEvents.end(),
+                                      "exit:" + std::to_string(pid));
+        EXPECT_LT(spawned, exited);
+    }
+}
+
+TEST_F(AppSpawnTest, spawnFailure) {
+    spawn("/nonexistent/program");
+    runLoop(0);
+    ASSERT_EQ(mPids.size(), 1u);
+    EXPECT_LT(mPids[0], 0);
+}
+
+TEST_F(AppSpawnTest, deliverWithoutWait) {
+    // nothing is completed, it returns at once
+    mSpawn->deliverSpawned();
+    EXPECT_TRUE(mPids.empty());
+    spawn("/bin/true");
+    while (mPids.empty()) {
+        mSpawn->deliverSpawned();
+    }
+    EXPECT_GT(mPids[0], 0);
+    runLoop(1);
+    EXPECT_EQ(mEvents.size(), 2u);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "BinderStats.h"
+
+using namespace os::am;
+
+namespace test {
+
+static std::string dump(const BinderStats& stats) {
+    std::ostringstream os;
+    JsonWriter writer(os);
+    writer.beginObject();
+    stats.dumpJson(writer);
+    writer.endObject();
+    return os.str();
+}
+
+TEST(BinderStatsTest, linearBuckets) {
+    for (uint64_t latency = 0; latency < 8; latency++) {
+        EXPECT_EQ(BinderStats::getBucket(latency), (int)latency);
+        EXPECT_EQ(BinderStats::getBucketUpperBound(latency), latency + 1);
+    }
+    // every power of two is split into 4 buckets from here
+    EXPECT_EQ(BinderStats::getBucket(9), 8);
+    EXPECT_EQ(BinderStats::getBucket(10), 9);
+    EXPECT_EQ(BinderStats::getBucket(15), 11);
+    EXPECT_EQ(BinderStats::getBucket(16), 12);
+    EXPECT_EQ(BinderStats::getBucketUpperBound(8), 10u);
+    EXPECT_EQ(BinderStats::getBucketUpperBound(11), 16u);
+}
+
+TEST(BinderStatsTest, bucketsCoverLatency) {
+    const uint64_t maxLatency = 1ull << BinderStats::MAX_LATENCY_BITS;
+    int prev = 0;
+    for (uint64_t latency = 1; latency < maxLatency; latency += latency / 16 + 1) {
+        const int bucket = BinderStats::getBucket(latency);
+        // the buckets are in order, the latency is between the bounds
+        ASSERT_GE(bucket, prev);
+        ASSERT_LT(latency, BinderStats::getBucketUpperBound(bucket)) << latency;
+        ASSERT_GE(latency, BinderStats::getBucketUpperBound(bucket - 1)) << latency;
+        prev = bucket;
+    }
+    EXPECT_EQ(BinderStats::getBucket(maxLatency - 1), BinderStats::BUCKET_NUM - 2);
+    EXPECT_EQ(BinderStats::getBucketUpperBound(BinderStats::BUCKET_NUM - 2), maxLatency);
+    // the last bucket has no upper bound
+    EXPECT_EQ(BinderStats::getBucket(maxLatency), BinderStats::BUCKET_NUM - 1);
+    EXPECT_EQ(BinderStats::getBucket(UINT64_MAX), BinderStats::BUCKET_NUM - 1);
+}
+
+TEST(BinderStatsTest, percentileFromBuckets) {
+    BinderStats stats;
+    for (uint64_t latency = 1; latency <= 10; latency++) {
+        stats.record(BinderStats::START_ACTIVITY, latency, latency);
+    }
+    const std::string result = dump(stats);
+    EXPECT_NE(result.find("\"method\":\"startActivity\",\"count\":10,\"totalUs\":55"),
+              std::string::npos);
+    // the upper bound of the bucket, but never above the max
+    EXPECT_NE(result.find("\"p50Us\":6,\"p90Us\":10,\"p99Us\":10,\"maxUs\":10"),
+              std::string::npos);
+    // the uids beyond the slots are counted in the other
+    EXPECT_NE(result.find("{\"uid\":8,\"count\":1}]"), std::string::npos);
+    EXPECT_NE(result.find("\"otherUidCount\":2"), std::string::npos);
+
+    stats.reset();
+    EXPECT_EQ(dump(stats), "{\"binder\":[]}");
+}
+
+TEST(BinderStatsTest, unboundedLatency) {
+    BinderStats stats;
+    stats.record(BinderStats::POST_INTENT, 0, 1ull << 40);
+    const std::string result = dump(stats);
+    EXPECT_NE(result.find("\"maxUs\":4294967295"), std::string::npos);
+    EXPECT_NE(result.find("\"histogram\":[[0,1]]"), std::string::npos);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
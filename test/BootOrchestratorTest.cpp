@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BootOrchestrator.h"
+
+using namespace os::am;
+
+namespace test {
+
+static const char* MANIFEST_FILE = "/tmp/amBootTest.manifest";
+
+class BootOrchestratorTest : public testing::Test {
+protected:
+    void SetUp() override {
+        PackageManager::clearPackages();
+        for (const char* name : {"pkg.a", "pkg.b", "pkg.c"}) {
+            PackageInfo info;
+            info.packageName = name;
+            info.execfile = name;
+            PackageManager::installPackage(info);
+        }
+    }
+    void TearDown() override {
+        PackageManager::clearPackages();
+        unlink(MANIFEST_FILE);
+    }
+
+    void begin(const std::string& manifest) {
+        std::ofstream(MANIFEST_FILE) << manifest;
+        mBoot.begin(MANIFEST_FILE, mPm, [this](const BootEntry& entry, const PackageInfo&) {
+            const std::string name = entry.packageName + "/" + entry.componentName;
+            mStarted.push_back(name);
+            return name == mFailure ? -1 : 0;
+        });
+    }
+
+    void waitForCompletion(const bool isHomeStarted) {
+        mBoot.waitForCompletion(isHomeStarted, [this] { mCompleted++; });
+    }
+
+    BootOrchestrator mBoot;
+    PackageManager mPm;
+    std::vector<std::string> mStarted;
+    std::string mFailure; // the entry that fails to start
+    int mCompleted = 0;
+};
+
+TEST_F(BootOrchestratorTest, startAfterDependencies) {
+    // the entries may depend on the later ones
+    begin("activity pkg.c/C pkg.b/B\n"
+          "service pkg.b/B pkg.a/A\n"
+          "service pkg.a/A\n");
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A"}));
+    waitForCompletion(true);
+
+    mBoot.onReady("pkg.a", "A");
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A", "pkg.b/B"}));
+    mBoot.onReady("pkg.b", "B");
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A", "pkg.b/B", "pkg.c/C"}));
+    mBoot.onReady("pkg.c", "C");
+    // the home isn't resumed yet
+    EXPECT_EQ(mCompleted, 0);
+    EXPECT_TRUE(mBoot.isBooting());
+
+    mBoot.onHomeResumed();
+    EXPECT_EQ(mCompleted, 1);
+    EXPECT_FALSE(mBoot.isBooting());
+}
+
+TEST_F(BootOrchestratorTest, failedDependencyDoesNotBlock) {
+    mFailure = "pkg.a/A";
+    begin("service pkg.a/A\n"
+          "service pkg.b/B pkg.a/A\n");
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A", "pkg.b/B"}));
+    waitForCompletion(false);
+    mBoot.onReady("pkg.b", "B");
+    EXPECT_EQ(mCompleted, 1);
+}
+
+TEST_F(BootOrchestratorTest, failedAfterStart) {
+    begin("service pkg.a/A\n"
+          "service pkg.b/B pkg.a/A\n");
+    waitForCompletion(false);
+    // the process of the entry can't be spawned
+    mBoot.onFailed("pkg.a", "A");
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A", "pkg.b/B"}));
+    mBoot.onReady("pkg.b", "B");
+    EXPECT_EQ(mCompleted, 1);
+}
+
+TEST_F(BootOrchestratorTest, completeOnTimeout) {
+    begin("service pkg.a/A\n"
+          "service pkg.b/B pkg.a/A\n"
+          "service pkg.c/C pkg.c/C\n");
+    waitForCompletion(true);
+    EXPECT_EQ(mCompleted, 0);
+
+    // the entries that aren't ready and the home are given up
+    mBoot.timeout();
+    EXPECT_EQ(mCompleted, 1);
+    EXPECT_FALSE(mBoot.isBooting());
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A"}));
+    std::ostringstream dump;
+    dump << mBoot;
+    EXPECT_NE(dump.str().find("service pkg.b/B failed"), std::string::npos);
+
+    // the entry that is ready late doesn't start the others
+    mBoot.onReady("pkg.a", "A");
+    mBoot.timeout();
+    EXPECT_EQ(mStarted, std::vector<std::string>({"pkg.a/A"}));
+    EXPECT_EQ(mCompleted, 1);
+}
+
+TEST_F(BootOrchestratorTest, noManifestCompletesAtOnce) {
+    unlink(MANIFEST_FILE);
+    mBoot.begin(MANIFEST_FILE, mPm, [](const BootEntry&, const PackageInfo&) { return 0; });
+    waitForCompletion(true);
+    EXPECT_EQ(mCompleted, 1);
+    EXPECT_FALSE(mBoot.isBooting());
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CpuClassPolicy.h"
+#include "LowMemoryManager.h"
+#include "ProcessPriorityPolicy.h"
+
+using namespace os::am;
+
+namespace test {
+
+// beyond PID_MAX_LIMIT, the pid is never a real process, nothing is really rescheduled
+const pid_t FAKE_PID = 4 * 1024 * 1024 + 1;
+
+/** The bands that a bare priority policy gives to the processes */
+class CpuClassBandTest : public testing::Test {
+protected:
+    LowMemoryManager mLmk;
+    ProcessPriorityPolicy mPolicy{&mLmk};
+};
+
+TEST_F(CpuClassBandTest, followPolicy) {
+    const pid_t app = FAKE_PID;
+    const pid_t home = app + 1;
+    auto& cpuClass = mPolicy.getCpuClassPolicy();
+    mPolicy.add(home, true, ProcessPriority::HIGH);
+    mPolicy.pushForeground(home);
+    EXPECT_EQ(cpuClass.getBand(home), CpuClassPolicy::FOREGROUND);
+
+    mPolicy.add(app, true, ProcessPriority::LOW);
+    EXPECT_EQ(cpuClass.getBand(app), CpuClassPolicy::MIDDLE);
+    mPolicy.pushForeground(app);
+    mPolicy.analyseProcessPriority();
+    EXPECT_EQ(cpuClass.getBand(app), CpuClassPolicy::FOREGROUND);
+    EXPECT_EQ(cpuClass.getBand(home), CpuClassPolicy::HOME);
+
+    // it's rescheduled before the next analyse
+    mPolicy.intoBackground(app);
+    EXPECT_EQ(cpuClass.getBand(app), CpuClassPolicy::LOW);
+    mPolicy.pushForeground(app);
+    EXPECT_EQ(cpuClass.getBand(app), CpuClassPolicy::FOREGROUND);
+
+    mPolicy.remove(app);
+    EXPECT_EQ(cpuClass.getBand(app), CpuClassPolicy::BAND_NUM);
+}
+
+// the affinity needs SMP on NuttX
+#if !defined(__NuttX__) || defined(CONFIG_SMP)
+using Cpus = std::vector<int>;
+
+/** The affinity.cfg is a temporary file */
+class CpuClassPolicyTest : public testing::Test {
+protected:
+    void SetUp() override {
+        char path[] = "/tmp/amAffinity.XXXXXX";
+        const int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        mPath = path;
+        mOnlineCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    void TearDown() override {
+        unlink(mPath.c_str());
+    }
+
+    bool load(const std::string& config) {
+        std::ofstream(mPath) << config;
+        return mPolicy.loadAffinity(mPath);
+    }
+
+    std::string mPath;
+    int mOnlineCpus;
+    CpuClassPolicy mPolicy;
+};
+
+TEST_F(CpuClassPolicyTest, rangesAndLists) {
+    ASSERT_TRUE(load("foreground 0-1\nbackground 0,1\ncached 1-0,0\n"));
+    const Cpus first = mOnlineCpus > 1 ? Cpus({0, 1}) : Cpus({0});
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::FOREGROUND), first);
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::HOME), first);
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::HIGH), first);
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::LOW), first);
+    // an empty range is skipped, the cached ones get a single core
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::CACHED), Cpus({0}));
+}
+
+TEST_F(CpuClassPolicyTest, skipBadLines) {
+    ASSERT_TRUE(load("# the comment 0-1\nforeground\nbackground x\ncached -1\nidle 0\n"
+                     "foreground 0\n"));
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::FOREGROUND), Cpus({0}));
+    // the bands that aren't configured run on all the cores
+    EXPECT_TRUE(mPolicy.getCpus(CpuClassPolicy::MIDDLE).empty());
+    EXPECT_TRUE(mPolicy.getCpus(CpuClassPolicy::CACHED).empty());
+}
+
+TEST_F(CpuClassPolicyTest, dropOfflineCores) {
+    const std::string beyond = std::to_string(mOnlineCpus);
+    ASSERT_TRUE(load("foreground 0-" + std::to_string(mOnlineCpus + 8) + "\ncached " + beyond +
+                     "\nbackground " + beyond + ",0\n"));
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::FOREGROUND).size(), (size_t)mOnlineCpus);
+    // none of them is online, the line is illegal
+    EXPECT_TRUE(mPolicy.getCpus(CpuClassPolicy::CACHED).empty());
+    EXPECT_EQ(mPolicy.getCpus(CpuClassPolicy::MIDDLE), Cpus({0}));
+}
+
+TEST_F(CpuClassPolicyTest, missingFile) {
+    EXPECT_FALSE(mPolicy.loadAffinity(mPath + ".missing"));
+}
+#endif
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+#include <sstream>
+#include <string>
+
+#include "DumpWriter.h"
+
+using namespace os::am;
+
+namespace test {
+
+class JsonWriterTest : public testing::Test {
+protected:
+    std::ostringstream mOs;
+    JsonWriter mWriter{mOs};
+};
+
+TEST_F(JsonWriterTest, escapeStrings) {
+    mWriter.beginObject()
+            .field("quote\"key", "a\"b")
+            .field("slash", std::string("a\\b"))
+            .field("lines", "a\nb\tc")
+            .field("control", std::string("a\x01\x1f"
+                                          "b"))
+            .field("utf8", "\xe4\xb8\xad")
+            .endObject();
+    EXPECT_EQ(mOs.str(),
+              "{\"quote\\\"key\":\"a\\\"b\",\"slash\":\"a\\\\b\",\"lines\":\"a\\nb\\tc\","
+              "\"control\":\"a\\u0001\\u001fb\",\"utf8\":\"\xe4\xb8\xad\"}");
+}
+
+TEST_F(JsonWriterTest, nestedCommas) {
+    mWriter.beginObject().field("empty", "");
+    mWriter.beginArray("list").field(nullptr, 1).field(nullptr, 2);
+    mWriter.beginObject().endObject().beginArray().endArray().endArray();
+    mWriter.beginObject("inner").field("a", true).field("b", false).endObject();
+    mWriter.beginArray("none").endArray().endObject();
+    EXPECT_EQ(mOs.str(),
+              "{\"empty\":\"\",\"list\":[1,2,{},[]],\"inner\":{\"a\":true,\"b\":false},"
+              "\"none\":[]}");
+}
+
+TEST_F(JsonWriterTest, scalarValues) {
+    const char* missing = nullptr;
+    mWriter.beginArray()
+            .field(nullptr, missing)
+            .field(nullptr, (uint8_t)200)
+            .field(nullptr, (int64_t)-5)
+            .field(nullptr, 1.5)
+            .field(nullptr, NAN)
+            .field(nullptr, (double)INFINITY)
+            .endArray();
+    // the bytes are numbers rather than characters, NaN and infinity are null
+    EXPECT_EQ(mOs.str(), "[null,200,-5,1.5,null,null]");
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "ActivityRecord.h"
+#include "AppRecord.h"
+#include "LowMemoryManager.h"
+#include "NullApplicationThread.h"
+#include "ProcessPriorityPolicy.h"
+#include "ServiceRecord.h"
+#include "TaskBoard.h"
+#include "TaskManager.h"
+#include "os/app/BnServiceConnection.h"
+
+namespace test {
+
+using namespace os::am;
+
+using Calls = std::vector<std::string>;
+
+/** Record the lifecycle requests that the application received */
+class FakeApplicationThread : public NullApplicationThread {
+public:
+    Status scheduleLaunchActivity(const std::string& activityName, const sp<IBinder>& token,
+                                  const Intent& intent) override {
+        return record("create", token);
+    }
+    Status scheduleStartActivity(const sp<IBinder>& token,
+                                 const std::optional<Intent>& intent) override {
+        return record("start", token);
+    }
+    Status scheduleResumeActivity(const sp<IBinder>& token,
+                                  const std::optional<Intent>& intent) override {
+        return record("resume", token);
+    }
+    Status schedulePauseActivity(const sp<IBinder>& token) override {
+        return record("pause", token);
+    }
+    Status scheduleStopActivity(const sp<IBinder>& token) override {
+        return record("stop", token);
+    }
+    Status scheduleDestroyActivity(const sp<IBinder>& token) override {
+        return record("destroy", token);
+    }
+    Status scheduleStartService(const std::string& serviceName, const sp<IBinder>& token,
+                                const Intent& intent) override {
+        return record(("start(" + intent.mData + ")").c_str(), token);
+    }
+    Status scheduleStartServiceBatch(const std::string& serviceName, const sp<IBinder>& token,
+                                     const std::vector<Intent>& intents) override {
+        std::string call = "start(";
+        for (const auto& intent : intents) {
+            call += intent.mData + (&intent == &intents.back() ? ")" : ",");
+        }
+        return record(call.c_str(), token);
+    }
+    Status scheduleBindService(const std::string& serviceName, const sp<IBinder>& token,
+                               const Intent& intent,
+                               const sp<IServiceConnection>& connection) override {
+        return record("bind", token);
+    }
+    Status scheduleUnbindService(const sp<IBinder>& token) override {
+        return record("unbind", token);
+    }
+
+    void setName(const sp<IBinder>& token, const std::string& name) {
+        mNames.emplace_back(token, name);
+    }
+
+    std::vector<std::string> mCalls;
+
+private:
+    Status record(const char* call, const sp<IBinder>& token) {
+        std::string name;
+        for (const auto& it : mNames) {
+            if (it.first == token) {
+                name = it.second;
+            }
+        }
+        mCalls.push_back(name + ":" + call);
+        return Status::ok();
+    }
+
+    std::vector<std::pair<sp<IBinder>, std::string>> mNames;
+};
+
+/** Count the callbacks that the client of a service connection received */
+class FakeServiceConnection : public os::app::BnServiceConnection {
+public:
+    Status onServiceConnected(const sp<IBinder>& server) override {
+        mConnected++;
+        return Status::ok();
+    }
+    Status onServiceDisconnected(const sp<IBinder>& server) override {
+        mDisconnected++;
+        return Status::ok();
+    }
+
+    int mConnected = 0;
+    int mDisconnected = 0;
+};
+
+/** An application with a fake thread, for the tests of the records that it hosts */
+class FakeAppTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // debug mode, the lifecycle tasks never timeout and the looper isn't used
+        mTaskBoard.setDebugMode(true);
+        mTaskBoard.startWork(nullptr);
+        mAppThread = new FakeApplicationThread();
+        mApp = std::make_shared<AppRecord>(mAppThread, "test.app", false, 1, 1, nullptr,
+                                           &mPriorityPolicy);
+    }
+
+    ActivityHandler newActivity(const std::string& name) {
+        auto activity = std::make_shared<ActivityRecord>("test.app/" + name, nullptr, -1,
+                                                         ActivityRecord::STANDARD, nullptr,
+                                                         Intent(), nullptr, &mTaskManager,
+                                                         &mTaskBoard);
+        activity->setAppThread(mApp);
+        mAppThread->setName(activity->getToken(), name);
+        return activity;
+    }
+
+    ServiceHandler newService(const std::string& name, ServiceRecord::StartMode startMode) {
+        const sp<IBinder> token(new android::BBinder());
+        auto service = std::make_shared<ServiceRecord>(name, token, os::pm::MIDDLE, mApp,
+                                                       startMode);
+        mAppThread->setName(token, name);
+        return service;
+    }
+
+    void startService(const ServiceHandler& service, const std::string& data) {
+        Intent intent;
+        intent.setData(data);
+        service->start(intent);
+    }
+
+    /** the application reports like AMS::reportActivityStatus */
+    void report(const ActivityHandler& activity, ActivityRecord::Status status) {
+        const ActivityLifeCycleTask::Event event(status, activity->getToken());
+        mTaskBoard.eventTrigger(event);
+    }
+
+    void resumeActivity(const ActivityHandler& activity) {
+        activity->lifecycleTransition(ActivityRecord::RESUMED);
+        report(activity, ActivityRecord::CREATED);
+        report(activity, ActivityRecord::STARTED);
+        report(activity, ActivityRecord::RESUMED);
+        mAppThread->mCalls.clear();
+    }
+
+    TaskBoard mTaskBoard;
+    ITaskManager mTaskManager;
+    LowMemoryManager mLmk;
+    ProcessPriorityPolicy mPriorityPolicy{&mLmk};
+    sp<FakeApplicationThread> mAppThread;
+    std::shared_ptr<AppRecord> mApp;
+};
+
+} // namespace test
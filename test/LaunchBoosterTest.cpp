@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LaunchBooster.h"
+#include "SchedLevel.h"
+
+using namespace os::am;
+
+namespace test {
+
+static int idleMain(int argc, char** argv) {
+    while (true) {
+        pause();
+    }
+    return 0;
+}
+
+/** The launching and the background applications are real child processes */
+class LaunchBoosterTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mLooper = std::make_shared<os::app::UvLoop>();
+        mBooster.init(mLooper, [this] { return std::vector<pid_t>({mBackground}); });
+        if (!mBooster.isEnabled()) {
+            GTEST_SKIP() << "no privilege to raise the priority";
+        }
+        mLaunching = spawn();
+        mBackground = spawn();
+        ASSERT_TRUE(getSchedLevel(0, mBase));
+    }
+
+    void TearDown() override {
+        for (const pid_t pid : {mLaunching, mBackground}) {
+            if (pid > 0) {
+                kill(pid, SIGKILL);
+#ifndef __NuttX__
+                waitpid(pid, nullptr, 0);
+#endif
+            }
+        }
+        setSchedLevel(0, mBase);
+    }
+
+    pid_t spawn() {
+#ifdef __NuttX__
+        const pid_t pid =
+                task_create("amBoosterTest", SCHED_PRIORITY_DEFAULT, 2048, idleMain, nullptr);
+#else
+        const pid_t pid = fork();
+        if (pid == 0) {
+            _exit(idleMain(0, nullptr));
+        }
+#endif
+        EXPECT_GT(pid, 0);
+        return pid;
+    }
+
+    /** The level relative to the one before the boost */
+    int levelOf(pid_t pid) {
+        int level = 0;
+        EXPECT_TRUE(getSchedLevel(pid, level));
+        return level - mBase;
+    }
+
+    std::string dump() {
+        std::ostringstream os;
+        JsonWriter writer(os);
+        writer.beginObject();
+        mBooster.dumpJson(writer);
+        writer.endObject();
+        return os.str();
+    }
+
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    LaunchBooster mBooster{true, 20};
+    pid_t mLaunching = 0;
+    pid_t mBackground = 0;
+    int mBase = 0;
+};
+
+TEST_F(LaunchBoosterTest, restoreAfterLastLaunch) {
+    ASSERT_TRUE(mBooster.boost(mLaunching, 1));
+    EXPECT_FALSE(mBooster.boost(mLaunching, 1));
+    ASSERT_TRUE(mBooster.boost(mLaunching, 2));
+    EXPECT_GT(levelOf(mLaunching), 0);
+    EXPECT_GT(levelOf(0), 0);
+    EXPECT_LT(levelOf(mBackground), 0);
+    const int boosted = levelOf(mLaunching);
+
+    // the process is boosted once, it's restored with its last launch
+    mBooster.end(1);
+    EXPECT_EQ(levelOf(mLaunching), boosted);
+    EXPECT_LT(levelOf(mBackground), 0);
+    mBooster.end(2);
+    EXPECT_EQ(levelOf(mLaunching), 0);
+    EXPECT_EQ(levelOf(0), 0);
+    EXPECT_EQ(levelOf(mBackground), 0);
+    EXPECT_NE(dump().find("\"boosts\":2,\"timeouts\":0,\"failures\":0,\"active\":0,\"demoted\":0"),
+              std::string::npos);
+}
+
+TEST_F(LaunchBoosterTest, backgroundLaunchRestoredToBase) {
+    ASSERT_TRUE(mBooster.boost(mLaunching, 1));
+    ASSERT_LT(levelOf(mBackground), 0);
+    // the demoted one launches, it's restored to the level before the demotion
+    ASSERT_TRUE(mBooster.boost(mBackground, 2));
+    EXPECT_GT(levelOf(mBackground), 0);
+    mBooster.end(1);
+    mBooster.end(2);
+    EXPECT_EQ(levelOf(mBackground), 0);
+}
+
+TEST_F(LaunchBoosterTest, rebaseWhileBoosted) {
+    ASSERT_TRUE(mBooster.boost(mLaunching, 1));
+    const int boosted = levelOf(mLaunching);
+    EXPECT_TRUE(mBooster.rebase(mLaunching, mBase - 2));
+    EXPECT_EQ(levelOf(mLaunching), boosted - 2);
+    EXPECT_FALSE(mBooster.rebase(getpid() + 100000, mBase));
+    mBooster.end(1);
+    EXPECT_EQ(levelOf(mLaunching), -2);
+}
+
+TEST_F(LaunchBoosterTest, timeoutEndsBoost) {
+    ASSERT_TRUE(mBooster.boost(mLaunching, 1));
+    os::app::UvTimer timer(mLooper->get(), [this](void*) { mLooper->stop(); });
+    timer.start(100);
+    mLooper->run();
+    EXPECT_EQ(levelOf(mLaunching), 0);
+    EXPECT_EQ(levelOf(mBackground), 0);
+    EXPECT_NE(dump().find("\"timeouts\":1"), std::string::npos);
+    // the late end is ignored
+    mBooster.end(1);
+    EXPECT_EQ(levelOf(0), 0);
+}
+
+TEST_F(LaunchBoosterTest, exitEndsLaunches) {
+    ASSERT_TRUE(mBooster.boost(mLaunching, 1));
+    mBooster.remove(mLaunching);
+    EXPECT_EQ(levelOf(0), 0);
+    EXPECT_EQ(levelOf(mBackground), 0);
+    EXPECT_NE(dump().find("\"active\":0"), std::string::npos);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LaunchTrace.h"
+
+using namespace os::am;
+
+namespace test {
+
+using Samples = std::vector<uint64_t>;
+
+/** The launches are checked through the dump, one line for each recent launch */
+class LaunchTraceTest : public testing::Test {
+protected:
+    std::string dump(const LaunchTrace& trace) {
+        std::ostringstream os;
+        os << trace;
+        return os.str();
+    }
+
+    /** The line of the recent launch, empty if it isn't in the dump */
+    static std::string lineOf(const std::string& dump, const uint32_t id) {
+        const auto pos = dump.find("#" + std::to_string(id) + " ");
+        return pos == std::string::npos ? "" : dump.substr(pos, dump.find('\n', pos) - pos);
+    }
+
+    /** The milliseconds after the key in the line, -1 if the key is missing */
+    static double valueOf(const std::string& line, const std::string& key) {
+        const auto pos = line.find(" " + key + ":");
+        return pos == std::string::npos ? -1 : std::stod(line.substr(pos + key.size() + 2));
+    }
+
+    void finish(LaunchTrace& trace, const uint32_t id) {
+        trace.setType(id, LaunchTrace::HOT);
+        trace.mark(id, LaunchTrace::RESUMED);
+    }
+};
+
+TEST_F(LaunchTraceTest, ringOverwritesOldest) {
+    LaunchTrace trace(2);
+    const uint32_t first = trace.beginLaunch("first");
+    trace.leaveLaunch(false);
+    const uint32_t second = trace.beginLaunch("second");
+    trace.leaveLaunch(false);
+    const uint32_t third = trace.beginLaunch("third");
+    trace.leaveLaunch(false);
+    // the third shares the slot of the first, the late marks of the first are dropped
+    trace.setName(first, "late");
+    trace.mark(first, LaunchTrace::RESUMED);
+
+    const std::string result = dump(trace);
+    EXPECT_EQ(lineOf(result, first), "");
+    EXPECT_EQ(result.find("late"), std::string::npos);
+    // from the oldest to the newest
+    EXPECT_NE(lineOf(result, second).find(" second "), std::string::npos);
+    EXPECT_NE(lineOf(result, third).find(" third "), std::string::npos);
+    EXPECT_LT(result.find(lineOf(result, second)), result.find(lineOf(result, third)));
+    EXPECT_EQ(result.find(" total:"), std::string::npos);
+    EXPECT_EQ(second, first + 1);
+    EXPECT_EQ(third, first + 2);
+}
+
+TEST_F(LaunchTraceTest, failedLaunchDropped) {
+    LaunchTrace trace(4);
+    const uint32_t id = trace.beginLaunch("failed");
+    EXPECT_EQ(trace.currentLaunch(), id);
+    trace.leaveLaunch(true);
+    EXPECT_EQ(trace.currentLaunch(), 0u);
+    EXPECT_EQ(lineOf(dump(trace), id), "");
+}
+
+TEST_F(LaunchTraceTest, skippedPhasesFromPreviousPoint) {
+    LaunchTrace trace(4);
+    const uint32_t id = trace.beginLaunch("hot");
+    trace.leaveLaunch(false);
+    usleep(5000);
+    // the hot launch goes to resumed directly, the phase starts from the beginning
+    finish(trace, id);
+
+    const std::string result = dump(trace);
+    const std::string line = lineOf(result, id);
+    EXPECT_EQ(valueOf(line, "resolve"), -1);
+    EXPECT_EQ(valueOf(line, "attach"), -1);
+    EXPECT_GE(valueOf(line, "resume"), 5.0);
+    EXPECT_EQ(valueOf(line, "total"), valueOf(line, "resume"));
+    EXPECT_NE(result.find("hot count:1\n"), std::string::npos);
+}
+
+TEST_F(LaunchTraceTest, markOnlyOnce) {
+    LaunchTrace trace(4);
+    const uint32_t id = trace.beginLaunch("warm");
+    trace.mark(id, LaunchTrace::APP_ATTACHED);
+    const std::string before = dump(trace);
+    usleep(2000);
+    trace.mark(id, LaunchTrace::APP_ATTACHED);
+    EXPECT_EQ(dump(trace), before);
+
+    finish(trace, id);
+    const std::string result = dump(trace);
+    EXPECT_NE(lineOf(result, id).find(" total:"), std::string::npos);
+    // the finished launch isn't marked again
+    trace.mark(id, LaunchTrace::CREATED);
+    EXPECT_EQ(dump(trace), result);
+}
+
+TEST_F(LaunchTraceTest, preparedBeforeAttach) {
+    LaunchTrace trace(4);
+    const uint32_t id = trace.beginLaunch("cold");
+    trace.leaveLaunch(false);
+    trace.beginPrepare(id);
+    trace.endPrepare(id);
+    usleep(5000);
+    trace.mark(id, LaunchTrace::APP_ATTACHED);
+
+    // the launch is ready when the process attaches
+    const std::string line = lineOf(dump(trace), id);
+    EXPECT_NE(line.find("(attach)"), std::string::npos) << line;
+    EXPECT_GE(valueOf(line, "critical"), 5.0);
+    EXPECT_LT(valueOf(line, "prepare"), valueOf(line, "critical"));
+}
+
+TEST_F(LaunchTraceTest, attachedBeforePrepared) {
+    LaunchTrace trace(4);
+    const uint32_t id = trace.beginLaunch("cold");
+    trace.leaveLaunch(false);
+    trace.beginPrepare(id);
+    trace.mark(id, LaunchTrace::APP_ATTACHED);
+    usleep(5000);
+    trace.endPrepare(id);
+    // only the first preparation is measured
+    trace.beginPrepare(id);
+    trace.endPrepare(id);
+
+    const std::string line = lineOf(dump(trace), id);
+    EXPECT_NE(line.find("(prepare)"), std::string::npos) << line;
+    EXPECT_GE(valueOf(line, "prepare"), 5.0);
+    EXPECT_GE(valueOf(line, "critical"), valueOf(line, "prepare"));
+}
+
+TEST_F(LaunchTraceTest, preparedWithoutAttach) {
+    LaunchTrace trace(4);
+    const uint32_t id = trace.beginLaunch("cold");
+    trace.leaveLaunch(false);
+    trace.beginPrepare(id);
+    usleep(2000);
+    trace.endPrepare(id);
+
+    // the launch still waits for the process
+    const std::string line = lineOf(dump(trace), id);
+    EXPECT_NE(line.find("(attach)"), std::string::npos) << line;
+    EXPECT_EQ(valueOf(line, "critical"), 0.0);
+    EXPECT_GE(valueOf(line, "prepare"), 2.0);
+}
+
+TEST_F(LaunchTraceTest, nearestRankPercentile) {
+    EXPECT_EQ(LaunchTrace::percentile({7}, 50), 7u);
+    EXPECT_EQ(LaunchTrace::percentile({7}, 99), 7u);
+    const Samples ten = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    EXPECT_EQ(LaunchTrace::percentile(ten, 50), 5u);
+    EXPECT_EQ(LaunchTrace::percentile(ten, 90), 9u);
+    EXPECT_EQ(LaunchTrace::percentile(ten, 99), 10u);
+    // the rank rounds up, it's always one of the samples
+    EXPECT_EQ(LaunchTrace::percentile({10, 20, 30}, 50), 20u);
+    EXPECT_EQ(LaunchTrace::percentile({10, 20, 30}, 34), 20u);
+    EXPECT_EQ(LaunchTrace::percentile({10, 20, 30}, 33), 10u);
+    EXPECT_EQ(LaunchTrace::percentile({10, 20, 30}, 0), 10u);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LowMemoryManager.h"
+#include "MemoryPressureSource.h"
+#include "app/ActivityManager.h"
+#include "app/UvLoop.h"
+
+namespace test {
+
+using namespace os::am;
+
+TEST(LowMemoryManagerTest, trimStepByStep) {
+    using Trims = std::vector<std::pair<pid_t, int>>;
+    auto looper = std::make_shared<os::app::UvLoop>();
+    LowMemoryManager lmk;
+    lmk.setPressureSource(MemoryPressureSource::create("fake:0=50,10=85,20=80,30=99,40=99,50=99"));
+    lmk.init(looper);
+    Trims trims;
+    lmk.setTrimMemoryExecutor([&trims](pid_t pid, int level) { trims.emplace_back(pid, level); });
+    lmk.setPidOomScore(1, 10);
+    lmk.setPidOomScore(2, 200);
+    lmk.setPidOomScore(3, 900);
+    looper->postDelayTask([&looper](void*) { looper->stop(); }, 100);
+    looper->run();
+
+    // an application a report from the highest score, 80 and 85 trim the ones from 102
+    // moderately, 99 trims all of them completely
+    const int moderate = os::app::ActivityManager::TRIM_MEMORY_MODERATE;
+    const int complete = os::app::ActivityManager::TRIM_MEMORY_COMPLETE;
+    EXPECT_EQ(trims, Trims({{3, moderate}, {2, moderate}, {3, complete}, {2, complete},
+                            {1, complete}}));
+    EXPECT_FALSE(lmk.isOkToLaunch());
+
+    // the drop from 85 to 80 is measured after the first trim only
+    std::ostringstream dump;
+    dump << lmk;
+    EXPECT_NE(dump.str().find("pid:3 trimmed:2 spared:0 systemRelief:5"), std::string::npos)
+            << dump.str();
+    EXPECT_NE(dump.str().find("pid:2 trimmed:2 spared:0 systemRelief:0"), std::string::npos)
+            << dump.str();
+}
+
+TEST(LowMemoryManagerTest, trimWithoutReport) {
+    using Trims = std::vector<std::pair<pid_t, int>>;
+    auto looper = std::make_shared<os::app::UvLoop>();
+    LowMemoryManager lmk;
+    // a notified source reports once, the pressure stays
+    lmk.setPressureSource(MemoryPressureSource::create("fake:0=85"));
+    lmk.init(looper);
+    Trims trims;
+    lmk.setTrimMemoryExecutor([&trims](pid_t pid, int level) { trims.emplace_back(pid, level); });
+    lmk.setPidOomScore(1, 10);
+    lmk.setPidOomScore(2, 200);
+    lmk.setPidOomScore(3, 900);
+    looper->postDelayTask([&looper](void*) { looper->stop(); }, 1200);
+    looper->run();
+
+    // the next one is trimmed on the recheck of the pressure
+    const int moderate = os::app::ActivityManager::TRIM_MEMORY_MODERATE;
+    EXPECT_EQ(trims, Trims({{3, moderate}, {2, moderate}}));
+}
+
+TEST(LowMemoryManagerTest, criticalTrimsAtOnce) {
+    using Trims = std::vector<std::pair<pid_t, int>>;
+    auto looper = std::make_shared<os::app::UvLoop>();
+    LowMemoryManager lmk;
+    lmk.setPressureSource(MemoryPressureSource::create("fake:0=90"));
+    lmk.init(looper);
+    Trims trims;
+    std::vector<pid_t> kills;
+    lmk.setTrimMemoryExecutor([&trims](pid_t pid, int level) { trims.emplace_back(pid, level); });
+    lmk.setLMKExecutor([&kills](pid_t pid) { kills.push_back(pid); });
+    lmk.setPidOomScore(1, 10);
+    lmk.setPidOomScore(2, 200);
+    lmk.setPidOomScore(3, 900);
+    // before the recheck
+    looper->postDelayTask([&looper](void*) { looper->stop(); }, 100);
+    looper->run();
+    const int complete = os::app::ActivityManager::TRIM_MEMORY_COMPLETE;
+    EXPECT_EQ(trims, Trims({{3, complete}, {2, complete}, {1, complete}}));
+    EXPECT_TRUE(kills.empty());
+
+    // the memory is still low after the reclaim timeout, all of them are killed together
+    looper->postDelayTask([&looper](void*) { looper->stop(); }, 3500);
+    looper->run();
+    EXPECT_EQ(trims.size(), 3u);
+    EXPECT_EQ(kills, std::vector<pid_t>({3, 2, 1}));
+}
+
+// the Linux sources
+#ifndef __NuttX__
+/** The files of the sources and lmk.cfg are under a temporary root */
+class LowMemorySourceTest : public testing::Test {
+protected:
+    using Trims = std::vector<std::pair<pid_t, int>>;
+
+    void SetUp() override {
+        char root[] = "/tmp/amLmkTest.XXXXXX";
+        ASSERT_NE(mkdtemp(root), nullptr);
+        mRoot = root;
+        mLooper = std::make_shared<os::app::UvLoop>();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(mRoot);
+    }
+
+    void write(const std::string& path, const std::string& content) {
+        std::filesystem::create_directories(std::filesystem::path(mRoot + path).parent_path());
+        std::ofstream(mRoot + path) << content;
+    }
+
+    void writeMeminfo(int totalKb, int availableKb) {
+        write("/proc/meminfo",
+              "MemTotal: " + std::to_string(totalKb) + " kB\nMemFree: 0 kB\nMemAvailable: " +
+                      std::to_string(availableKb) + " kB\n");
+    }
+
+    std::unique_ptr<LowMemoryManager> newLmk(const std::string& spec) {
+        auto lmk = std::make_unique<LowMemoryManager>(spec, mRoot);
+        lmk->init(mLooper);
+        lmk->setTrimMemoryExecutor(
+                [this](pid_t pid, int level) { mTrims.emplace_back(pid, level); });
+        return lmk;
+    }
+
+    static std::string getSource(const LowMemoryManager& lmk) {
+        std::ostringstream dump;
+        dump << lmk;
+        const std::string str = dump.str();
+        const size_t begin = str.find("source:") + strlen("source:");
+        return str.substr(begin, str.find(' ', begin) - begin);
+    }
+
+    void runLoop() {
+        os::app::UvTimer timer(mLooper->get(), [this](void*) { mLooper->stop(); });
+        timer.start(50, 0);
+        mLooper->run();
+    }
+
+    std::string mRoot;
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    Trims mTrims;
+};
+
+TEST_F(LowMemorySourceTest, psiStallTime) {
+    auto source = MemoryPressureSource::create("psi", mRoot);
+    EXPECT_EQ(source->getPressure(), -1);
+
+    // the "some" threshold is 70, the "full" one is 90
+    write("/proc/pressure/memory",
+          "some avg10=7.50 avg60=1.00 avg300=0.00 total=100\n"
+          "full avg10=1.00 avg60=0.00 avg300=0.00 total=10\n");
+    EXPECT_EQ(source->getPressure(), 35);
+    write("/proc/pressure/memory",
+          "some avg10=15.00 avg60=1.00 avg300=0.00 total=100\n"
+          "full avg10=7.00 avg60=0.00 avg300=0.00 total=10\n");
+    EXPECT_EQ(source->getPressure(), 90);
+    EXPECT_EQ(source->bytesToPressure(1024), -1);
+}
+
+TEST_F(LowMemorySourceTest, psiFallbackToMeminfo) {
+    // no psi, the thresholds of the legacy lmk.cfg are converted by the fallback
+    writeMeminfo(10240, 5120);
+    write("/data/lmk.cfg", "2097152 1048576 100\n95 10\n");
+    auto lmk = newLmk("psi");
+    EXPECT_EQ(getSource(*lmk), "meminfo");
+    lmk->setPidOomScore(1, 50);
+    lmk->setPidOomScore(2, 200);
+    EXPECT_FALSE(lmk->isUnderPressure());
+
+    // 2MB of 10MB free is 80
+    writeMeminfo(10240, 2048);
+    EXPECT_TRUE(lmk->isUnderPressure());
+    lmk->executeLMK(80);
+    EXPECT_EQ(mTrims, Trims({{2, os::app::ActivityManager::TRIM_MEMORY_MODERATE}}));
+}
+
+TEST_F(LowMemorySourceTest, meminfoAvailable) {
+    auto source = MemoryPressureSource::create("meminfo", mRoot);
+    EXPECT_EQ(source->getPressure(), -1);
+    writeMeminfo(4000, 1000);
+    EXPECT_EQ(source->getPressure(), 75);
+    EXPECT_EQ(source->bytesToPressure(2000 * 1024), 50);
+}
+
+TEST_F(LowMemorySourceTest, cgroupEvents) {
+    write("/cg/memory.max", "max\n");
+    write("/cg/memory.high", "1000\n");
+    write("/cg/memory.current", "250\n");
+    write("/cg/memory.events", "low 0\nhigh 0\nmax 0\noom 0\noom_kill 0\n");
+    // 100 bytes free of the memory.high is 90
+    write("/etc/lmk.cfg", "100 0 100\n");
+    auto lmk = newLmk("cgroup:/cg");
+    EXPECT_EQ(getSource(*lmk), "cgroup");
+    lmk->setPidOomScore(1, 50);
+    lmk->setPidOomScore(2, 200);
+    EXPECT_FALSE(lmk->isUnderPressure());
+
+    // "max" tells it's 90 at least, whatever the usage is
+    write("/cg/memory.events", "low 0\nhigh 1\nmax 1\noom 0\noom_kill 0\n");
+    runLoop();
+    EXPECT_EQ(mTrims, Trims({{2, os::app::ActivityManager::TRIM_MEMORY_COMPLETE}}));
+}
+#endif
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MemoryCgroup.h"
+#include "app/ActivityManager.h"
+
+using namespace os::am;
+using os::app::ActivityManager;
+
+namespace test {
+
+static const pid_t APP_PID = 100;
+
+/** The cgroup files are plain files in a temporary directory, the events are written by hand */
+class MemoryCgroupTest : public testing::Test {
+protected:
+    void SetUp() override {
+        char root[] = "/tmp/amCgroupTest.XXXXXX";
+        ASSERT_NE(mkdtemp(root), nullptr);
+        mRoot = root;
+        mAppPath = mRoot + "/app-" + std::to_string(APP_PID);
+        // the watch is added when the application is moved in, memory.events must exist
+        ASSERT_EQ(mkdir(mAppPath.c_str(), 0755), 0);
+        writeEvents(0, 0, 0, 0);
+
+        mLooper = std::make_shared<os::app::UvLoop>();
+        mCgroup = std::make_unique<MemoryCgroup>(mRoot, "64,128,256,0");
+        mCgroup->init(
+                mLooper, [this](pid_t pid, int level) { mTrims.push_back(level); },
+                [this](pid_t pid) { mKills.push_back(pid); });
+        ASSERT_TRUE(mCgroup->isEnabled());
+        mCgroup->add(APP_PID, os::pm::MIDDLE, CpuClassPolicy::MIDDLE);
+    }
+
+    void TearDown() override {
+        mCgroup.reset();
+        std::filesystem::remove_all(mRoot);
+    }
+
+    void writeEvents(int high, int max, int oom, int oomKill) {
+        std::ofstream(mAppPath + "/memory.events")
+                << "low 0\nhigh " << high << "\nmax " << max << "\noom " << oom << "\noom_kill "
+                << oomKill << "\n";
+    }
+
+    /** Run the loop for the inotify events of the files */
+    void runLoop() {
+        os::app::UvTimer timer(mLooper->get(), [this](void*) { mLooper->stop(); });
+        timer.start(50, 0);
+        mLooper->run();
+    }
+
+    std::string mRoot;
+    std::string mAppPath;
+    std::shared_ptr<os::app::UvLoop> mLooper;
+    std::unique_ptr<MemoryCgroup> mCgroup;
+    std::vector<int> mTrims;
+    std::vector<pid_t> mKills;
+};
+
+TEST_F(MemoryCgroupTest, limitsByPriority) {
+    std::ifstream max(mAppPath + "/memory.max");
+    uint64_t value = 0;
+    max >> value;
+    EXPECT_EQ(value, 128u * 1024 * 1024);
+}
+
+TEST_F(MemoryCgroupTest, trimOverHigh) {
+    writeEvents(1, 0, 0, 0);
+    runLoop();
+    EXPECT_EQ(mTrims, std::vector<int>({ActivityManager::TRIM_MEMORY_MODERATE}));
+
+    // the application has a moment to release memory
+    writeEvents(2, 0, 0, 0);
+    runLoop();
+    EXPECT_EQ(mTrims.size(), 1u);
+    EXPECT_TRUE(mKills.empty());
+    EXPECT_FALSE(mCgroup->isOutOfMemory(APP_PID));
+}
+
+TEST_F(MemoryCgroupTest, trimCompleteOverMax) {
+    writeEvents(1, 1, 0, 0);
+    runLoop();
+    EXPECT_EQ(mTrims, std::vector<int>({ActivityManager::TRIM_MEMORY_COMPLETE}));
+}
+
+TEST_F(MemoryCgroupTest, stopOnOom) {
+    writeEvents(1, 1, 1, 0);
+    runLoop();
+    EXPECT_TRUE(mTrims.empty());
+    EXPECT_EQ(mKills, std::vector<pid_t>({APP_PID}));
+
+    // it's killed by the kernel already, it isn't stopped again
+    writeEvents(1, 1, 2, 1);
+    runLoop();
+    EXPECT_EQ(mKills.size(), 1u);
+    EXPECT_TRUE(mCgroup->isOutOfMemory(APP_PID));
+    std::ostringstream dump;
+    dump << *mCgroup;
+    EXPECT_NE(dump.str().find("trims:0 kills:1 oomKills:1"), std::string::npos);
+}
+
+TEST_F(MemoryCgroupTest, reuseAfterEarlyExit) {
+    // the process exits before it attaches, its cgroup and its watch are gone with it
+    mCgroup->remove(APP_PID);
+    writeEvents(1, 1, 1, 0);
+    runLoop();
+    EXPECT_TRUE(mKills.empty());
+    EXPECT_FALSE(mCgroup->isOutOfMemory(APP_PID));
+
+    // the reused pid is limited by its own priority
+    writeEvents(0, 0, 0, 0);
+    mCgroup->add(APP_PID, os::pm::HIGH, CpuClassPolicy::MIDDLE);
+    std::ifstream max(mAppPath + "/memory.max");
+    uint64_t value = 0;
+    max >> value;
+    EXPECT_EQ(value, 256u * 1024 * 1024);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
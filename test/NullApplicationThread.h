@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "os/app/BnApplicationThread.h"
+
+namespace os {
+namespace am {
+
+using android::IBinder;
+using android::sp;
+using android::binder::Status;
+using os::app::Intent;
+using os::app::IServiceConnection;
+
+/**
+ * Accept every request of activity manager and do nothing. The fake applications of the tests,
+ * the benchmark and the soak harness override the requests that they play, the others go to
+ * onRequest.
+ */
+class NullApplicationThread : public os::app::BnApplicationThread {
+public:
+    Status scheduleLaunchActivity(const std::string& activityName, const sp<IBinder>& token,
+                                  const Intent& intent) override {
+        return onRequest();
+    }
+    Status scheduleStartActivity(const sp<IBinder>& token,
+                                 const std::optional<Intent>& intent) override {
+        return onRequest();
+    }
+    Status scheduleResumeActivity(const sp<IBinder>& token,
+                                  const std::optional<Intent>& intent) override {
+        return onRequest();
+    }
+    Status schedulePauseActivity(const sp<IBinder>& token) override {
+        return onRequest();
+    }
+    Status scheduleStopActivity(const sp<IBinder>& token) override {
+        return onRequest();
+    }
+    Status scheduleDestroyActivity(const sp<IBinder>& token) override {
+        return onRequest();
+    }
+    Status onActivityResult(const sp<IBinder>& token, int32_t requestCode, int32_t resultCode,
+                            const Intent& resultData) override {
+        return onRequest();
+    }
+    Status scheduleStartService(const std::string& serviceName, const sp<IBinder>& token,
+                                const Intent& intent) override {
+        return onRequest();
+    }
+    Status scheduleStartServiceBatch(const std::string& serviceName, const sp<IBinder>& token,
+                                     const std::vector<Intent>& intents) override {
+        return onRequest();
+    }
+    Status scheduleStopService(const sp<IBinder>& token) override {
+        return onRequest();
+    }
+    Status scheduleBindService(const std::string& serviceName, const sp<IBinder>& token,
+                               const Intent& intent,
+                               const sp<IServiceConnection>& connection) override {
+        return onRequest();
+    }
+    Status scheduleUnbindService(const sp<IBinder>& token) override {
+        return onRequest();
+    }
+    Status scheduleReceiveIntent(const sp<IBinder>& token, const Intent& intent) override {
+        return onRequest();
+    }
+    Status setForegroundApplication(bool isForeground) override {
+        return onRequest();
+    }
+    Status setFrozenApplication(bool isFrozen) override {
+        return onRequest();
+    }
+    Status scheduleTrimMemory(int32_t level) override {
+        return onRequest();
+    }
+    Status terminateApplication() override {
+        return onRequest();
+    }
+    Status scheduleReattachApplication(const std::vector<std::string>& activityNames,
+                                       const std::vector<sp<IBinder>>& activityTokens,
+                                       const std::vector<std::string>& serviceNames,
+                                       const std::vector<sp<IBinder>>& serviceTokens) override {
+        return onRequest();
+    }
+
+protected:
+    virtual Status onRequest() {
+        return Status::ok();
+    }
+};
+
+} // namespace am
+} // namespace os
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "LowMemoryManager.h"
+#include "ProcessPriorityPolicy.h"
+
+namespace test {
+
+using namespace os::am;
+
+// beyond PID_MAX_LIMIT, the pid is never a real process, nothing is really rescheduled
+const pid_t FAKE_PID = 4 * 1024 * 1024 + 1;
+
+class ProcessPriorityPolicyTest : public ::testing::Test {
+protected:
+    LowMemoryManager mLmk;
+    ProcessPriorityPolicy mPolicy{&mLmk};
+};
+
+TEST_F(ProcessPriorityPolicyTest, bindingPropagatesScore) {
+    const pid_t client = FAKE_PID;
+    const pid_t provider = client + 1;
+    const pid_t backend = client + 2;
+    mPolicy.add(backend, false, ProcessPriority::LOW);
+    mPolicy.add(provider, false, ProcessPriority::LOW);
+    mPolicy.add(client, true, ProcessPriority::MIDDLE);
+    mPolicy.pushForeground(client);
+    mPolicy.analyseProcessPriority();
+    EXPECT_GE(mPolicy.get(provider)->oomScore, OS_LOW_LEVEL_MIN_ADJ);
+
+    // the foreground client promotes its provider, and the provider's provider at once
+    mPolicy.bindProcess(provider, backend);
+    mPolicy.bindProcess(client, provider);
+    EXPECT_EQ(mPolicy.get(provider)->oomScore, OS_FOREGROUND_APP_ADJ);
+    EXPECT_EQ(mPolicy.get(backend)->oomScore, OS_FOREGROUND_APP_ADJ);
+    mPolicy.analyseProcessPriority();
+    EXPECT_EQ(mPolicy.get(backend)->oomScore, OS_FOREGROUND_APP_ADJ);
+
+    // neither the system nor an unknown process is a client
+    mPolicy.bindProcess(-1, backend);
+    mPolicy.bindProcess(0, backend);
+    mPolicy.bindProcess(client + 3, backend);
+    EXPECT_EQ(mPolicy.get(backend)->clients.size(), 1u);
+
+    mPolicy.unbindProcess(client, provider);
+    mPolicy.analyseProcessPriority();
+    EXPECT_GE(mPolicy.get(provider)->oomScore, OS_LOW_LEVEL_MIN_ADJ);
+    EXPECT_GE(mPolicy.get(backend)->oomScore, OS_LOW_LEVEL_MIN_ADJ);
+    EXPECT_TRUE(mPolicy.get(client)->providers.empty());
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "FakeApplication.h"
+
+namespace test {
+
+class ServiceRecordTest : public FakeAppTest {};
+
+TEST_F(ServiceRecordTest, coalesceServiceStart) {
+    auto direct = newService("D", ServiceRecord::START_DIRECT);
+    auto latest = newService("L", ServiceRecord::START_LATEST);
+    auto append = newService("A", ServiceRecord::START_APPEND);
+    for (const auto data : {"1", "2", "3"}) {
+        startService(direct, data);
+        startService(latest, data);
+        startService(append, data);
+    }
+    EXPECT_EQ(mAppThread->mCalls, Calls({"D:start(1)", "L:start(1)", "A:start(1)", "D:start(2)",
+                                         "D:start(3)"}));
+    mAppThread->mCalls.clear();
+
+    // the merged intents are delivered when the service reports the pending start
+    latest->onStarted();
+    append->onStarted();
+    EXPECT_EQ(mAppThread->mCalls, Calls({"L:start(3)", "A:start(2,3)"}));
+    latest->onStarted();
+    EXPECT_EQ(mAppThread->mCalls.size(), 2u);
+    EXPECT_EQ(latest->mStartRequests, 3u);
+    EXPECT_EQ(latest->mStartDeliveries, 2u);
+}
+
+TEST_F(ServiceRecordTest, capAppendBatch) {
+    auto append = newService("A", ServiceRecord::START_APPEND);
+    for (int i = 0; i <= 40; i++) {
+        startService(append, std::to_string(i));
+    }
+    EXPECT_EQ(append->mPendingIntents.size(), 32u);
+    EXPECT_EQ(append->mStartDrops, 8u);
+
+    // the service that reports at last gets the latest ones in order
+    mAppThread->mCalls.clear();
+    append->onStarted();
+    std::string batch = "A:start(";
+    for (int i = 9; i <= 40; i++) {
+        batch += std::to_string(i) + (i < 40 ? "," : ")");
+    }
+    EXPECT_EQ(mAppThread->mCalls, Calls({batch}));
+}
+
+TEST_F(ServiceRecordTest, bindServiceOnce) {
+    auto service = newService("S", ServiceRecord::START_DIRECT);
+    sp<FakeServiceConnection> conns[3] = {new FakeServiceConnection(),
+                                          new FakeServiceConnection(),
+                                          new FakeServiceConnection()};
+    service->bind(nullptr, conns[0], Intent(), 2);
+    service->bind(nullptr, conns[1], Intent(), 3);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"S:bind"}));
+    EXPECT_EQ(conns[0]->mConnected + conns[1]->mConnected, 0);
+
+    // the pending connections are connected by the publish, the later one at once
+    service->publish(new android::BBinder());
+    EXPECT_EQ(conns[0]->mConnected, 1);
+    EXPECT_EQ(conns[1]->mConnected, 1);
+    service->bind(nullptr, conns[2], Intent(), 4);
+    EXPECT_EQ(conns[2]->mConnected, 1);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"S:bind"}));
+
+    // the dead client is pruned without callbacks
+    service->onConnectionDied(android::IInterface::asBinder(conns[1]).get());
+    EXPECT_EQ(conns[1]->mDisconnected, 0);
+    EXPECT_EQ(service->mConnectRecord.size(), 2u);
+
+    service->unbind(conns[0]);
+    service->unbind(conns[2]);
+    EXPECT_EQ(conns[0]->mDisconnected, 1);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"S:bind", "S:unbind"}));
+    EXPECT_EQ(service->mBindState, ServiceRecord::BIND_NONE);
+
+    // the unbound service is asked to bind again
+    service->bind(nullptr, conns[0], Intent(), 2);
+    EXPECT_EQ(mAppThread->mCalls, Calls({"S:bind", "S:unbind", "S:bind"}));
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
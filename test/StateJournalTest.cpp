@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "StateJournal.h"
+
+using namespace os::am;
+
+namespace test {
+
+static const char* JOURNAL_FILE = "/tmp/amJournalTest.journal";
+
+class StateJournalTest : public testing::Test {
+protected:
+    void SetUp() override {
+        unlink(JOURNAL_FILE);
+    }
+    void TearDown() override {
+        unlink(JOURNAL_FILE);
+    }
+
+    /** Open the journal again, like the restarted service */
+    RecoveredState restart(StateJournal& journal, const size_t capacity = 4096) {
+        journal.close();
+        RecoveredState state;
+        EXPECT_TRUE(journal.open(JOURNAL_FILE, capacity));
+        journal.recover(state);
+        return state;
+    }
+
+    // the journal only needs distinct addresses
+    int mTokens[8];
+    int mTasks[4];
+};
+
+TEST_F(StateJournalTest, RecoverAfterRestart) {
+    StateJournal journal;
+    ASSERT_TRUE(journal.open(JOURNAL_FILE, 4096));
+    journal.appAttached(100, 1, false, "pkg.a");
+    journal.priorityChanged(100, 2);
+    journal.activityAdded(100, &mTokens[0], &mTasks[0], "pkg.a", 1, "pkg.a/Main");
+    journal.activityStatus(&mTokens[0], 3);
+    journal.activityAdded(100, &mTokens[1], &mTasks[1], "other", 0, "pkg.a/Detail");
+    journal.activityAdded(100, &mTokens[2], &mTasks[1], "other", 0, "pkg.a/Gone");
+    journal.activityRemoved(&mTokens[2]);
+    journal.serviceAdded(100, &mTokens[3], 2, "Service");
+    journal.serviceStatus(&mTokens[3], 4, 1);
+    journal.taskOrder({&mTasks[1], &mTasks[0]}, &mTasks[0]);
+    journal.appAttached(101, 1, false, "pkg.b");
+    journal.appExited(101);
+
+    const auto state = restart(journal);
+    ASSERT_EQ(state.apps.size(), 1u);
+    const auto& app = state.apps.at(100);
+    EXPECT_EQ(app.packageName, "pkg.a");
+    EXPECT_EQ(app.priority, 2);
+    ASSERT_EQ(app.activities.size(), 2u);
+    EXPECT_EQ(app.activities[0].name, "pkg.a/Main");
+    EXPECT_EQ(app.activities[0].status, 3);
+    EXPECT_EQ(app.activities[1].name, "pkg.a/Detail");
+    EXPECT_EQ(app.activities[1].taskTag, "other");
+    ASSERT_EQ(app.services.size(), 1u);
+    EXPECT_EQ(app.services[0].status, 4);
+    EXPECT_EQ(app.services[0].startFlag, 1);
+    const std::vector<uint32_t> order = {app.activities[1].taskId, app.activities[0].taskId};
+    EXPECT_EQ(state.taskOrder, order);
+    EXPECT_EQ(state.homeTaskId, app.activities[0].taskId);
+}
+
+TEST_F(StateJournalTest, CompactWhenFull) {
+    StateJournal journal;
+    ASSERT_TRUE(journal.open(JOURNAL_FILE, 512));
+    journal.appAttached(100, 1, false, "pkg.a");
+    journal.activityAdded(100, &mTokens[0], &mTasks[0], "pkg.a", 1, "pkg.a/Main");
+    // much more than the capacity, the journal is rewritten with the live state
+    for (int i = 0; i < 200; i++) {
+        journal.activityStatus(&mTokens[0], i % 5);
+    }
+    ASSERT_TRUE(journal.isOpen());
+
+    const auto state = restart(journal, 512);
+    ASSERT_EQ(state.apps.size(), 1u);
+    ASSERT_EQ(state.apps.at(100).activities.size(), 1u);
+    EXPECT_EQ(state.apps.at(100).activities[0].status, 199 % 5);
+}
+
+TEST_F(StateJournalTest, AdoptedIdsAreKept) {
+    StateJournal journal;
+    ASSERT_TRUE(journal.open(JOURNAL_FILE, 4096));
+    journal.appAttached(100, 1, false, "pkg.a");
+    journal.activityAdded(100, &mTokens[0], &mTasks[0], "pkg.a", 1, "pkg.a/Main");
+
+    auto state = restart(journal);
+    journal.reset(state);
+    // the adopted activity gets a new token, but its records go on with the old id
+    const auto recovered = state.apps.at(100).activities[0];
+    journal.bindId(&mTokens[4], recovered.id);
+    journal.bindId(&mTasks[2], recovered.taskId);
+    journal.activityStatus(&mTokens[4], 3);
+    journal.activityAdded(100, &mTokens[5], &mTasks[2], "pkg.a", 1, "pkg.a/Detail");
+
+    state = restart(journal);
+    const auto& activities = state.apps.at(100).activities;
+    ASSERT_EQ(activities.size(), 2u);
+    EXPECT_EQ(activities[0].id, recovered.id);
+    EXPECT_EQ(activities[0].status, 3);
+    EXPECT_GT(activities[1].id, recovered.id);
+    EXPECT_EQ(activities[1].taskId, recovered.taskId);
+}
+
+TEST_F(StateJournalTest, LargeRecordDisables) {
+    StateJournal journal;
+    ASSERT_TRUE(journal.open(JOURNAL_FILE, 256 * 1024));
+    journal.appAttached(100, 1, false, "pkg.a");
+    // the payload size of a record is 16 bits
+    journal.activityAdded(100, &mTokens[0], &mTasks[0], "pkg.a", 1, std::string(70000, 'a'));
+    EXPECT_FALSE(journal.isOpen());
+
+    // the state isn't complete, nothing is adopted
+    EXPECT_TRUE(restart(journal, 256 * 1024).apps.empty());
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Xiaomi Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "FakeApplication.h"
+#include "SystemUIManager.h"
+#include "TaskStackManager.h"
+
+namespace test {
+
+class TaskManagerTest : public FakeAppTest {
+protected:
+    /** A task of the tag whose root Activity is hosted by the running test app */
+    ActivityStackHandler newTask(const std::string& tag, ITaskManager* taskManager) {
+        auto task = std::make_shared<ActivityStack>(tag);
+        auto activity = std::make_shared<ActivityRecord>("test.app/" + tag, nullptr, -1,
+                                                         ActivityRecord::STANDARD, task,
+                                                         Intent(), nullptr, taskManager,
+                                                         &mTaskBoard);
+        activity->setAppThread(mApp);
+        task->pushActivity(activity);
+        return task;
+    }
+};
+
+TEST_F(TaskManagerTest, duplicateTagInListOrder) {
+    TaskStackManager manager(mTaskBoard);
+    auto first = newTask("t", &manager);
+    auto second = newTask("t", &manager);
+    manager.restoreTask(first, nullptr, false);
+    manager.restoreTask(second, nullptr, false);
+    EXPECT_EQ(manager.findTask("t"), first);
+
+    manager.pushTaskToFront(second);
+    EXPECT_EQ(manager.findTask("t"), second);
+
+    // the front task isn't alive, the next one of the tag is found
+    auto stopped = std::make_shared<AppRecord>(mAppThread, "test.stopped", false, 2, 2, nullptr,
+                                               &mPriorityPolicy);
+    stopped->mStatus = APP_STOPPED;
+    second->getRootActivity()->setAppThread(stopped);
+    EXPECT_EQ(manager.findTask("t"), first);
+}
+
+TEST_F(TaskManagerTest, removedTaskIsNotFound) {
+    TaskStackManager manager(mTaskBoard);
+    auto first = newTask("t", &manager);
+    auto second = newTask("t", &manager);
+    auto other = newTask("o", &manager);
+    manager.restoreTask(first, nullptr, false);
+    manager.restoreTask(other, nullptr, false);
+    manager.restoreTask(second, nullptr, false);
+
+    manager.deleteTask(first);
+    EXPECT_EQ(manager.findTask("t"), second);
+    manager.deleteTask(second);
+    EXPECT_EQ(manager.findTask("t"), nullptr);
+    EXPECT_EQ(manager.findTask("o"), other);
+    EXPECT_EQ(manager.getTasks(), std::vector<ActivityStackHandler>({other}));
+}
+
+TEST_F(TaskManagerTest, systemUIDuplicateTag) {
+    SystemUIManager manager;
+    auto first = newTask("t", &manager);
+    auto second = newTask("t", &manager);
+    manager.restoreTask(first, nullptr, false);
+    // the restored task is put in front of the list
+    manager.restoreTask(second, nullptr, false);
+    EXPECT_EQ(manager.findTask("t"), second);
+
+    manager.deleteActivity(second->getRootActivity());
+    EXPECT_EQ(manager.findTask("t"), first);
+    manager.deleteActivity(first->getRootActivity());
+    EXPECT_EQ(manager.findTask("t"), nullptr);
+}
+
+extern "C" int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+} // namespace test